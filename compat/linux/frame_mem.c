@@ -0,0 +1,112 @@
+/*
+ * Linux specific memory mapping for frame buffers
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/* MAP_ANONYMOUS, madvise() and syscall() are not part of the POSIX level
+ * the rest of the tree is built with */
+#define _DEFAULT_SOURCE
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "libavutil/macros.h"
+#include "frame_mem.h"
+
+#define MPOL_PREFERRED 1
+
+uint8_t *ff_linux_frame_map(size_t size, int hugetlb, size_t thp_align, int node,
+                            size_t *mapped, int *result)
+{
+    void *data = MAP_FAILED;
+    size_t len = size;
+
+    *result = 0;
+
+#ifdef MAP_HUGETLB
+    if (hugetlb) {
+        len  = FFALIGN(size, 2 * 1024 * 1024);
+        data = mmap(NULL, len, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        *result |= data == MAP_FAILED ? FF_LINUX_FRAME_HUGETLB_FAILED :
+                                        FF_LINUX_FRAME_HUGETLB;
+    }
+#endif
+
+    if (data == MAP_FAILED) {
+        size_t align = 0;
+
+#ifdef MADV_HUGEPAGE
+        /* transparent huge pages need a suitably aligned range */
+        align = thp_align;
+#endif
+        len  = align ? FFALIGN(size, align) : size;
+        data = mmap(NULL, len + align, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (data == MAP_FAILED)
+            return NULL;
+
+#ifdef MADV_HUGEPAGE
+        if (align) {
+            uint8_t *base    = data;
+            uint8_t *aligned = (uint8_t *)FFALIGN((uintptr_t)base, align);
+
+            if (aligned > base)
+                munmap(base, aligned - base);
+            if (base + align > aligned)
+                munmap(aligned + len, base + align - aligned);
+            data = aligned;
+
+            if (!madvise(data, len, MADV_HUGEPAGE))
+                *result |= FF_LINUX_FRAME_HUGEPAGES;
+        }
+#endif
+    }
+
+#if defined(SYS_mbind)
+    /* has to happen before the pages are first touched */
+    if (node >= 0 && node < 256) {
+        unsigned long mask[256 / (8 * sizeof(unsigned long))] = { 0 };
+
+        mask[node / (8 * sizeof(*mask))] |= 1UL << (node % (8 * sizeof(*mask)));
+        if (!syscall(SYS_mbind, data, len, MPOL_PREFERRED,
+                     mask, 8 * sizeof(mask) + 1, 0))
+            *result |= FF_LINUX_FRAME_NUMA_BOUND;
+    }
+#endif
+
+    *mapped = len;
+    return data;
+}
+
+void ff_linux_frame_unmap(uint8_t *data, size_t mapped)
+{
+    munmap(data, mapped);
+}
+
+int ff_linux_numa_node(void)
+{
+#if defined(SYS_getcpu)
+    unsigned cpu, node;
+
+    if (!syscall(SYS_getcpu, &cpu, &node, NULL))
+        return node;
+#endif
+    return -1;
+}
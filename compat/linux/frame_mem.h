@@ -0,0 +1,52 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef COMPAT_LINUX_FRAME_MEM_H
+#define COMPAT_LINUX_FRAME_MEM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* what ff_linux_frame_map() did, returned in *result */
+#define FF_LINUX_FRAME_HUGETLB        (1 << 0) ///< mapped with MAP_HUGETLB
+#define FF_LINUX_FRAME_HUGETLB_FAILED (1 << 1) ///< MAP_HUGETLB was tried and failed
+#define FF_LINUX_FRAME_HUGEPAGES      (1 << 2) ///< madvise(MADV_HUGEPAGE) succeeded
+#define FF_LINUX_FRAME_NUMA_BOUND     (1 << 3) ///< bound to the requested node
+
+/**
+ * Map a zeroed anonymous buffer of at least size bytes.
+ *
+ * @param hugetlb   try explicit huge pages first
+ * @param thp_align if nonzero, align the mapping to this size and advise
+ *                  transparent huge pages for it
+ * @param node      NUMA node to bind the pages to, or -1
+ * @param mapped    length of the mapping, to be passed to ff_linux_frame_unmap()
+ * @param result    FF_LINUX_FRAME_* flags
+ * @return the mapping or NULL on failure
+ */
+uint8_t *ff_linux_frame_map(size_t size, int hugetlb, size_t thp_align, int node,
+                            size_t *mapped, int *result);
+
+void ff_linux_frame_unmap(uint8_t *data, size_t mapped);
+
+/**
+ * @return the NUMA node of the calling thread or -1 if unknown
+ */
+int ff_linux_numa_node(void);
+
+#endif /* COMPAT_LINUX_FRAME_MEM_H */
@@ -63,6 +63,7 @@
 #include "libavutil/time.h"
 #include "libavutil/thread.h"
 #include "libavutil/threadmessage.h"
+#include "libavutil/trace.h"
 #include "libavcodec/mathops.h"
 #include "libavformat/os_support.h"
 
@@ -512,6 +513,55 @@ static int decode_interrupt_cb(void *ctx)
 
 const AVIOInterruptCB int_cb = { decode_interrupt_cb, NULL };
 
+static void write_trace(void)
+{
+    AVIOContext *pb;
+    AVBPrint bp;
+    int ret;
+
+    av_trace_disable();
+
+    av_bprint_init(&bp, 0, AV_BPRINT_SIZE_UNLIMITED);
+    av_trace_dump_stats(&bp);
+    av_log(NULL, AV_LOG_INFO, "trace: per-stage span durations\n%s", bp.str);
+    av_bprint_clear(&bp);
+
+    ret = av_trace_dump_json(&bp);
+    if (ret >= 0)
+        ret = avio_open2(&pb, trace_filename, AVIO_FLAG_WRITE, &int_cb, NULL);
+    if (ret >= 0) {
+        avio_write(pb, bp.str, bp.len);
+        ret = avio_closep(&pb);
+    }
+    if (ret < 0)
+        av_log(NULL, AV_LOG_ERROR, "Error writing trace file '%s': %s\n",
+               trace_filename, av_err2str(ret));
+    av_bprint_finalize(&bp, NULL);
+}
+
+static void print_filter_stats(FilterGraph *fg)
+{
+    int i;
+
+    av_log(NULL, AV_LOG_INFO, "Filter graph #%d statistics:\n", fg->index);
+    av_log(NULL, AV_LOG_INFO, "%-24s %8s %10s %10s %8s %8s %8s %10s %6s\n",
+           "filter", "activ", "time[ms]", "wait[ms]", "slices", "in", "out",
+           "buf[kB]", "queue");
+    for (i = 0; i < fg->graph->nb_filters; i++) {
+        AVFilterContext *f = fg->graph->filters[i];
+        AVFilterStats stats;
+
+        if (avfilter_get_stats(f, &stats) < 0)
+            continue;
+        av_log(NULL, AV_LOG_INFO, "%-24s %8"PRId64" %10.3f %10.3f %8"PRId64
+               " %8"PRId64" %8"PRId64" %10"PRId64" %6"PRId64"\n",
+               f->name, stats.nb_activations, stats.activate_time / 1000.0,
+               stats.wait_time / 1000.0, stats.nb_slices, stats.frame_count_in,
+               stats.frame_count_out, stats.bytes_requested >> 10,
+               stats.max_queued_frames);
+    }
+}
+
 static void ffmpeg_cleanup(int ret)
 {
     int i, j;
@@ -523,6 +573,8 @@ static void ffmpeg_cleanup(int ret)
 
     for (i = 0; i < nb_filtergraphs; i++) {
         FilterGraph *fg = filtergraphs[i];
+        if (do_filter_stats && fg->graph)
+            print_filter_stats(fg);
         avfilter_graph_free(&fg->graph);
         for (j = 0; j < fg->nb_inputs; j++) {
             InputFilter *ifilter = fg->inputs[j];
@@ -654,6 +706,12 @@ static void ffmpeg_cleanup(int ret)
     }
     av_freep(&vstats_filename);
 
+    if (trace_filename) {
+        write_trace();
+        av_freep(&trace_filename);
+    }
+    av_trace_free();
+
     av_freep(&input_streams);
     av_freep(&input_files);
     av_freep(&output_streams);
@@ -730,6 +788,7 @@ static void write_packet(OutputFile *of, AVPacket *pkt, OutputStream *ost, int u
 {
     AVFormatContext *s = of->ctx;
     AVStream *st = ost->st;
+    int64_t trace_start;
     int ret;
 
     /*
@@ -863,7 +922,9 @@ static void write_packet(OutputFile *of, AVPacket *pkt, OutputStream *ost, int u
               );
     }
 
+    trace_start = av_trace_begin();
     ret = av_interleaved_write_frame(s, pkt);
+    av_trace_end(trace_start, AV_TRACE_STAGE_MUX, s->oformat->name, st->index);
     if (ret < 0) {
         print_error("av_interleaved_write_frame()", ret);
         main_return_code = 1;
@@ -1001,6 +1062,22 @@ static int init_output_stream_wrapper(OutputStream *ost, AVFrame *frame,
     return ret;
 }
 
+static int encode_send_frame(OutputStream *ost, const AVFrame *frame)
+{
+    int64_t trace_start = av_trace_begin();
+    int ret = avcodec_send_frame(ost->enc_ctx, frame);
+    av_trace_end(trace_start, AV_TRACE_STAGE_ENCODE, ost->enc_ctx->codec->name, ost->index);
+    return ret;
+}
+
+static int encode_receive_packet(OutputStream *ost, AVPacket *pkt)
+{
+    int64_t trace_start = av_trace_begin();
+    int ret = avcodec_receive_packet(ost->enc_ctx, pkt);
+    av_trace_end(trace_start, AV_TRACE_STAGE_ENCODE, ost->enc_ctx->codec->name, ost->index);
+    return ret;
+}
+
 static void do_audio_out(OutputFile *of, OutputStream *ost,
                          AVFrame *frame)
 {
@@ -1027,13 +1104,13 @@ static void do_audio_out(OutputFile *of, OutputStream *ost,
                enc->time_base.num, enc->time_base.den);
     }
 
-    ret = avcodec_send_frame(enc, frame);
+    ret = encode_send_frame(ost, frame);
     if (ret < 0)
         goto error;
 
     while (1) {
         av_packet_unref(pkt);
-        ret = avcodec_receive_packet(enc, pkt);
+        ret = encode_receive_packet(ost, pkt);
         if (ret == AVERROR(EAGAIN))
             break;
         if (ret < 0)
@@ -1370,7 +1447,7 @@ static void do_video_out(OutputFile *of,
 
         ost->frames_encoded++;
 
-        ret = avcodec_send_frame(enc, in_picture);
+        ret = encode_send_frame(ost, in_picture);
         if (ret < 0)
             goto error;
         // Make sure Closed Captions will not be duplicated
@@ -1378,7 +1455,7 @@ static void do_video_out(OutputFile *of,
 
         while (1) {
             av_packet_unref(pkt);
-            ret = avcodec_receive_packet(enc, pkt);
+            ret = encode_receive_packet(ost, pkt);
             update_benchmark("encode_video %d.%d", ost->file_index, ost->index);
             if (ret == AVERROR(EAGAIN))
                 break;
@@ -1994,8 +2071,8 @@ static void flush_encoders(void)
             update_benchmark(NULL);
 
             av_packet_unref(pkt);
-            while ((ret = avcodec_receive_packet(enc, pkt)) == AVERROR(EAGAIN)) {
-                ret = avcodec_send_frame(enc, NULL);
+            while ((ret = encode_receive_packet(ost, pkt)) == AVERROR(EAGAIN)) {
+                ret = encode_send_frame(ost, NULL);
                 if (ret < 0) {
                     av_log(NULL, AV_LOG_FATAL, "%s encoding failed: %s\n",
                            desc,
@@ -2339,6 +2416,7 @@ static int decode_audio(InputStream *ist, AVPacket *pkt, int *got_output,
     AVCodecContext *avctx = ist->dec_ctx;
     int ret, err = 0;
     AVRational decoded_frame_tb;
+    int64_t trace_start;
 
     if (!ist->decoded_frame && !(ist->decoded_frame = av_frame_alloc()))
         return AVERROR(ENOMEM);
@@ -2347,7 +2425,9 @@ static int decode_audio(InputStream *ist, AVPacket *pkt, int *got_output,
     decoded_frame = ist->decoded_frame;
 
     update_benchmark(NULL);
+    trace_start = av_trace_begin();
     ret = decode(avctx, decoded_frame, got_output, pkt);
+    av_trace_end(trace_start, AV_TRACE_STAGE_DECODE, avctx->codec->name, ist->st->index);
     update_benchmark("decode_audio %d.%d", ist->file_index, ist->st->index);
     if (ret < 0)
         *decode_failed = 1;
@@ -2401,6 +2481,7 @@ static int decode_video(InputStream *ist, AVPacket *pkt, int *got_output, int64_
     int i, ret = 0, err = 0;
     int64_t best_effort_timestamp;
     int64_t dts = AV_NOPTS_VALUE;
+    int64_t trace_start;
 
     // With fate-indeo3-2, we're getting 0-sized packets before EOF for some
     // reason. This seems like a semi-critical bug. Don't trigger EOF, and
@@ -2430,7 +2511,9 @@ static int decode_video(InputStream *ist, AVPacket *pkt, int *got_output, int64_
     }
 
     update_benchmark(NULL);
+    trace_start = av_trace_begin();
     ret = decode(ist->dec_ctx, decoded_frame, got_output, pkt);
+    av_trace_end(trace_start, AV_TRACE_STAGE_DECODE, ist->dec_ctx->codec->name, ist->st->index);
     update_benchmark("decode_video %d.%d", ist->file_index, ist->st->index);
     if (ret < 0)
         *decode_failed = 1;
@@ -4105,6 +4188,15 @@ static int check_keyboard_interaction(int64_t cur_time)
     return 0;
 }
 
+static int read_frame(InputFile *f, AVPacket *pkt)
+{
+    int64_t trace_start = av_trace_begin();
+    int ret = av_read_frame(f->ctx, pkt);
+    av_trace_end(trace_start, AV_TRACE_STAGE_DEMUX, f->ctx->iformat->name,
+                 ret < 0 ? -1 : pkt->stream_index);
+    return ret;
+}
+
 #if HAVE_THREADS
 static void *input_thread(void *arg)
 {
@@ -4114,7 +4206,7 @@ static void *input_thread(void *arg)
     int ret = 0;
 
     while (1) {
-        ret = av_read_frame(f->ctx, pkt);
+        ret = read_frame(f, pkt);
 
         if (ret == AVERROR(EAGAIN)) {
             av_usleep(10000);
@@ -4251,7 +4343,7 @@ static int get_input_packet(InputFile *f, AVPacket **pkt)
         return get_input_packet_mt(f, pkt);
 #endif
     *pkt = f->pkt;
-    return av_read_frame(f->ctx, *pkt);
+    return read_frame(f, *pkt);
 }
 
 static int got_eagain(void)
@@ -604,6 +604,7 @@ extern int        nb_filtergraphs;
 
 extern char *vstats_filename;
 extern char *sdp_filename;
+extern char *trace_filename;
 
 extern float audio_drift_threshold;
 extern float dts_delta_threshold;
@@ -615,6 +616,7 @@ extern int video_sync_method;
 extern float frame_drop_threshold;
 extern int do_benchmark;
 extern int do_benchmark_all;
+extern int do_filter_stats;
 extern int do_deinterlace;
 extern int do_hex_dump;
 extern int do_pkt_dump;
@@ -634,6 +636,7 @@ extern float max_error_rate;
 extern char *videotoolbox_pixfmt;
 
 extern int filter_nbthreads;
+extern int filter_audio_batch;
 extern int filter_complex_nbthreads;
 extern int vstats_version;
 extern int auto_conversion_filters;
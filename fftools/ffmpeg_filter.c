@@ -962,6 +962,8 @@ int configure_filtergraph(FilterGraph *fg)
     cleanup_filtergraph(fg);
     if (!(fg->graph = avfilter_graph_alloc()))
         return AVERROR(ENOMEM);
+    fg->graph->collect_stats = do_filter_stats;
+    fg->graph->audio_batch_samples = filter_audio_batch;
 
     if (simple) {
         OutputStream *ost = fg->outputs[0]->ost;
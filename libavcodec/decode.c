@@ -1309,10 +1309,9 @@ static int update_frame_pool(AVCodecContext *avctx, AVFrame *frame)
                     ret = AVERROR(EINVAL);
                     goto fail;
                 }
-                pool->pools[i] = av_buffer_pool_init(size[i] + 16 + STRIDE_ALIGN - 1,
-                                                     CONFIG_MEMORY_POISONING ?
-                                                        NULL :
-                                                        av_buffer_allocz);
+                pool->pools[i] = CONFIG_MEMORY_POISONING ?
+                    av_buffer_pool_init(size[i] + 16 + STRIDE_ALIGN - 1, NULL) :
+                    av_buffer_pool_init_frame(size[i] + 16 + STRIDE_ALIGN - 1);
                 if (!pool->pools[i]) {
                     ret = AVERROR(ENOMEM);
                     goto fail;
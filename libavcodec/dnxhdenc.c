@@ -114,55 +114,43 @@ void dnxhd_10bit_get_pixels_8x4_sym(int16_t *av_restrict block,
     memcpy(block + 4 * 8, pixels + 3 * line_size, 8 * sizeof(*block));
 }
 
-static int dnxhd_10bit_dct_quantize_444(MpegEncContext *ctx, int16_t *block,
-                                        int n, int qscale, int *overflow)
+static int dnxhd_10bit_quantize_c(int16_t *block, const int *qmat, int bias,
+                                  int shift, const int16_t *scan_pos, int *max)
 {
-    int i, j, level, last_non_zero, start_i;
-    const int *qmat;
-    const uint8_t *scantable= ctx->intra_scantable.scantable;
-    int bias;
-    int max = 0;
-    unsigned int threshold1, threshold2;
-
-    ctx->fdsp.fdct(block);
+    int i, last_non_zero = 0, levels = 0;
 
-    block[0] = (block[0] + 2) >> 2;
-    start_i = 1;
-    last_non_zero = 0;
-    qmat = n < 4 ? ctx->q_intra_matrix[qscale] : ctx->q_chroma_intra_matrix[qscale];
-    bias= ctx->intra_quant_bias * (1 << (16 - 8));
-    threshold1 = (1 << 16) - bias - 1;
-    threshold2 = (threshold1 << 1);
+    for (i = 0; i < 64; i++) {
+        int sign  = FF_SIGNBIT(block[i]);
+        int level = (((block[i] ^ sign) - sign) * qmat[i] + bias) >> shift;
 
-    for (i = 63; i >= start_i; i--) {
-        j = scantable[i];
-        level = block[j] * qmat[j];
-
-        if (((unsigned)(level + threshold1)) > threshold2) {
-            last_non_zero = i;
-            break;
-        } else{
-            block[j]=0;
+        block[i] = (level ^ sign) - sign;
+        if (level) {
+            levels       |= level;
+            last_non_zero = FFMAX(last_non_zero, scan_pos[i]);
         }
     }
+    *max = levels;
 
-    for (i = start_i; i <= last_non_zero; i++) {
-        j = scantable[i];
-        level = block[j] * qmat[j];
-
-        if (((unsigned)(level + threshold1)) > threshold2) {
-            if (level > 0) {
-                level = (bias + level) >> 16;
-                block[j] = level;
-            } else{
-                level = (bias - level) >> 16;
-                block[j] = -level;
-            }
-            max |= level;
-        } else {
-            block[j] = 0;
-        }
-    }
+    return last_non_zero;
+}
+
+static int dnxhd_10bit_dct_quantize_444(MpegEncContext *ctx, int16_t *block,
+                                        int n, int qscale, int *overflow)
+{
+    const DNXHDEncContext *dctx = ctx->avctx->priv_data;
+    const uint8_t *scantable = ctx->intra_scantable.scantable;
+    const int *qmat = n < 4 ? ctx->q_intra_matrix[qscale] : ctx->q_chroma_intra_matrix[qscale];
+    int dc, last_non_zero, max;
+
+    ctx->fdsp.fdct(block);
+
+    /* |level| only survives the (1 << 16) - bias - 1 threshold when adding
+     * the bias carries into bit 16, so this is a plain biased quantizer. */
+    dc = (block[0] + 2) >> 2;
+    last_non_zero = dctx->quantize_10bit(block, qmat,
+                                         ctx->intra_quant_bias * (1 << (16 - 8)),
+                                         16, dctx->scan_pos, &max);
+    block[0] = dc;
     *overflow = ctx->max_qcoeff < max; //overflow might have happened
 
     /* we need this permutation so that we correct the IDCT, we only permute the !=0 elements */
@@ -176,25 +164,18 @@ static int dnxhd_10bit_dct_quantize_444(MpegEncContext *ctx, int16_t *block,
 static int dnxhd_10bit_dct_quantize(MpegEncContext *ctx, int16_t *block,
                                     int n, int qscale, int *overflow)
 {
+    const DNXHDEncContext *dctx = ctx->avctx->priv_data;
     const uint8_t *scantable= ctx->intra_scantable.scantable;
     const int *qmat = n<4 ? ctx->q_intra_matrix[qscale] : ctx->q_chroma_intra_matrix[qscale];
-    int last_non_zero = 0;
-    int i;
+    int dc, last_non_zero, max;
 
     ctx->fdsp.fdct(block);
 
     // Divide by 4 with rounding, to compensate scaling of DCT coefficients
-    block[0] = (block[0] + 2) >> 2;
-
-    for (i = 1; i < 64; ++i) {
-        int j = scantable[i];
-        int sign = FF_SIGNBIT(block[j]);
-        int level = (block[j] ^ sign) - sign;
-        level = level * qmat[j] >> DNX10BIT_QMAT_SHIFT;
-        block[j] = (level ^ sign) - sign;
-        if (level)
-            last_non_zero = i;
-    }
+    dc = (block[0] + 2) >> 2;
+    last_non_zero = dctx->quantize_10bit(block, qmat, 0, DNX10BIT_QMAT_SHIFT,
+                                         dctx->scan_pos, &max);
+    block[0] = dc;
 
     /* we need this permutation so that we correct the IDCT, we only permute the !=0 elements */
     if (ctx->idsp.perm_type != FF_IDCT_PERM_NONE)
@@ -204,6 +185,14 @@ static int dnxhd_10bit_dct_quantize(MpegEncContext *ctx, int16_t *block,
     return last_non_zero;
 }
 
+av_cold void ff_dnxhdenc_init(DNXHDEncContext *ctx)
+{
+    ctx->quantize_10bit = dnxhd_10bit_quantize_c;
+
+    if (ARCH_X86)
+        ff_dnxhdenc_init_x86(ctx);
+}
+
 static av_cold int dnxhd_init_vlc(DNXHDEncContext *ctx)
 {
     int i, j, level, run;
@@ -447,8 +436,10 @@ static av_cold int dnxhd_encode_init(AVCodecContext *avctx)
         ctx->block_width_l2     = 3;
     }
 
-    if (ARCH_X86)
-        ff_dnxhdenc_init_x86(ctx);
+    for (i = 0; i < 64; i++)
+        ctx->scan_pos[ctx->m.intra_scantable.scantable[i]] = i;
+
+    ff_dnxhdenc_init(ctx);
 
     ctx->m.mb_height = (avctx->height + 15) / 16;
     ctx->m.mb_width  = (avctx->width  + 15) / 16;
@@ -1370,5 +1361,6 @@ const AVCodec ff_dnxhd_encoder = {
     .priv_class     = &dnxhd_class,
     .defaults       = dnxhd_defaults,
     .profiles       = NULL_IF_CONFIG_SMALL(ff_dnxhd_profiles),
-    .caps_internal  = FF_CODEC_CAP_INIT_THREADSAFE | FF_CODEC_CAP_INIT_CLEANUP,
+    .caps_internal  = FF_CODEC_CAP_INIT_THREADSAFE | FF_CODEC_CAP_INIT_CLEANUP |
+                      FF_CODEC_CAP_SLICE_THREAD_SHARED,
 };
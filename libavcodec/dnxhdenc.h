@@ -79,6 +79,7 @@ typedef struct DNXHDEncContext {
     DECLARE_ALIGNED(32, int16_t, blocks)[12][64];
     DECLARE_ALIGNED(16, uint8_t, edge_buf_y)[512]; // has to hold 16x16 uint16 when depth=10
     DECLARE_ALIGNED(16, uint8_t, edge_buf_uv)[2][512]; // has to hold 16x16 uint16_t when depth=10
+    DECLARE_ALIGNED(32, int16_t, scan_pos)[64]; ///< position of each coefficient in the intra scan
 
     int      (*qmatrix_c)     [64];
     int      (*qmatrix_l)     [64];
@@ -109,8 +110,17 @@ typedef struct DNXHDEncContext {
 
     void (*get_pixels_8x4_sym)(int16_t *av_restrict /* align 16 */ block,
                                const uint8_t *pixels, ptrdiff_t line_size);
+    /**
+     * Quantize a 10-bit block in natural order to
+     * sign(x) * ((|x| * qmat + bias) >> shift), with 0 <= bias < (1 << shift).
+     * @param max  set to the OR of all quantized magnitudes
+     * @return the highest scan_pos of a nonzero level, 0 if there is none
+     */
+    int (*quantize_10bit)(int16_t *block, const int *qmat, int bias, int shift,
+                          const int16_t *scan_pos, int *max);
 } DNXHDEncContext;
 
+void ff_dnxhdenc_init(DNXHDEncContext *ctx);
 void ff_dnxhdenc_init_x86(DNXHDEncContext *ctx);
 
 #endif /* AVCODEC_DNXHDENC_H */
@@ -83,6 +83,11 @@
  * internal logic derive them from AVCodecInternal.last_pkt_props.
  */
 #define FF_CODEC_CAP_SETS_FRAME_PROPS       (1 << 8)
+/**
+ * Slice threaded jobs of the codec only wait for jobs with a lower number,
+ * so they can run on the worker pool shared with other contexts.
+ */
+#define FF_CODEC_CAP_SLICE_THREAD_SHARED    (1 << 9)
 
 /**
  * AVCodec.codec_tags termination value
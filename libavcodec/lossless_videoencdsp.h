@@ -38,6 +38,19 @@ typedef struct LLVidEncDSPContext {
 
     void (*sub_left_predict)(uint8_t *dst, uint8_t *src,
                           ptrdiff_t stride, ptrdiff_t width, int height);
+
+    /**
+     * Subtract PNG's Paeth prediction.
+     * Reads src[-bpp] and top[-bpp]; w must be a positive multiple of 16.
+     */
+    void (*sub_paeth_pred)(uint8_t *dst, const uint8_t *src,
+                           const uint8_t *top, intptr_t w, int bpp);
+
+    /**
+     * Sum of the absolute values of w signed bytes, as used for picking
+     * filters; w must be a positive multiple of 32.
+     */
+    int (*sum_abs_s8)(const uint8_t *src, intptr_t w);
 } LLVidEncDSPContext;
 
 void ff_llvidencdsp_init(LLVidEncDSPContext *c);
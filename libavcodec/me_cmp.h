@@ -50,6 +50,12 @@ typedef int (*me_cmp_func)(struct MpegEncContext *c,
                            uint8_t *blk2 /* align 1 */, ptrdiff_t stride,
                            int h);
 
+/* Compute the SAD of one block against four candidate reference blocks
+ * sharing the same stride, as used when scanning a search window.
+ * The width is 16 for sad_x4[0] and 8 for sad_x4[1], h is as above. */
+typedef void (*me_cmp_x4_func)(uint8_t *blk1, uint8_t *const blk2[4],
+                               ptrdiff_t stride, int h, int scores[4]);
+
 typedef struct MECmpContext {
     int (*sum_abs_dctelem)(int16_t *block /* align 16 */);
 
@@ -77,6 +83,8 @@ typedef struct MECmpContext {
 
     me_cmp_func pix_abs[2][4];
     me_cmp_func median_sad[6];
+
+    me_cmp_x4_func sad_x4[2];
 } MECmpContext;
 
 void ff_me_cmp_init(MECmpContext *c, AVCodecContext *avctx);
@@ -1594,6 +1594,27 @@ void ff_estimate_b_frame_motion(MpegEncContext * s,
     s->mb_type[mb_y*s->mb_stride + mb_x]= type;
 }
 
+void ff_estimate_b_frame_motion_init_row(MpegEncContext *s, int mb_y)
+{
+    MotionEstContext * const c= &s->me;
+    int x, y;
+
+    /* The penalty factors are read before they are recomputed for the
+     * current picture, so they come from the last macroblock that did
+     * not take the direct skip path. */
+    for (y = 0; y < mb_y; y++) {
+        for (x = 0; x < s->mb_width; x++) {
+            if (s->codec_id != AV_CODEC_ID_MPEG4 ||
+                !s->next_picture.mbskip_table[y * s->mb_stride + x]) {
+                c->penalty_factor    = get_penalty_factor(s->lambda, s->lambda2, c->avctx->me_cmp);
+                c->sub_penalty_factor= get_penalty_factor(s->lambda, s->lambda2, c->avctx->me_sub_cmp);
+                c->mb_penalty_factor = get_penalty_factor(s->lambda, s->lambda2, c->avctx->mb_cmp);
+                return;
+            }
+        }
+    }
+}
+
 /* find best f_code for ME which do unlimited searches */
 int ff_get_best_fcode(MpegEncContext * s, int16_t (*mv_table)[2], int type)
 {
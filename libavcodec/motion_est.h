@@ -113,6 +113,13 @@ int ff_init_me(struct MpegEncContext *s);
 void ff_estimate_p_frame_motion(struct MpegEncContext *s, int mb_x, int mb_y);
 void ff_estimate_b_frame_motion(struct MpegEncContext *s, int mb_x, int mb_y);
 
+/**
+ * Prepare a context for B-frame motion estimation starting at the first
+ * macroblock of row mb_y while the rows above are still being searched,
+ * so that it holds the state a raster scan would have left behind.
+ */
+void ff_estimate_b_frame_motion_init_row(struct MpegEncContext *s, int mb_y);
+
 int ff_pre_estimate_p_frame_motion(struct MpegEncContext *s,
                                    int mb_x, int mb_y);
 
@@ -375,6 +375,19 @@ static int qpel_motion_search(MpegEncContext * s,
     }\
 }
 
+#define CHECK_MV_SCORE(x,y,score)\
+{\
+    const unsigned key = ((unsigned)(y)<<ME_MAP_MV_BITS) + (x) + map_generation;\
+    const int index= (((unsigned)(y)<<ME_MAP_SHIFT) + (x))&(ME_MAP_SIZE-1);\
+    if(map[index]!=key){\
+        d= score;\
+        map[index]= key;\
+        score_map[index]= d;\
+        d += (mv_penalty[((x)*(1<<shift))-pred_x] + mv_penalty[((y)*(1<<shift))-pred_y])*penalty_factor;\
+        COPY3_IF_LT(dmin, d, best[0], x, best[1], y)\
+    }\
+}
+
 #define CHECK_CLIPPED_MV(ax,ay)\
 {\
     const int Lx= ax;\
@@ -630,9 +643,37 @@ static int full_search(MpegEncContext * s, int *best, int dmin,
     cmpf        = s->mecc.me_cmp[size];
     chroma_cmpf = s->mecc.me_cmp[size + 1];
 
-    for(y=FFMAX(-dia_size, ymin); y<=FFMIN(dia_size,ymax); y++){
-        for(x=FFMAX(-dia_size, xmin); x<=FFMIN(dia_size,xmax); x++){
-            CHECK_MV(x, y);
+    if (!(flags & (FLAG_CHROMA | FLAG_DIRECT)) && size < 2 &&
+        cmpf == s->mecc.sad[size]) {
+        /* luma-only SAD, score four horizontal neighbours per call */
+        const me_cmp_x4_func sad_x4 = s->mecc.sad_x4[size];
+        uint8_t *const src = c->src[src_index][0];
+        uint8_t *const ref = c->ref[ref_index][0];
+        const int stride   = c->stride;
+
+        for(y=FFMAX(-dia_size, ymin); y<=FFMIN(dia_size,ymax); y++){
+            for(x=FFMAX(-dia_size, xmin); x+3<=FFMIN(dia_size,xmax); x+=4){
+                uint8_t *const cand[4] = {
+                    ref + x + y*stride,     ref + x + 1 + y*stride,
+                    ref + x + 2 + y*stride, ref + x + 3 + y*stride,
+                };
+                int scores[4];
+
+                sad_x4(src, cand, stride, h, scores);
+                CHECK_MV_SCORE(x    , y, scores[0]);
+                CHECK_MV_SCORE(x + 1, y, scores[1]);
+                CHECK_MV_SCORE(x + 2, y, scores[2]);
+                CHECK_MV_SCORE(x + 3, y, scores[3]);
+            }
+            for(; x<=FFMIN(dia_size,xmax); x++){
+                CHECK_MV(x, y);
+            }
+        }
+    } else {
+        for(y=FFMAX(-dia_size, ymin); y<=FFMIN(dia_size,ymax); y++){
+            for(x=FFMAX(-dia_size, xmin); x<=FFMIN(dia_size,xmax); x++){
+                CHECK_MV(x, y);
+            }
         }
     }
 
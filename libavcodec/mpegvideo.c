@@ -414,16 +414,23 @@ static int init_duplicate_context(MpegEncContext *s)
 static int init_duplicate_contexts(MpegEncContext *s)
 {
     int nb_slices = s->slice_context_count, ret;
+    int nb_contexts = FFMAX(nb_slices, s->me_context_count);
 
     /* We initialize the copies before the original so that
      * fields allocated in init_duplicate_context are NULL after
-     * copying. This prevents double-frees upon allocation error. */
-    for (int i = 1; i < nb_slices; i++) {
+     * copying. This prevents double-frees upon allocation error.
+     * Contexts beyond nb_slices are only used for motion estimation. */
+    for (int i = 1; i < nb_contexts; i++) {
         s->thread_context[i] = av_memdup(s, sizeof(MpegEncContext));
         if (!s->thread_context[i])
             return AVERROR(ENOMEM);
         if ((ret = init_duplicate_context(s->thread_context[i])) < 0)
             return ret;
+        if (i >= nb_slices) {
+            s->thread_context[i]->start_mb_y = 0;
+            s->thread_context[i]->end_mb_y   = s->mb_height;
+            continue;
+        }
         s->thread_context[i]->start_mb_y =
             (s->mb_height * (i    ) + nb_slices / 2) / nb_slices;
         s->thread_context[i]->end_mb_y   =
@@ -459,7 +466,7 @@ static void free_duplicate_context(MpegEncContext *s)
 
 static void free_duplicate_contexts(MpegEncContext *s)
 {
-    for (int i = 1; i < s->slice_context_count; i++) {
+    for (int i = 1; i < FFMAX(s->slice_context_count, s->me_context_count); i++) {
         free_duplicate_context(s->thread_context[i]);
         av_freep(&s->thread_context[i]);
     }
@@ -981,6 +988,14 @@ av_cold int ff_mpv_common_init(MpegEncContext *s)
     s->thread_context[0]   = s;
     s->slice_context_count = nb_slices;
 
+    /* Let motion estimation use all slice threads even when the picture
+     * is coded as a single slice, by scanning MB rows as a wavefront. */
+    if (s->encoding && HAVE_THREADS && nb_slices == 1 &&
+        s->avctx->active_thread_type & FF_THREAD_SLICE &&
+        s->avctx->thread_count > 1 && s->avctx->thread_count <= MAX_THREADS &&
+        s->mb_height > 1)
+        s->me_context_count = FFMIN(s->avctx->thread_count, s->mb_height);
+
 //     if (s->width && s->height) {
     ret = init_duplicate_contexts(s);
     if (ret < 0)
@@ -1118,6 +1133,7 @@ void ff_mpv_common_end(MpegEncContext *s)
     free_context_frame(s);
     if (s->slice_context_count > 1)
         s->slice_context_count = 1;
+    s->me_context_count = 0;
 
     av_freep(&s->parse_context.buffer);
     s->parse_context.buffer_size = 0;
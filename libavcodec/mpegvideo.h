@@ -154,6 +154,7 @@ typedef struct MpegEncContext {
     int end_mb_y;              ///< end   mb_y of this thread (so current thread should process start_mb_y <= row < end_mb_y)
     struct MpegEncContext *thread_context[MAX_THREADS];
     int slice_context_count;   ///< number of used thread_contexts
+    int me_context_count;      ///< number of thread_contexts used for row-wavefront motion estimation, 0 if disabled
 
     /**
      * copy of the previous picture structure.
@@ -836,6 +836,10 @@ av_cold int ff_mpv_encode_init(AVCodecContext *avctx)
     if ((ret = ff_mpv_common_init(s)) < 0)
         return ret;
 
+    if (s->me_context_count &&
+        (ret = ff_alloc_entries(avctx, s->mb_height)) < 0)
+        return ret;
+
     ff_fdctdsp_init(&s->fdsp, avctx);
     ff_me_cmp_init(&s->mecc, avctx);
     ff_mpegvideoencdsp_init(&s->mpvencdsp, avctx);
@@ -1251,24 +1255,120 @@ static int encode_frame(AVCodecContext *c, AVFrame *frame, AVPacket *pkt)
     return size;
 }
 
-static int estimate_best_b_count(MpegEncContext *s)
+typedef struct BCountCandidate {
+    int b_count;
+    int p_lambda, b_lambda, lambda2;
+    int64_t rd;
+} BCountCandidate;
+
+/**
+ * Encode the downscaled input pictures with one P-frame every b_count + 1
+ * pictures and store the resulting rate-distortion score.
+ * Candidates are independent of each other, so they can run in parallel.
+ */
+static int estimate_b_count_candidate(AVCodecContext *avctx, void *arg)
 {
-    const AVCodec *codec = avcodec_find_encoder(s->avctx->codec_id);
+    MpegEncContext *s = avctx->priv_data;
+    BCountCandidate *cand = arg;
+    const AVCodec *codec = avcodec_find_encoder(avctx->codec_id);
+    AVCodecContext *c;
+    AVFrame *frame;
     AVPacket *pkt;
+    int i, out_size, ret;
+    int64_t rd = 0;
+
+    c     = avcodec_alloc_context3(NULL);
+    frame = av_frame_alloc();
+    pkt   = av_packet_alloc();
+    if (!c || !frame || !pkt) {
+        ret = AVERROR(ENOMEM);
+        goto fail;
+    }
+
+    c->width        = s->width  >> s->brd_scale;
+    c->height       = s->height >> s->brd_scale;
+    c->flags        = AV_CODEC_FLAG_QSCALE | AV_CODEC_FLAG_PSNR;
+    c->flags       |= avctx->flags & AV_CODEC_FLAG_QPEL;
+    c->mb_decision  = avctx->mb_decision;
+    c->me_cmp       = avctx->me_cmp;
+    c->mb_cmp       = avctx->mb_cmp;
+    c->me_sub_cmp   = avctx->me_sub_cmp;
+    c->pix_fmt      = AV_PIX_FMT_YUV420P;
+    c->time_base    = avctx->time_base;
+    c->max_b_frames = s->max_b_frames;
+
+    ret = avcodec_open2(c, codec, NULL);
+    if (ret < 0)
+        goto fail;
+
+    /* The shrunk pictures are shared by all candidates, so only
+     * per-candidate references carry the forced picture type. */
+    if ((ret = av_frame_ref(frame, s->tmp_frames[0])) < 0)
+        goto fail;
+    frame->pict_type = AV_PICTURE_TYPE_I;
+    frame->quality   = 1 * FF_QP2LAMBDA;
+
+    out_size = encode_frame(c, frame, pkt);
+    av_frame_unref(frame);
+    if (out_size < 0) {
+        ret = out_size;
+        goto fail;
+    }
+
+    //rd += (out_size * lambda2) >> FF_LAMBDA_SHIFT;
+
+    for (i = 0; i < s->max_b_frames + 1; i++) {
+        int is_p = i % (cand->b_count + 1) == cand->b_count || i == s->max_b_frames;
+
+        if ((ret = av_frame_ref(frame, s->tmp_frames[i + 1])) < 0)
+            goto fail;
+        frame->pict_type = is_p ?
+                           AV_PICTURE_TYPE_P : AV_PICTURE_TYPE_B;
+        frame->quality   = is_p ? cand->p_lambda : cand->b_lambda;
+
+        out_size = encode_frame(c, frame, pkt);
+        av_frame_unref(frame);
+        if (out_size < 0) {
+            ret = out_size;
+            goto fail;
+        }
+
+        rd += (out_size * cand->lambda2) >> (FF_LAMBDA_SHIFT - 3);
+    }
+
+    /* get the delayed frames */
+    out_size = encode_frame(c, NULL, pkt);
+    if (out_size < 0) {
+        ret = out_size;
+        goto fail;
+    }
+    rd += (out_size * cand->lambda2) >> (FF_LAMBDA_SHIFT - 3);
+
+    rd += c->error[0] + c->error[1] + c->error[2];
+
+    cand->rd = rd;
+    ret = 0;
+
+fail:
+    avcodec_free_context(&c);
+    av_frame_free(&frame);
+    av_packet_free(&pkt);
+    return ret;
+}
+
+static int estimate_best_b_count(MpegEncContext *s)
+{
+    BCountCandidate cand[MAX_B_FRAMES + 1];
+    int ret[MAX_B_FRAMES + 1];
     const int scale = s->brd_scale;
     int width  = s->width  >> scale;
     int height = s->height >> scale;
-    int i, j, out_size, p_lambda, b_lambda, lambda2;
+    int i, j, nb_candidates, p_lambda, b_lambda, lambda2;
     int64_t best_rd  = INT64_MAX;
     int best_b_count = -1;
-    int ret = 0;
 
     av_assert0(scale >= 0 && scale <= 3);
 
-    pkt = av_packet_alloc();
-    if (!pkt)
-        return AVERROR(ENOMEM);
-
     //emms_c();
     //s->next_picture_ptr->quality;
     p_lambda = s->last_lambda_for[AV_PICTURE_TYPE_P];
@@ -1312,89 +1412,29 @@ static int estimate_best_b_count(MpegEncContext *s)
         }
     }
 
-    for (j = 0; j < s->max_b_frames + 1; j++) {
-        AVCodecContext *c;
-        int64_t rd = 0;
-
-        if (!s->input_picture[j])
+    for (nb_candidates = 0; nb_candidates < s->max_b_frames + 1; nb_candidates++) {
+        if (!s->input_picture[nb_candidates])
             break;
-
-        c = avcodec_alloc_context3(NULL);
-        if (!c) {
-            ret = AVERROR(ENOMEM);
-            goto fail;
-        }
-
-        c->width        = width;
-        c->height       = height;
-        c->flags        = AV_CODEC_FLAG_QSCALE | AV_CODEC_FLAG_PSNR;
-        c->flags       |= s->avctx->flags & AV_CODEC_FLAG_QPEL;
-        c->mb_decision  = s->avctx->mb_decision;
-        c->me_cmp       = s->avctx->me_cmp;
-        c->mb_cmp       = s->avctx->mb_cmp;
-        c->me_sub_cmp   = s->avctx->me_sub_cmp;
-        c->pix_fmt      = AV_PIX_FMT_YUV420P;
-        c->time_base    = s->avctx->time_base;
-        c->max_b_frames = s->max_b_frames;
-
-        ret = avcodec_open2(c, codec, NULL);
-        if (ret < 0)
-            goto fail;
-
-
-        s->tmp_frames[0]->pict_type = AV_PICTURE_TYPE_I;
-        s->tmp_frames[0]->quality   = 1 * FF_QP2LAMBDA;
-
-        out_size = encode_frame(c, s->tmp_frames[0], pkt);
-        if (out_size < 0) {
-            ret = out_size;
-            goto fail;
-        }
-
-        //rd += (out_size * lambda2) >> FF_LAMBDA_SHIFT;
-
-        for (i = 0; i < s->max_b_frames + 1; i++) {
-            int is_p = i % (j + 1) == j || i == s->max_b_frames;
-
-            s->tmp_frames[i + 1]->pict_type = is_p ?
-                                     AV_PICTURE_TYPE_P : AV_PICTURE_TYPE_B;
-            s->tmp_frames[i + 1]->quality   = is_p ? p_lambda : b_lambda;
-
-            out_size = encode_frame(c, s->tmp_frames[i + 1], pkt);
-            if (out_size < 0) {
-                ret = out_size;
-                goto fail;
-            }
-
-            rd += (out_size * lambda2) >> (FF_LAMBDA_SHIFT - 3);
-        }
-
-        /* get the delayed frames */
-        out_size = encode_frame(c, NULL, pkt);
-        if (out_size < 0) {
-            ret = out_size;
-            goto fail;
-        }
-        rd += (out_size * lambda2) >> (FF_LAMBDA_SHIFT - 3);
-
-        rd += c->error[0] + c->error[1] + c->error[2];
-
-        if (rd < best_rd) {
-            best_rd = rd;
+        cand[nb_candidates] = (BCountCandidate) {
+            .b_count  = nb_candidates,
+            .p_lambda = p_lambda,
+            .b_lambda = b_lambda,
+            .lambda2  = lambda2,
+        };
+    }
+
+    s->avctx->execute(s->avctx, estimate_b_count_candidate, cand, ret,
+                      nb_candidates, sizeof(*cand));
+
+    for (j = 0; j < nb_candidates; j++) {
+        if (ret[j] < 0)
+            return ret[j];
+        if (cand[j].rd < best_rd) {
+            best_rd = cand[j].rd;
             best_b_count = j;
         }
-
-fail:
-        avcodec_free_context(&c);
-        av_packet_unref(pkt);
-        if (ret < 0) {
-            best_b_count = ret;
-            break;
-        }
     }
 
-    av_packet_free(&pkt);
-
     return best_b_count;
 }
 
@@ -2652,26 +2692,109 @@ static int estimate_motion_thread(AVCodecContext *c, void *arg){
     return 0;
 }
 
+/**
+ * Distance in MBs the previous row of the motion estimation wavefront must
+ * be ahead, so that every predictor read (left, top, top-right and the
+ * last_predictor_count window) sees the same value as in a raster scan.
+ *
+ * The progress is kept per row in the slice thread entries and each row
+ * reports under the lock of slot row % thread_count, which is the slot the
+ * next row waits on. Jobs are handed out in increasing row order but not to
+ * fixed workers, so neither the wait nor the output depends on which thread
+ * runs a row.
+ */
+static int me_wavefront_lag(MpegEncContext *s)
+{
+    return FFMAX(2, s->avctx->last_predictor_count + 2);
+}
+
+static int pre_estimate_motion_row(AVCodecContext *c, void *arg, int jobnr, int threadnr)
+{
+    MpegEncContext *s = ((MpegEncContext**)arg)[threadnr];
+    const int lag     = me_wavefront_lag(s);
+    const int slot    = jobnr % c->thread_count;
+
+    /* the pre-pass scans bottom-up, so job n depends on the row below */
+    s->mb_y = s->mb_height - 1 - jobnr;
+
+    s->me.pre_pass = 1;
+    s->me.dia_size = s->avctx->pre_dia_size;
+    s->first_slice_line = !jobnr;
+    for (s->mb_x = s->mb_width - 1; s->mb_x >= 0; s->mb_x--) {
+        ff_thread_await_progress2(c, jobnr, slot, lag);
+        ff_pre_estimate_p_frame_motion(s, s->mb_x, s->mb_y);
+        ff_thread_report_progress2(c, jobnr, slot, 1);
+    }
+    ff_thread_report_progress2(c, jobnr, slot, lag);
+    s->me.pre_pass = 0;
+
+    return 0;
+}
+
+static int estimate_motion_row(AVCodecContext *c, void *arg, int jobnr, int threadnr)
+{
+    MpegEncContext *s = ((MpegEncContext**)arg)[threadnr];
+    const int lag     = me_wavefront_lag(s);
+    const int slot    = jobnr % c->thread_count;
+
+    s->mb_y = jobnr;
+
+    s->me.dia_size = s->avctx->dia_size;
+    s->first_slice_line = !jobnr;
+    if (s->pict_type == AV_PICTURE_TYPE_B)
+        ff_estimate_b_frame_motion_init_row(s, s->mb_y);
+    s->mb_x = 0; //for block init below
+    ff_init_block_index(s);
+    for (s->mb_x = 0; s->mb_x < s->mb_width; s->mb_x++) {
+        s->block_index[0] += 2;
+        s->block_index[1] += 2;
+        s->block_index[2] += 2;
+        s->block_index[3] += 2;
+
+        ff_thread_await_progress2(c, jobnr, slot, lag);
+        if (s->pict_type == AV_PICTURE_TYPE_B)
+            ff_estimate_b_frame_motion(s, s->mb_x, s->mb_y);
+        else
+            ff_estimate_p_frame_motion(s, s->mb_x, s->mb_y);
+        ff_thread_report_progress2(c, jobnr, slot, 1);
+    }
+    ff_thread_report_progress2(c, jobnr, slot, lag);
+
+    return 0;
+}
+
+static void mb_var_row(MpegEncContext *s, int mb_y)
+{
+    int mb_x;
+
+    for (mb_x = 0; mb_x < s->mb_width; mb_x++) {
+        int xx = mb_x * 16;
+        int yy = mb_y * 16;
+        uint8_t *pix = s->new_picture.f->data[0] + (yy * s->linesize) + xx;
+        int varc;
+        int sum = s->mpvencdsp.pix_sum(pix, s->linesize);
+
+        varc = (s->mpvencdsp.pix_norm1(pix, s->linesize) -
+                (((unsigned) sum * sum) >> 8) + 500 + 128) >> 8;
+
+        s->current_picture.mb_var [s->mb_stride * mb_y + mb_x] = varc;
+        s->current_picture.mb_mean[s->mb_stride * mb_y + mb_x] = (sum+128)>>8;
+        s->me.mb_var_sum_temp    += varc;
+    }
+}
+
+static int mb_var_row_thread(AVCodecContext *c, void *arg, int jobnr, int threadnr)
+{
+    mb_var_row(((MpegEncContext**)arg)[threadnr], jobnr);
+    return 0;
+}
+
 static int mb_var_thread(AVCodecContext *c, void *arg){
     MpegEncContext *s= *(void**)arg;
-    int mb_x, mb_y;
+    int mb_y;
 
-    for(mb_y=s->start_mb_y; mb_y < s->end_mb_y; mb_y++) {
-        for(mb_x=0; mb_x < s->mb_width; mb_x++) {
-            int xx = mb_x * 16;
-            int yy = mb_y * 16;
-            uint8_t *pix = s->new_picture.f->data[0] + (yy * s->linesize) + xx;
-            int varc;
-            int sum = s->mpvencdsp.pix_sum(pix, s->linesize);
-
-            varc = (s->mpvencdsp.pix_norm1(pix, s->linesize) -
-                    (((unsigned) sum * sum) >> 8) + 500 + 128) >> 8;
-
-            s->current_picture.mb_var [s->mb_stride * mb_y + mb_x] = varc;
-            s->current_picture.mb_mean[s->mb_stride * mb_y + mb_x] = (sum+128)>>8;
-            s->me.mb_var_sum_temp    += varc;
-        }
-    }
+    for(mb_y=s->start_mb_y; mb_y < s->end_mb_y; mb_y++)
+        mb_var_row(s, mb_y);
     return 0;
 }
 
@@ -3508,6 +3631,7 @@ static int encode_picture(MpegEncContext *s, int picture_number)
     int i, ret;
     int bits;
     int context_count = s->slice_context_count;
+    int me_context_count = FFMAX(context_count, s->me_context_count);
 
     s->picture_number = picture_number;
 
@@ -3554,27 +3678,50 @@ static int encode_picture(MpegEncContext *s, int picture_number)
     }
 
     s->mb_intra=0; //for the rate distortion & bit compare functions
-    for(i=1; i<context_count; i++){
+
+    /* Wavefront rows move between contexts, so unlike slices they all
+     * need the motion estimation setup of the current picture. */
+    if (s->me_context_count && ff_init_me(s) < 0)
+        return -1;
+
+    for(i=1; i<me_context_count; i++){
         ret = ff_update_duplicate_context(s->thread_context[i], s);
         if (ret < 0)
             return ret;
     }
 
-    if(ff_init_me(s)<0)
+    if(!s->me_context_count && ff_init_me(s)<0)
         return -1;
 
     /* Estimate motion for every MB */
     if(s->pict_type != AV_PICTURE_TYPE_I){
         s->lambda  = (s->lambda  * s->me_penalty_compensation + 128) >> 8;
         s->lambda2 = (s->lambda2 * (int64_t) s->me_penalty_compensation + 128) >> 8;
+        for (i = 1; i < s->me_context_count; i++) {
+            s->thread_context[i]->lambda  = s->lambda;
+            s->thread_context[i]->lambda2 = s->lambda2;
+        }
         if (s->pict_type != AV_PICTURE_TYPE_B) {
             if ((s->me_pre && s->last_non_b_pict_type == AV_PICTURE_TYPE_I) ||
                 s->me_pre == 2) {
-                s->avctx->execute(s->avctx, pre_estimate_motion_thread, &s->thread_context[0], NULL, context_count, sizeof(void*));
+                if (s->me_context_count) {
+                    ff_reset_entries(s->avctx);
+                    s->avctx->execute2(s->avctx, pre_estimate_motion_row, &s->thread_context[0], NULL, s->mb_height);
+                } else {
+                    s->avctx->execute(s->avctx, pre_estimate_motion_thread, &s->thread_context[0], NULL, context_count, sizeof(void*));
+                }
             }
         }
 
-        s->avctx->execute(s->avctx, estimate_motion_thread, &s->thread_context[0], NULL, context_count, sizeof(void*));
+        if (s->me_context_count) {
+            ff_reset_entries(s->avctx);
+            s->avctx->execute2(s->avctx, estimate_motion_row, &s->thread_context[0], NULL, s->mb_height);
+            /* leave the state for the next picture as a raster scan would */
+            if (s->pict_type == AV_PICTURE_TYPE_B)
+                ff_estimate_b_frame_motion_init_row(s, s->mb_height);
+        } else {
+            s->avctx->execute(s->avctx, estimate_motion_thread, &s->thread_context[0], NULL, context_count, sizeof(void*));
+        }
     }else /* if(s->pict_type == AV_PICTURE_TYPE_I) */{
         /* I-Frame */
         for(i=0; i<s->mb_stride*s->mb_height; i++)
@@ -3582,10 +3729,13 @@ static int encode_picture(MpegEncContext *s, int picture_number)
 
         if(!s->fixed_qscale){
             /* finding spatial complexity for I-frame rate control */
-            s->avctx->execute(s->avctx, mb_var_thread, &s->thread_context[0], NULL, context_count, sizeof(void*));
+            if (s->me_context_count)
+                s->avctx->execute2(s->avctx, mb_var_row_thread, &s->thread_context[0], NULL, s->mb_height);
+            else
+                s->avctx->execute(s->avctx, mb_var_thread, &s->thread_context[0], NULL, context_count, sizeof(void*));
         }
     }
-    for(i=1; i<context_count; i++){
+    for(i=1; i<me_context_count; i++){
         merge_context_after_me(s, s->thread_context[i]);
     }
     s->current_picture.mc_mb_var_sum= s->current_picture_ptr->mc_mb_var_sum= s->me.mc_mb_var_sum_temp;
@@ -38,6 +38,10 @@
 
 #define IOBUF_SIZE 4096
 
+/* amount of filtered image data compressed by one slice thread */
+#define DEFLATE_CHUNK_SIZE  (128 * 1024)
+#define DEFLATE_WINDOW_SIZE (1 << 15)
+
 typedef struct APNGFctlChunk {
     uint32_t sequence_number;
     uint32_t width, height;
@@ -46,6 +50,25 @@ typedef struct APNGFctlChunk {
     uint8_t dispose_op, blend_op;
 } APNGFctlChunk;
 
+typedef struct PNGEncChunk {
+    uint8_t *buf;
+    unsigned size;               ///< compressed size
+    uint32_t adler;              ///< Adler-32 of the uncompressed data
+} PNGEncChunk;
+
+typedef struct PNGEncThreadData {
+    const AVFrame *pict;
+    uint8_t *rows;               ///< filtered rows, each prefixed by its filter type
+    uint8_t *crow_base;          ///< per-thread filter scratch buffers
+    int crow_size;
+    int row_size;
+    int nb_filter_jobs;
+    int chunk_rows;
+    int nb_chunks;
+    unsigned chunk_capacity;
+    PNGEncChunk *chunks;
+} PNGEncThreadData;
+
 typedef struct PNGEncContext {
     AVClass *class;
     LLVidEncDSPContext llvidencdsp;
@@ -58,6 +81,12 @@ typedef struct PNGEncContext {
 
     z_stream zstream;
     uint8_t buf[IOBUF_SIZE];
+
+    int chunked_deflate;         ///< compress the image in independent chunks
+    z_stream *thread_zstream;    ///< raw deflate streams, one per slice thread
+    int nb_thread_zstreams;
+    int zlib_header;             ///< zlib stream header matching the compression level
+
     int dpi;                     ///< Physical pixel density, in dots per inch, if set
     int dpm;                     ///< Physical pixel density, in dots per meter, if set
 
@@ -119,11 +148,14 @@ static void png_get_interlaced_row(uint8_t *dst, int row_size,
     }
 }
 
-static void sub_png_paeth_prediction(uint8_t *dst, uint8_t *src, uint8_t *top,
-                                     int w, int bpp)
+static void sub_png_paeth_prediction(PNGEncContext *c, uint8_t *dst, uint8_t *src,
+                                     uint8_t *top, int w, int bpp)
 {
-    int i;
-    for (i = 0; i < w; i++) {
+    int i = w & ~15;
+
+    if (i)
+        c->llvidencdsp.sub_paeth_pred(dst, src, top, i, bpp);
+    for (; i < w; i++) {
         int a, b, c, p, pa, pb, pc;
 
         a = src[i - bpp];
@@ -187,11 +219,20 @@ static void png_filter_row(PNGEncContext *c, uint8_t *dst, int filter_type,
     case PNG_FILTER_VALUE_PAETH:
         for (i = 0; i < bpp; i++)
             dst[i] = src[i] - top[i];
-        sub_png_paeth_prediction(dst + i, src + i, top + i, size - i, bpp);
+        sub_png_paeth_prediction(c, dst + i, src + i, top + i, size - i, bpp);
         break;
     }
 }
 
+static int png_filter_cost(PNGEncContext *s, const uint8_t *buf, int size)
+{
+    int i = size & ~31, cost = i ? s->llvidencdsp.sum_abs_s8(buf, i) : 0;
+
+    for (; i < size; i++)
+        cost += abs((int8_t) buf[i]);
+    return cost;
+}
+
 static uint8_t *png_choose_filter(PNGEncContext *s, uint8_t *dst,
                                   uint8_t *src, uint8_t *top, int size, int bpp)
 {
@@ -200,15 +241,12 @@ static uint8_t *png_choose_filter(PNGEncContext *s, uint8_t *dst,
     if (!top && pred)
         pred = PNG_FILTER_VALUE_SUB;
     if (pred == PNG_FILTER_VALUE_MIXED) {
-        int i;
         int cost, bcost = INT_MAX;
         uint8_t *buf1 = dst, *buf2 = dst + size + 16;
         for (pred = 0; pred < 5; pred++) {
             png_filter_row(s, buf1 + 1, pred, src, top, size, bpp);
             buf1[0] = pred;
-            cost = 0;
-            for (i = 0; i <= size; i++)
-                cost += abs((int8_t) buf1[i]);
+            cost = png_filter_cost(s, buf1, size + 1);
             if (cost < bcost) {
                 bcost = cost;
                 FFSWAP(uint8_t *, buf1, buf2);
@@ -429,6 +467,161 @@ static int encode_headers(AVCodecContext *avctx, const AVFrame *pict)
     return 0;
 }
 
+static int filter_rows_thread(AVCodecContext *avctx, void *arg,
+                              int jobnr, int threadnr)
+{
+    PNGEncContext *s     = avctx->priv_data;
+    PNGEncThreadData *td = arg;
+    const AVFrame *p     = td->pict;
+    const int stride     = td->row_size + 1;
+    const int y_start    = p->height *  jobnr      / td->nb_filter_jobs;
+    const int y_end      = p->height * (jobnr + 1) / td->nb_filter_jobs;
+    uint8_t *crow_buf    = td->crow_base + threadnr * td->crow_size + 15;
+    int y;
+
+    for (y = y_start; y < y_end; y++) {
+        uint8_t *ptr  = p->data[0] + y * p->linesize[0];
+        uint8_t *top  = y ? ptr - p->linesize[0] : NULL;
+        uint8_t *crow = png_choose_filter(s, crow_buf, ptr, top,
+                                          td->row_size, s->bits_per_pixel >> 3);
+        memcpy(td->rows + (size_t)y * stride, crow, stride);
+    }
+
+    return 0;
+}
+
+static int deflate_chunk_thread(AVCodecContext *avctx, void *arg,
+                                int jobnr, int threadnr)
+{
+    PNGEncContext *s     = avctx->priv_data;
+    PNGEncThreadData *td = arg;
+    PNGEncChunk *chunk   = &td->chunks[jobnr];
+    z_stream *zstream    = &s->thread_zstream[threadnr];
+    const size_t stride  = td->row_size + 1;
+    const int y          = jobnr * td->chunk_rows;
+    const int last       = jobnr == td->nb_chunks - 1;
+    const uint8_t *in    = td->rows + y * stride;
+    unsigned len         = FFMIN(td->chunk_rows, td->pict->height - y) * stride;
+    int ret;
+
+    deflateReset(zstream);
+    /* Prime the window with the end of the previous chunk, so matches
+     * across the chunk boundary are still found. */
+    if (jobnr) {
+        unsigned dict_size = FFMIN(in - td->rows, DEFLATE_WINDOW_SIZE);
+        if (deflateSetDictionary(zstream, in - dict_size, dict_size) != Z_OK)
+            return AVERROR_EXTERNAL;
+    }
+
+    zstream->next_in   = in;
+    zstream->avail_in  = len;
+    zstream->next_out  = chunk->buf;
+    zstream->avail_out = td->chunk_capacity;
+    /* All but the last chunk end byte-aligned on a sync flush without
+     * setting BFINAL, so the chunks can simply be concatenated. */
+    ret = deflate(zstream, last ? Z_FINISH : Z_SYNC_FLUSH);
+    if (last ? ret != Z_STREAM_END : (ret != Z_OK || !zstream->avail_out))
+        return AVERROR_EXTERNAL;
+
+    chunk->size  = td->chunk_capacity - zstream->avail_out;
+    chunk->adler = adler32(1, in, len);
+
+    return 0;
+}
+
+static int png_write_idat_buffered(AVCodecContext *avctx, int *fill,
+                                   const uint8_t *data, unsigned size, int flush)
+{
+    PNGEncContext *s = avctx->priv_data;
+
+    while (size || (flush && *fill)) {
+        int len = FFMIN(size, IOBUF_SIZE - *fill);
+
+        memcpy(s->buf + *fill, data, len);
+        *fill += len;
+        data  += len;
+        size  -= len;
+        if (*fill == IOBUF_SIZE || (flush && !size)) {
+            if (s->bytestream_end - s->bytestream < *fill + 100)
+                return AVERROR_BUFFER_TOO_SMALL;
+            png_write_image_data(avctx, s->buf, *fill);
+            *fill = 0;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Filter and compress the image with all slice threads, in the style of
+ * pigz: the filtered data is cut into fixed-size chunks that are deflated
+ * independently and concatenated into a single zlib stream. The chunking
+ * does not depend on the thread count, so neither does the output.
+ */
+static int encode_frame_threaded(AVCodecContext *avctx, const AVFrame *pict,
+                                 int row_size, int chunk_rows)
+{
+    PNGEncContext *s     = avctx->priv_data;
+    const size_t stride  = row_size + 1;
+    PNGEncThreadData td  = {
+        .pict       = pict,
+        .row_size   = row_size,
+        /* padded so that every thread's row is aligned like the first one */
+        .crow_size  = FFALIGN((row_size + 32) << (s->filter_type == PNG_FILTER_VALUE_MIXED), 16),
+        .chunk_rows = chunk_rows,
+        .nb_chunks  = (pict->height + chunk_rows - 1) / chunk_rows,
+    };
+    uint32_t adler = adler32(0, NULL, 0);
+    uint8_t *chunk_buf = NULL;
+    uint8_t tail[4];
+    int *rets = NULL;
+    int i, fill = 0, ret;
+
+    td.nb_filter_jobs = FFMIN(s->nb_thread_zstreams, pict->height);
+    td.chunk_capacity = deflateBound(&s->thread_zstream[0], chunk_rows * stride) + 16;
+
+    td.rows      = av_malloc(stride * pict->height);
+    td.crow_base = av_malloc_array(s->nb_thread_zstreams, td.crow_size);
+    td.chunks    = av_calloc(td.nb_chunks, sizeof(*td.chunks));
+    chunk_buf    = av_malloc_array(td.nb_chunks, td.chunk_capacity);
+    rets         = av_malloc_array(td.nb_chunks, sizeof(*rets));
+    if (!td.rows || !td.crow_base || !td.chunks || !chunk_buf || !rets) {
+        ret = AVERROR(ENOMEM);
+        goto the_end;
+    }
+    for (i = 0; i < td.nb_chunks; i++)
+        td.chunks[i].buf = chunk_buf + (size_t)i * td.chunk_capacity;
+
+    avctx->execute2(avctx, filter_rows_thread, &td, NULL, td.nb_filter_jobs);
+    avctx->execute2(avctx, deflate_chunk_thread, &td, rets, td.nb_chunks);
+
+    AV_WB16(tail, s->zlib_header);
+    ret = png_write_idat_buffered(avctx, &fill, tail, 2, 0);
+    for (i = 0; i < td.nb_chunks && ret >= 0; i++) {
+        const PNGEncChunk *chunk = &td.chunks[i];
+        unsigned len = FFMIN(chunk_rows, pict->height - i * chunk_rows) * stride;
+
+        if (rets[i] < 0) {
+            ret = rets[i];
+            break;
+        }
+        adler = adler32_combine(adler, chunk->adler, len);
+        ret   = png_write_idat_buffered(avctx, &fill, chunk->buf, chunk->size, 0);
+    }
+    if (ret >= 0) {
+        AV_WB32(tail, adler);
+        ret = png_write_idat_buffered(avctx, &fill, tail, 4, 1);
+    }
+
+the_end:
+    av_freep(&td.rows);
+    av_freep(&td.crow_base);
+    av_freep(&td.chunks);
+    av_freep(&chunk_buf);
+    av_freep(&rets);
+    return ret;
+}
+
 static int encode_frame(AVCodecContext *avctx, const AVFrame *pict)
 {
     PNGEncContext *s       = avctx->priv_data;
@@ -442,6 +635,12 @@ static int encode_frame(AVCodecContext *avctx, const AVFrame *pict)
 
     row_size = (pict->width * s->bits_per_pixel + 7) >> 3;
 
+    if (s->thread_zstream) {
+        int chunk_rows = FFMAX(DEFLATE_CHUNK_SIZE / (row_size + 1), 1);
+        if (pict->height > chunk_rows)
+            return encode_frame_threaded(avctx, pict, row_size, chunk_rows);
+    }
+
     crow_base = av_malloc((row_size + 32) << (s->filter_type == PNG_FILTER_VALUE_MIXED));
     if (!crow_base) {
         ret = AVERROR(ENOMEM);
@@ -989,7 +1188,7 @@ static int encode_apng(AVCodecContext *avctx, AVPacket *pkt,
 static av_cold int png_enc_init(AVCodecContext *avctx)
 {
     PNGEncContext *s = avctx->priv_data;
-    int compression_level;
+    int compression_level, level_flags;
 
     switch (avctx->pix_fmt) {
     case AV_PIX_FMT_RGBA:
@@ -1076,6 +1275,36 @@ static av_cold int png_enc_init(AVCodecContext *avctx)
     if (deflateInit2(&s->zstream, compression_level, Z_DEFLATED, 15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
         return -1;
 
+    /* The chunked stream compresses slightly worse than a single deflate()
+     * and differs from it, but does not depend on the thread count. */
+    if (s->chunked_deflate && !s->is_progressive) {
+        const int nb_threads = FFMAX(avctx->thread_count, 1);
+        int i;
+
+        s->thread_zstream = av_calloc(nb_threads, sizeof(*s->thread_zstream));
+        if (!s->thread_zstream)
+            return AVERROR(ENOMEM);
+        for (i = 0; i < nb_threads; i++) {
+            z_stream *zstream = &s->thread_zstream[i];
+
+            zstream->zalloc = ff_png_zalloc;
+            zstream->zfree  = ff_png_zfree;
+            zstream->opaque = NULL;
+            if (deflateInit2(zstream, compression_level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+                return -1;
+            s->nb_thread_zstreams++;
+        }
+
+        /* same header as deflate() writes for a zlib stream */
+        if (compression_level == Z_DEFAULT_COMPRESSION)
+            compression_level = 6;
+        level_flags = compression_level < 2 ? 0 :
+                      compression_level < 6 ? 1 :
+                      compression_level == 6 ? 2 : 3;
+        s->zlib_header  = 0x7800 | level_flags << 6;
+        s->zlib_header += 31 - s->zlib_header % 31;
+    }
+
     return 0;
 }
 
@@ -1084,6 +1313,10 @@ static av_cold int png_enc_close(AVCodecContext *avctx)
     PNGEncContext *s = avctx->priv_data;
 
     deflateEnd(&s->zstream);
+    for (int i = 0; i < s->nb_thread_zstreams; i++)
+        deflateEnd(&s->thread_zstream[i]);
+    av_freep(&s->thread_zstream);
+    s->nb_thread_zstreams = 0;
     av_frame_free(&s->last_frame);
     av_frame_free(&s->prev_frame);
     av_freep(&s->last_frame_packet);
@@ -1104,6 +1337,7 @@ static const AVOption options[] = {
         { "avg",   NULL, 0, AV_OPT_TYPE_CONST, { .i64 = PNG_FILTER_VALUE_AVG },   INT_MIN, INT_MAX, VE, "pred" },
         { "paeth", NULL, 0, AV_OPT_TYPE_CONST, { .i64 = PNG_FILTER_VALUE_PAETH }, INT_MIN, INT_MAX, VE, "pred" },
         { "mixed", NULL, 0, AV_OPT_TYPE_CONST, { .i64 = PNG_FILTER_VALUE_MIXED }, INT_MIN, INT_MAX, VE, "pred" },
+    { "chunked_deflate", "Filter and compress the image in chunks, in parallel with slice threads", OFFSET(chunked_deflate), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, VE },
     { NULL},
 };
 
@@ -1123,7 +1357,7 @@ const AVCodec ff_png_encoder = {
     .init           = png_enc_init,
     .close          = png_enc_close,
     .encode2        = encode_png,
-    .capabilities   = AV_CODEC_CAP_FRAME_THREADS,
+    .capabilities   = AV_CODEC_CAP_FRAME_THREADS | AV_CODEC_CAP_SLICE_THREADS,
     .pix_fmts       = (const enum AVPixelFormat[]) {
         AV_PIX_FMT_RGB24, AV_PIX_FMT_RGBA,
         AV_PIX_FMT_RGB48BE, AV_PIX_FMT_RGBA64BE,
@@ -1133,7 +1367,7 @@ const AVCodec ff_png_encoder = {
         AV_PIX_FMT_MONOBLACK, AV_PIX_FMT_NONE
     },
     .priv_class     = &pngenc_class,
-    .caps_internal  = FF_CODEC_CAP_INIT_THREADSAFE,
+    .caps_internal  = FF_CODEC_CAP_INIT_THREADSAFE | FF_CODEC_CAP_INIT_CLEANUP,
 };
 
 const AVCodec ff_apng_encoder = {
@@ -1155,5 +1389,5 @@ const AVCodec ff_apng_encoder = {
         AV_PIX_FMT_NONE
     },
     .priv_class     = &pngenc_class,
-    .caps_internal  = FF_CODEC_CAP_INIT_THREADSAFE,
+    .caps_internal  = FF_CODEC_CAP_INIT_THREADSAFE | FF_CODEC_CAP_INIT_CLEANUP,
 };
@@ -682,8 +682,8 @@ static int estimate_acs(int *error, int16_t *blocks, int blocks_per_slice,
                         const uint8_t *scan, const int16_t *qmat)
 {
     int idx, i;
-    int run, level, run_cb, lev_cb;
-    int max_coeffs, abs_level;
+    int run, run_cb, lev_cb;
+    int max_coeffs, abs_coeff, abs_level;
     int bits = 0;
 
     max_coeffs = blocks_per_slice << 6;
@@ -692,11 +692,17 @@ static int estimate_acs(int *error, int16_t *blocks, int blocks_per_slice,
     run        = 0;
 
     for (i = 1; i < 64; i++) {
+        const unsigned q = qmat[scan[i]];
+        /* Coefficient magnitudes are at most 2^15 and q is below 2^15, so
+         * multiplying by the rounded up reciprocal gives the exact quotient
+         * without a division per coefficient. */
+        const uint64_t recip = ((UINT64_C(1) << 32) + q - 1) / q;
+
         for (idx = scan[i]; idx < max_coeffs; idx += 64) {
-            level   = blocks[idx] / qmat[scan[i]];
-            *error += FFABS(blocks[idx]) % qmat[scan[i]];
-            if (level) {
-                abs_level = FFABS(level);
+            abs_coeff = FFABS(blocks[idx]);
+            abs_level = abs_coeff * recip >> 32;
+            *error   += abs_coeff - abs_level * q;
+            if (abs_level) {
                 bits += estimate_vlc(ff_prores_ac_codebook[run_cb], run);
                 bits += estimate_vlc(ff_prores_ac_codebook[lev_cb],
                                      abs_level - 1) + 1;
@@ -1416,5 +1422,5 @@ const AVCodec ff_prores_ks_encoder = {
                       },
     .priv_class     = &proresenc_class,
     .profiles       = NULL_IF_CONFIG_SMALL(ff_prores_profiles),
-    .caps_internal  = FF_CODEC_CAP_INIT_THREADSAFE,
+    .caps_internal  = FF_CODEC_CAP_INIT_THREADSAFE | FF_CODEC_CAP_SLICE_THREAD_SHARED,
 };
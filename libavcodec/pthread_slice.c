@@ -156,7 +156,14 @@ int ff_slice_thread_init(AVCodecContext *avctx)
 
     avctx->internal->thread_ctx = c = av_mallocz(sizeof(*c));
     mainfunc = avctx->codec->caps_internal & FF_CODEC_CAP_SLICE_THREAD_HAS_MF ? &main_function : NULL;
-    if (!c || (thread_count = avpriv_slicethread_create(&c->thread, avctx, worker_func, mainfunc, thread_count)) <= 1) {
+    if (c && !mainfunc && avctx->codec->caps_internal & FF_CODEC_CAP_SLICE_THREAD_SHARED)
+        thread_count = avpriv_slicethread_create_shared(&c->thread, avctx, worker_func, thread_count,
+                                                        av_codec_is_decoder(avctx->codec) ?
+                                                        AVPRIV_SLICETHREAD_PRIORITY_HIGH :
+                                                        AVPRIV_SLICETHREAD_PRIORITY_NORMAL);
+    else if (c)
+        thread_count = avpriv_slicethread_create(&c->thread, avctx, worker_func, mainfunc, thread_count);
+    if (!c || thread_count <= 1) {
         if (c)
             avpriv_slicethread_free(&c->thread);
         av_freep(&avctx->internal->thread_ctx);
@@ -178,7 +185,8 @@ void ff_thread_report_progress2(AVCodecContext *avctx, int field, int thread, in
 
     pthread_mutex_lock(&p->progress_mutex[thread]);
     entries[field] +=n;
-    pthread_cond_signal(&p->progress_cond[thread]);
+    /* rows field and field + thread_count share the slot, wake all waiters */
+    pthread_cond_broadcast(&p->progress_cond[thread]);
     pthread_mutex_unlock(&p->progress_mutex[thread]);
 }
 
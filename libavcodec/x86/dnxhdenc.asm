@@ -22,6 +22,10 @@
 
 %include "libavutil/x86/x86util.asm"
 
+SECTION_RODATA
+
+cextern pd_65535
+
 SECTION .text
 
 ; void get_pixels_8x4_sym_sse2(int16_t *block, const uint8_t *pixels,
@@ -47,3 +51,68 @@ cglobal get_pixels_8x4_sym, 3,3,5, block, pixels, linesize
     mova  [blockq+96 ], m1
     mova  [blockq+112], m0
     RET
+
+%if HAVE_AVX2_EXTERNAL
+; %1 = coefficient offset
+%macro QUANT10 1
+    pmovsxwd      m0, [blockq+2*%1]
+    pmovsxwd      m1, [blockq+2*%1+16]
+    pabsd         m2, m0
+    pabsd         m3, m1
+    pmulld        m2, [qmatq+4*%1]
+    pmulld        m3, [qmatq+4*%1+32]
+    paddd         m2, m5
+    paddd         m3, m5
+    psrld         m2, xm6
+    psrld         m3, xm6
+    por           m7, m2
+    por           m7, m3
+    psignd        m2, m0
+    psignd        m3, m1
+    ; the C version truncates the levels to int16
+    pand          m2, m4
+    pand          m3, m4
+    packusdw      m2, m3
+    vpermq        m2, m2, q3120
+    movu [blockq+2*%1], m2
+    pcmpeqw       m2, m9
+    pandn         m2, [scanq+2*%1]
+    pmaxsw        m8, m2
+%endmacro
+
+; int ff_dnxhd_10bit_quantize_avx2(int16_t *block, const int *qmat, int bias,
+;                                  int shift, const int16_t *scan_pos, int *max)
+INIT_YMM avx2
+cglobal dnxhd_10bit_quantize, 6, 6, 10, block, qmat, bias, shift, scan, max
+    movd         xm5, biasd
+    vpbroadcastd  m5, xm5
+    movd         xm6, shiftd
+    mova          m4, [pd_65535]
+    pxor          m7, m7
+    pxor          m8, m8
+    pxor          m9, m9
+    QUANT10        0
+    QUANT10       16
+    QUANT10       32
+    QUANT10       48
+
+    vextracti128 xm0, m7, 1
+    por          xm7, xm0
+    pshufd       xm0, xm7, q1032
+    por          xm7, xm0
+    pshufd       xm0, xm7, q2301
+    por          xm7, xm0
+    movd       [maxq], xm7
+
+    vextracti128 xm0, m8, 1
+    pmaxsw       xm8, xm0
+    pshufd       xm0, xm8, q1032
+    pmaxsw       xm8, xm0
+    pshufd       xm0, xm8, q2301
+    pmaxsw       xm8, xm0
+    psrld        xm0, xm8, 16
+    pmaxsw       xm8, xm0
+    movd         eax, xm8
+    movzx        eax, ax
+    RET
+%endif
@@ -27,11 +27,17 @@
 
 void ff_get_pixels_8x4_sym_sse2(int16_t *block, const uint8_t *pixels,
                                 ptrdiff_t line_size);
+int ff_dnxhd_10bit_quantize_avx2(int16_t *block, const int *qmat, int bias,
+                                 int shift, const int16_t *scan_pos, int *max);
 
 av_cold void ff_dnxhdenc_init_x86(DNXHDEncContext *ctx)
 {
-    if (EXTERNAL_SSE2(av_get_cpu_flags())) {
+    int cpu_flags = av_get_cpu_flags();
+
+    if (EXTERNAL_SSE2(cpu_flags)) {
         if (ctx->cid_table->bit_depth == 8)
             ctx->get_pixels_8x4_sym = ff_get_pixels_8x4_sym_sse2;
     }
+    if (EXTERNAL_AVX2_FAST(cpu_flags))
+        ctx->quantize_10bit = ff_dnxhd_10bit_quantize_avx2;
 }
@@ -192,3 +192,69 @@ cglobal sub_left_predict, 5,6,5, dst, src, stride, width, height, x
     dec  heightd
     jg .loop
     RET
+
+%if HAVE_AVX2_EXTERNAL
+;--------------------------------------------------------------------------------------------------
+;void sub_paeth_pred(uint8_t *dst, const uint8_t *src, const uint8_t *top, intptr_t w, int bpp)
+;--------------------------------------------------------------------------------------------------
+
+INIT_YMM avx2
+cglobal sub_paeth_pred, 5,7,7, dst, src, top, w, bpp, left, topleft
+    movsxdifnidn   bppq, bppd
+    add            dstq, wq
+    add            srcq, wq
+    add            topq, wq
+    mov           leftq, srcq
+    mov        topleftq, topq
+    sub           leftq, bppq
+    sub        topleftq, bppq
+    neg              wq
+
+.loop:
+    pmovzxbw         m0, [leftq + wq]    ; a
+    pmovzxbw         m1, [topq + wq]     ; b
+    pmovzxbw         m2, [topleftq + wq] ; c
+    psubw            m3, m1, m2          ; b - c
+    psubw            m4, m0, m2          ; a - c
+    paddw            m5, m3, m4
+    pabsw            m3, m3              ; pa
+    pabsw            m4, m4              ; pb
+    pabsw            m5, m5              ; pc
+    pcmpgtw          m6, m4, m5
+    pblendvb         m1, m1, m2, m6      ; pb <= pc ? b : c
+    pminsw           m4, m5
+    pcmpgtw          m3, m4
+    pblendvb         m0, m0, m1, m3      ; pa <= FFMIN(pb, pc) ? a : ...
+    vextracti128    xm1, m0, 1
+    packuswb        xm0, xm1
+    movu            xm1, [srcq + wq]
+    psubb           xm1, xm0
+    movu   [dstq + wq], xm1
+    add              wq, 16
+    jl .loop
+    RET
+
+;--------------------------------------------------------------------------------------------------
+;int sum_abs_s8(const uint8_t *src, intptr_t w)
+;--------------------------------------------------------------------------------------------------
+
+cglobal sum_abs_s8, 2,2,3, src, w
+    add            srcq, wq
+    neg              wq
+    pxor             m0, m0
+    pxor             m1, m1
+
+.loop:
+    pabsb            m2, [srcq + wq]
+    psadbw           m2, m1
+    paddq            m0, m2
+    add              wq, mmsize
+    jl .loop
+
+    vextracti128    xm2, m0, 1
+    paddq           xm0, xm2
+    movhlps         xm2, xm0
+    paddq           xm0, xm2
+    movd            eax, xm0
+    RET
+%endif
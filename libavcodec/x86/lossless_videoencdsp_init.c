@@ -39,6 +39,10 @@ void ff_diff_bytes_avx2(uint8_t *dst, const uint8_t *src1, const uint8_t *src2,
 void ff_sub_left_predict_avx(uint8_t *dst, uint8_t *src,
                             ptrdiff_t stride, ptrdiff_t width, int height);
 
+void ff_sub_paeth_pred_avx2(uint8_t *dst, const uint8_t *src,
+                            const uint8_t *top, intptr_t w, int bpp);
+int ff_sum_abs_s8_avx2(const uint8_t *src, intptr_t w);
+
 #if HAVE_INLINE_ASM
 
 static void sub_median_pred_mmxext(uint8_t *dst, const uint8_t *src1,
@@ -106,6 +110,8 @@ av_cold void ff_llvidencdsp_init_x86(LLVidEncDSPContext *c)
     }
 
     if (EXTERNAL_AVX2_FAST(cpu_flags)) {
-        c->diff_bytes = ff_diff_bytes_avx2;
+        c->diff_bytes     = ff_diff_bytes_avx2;
+        c->sub_paeth_pred = ff_sub_paeth_pred_avx2;
+        c->sum_abs_s8     = ff_sum_abs_s8_avx2;
     }
 }
@@ -524,6 +524,86 @@ SAD 8
 SAD 16
 INIT_XMM sse2
 SAD 16
+;------------------------------------------------------------------------------
+;void ff_sad_x4_<opt>(uint8_t *pix1, uint8_t *const pix2[4], ptrdiff_t stride,
+;                     int h, int scores[4]);
+;------------------------------------------------------------------------------
+; load one row if the block is as wide as a register, else two
+%macro SAD_X4_LOAD 3 ; dst, src, width
+%if %3 == mmsize
+    movu          m%1, [%2]
+%elif mmsize == 16
+    movq          m%1, [%2]
+    movhps        m%1, [%2+strideq]
+%else
+    movu         xm%1, [%2]
+    vinserti128    m%1, m%1, [%2+strideq], 1
+%endif
+%endmacro
+
+;%1 = 8/16
+%macro SAD_X4 1
+%assign rows mmsize / %1
+cglobal sad%1_x4, 5, 8, 8, pix1, pix2, stride, h, scores, pix2b, pix2c, pix2d
+    mov     pix2bq, [pix2q+gprsize*1]
+    mov     pix2cq, [pix2q+gprsize*2]
+    mov     pix2dq, [pix2q+gprsize*3]
+    mov      pix2q, [pix2q]
+    pxor        m4, m4
+    pxor        m5, m5
+    pxor        m6, m6
+    pxor        m7, m7
+
+align 16
+.loop:
+    SAD_X4_LOAD  0, pix1q,  %1
+    SAD_X4_LOAD  1, pix2q,  %1
+    SAD_X4_LOAD  2, pix2bq, %1
+    SAD_X4_LOAD  3, pix2cq, %1
+    psadbw      m1, m0
+    psadbw      m2, m0
+    psadbw      m3, m0
+    paddw       m4, m1
+    paddw       m5, m2
+    paddw       m6, m3
+    SAD_X4_LOAD  1, pix2dq, %1
+    psadbw      m1, m0
+    paddw       m7, m1
+    lea      pix1q, [pix1q +strideq*rows]
+    lea      pix2q, [pix2q +strideq*rows]
+    lea     pix2bq, [pix2bq+strideq*rows]
+    lea     pix2cq, [pix2cq+strideq*rows]
+    lea     pix2dq, [pix2dq+strideq*rows]
+    sub         hd, rows
+    jg .loop
+
+    ; each accumulator holds one partial sum per qword, gather them
+    ; so that dword n of the result is the score of candidate n
+    punpcklqdq  m0, m4, m5
+    punpckhqdq  m4, m5
+    punpcklqdq  m1, m6, m7
+    punpckhqdq  m6, m7
+    paddd       m4, m0
+    paddd       m6, m1
+    shufps      m4, m6, q2020
+%if mmsize == 32
+    vextracti128 xm0, m4, 1
+    paddd      xm4, xm0
+%endif
+    movu [scoresq], xm4
+    RET
+%endmacro
+
+%if ARCH_X86_64
+INIT_XMM sse2
+SAD_X4 8
+SAD_X4 16
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+SAD_X4 16
+%endif
+%endif
+
 
 ;------------------------------------------------------------------------------------------
 ;int ff_sad_x2_<opt>(MpegEncContext *v, uint8_t *pix1, uint8_t *pix2, ptrdiff_t stride, int h);
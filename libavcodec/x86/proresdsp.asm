@@ -26,12 +26,25 @@
 
 %if ARCH_X86_64
 
-SECTION_RODATA
+SECTION_RODATA 32
+
+pd_w1:      times 8 dd 45451
+pd_w2:      times 8 dd 42813
+pd_w3:      times 8 dd 38531
+pd_w4:      times 8 dd 32767
+pd_w5:      times 8 dd 25746
+pd_w6:      times 8 dd 17734
+pd_w7:      times 8 dd 9041
+pd_2:       times 8 dd 2
+pd_32768:   times 8 dd 32768
+pw_4091:    times 8 dw 4091
 
 pw_88:      times 8 dw 0x2008
 cextern pw_1
 cextern pw_4
 cextern pw_1019
+cextern pd_1
+cextern pd_8192
 ; Below are defined in simple_idct10.asm built from selecting idctdsp
 cextern w4_plus_w2_hi
 cextern w4_min_w2_hi
@@ -65,4 +78,168 @@ INIT_XMM avx
 idct_fn
 %endif
 
+; The 12-bit coefficients do not fit pmaddwd, so the 12-bit IDCT is done in
+; 32-bit lanes, one row (column in the second pass) per lane. All sums wrap
+; modulo 2^32 exactly like the C version, so the output is bit-exact.
+
+; %1-%8 = inputs/outputs 0-7, %9 = shift, %10 = 1 for the row pass
+%macro IDCT12_1D 10
+    ; even part
+%if %10
+    pmulld      m%1, [pd_w4]
+    paddd       m%1, [pd_32768]
+%else
+    paddd       m%1, [pd_2]
+    pmulld      m%1, [pd_w4]
+%endif
+    pmulld      m%5, [pd_w4]
+    psubd        m8, m%1, m%5           ; e1
+    paddd       m%1, m%5                ; e0
+    pmulld       m9, m%3, [pd_w2]
+    pmulld      m%3, [pd_w6]
+    pmulld      m%5, m%7, [pd_w6]
+    pmulld      m%7, [pd_w2]
+    paddd        m9, m%5                ; W2 * x2 + W6 * x6
+    psubd       m%3, m%7                ; W6 * x2 - W2 * x6
+    psubd       m%7, m%1, m9            ; a3
+    paddd       m%1, m9                 ; a0
+    psubd       m%5, m8, m%3            ; a2
+    paddd       m%3, m8                 ; a1
+
+    ; odd part
+    pmulld       m8, m%2, [pd_w1]       ; b0
+    pmulld       m9, m%2, [pd_w3]       ; b1
+    pmulld      m10, m%2, [pd_w5]       ; b2
+    pmulld      m%2, [pd_w7]            ; b3
+    pmulld      m11, m%4, [pd_w3]
+    paddd        m8, m11
+    pmulld      m11, m%4, [pd_w7]
+    psubd        m9, m11
+    pmulld      m11, m%4, [pd_w1]
+    psubd       m10, m11
+    pmulld      m%4, [pd_w5]
+    psubd       m%2, m%4
+    pmulld      m11, m%6, [pd_w5]
+    paddd        m8, m11
+    pmulld      m11, m%6, [pd_w1]
+    psubd        m9, m11
+    pmulld      m11, m%6, [pd_w7]
+    paddd       m10, m11
+    pmulld      m%6, [pd_w3]
+    paddd       m%2, m%6
+    pmulld      m11, m%8, [pd_w7]
+    paddd        m8, m11
+    pmulld      m11, m%8, [pd_w5]
+    psubd        m9, m11
+    pmulld      m11, m%8, [pd_w3]
+    paddd       m10, m11
+    pmulld      m%8, [pd_w1]
+    psubd       m%2, m%8
+
+    ; butterfly
+    psubd       m%8, m%1, m8
+    paddd       m%1, m8
+    psubd       m%6, m%5, m10
+    paddd       m10, m%5
+    paddd       m%4, m%7, m%2
+    psubd       m%5, m%7, m%2
+    paddd       m%2, m%3, m9
+    psubd       m%7, m%3, m9
+    mova        m%3, m10
+    psrad       m%1, %9
+    psrad       m%2, %9
+    psrad       m%3, %9
+    psrad       m%4, %9
+    psrad       m%5, %9
+    psrad       m%6, %9
+    psrad       m%7, %9
+    psrad       m%8, %9
+%endmacro
+
+; %1 = dst, %2 = coefficient row
+%macro LOAD_DEQUANT 2
+    movu       xm%1, [blockq+16*%2]
+    pmullw     xm%1, [qmatq+16*%2]
+%if %2
+    por        xm15, xm%1
+%endif
+    pmovsxwd    m%1, xm%1
+%endmacro
+
+; %1 = src, %2 = dst
+%macro STORE_ROW 2
+    vextracti128 xm8, m%1, 1
+    packssdw   xm%1, xm8
+    pmaxsw     xm%1, xm13
+    pminsw     xm%1, xm14
+    movu         %2, xm%1
+%endmacro
+
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+cglobal prores_idct_put_12, 4, 5, 16, pixels, lsize, block, qmat, lsize3
+    ; the coefficients are transposed, so each load is one coefficient of
+    ; all 8 rows
+    pxor        xm15, xm15
+    LOAD_DEQUANT 0, 0
+    LOAD_DEQUANT 1, 1
+    LOAD_DEQUANT 2, 2
+    LOAD_DEQUANT 3, 3
+    LOAD_DEQUANT 4, 4
+    LOAD_DEQUANT 5, 5
+    LOAD_DEQUANT 6, 6
+    LOAD_DEQUANT 7, 7
+    IDCT12_1D    0, 1, 2, 3, 4, 5, 6, 7, 16, 1
+
+    ; rows with only a DC coefficient are (dc + 1) >> 1
+    pxor        xm12, xm12
+    pcmpeqw     xm15, xm12
+    pmovsxwd     m15, xm15
+    movu        xm12, [blockq]
+    pmullw      xm12, [qmatq]
+    pmovsxwd     m12, xm12
+    paddd        m12, [pd_1]
+    psrad        m12, 1
+    vpblendvb     m0, m0, m12, m15
+    vpblendvb     m1, m1, m12, m15
+    vpblendvb     m2, m2, m12, m15
+    vpblendvb     m3, m3, m12, m15
+    vpblendvb     m4, m4, m12, m15
+    vpblendvb     m5, m5, m12, m15
+    vpblendvb     m6, m6, m12, m15
+    vpblendvb     m7, m7, m12, m15
+
+    TRANSPOSE4x4D 0, 1, 2, 3, 8
+    TRANSPOSE4x4D 4, 5, 6, 7, 8
+    vperm2i128    m8, m0, m4, q0301
+    vinserti128   m0, m0, xm4, 1
+    vperm2i128    m4, m1, m5, q0301
+    vinserti128   m1, m1, xm5, 1
+    vperm2i128    m5, m2, m6, q0301
+    vinserti128   m2, m2, xm6, 1
+    vperm2i128    m6, m3, m7, q0301
+    vinserti128   m3, m3, xm7, 1
+    SWAP           7, 6, 5, 4, 8
+
+    ; the row pass output is stored as int16 before the bias is added
+    paddd         m0, [pd_8192]
+    pslld         m0, 16
+    psrad         m0, 16
+    IDCT12_1D    0, 1, 2, 3, 4, 5, 6, 7, 17, 0
+
+    mova         xm13, [pw_4]
+    mova         xm14, [pw_4091]
+    lea       lsize3q, [lsizeq*3]
+    STORE_ROW     0, [pixelsq]
+    STORE_ROW     1, [pixelsq+lsizeq]
+    STORE_ROW     2, [pixelsq+lsizeq*2]
+    STORE_ROW     3, [pixelsq+lsize3q]
+    lea       pixelsq, [pixelsq+lsizeq*4]
+    STORE_ROW     4, [pixelsq]
+    STORE_ROW     5, [pixelsq+lsizeq]
+    STORE_ROW     6, [pixelsq+lsizeq*2]
+    STORE_ROW     7, [pixelsq+lsize3q]
+    RET
+%endif
+
 %endif
@@ -27,18 +27,21 @@
 #include "libavutil/avstring.h"
 #include "libavutil/channel_layout.h"
 #include "libavutil/eval.h"
-#include "libavutil/float_dsp.h"
 #include "libavutil/internal.h"
 #include "libavutil/opt.h"
 
 #include "audio.h"
 #include "avfilter.h"
+#include "biquaddsp.h"
 #include "formats.h"
 #include "internal.h"
 
 #define MAX_SPLITS 16
 #define MAX_BANDS MAX_SPLITS + 1
 
+/* number of frames filtered at once, small enough to stay in cache */
+#define BLOCK_SIZE 256
+
 #define B0 0
 #define B1 1
 #define B2 2
@@ -47,7 +50,6 @@
 
 typedef struct BiquadCoeffs {
     double cd[5];
-    float cf[5];
 } BiquadCoeffs;
 
 typedef struct AudioCrossoverContext {
@@ -71,14 +73,18 @@ typedef struct AudioCrossoverContext {
     BiquadCoeffs hp[MAX_BANDS][20];
     BiquadCoeffs ap[MAX_BANDS][20];
 
-    AVFrame *xover;
+    void *coeffs;       ///< lowpass, highpass then allpass sections of every band
+    void *state;        ///< filter history of each group of channels
+    void *bands;        ///< interleaved samples of every band of each group
+    int nb_sections;    ///< number of sections filtered for each group
+    int nb_groups;
 
     AVFrame *input_frame;
     AVFrame *frames[MAX_BANDS];
 
     int (*filter_channels)(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs);
 
-    AVFloatDSPContext *fdsp;
+    BiquadDSPContext dsp;
 } AudioCrossoverContext;
 
 #define OFFSET(x) offsetof(AudioCrossoverContext, x)
@@ -145,10 +151,6 @@ static av_cold int init(AVFilterContext *ctx)
     char *p, *arg, *saveptr = NULL;
     int i, ret = 0;
 
-    s->fdsp = avpriv_float_dsp_alloc(0);
-    if (!s->fdsp)
-        return AVERROR(ENOMEM);
-
     p = s->splits_str;
     for (i = 0; i < MAX_SPLITS; i++) {
         float freq;
@@ -218,12 +220,6 @@ static void set_lp(BiquadCoeffs *b, double fc, double q, double sr)
     b->cd[B2] =  b2 / a0;
     b->cd[A1] = -a1 / a0;
     b->cd[A2] = -a2 / a0;
-
-    b->cf[B0] = b->cd[B0];
-    b->cf[B1] = b->cd[B1];
-    b->cf[B2] = b->cd[B2];
-    b->cf[A1] = b->cd[A1];
-    b->cf[A2] = b->cd[A2];
 }
 
 static void set_hp(BiquadCoeffs *b, double fc, double q, double sr)
@@ -244,12 +240,6 @@ static void set_hp(BiquadCoeffs *b, double fc, double q, double sr)
     b->cd[B2] =  b2 / a0;
     b->cd[A1] = -a1 / a0;
     b->cd[A2] = -a2 / a0;
-
-    b->cf[B0] = b->cd[B0];
-    b->cf[B1] = b->cd[B1];
-    b->cf[B2] = b->cd[B2];
-    b->cf[A1] = b->cd[A1];
-    b->cf[A2] = b->cd[A2];
 }
 
 static void set_ap(BiquadCoeffs *b, double fc, double q, double sr)
@@ -270,12 +260,6 @@ static void set_ap(BiquadCoeffs *b, double fc, double q, double sr)
     b->cd[B2] =  b2 / a0;
     b->cd[A1] = -a1 / a0;
     b->cd[A2] = -a2 / a0;
-
-    b->cf[B0] = b->cd[B0];
-    b->cf[B1] = b->cd[B1];
-    b->cf[B2] = b->cd[B2];
-    b->cf[A1] = b->cd[A1];
-    b->cf[A2] = b->cd[A2];
 }
 
 static void set_ap1(BiquadCoeffs *b, double fc, double sr)
@@ -287,12 +271,6 @@ static void set_ap1(BiquadCoeffs *b, double fc, double sr)
     b->cd[B0] = -b->cd[A1];
     b->cd[B1] = 1.;
     b->cd[B2] = 0.;
-
-    b->cf[B0] = b->cd[B0];
-    b->cf[B1] = b->cd[B1];
-    b->cf[B2] = b->cd[B2];
-    b->cf[A1] = b->cd[A1];
-    b->cf[A2] = b->cd[A2];
 }
 
 static void calc_q_factors(int order, double *q)
@@ -333,135 +311,114 @@ static int query_formats(AVFilterContext *ctx)
     return ff_set_common_samplerates(ctx, formats);
 }
 
-#define BIQUAD_PROCESS(name, type)                             \
-static void biquad_process_## name(const type *const c,        \
-                                   type *b,                    \
-                                   type *dst, const type *src, \
-                                   int nb_samples)             \
-{                                                              \
-    const type b0 = c[B0];                                     \
-    const type b1 = c[B1];                                     \
-    const type b2 = c[B2];                                     \
-    const type a1 = c[A1];                                     \
-    const type a2 = c[A2];                                     \
-    type z1 = b[0];                                            \
-    type z2 = b[1];                                            \
-                                                               \
-    for (int n = 0; n + 1 < nb_samples; n++) {                 \
-        type in = src[n];                                      \
-        type out;                                              \
-                                                               \
-        out = in * b0 + z1;                                    \
-        z1 = b1 * in + z2 + a1 * out;                          \
-        z2 = b2 * in + a2 * out;                               \
-        dst[n] = out;                                          \
-                                                               \
-        n++;                                                   \
-        in = src[n];                                           \
-        out = in * b0 + z1;                                    \
-        z1 = b1 * in + z2 + a1 * out;                          \
-        z2 = b2 * in + a2 * out;                               \
-        dst[n] = out;                                          \
-    }                                                          \
-                                                               \
-    if (nb_samples & 1) {                                      \
-        const int n = nb_samples - 1;                          \
-        const type in = src[n];                                \
-        type out;                                              \
-                                                               \
-        out = in * b0 + z1;                                    \
-        z1 = b1 * in + z2 + a1 * out;                          \
-        z2 = b2 * in + a2 * out;                               \
-        dst[n] = out;                                          \
-    }                                                          \
-                                                               \
-    b[0] = z1;                                                 \
-    b[1] = z2;                                                 \
-}
-
-BIQUAD_PROCESS(fltp, float)
-BIQUAD_PROCESS(dblp, double)
-
-#define XOVER_PROCESS(name, type, one, ff)                                                  \
+/* The channels are filtered in groups of interleaved lanes, every band of a
+ * group is kept interleaved until the gains are applied. */
+#define XOVER_PROCESS(name, type, one, lanes, ff)                                           \
 static int filter_channels_## name(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs) \
 {                                                                                           \
     AudioCrossoverContext *s = ctx->priv;                                                   \
     AVFrame *in = s->input_frame;                                                           \
     AVFrame **frames = s->frames;                                                           \
-    const int start = (in->channels * jobnr) / nb_jobs;                                     \
-    const int end = (in->channels * (jobnr+1)) / nb_jobs;                                   \
+    const int start = (s->nb_groups * jobnr) / nb_jobs;                                     \
+    const int end = (s->nb_groups * (jobnr+1)) / nb_jobs;                                   \
     const int nb_samples = in->nb_samples;                                                  \
     const int nb_outs = ctx->nb_outputs;                                                    \
     const int first_order = s->first_order;                                                 \
+    const int filter_count = s->filter_count;                                               \
+    const int ap_filter_count = s->ap_filter_count;                                         \
+    const int section_coeffs = BIQUAD_NB_COEFFS * lanes;                                    \
+    const int section_states = BIQUAD_NB_STATES * lanes;                                    \
+    const type *lpc = s->coeffs;                                                            \
+    const type *hpc = lpc + nb_outs * filter_count * section_coeffs;                        \
+    const type *apc = hpc + nb_outs * filter_count * section_coeffs;                        \
+    const type level_in = s->level_in;                                                      \
                                                                                             \
-    for (int ch = start; ch < end; ch++) {                                                  \
-        const type *src = (const type *)in->extended_data[ch];                              \
-        type *xover = (type *)s->xover->extended_data[ch];                                  \
+    for (int group = start; group < end; group++) {                                         \
+        const int first = group * lanes;                                                    \
+        const int nb_lanes = FFMIN(in->channels - first, lanes);                            \
+        type *bands = (type *)s->bands + group * nb_outs * BLOCK_SIZE * lanes;              \
+        type *lp = (type *)s->state + group * s->nb_sections * section_states;              \
+        type *hp = lp + nb_outs * filter_count * section_states;                            \
+        type *ap = hp + nb_outs * filter_count * section_states;                            \
                                                                                             \
-        s->fdsp->vector_## ff ##mul_scalar((type *)frames[0]->extended_data[ch], src,       \
-                                    s->level_in, FFALIGN(nb_samples, sizeof(type)));        \
+        for (int offset = 0; offset < nb_samples; offset += BLOCK_SIZE) {                   \
+            const int len = FFMIN(nb_samples - offset, BLOCK_SIZE);                         \
                                                                                             \
-        for (int band = 0; band < nb_outs; band++) {                                        \
-            for (int f = 0; band + 1 < nb_outs && f < s->filter_count; f++) {               \
-                const type *prv = (const type *)frames[band]->extended_data[ch];            \
-                type *dst = (type *)frames[band + 1]->extended_data[ch];                    \
-                const type *hsrc = f == 0 ? prv : dst;                                      \
-                type *hp = xover + nb_outs * 20 + band * 20 + f * 2;                        \
-                const type *const hpc = (type *)&s->hp[band][f].c ## ff;                    \
+            for (int l = 0; l < nb_lanes; l++) {                                            \
+                const type *src = (const type *)in->extended_data[first + l] + offset;      \
                                                                                             \
-                biquad_process_## name(hpc, hp, dst, hsrc, nb_samples);                     \
+                for (int n = 0; n < len; n++)                                               \
+                    bands[n * lanes + l] = src[n] * level_in;                               \
             }                                                                               \
                                                                                             \
-            for (int f = 0; band + 1 < nb_outs && f < s->filter_count; f++) {               \
-                type *dst = (type *)frames[band]->extended_data[ch];                        \
-                const type *lsrc = dst;                                                     \
-                type *lp = xover + band * 20 + f * 2;                                       \
-                const type *const lpc = (type *)&s->lp[band][f].c ## ff;                    \
-                                                                                            \
-                biquad_process_## name(lpc, lp, dst, lsrc, nb_samples);                     \
-            }                                                                               \
+            for (int band = 0; band < nb_outs; band++) {                                    \
+                type *dst = bands + band * BLOCK_SIZE * lanes;                              \
                                                                                             \
-            for (int aband = band + 1; aband + 1 < nb_outs; aband++) {                      \
-                if (first_order) {                                                          \
-                    const type *asrc = (const type *)frames[band]->extended_data[ch];       \
-                    type *dst = (type *)frames[band]->extended_data[ch];                    \
-                    type *ap = xover + nb_outs * 40 + (aband * nb_outs + band) * 20;        \
-                    const type *const apc = (type *)&s->ap[aband][0].c ## ff;               \
+                if (band + 1 < nb_outs) {                                                   \
+                    type *hdst = dst + BLOCK_SIZE * lanes;                                  \
+                    const int idx = band * filter_count;                                    \
                                                                                             \
-                    biquad_process_## name(apc, ap, dst, asrc, nb_samples);                 \
+                    memcpy(hdst, dst, len * lanes * sizeof(*hdst));                         \
+                    s->dsp.filter_## ff[BIQUAD_TDII](hdst, len, hpc + idx * section_coeffs, \
+                                                     hp + idx * section_states,             \
+                                                     filter_count);                         \
+                    s->dsp.filter_## ff[BIQUAD_TDII](dst, len, lpc + idx * section_coeffs,  \
+                                                     lp + idx * section_states,             \
+                                                     filter_count);                         \
                 }                                                                           \
                                                                                             \
-                for (int f = first_order; f < s->ap_filter_count; f++) {                    \
-                    const type *asrc = (const type *)frames[band]->extended_data[ch];       \
-                    type *dst = (type *)frames[band]->extended_data[ch];                    \
-                    type *ap = xover + nb_outs * 40 + (aband * nb_outs + band) * 20 + f * 2;\
-                    const type *const apc = (type *)&s->ap[aband][f].c ## ff;               \
+                for (int aband = band + 1; aband + 1 < nb_outs; aband++) {                  \
+                    const int idx = (aband * nb_outs + band) * ap_filter_count;             \
                                                                                             \
-                    biquad_process_## name(apc, ap, dst, asrc, nb_samples);                 \
+                    s->dsp.filter_## ff[BIQUAD_TDII](dst, len,                              \
+                                                     apc + aband * ap_filter_count * section_coeffs, \
+                                                     ap + idx * section_states,             \
+                                                     ap_filter_count);                      \
                 }                                                                           \
             }                                                                               \
-        }                                                                                   \
                                                                                             \
-        for (int band = 0; band < nb_outs; band++) {                                        \
-            const type gain = s->gains[band] * ((band & 1 && first_order) ? -one : one);    \
-            type *dst = (type *)frames[band]->extended_data[ch];                            \
+            for (int band = 0; band < nb_outs; band++) {                                    \
+                const type gain = s->gains[band] * ((band & 1 && first_order) ? -one : one);\
+                const type *src = bands + band * BLOCK_SIZE * lanes;                        \
+                                                                                            \
+                for (int l = 0; l < nb_lanes; l++) {                                        \
+                    type *dst = (type *)frames[band]->extended_data[first + l] + offset;    \
                                                                                             \
-            s->fdsp->vector_## ff ##mul_scalar(dst, dst, gain,                              \
-                                               FFALIGN(nb_samples, sizeof(type)));          \
+                    for (int n = 0; n < len; n++)                                           \
+                        dst[n] = src[n * lanes + l] * gain;                                 \
+                }                                                                           \
+            }                                                                               \
         }                                                                                   \
     }                                                                                       \
                                                                                             \
     return 0;                                                                               \
 }
 
-XOVER_PROCESS(fltp, float, 1.f, f)
-XOVER_PROCESS(dblp, double, 1.0, d)
+XOVER_PROCESS(fltp, float, 1.f, BIQUAD_LANES_FLT, flt)
+XOVER_PROCESS(dblp, double, 1.0, BIQUAD_LANES_DBL, dbl)
+
+static void set_section(AudioCrossoverContext *s, int format, int section,
+                        const BiquadCoeffs *b)
+{
+    /* the feedback coefficients of BiquadCoeffs are negated */
+    if (format == AV_SAMPLE_FMT_FLTP)
+        ff_biquaddsp_set_section_flt(s->coeffs, section, -1, BIQUAD_TDII,
+                                     b->cd[B0], b->cd[B1], b->cd[B2],
+                                     -b->cd[A1], -b->cd[A2]);
+    else
+        ff_biquaddsp_set_section_dbl(s->coeffs, section, -1, BIQUAD_TDII,
+                                     b->cd[B0], b->cd[B1], b->cd[B2],
+                                     -b->cd[A1], -b->cd[A2]);
+}
 
 static int config_input(AVFilterLink *inlink)
 {
     AVFilterContext *ctx = inlink->dst;
     AudioCrossoverContext *s = ctx->priv;
     int sample_rate = inlink->sample_rate;
+    const int nb_outs = ctx->nb_outputs;
+    const int lanes = inlink->format == AV_SAMPLE_FMT_FLTP ? BIQUAD_LANES_FLT : BIQUAD_LANES_DBL;
+    const size_t vector_size = lanes * av_get_bytes_per_sample(inlink->format);
     double q[16];
 
     s->order = (s->order_opt + 1) * 2;
@@ -498,11 +455,34 @@ static int config_input(AVFilterLink *inlink)
     case AV_SAMPLE_FMT_DBLP: s->filter_channels = filter_channels_dblp; break;
     }
 
-    s->xover = ff_get_audio_buffer(inlink, 2 * (ctx->nb_outputs * 10 + ctx->nb_outputs * 10 +
-                                                ctx->nb_outputs * ctx->nb_outputs * 10));
-    if (!s->xover)
+    ff_biquaddsp_init(&s->dsp);
+
+    /* lowpass and highpass cascades of every band, allpass cascades of
+     * every band for each of the lower bands */
+    s->nb_groups = (inlink->channels + lanes - 1) / lanes;
+    s->nb_sections = nb_outs * (2 * s->filter_count + nb_outs * s->ap_filter_count);
+
+    av_freep(&s->coeffs);
+    av_freep(&s->state);
+    av_freep(&s->bands);
+    s->coeffs = av_calloc(nb_outs * (2 * s->filter_count + s->ap_filter_count),
+                          BIQUAD_NB_COEFFS * vector_size);
+    s->state  = av_calloc(s->nb_groups * s->nb_sections, BIQUAD_NB_STATES * vector_size);
+    s->bands  = av_calloc(s->nb_groups * nb_outs, BLOCK_SIZE * vector_size);
+    if (!s->coeffs || !s->state || !s->bands)
         return AVERROR(ENOMEM);
 
+    for (int band = 0; band < nb_outs; band++) {
+        for (int f = 0; f < s->filter_count; f++) {
+            set_section(s, inlink->format, band * s->filter_count + f, &s->lp[band][f]);
+            set_section(s, inlink->format, (nb_outs + band) * s->filter_count + f, &s->hp[band][f]);
+        }
+
+        for (int f = 0; f < s->ap_filter_count; f++)
+            set_section(s, inlink->format, 2 * nb_outs * s->filter_count +
+                        band * s->ap_filter_count + f, &s->ap[band][f]);
+    }
+
     return 0;
 }
 
@@ -528,7 +508,7 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
         goto fail;
 
     s->input_frame = in;
-    ctx->internal->execute(ctx, s->filter_channels, NULL, NULL, FFMIN(inlink->channels,
+    ctx->internal->execute(ctx, s->filter_channels, NULL, NULL, FFMIN(s->nb_groups,
                                                                       ff_filter_get_nb_threads(ctx)));
 
     for (i = 0; i < ctx->nb_outputs; i++) {
@@ -552,8 +532,9 @@ static av_cold void uninit(AVFilterContext *ctx)
     AudioCrossoverContext *s = ctx->priv;
     int i;
 
-    av_freep(&s->fdsp);
-    av_frame_free(&s->xover);
+    av_freep(&s->coeffs);
+    av_freep(&s->state);
+    av_freep(&s->bands);
 
     for (i = 0; i < ctx->nb_outputs; i++)
         av_freep(&ctx->output_pads[i].name);
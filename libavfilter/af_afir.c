@@ -31,7 +31,6 @@
 #include "libavutil/intreadwrite.h"
 #include "libavutil/opt.h"
 #include "libavutil/xga_font_data.h"
-#include "libavcodec/avfft.h"
 
 #include "audio.h"
 #include "avfilter.h"
@@ -40,180 +39,11 @@
 #include "internal.h"
 #include "af_afir.h"
 
-static void fcmul_add_c(float *sum, const float *t, const float *c, ptrdiff_t len)
-{
-    int n;
-
-    for (n = 0; n < len; n++) {
-        const float cre = c[2 * n    ];
-        const float cim = c[2 * n + 1];
-        const float tre = t[2 * n    ];
-        const float tim = t[2 * n + 1];
-
-        sum[2 * n    ] += tre * cre - tim * cim;
-        sum[2 * n + 1] += tre * cim + tim * cre;
-    }
-
-    sum[2 * n] += t[2 * n] * c[2 * n];
-}
-
-static void direct(const float *in, const FFTComplex *ir, int len, float *out)
-{
-    for (int n = 0; n < len; n++)
-        for (int m = 0; m <= n; m++)
-            out[n] += ir[m].re * in[n - m];
-}
-
-static void fir_fadd(AudioFIRContext *s, float *dst, const float *src, int nb_samples)
-{
-    if ((nb_samples & 15) == 0 && nb_samples >= 16) {
-        s->fdsp->vector_fmac_scalar(dst, src, 1.f, nb_samples);
-    } else {
-        for (int n = 0; n < nb_samples; n++)
-            dst[n] += src[n];
-    }
-}
-
-static int fir_quantum(AVFilterContext *ctx, AVFrame *out, int ch, int offset)
-{
-    AudioFIRContext *s = ctx->priv;
-    const float *in = (const float *)s->in->extended_data[ch] + offset;
-    float *block, *buf, *ptr = (float *)out->extended_data[ch] + offset;
-    const int nb_samples = FFMIN(s->min_part_size, out->nb_samples - offset);
-    int n, i, j;
-
-    for (int segment = 0; segment < s->nb_segments; segment++) {
-        AudioFIRSegment *seg = &s->seg[segment];
-        float *src = (float *)seg->input->extended_data[ch];
-        float *dst = (float *)seg->output->extended_data[ch];
-        float *sum = (float *)seg->sum->extended_data[ch];
-
-        if (s->min_part_size >= 8) {
-            s->fdsp->vector_fmul_scalar(src + seg->input_offset, in, s->dry_gain, FFALIGN(nb_samples, 4));
-            emms_c();
-        } else {
-            for (n = 0; n < nb_samples; n++)
-                src[seg->input_offset + n] = in[n] * s->dry_gain;
-        }
-
-        seg->output_offset[ch] += s->min_part_size;
-        if (seg->output_offset[ch] == seg->part_size) {
-            seg->output_offset[ch] = 0;
-        } else {
-            memmove(src, src + s->min_part_size, (seg->input_size - s->min_part_size) * sizeof(*src));
-
-            dst += seg->output_offset[ch];
-            fir_fadd(s, ptr, dst, nb_samples);
-            continue;
-        }
-
-        if (seg->part_size < 8) {
-            memset(dst, 0, sizeof(*dst) * seg->part_size * seg->nb_partitions);
-
-            j = seg->part_index[ch];
-
-            for (i = 0; i < seg->nb_partitions; i++) {
-                const int coffset = j * seg->coeff_size;
-                const FFTComplex *coeff = (const FFTComplex *)seg->coeff->extended_data[ch * !s->one2many] + coffset;
-
-                direct(src, coeff, nb_samples, dst);
-
-                if (j == 0)
-                    j = seg->nb_partitions;
-                j--;
-            }
-
-            seg->part_index[ch] = (seg->part_index[ch] + 1) % seg->nb_partitions;
-
-            memmove(src, src + s->min_part_size, (seg->input_size - s->min_part_size) * sizeof(*src));
-
-            for (n = 0; n < nb_samples; n++) {
-                ptr[n] += dst[n];
-            }
-            continue;
-        }
-
-        memset(sum, 0, sizeof(*sum) * seg->fft_length);
-        block = (float *)seg->block->extended_data[ch] + seg->part_index[ch] * seg->block_size;
-        memset(block + seg->part_size, 0, sizeof(*block) * (seg->fft_length - seg->part_size));
-
-        memcpy(block, src, sizeof(*src) * seg->part_size);
-
-        av_rdft_calc(seg->rdft[ch], block);
-        block[2 * seg->part_size] = block[1];
-        block[1] = 0;
-
-        j = seg->part_index[ch];
-
-        for (i = 0; i < seg->nb_partitions; i++) {
-            const int coffset = j * seg->coeff_size;
-            const float *block = (const float *)seg->block->extended_data[ch] + i * seg->block_size;
-            const FFTComplex *coeff = (const FFTComplex *)seg->coeff->extended_data[ch * !s->one2many] + coffset;
-
-            s->afirdsp.fcmul_add(sum, block, (const float *)coeff, seg->part_size);
-
-            if (j == 0)
-                j = seg->nb_partitions;
-            j--;
-        }
-
-        sum[1] = sum[2 * seg->part_size];
-        av_rdft_calc(seg->irdft[ch], sum);
-
-        buf = (float *)seg->buffer->extended_data[ch];
-        fir_fadd(s, buf, sum, seg->part_size);
-
-        memcpy(dst, buf, seg->part_size * sizeof(*dst));
-
-        buf = (float *)seg->buffer->extended_data[ch];
-        memcpy(buf, sum + seg->part_size, seg->part_size * sizeof(*buf));
-
-        seg->part_index[ch] = (seg->part_index[ch] + 1) % seg->nb_partitions;
-
-        memmove(src, src + s->min_part_size, (seg->input_size - s->min_part_size) * sizeof(*src));
-
-        fir_fadd(s, ptr, dst, nb_samples);
-    }
-
-    if (s->min_part_size >= 8) {
-        s->fdsp->vector_fmul_scalar(ptr, ptr, s->wet_gain, FFALIGN(nb_samples, 4));
-        emms_c();
-    } else {
-        for (n = 0; n < nb_samples; n++)
-            ptr[n] *= s->wet_gain;
-    }
-
-    return 0;
-}
-
-static int fir_channel(AVFilterContext *ctx, AVFrame *out, int ch)
-{
-    AudioFIRContext *s = ctx->priv;
-
-    for (int offset = 0; offset < out->nb_samples; offset += s->min_part_size) {
-        fir_quantum(ctx, out, ch, offset);
-    }
-
-    return 0;
-}
-
-static int fir_channels(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
-{
-    AVFrame *out = arg;
-    const int start = (out->channels * jobnr) / nb_jobs;
-    const int end = (out->channels * (jobnr+1)) / nb_jobs;
-
-    for (int ch = start; ch < end; ch++) {
-        fir_channel(ctx, out, ch);
-    }
-
-    return 0;
-}
-
 static int fir_frame(AudioFIRContext *s, AVFrame *in, AVFilterLink *outlink)
 {
     AVFilterContext *ctx = outlink->src;
     AVFrame *out = NULL;
+    int ret;
 
     out = ff_get_audio_buffer(outlink, in->nb_samples);
     if (!out) {
@@ -223,16 +53,28 @@ static int fir_frame(AudioFIRContext *s, AVFrame *in, AVFilterLink *outlink)
 
     if (s->pts == AV_NOPTS_VALUE)
         s->pts = in->pts;
-    s->in = in;
-    ctx->internal->execute(ctx, fir_channels, out, NULL, FFMIN(outlink->channels,
-                                                               ff_filter_get_nb_threads(ctx)));
+    ret = ff_partconv_process(ctx, s->conv, (float **)out->extended_data, 1,
+                              (const float **)in->extended_data, 1, in->nb_samples);
+    if (ret < 0) {
+        av_frame_free(&in);
+        av_frame_free(&out);
+        return ret;
+    }
+
+    /* The convolution is linear, so the dry gain is applied with the wet one. */
+    for (int ch = 0; ch < out->channels; ch++) {
+        float *ptr = (float *)out->extended_data[ch];
+
+        s->fdsp->vector_fmul_scalar(ptr, ptr, s->dry_gain * s->wet_gain,
+                                    FFALIGN(out->nb_samples, 4));
+    }
+    emms_c();
 
     out->pts = s->pts;
     if (s->pts != AV_NOPTS_VALUE)
         s->pts += av_rescale_q(out->nb_samples, (AVRational){1, outlink->sample_rate}, outlink->time_base);
 
     av_frame_free(&in);
-    s->in = NULL;
 
     return ff_filter_frame(outlink, out);
 }
@@ -375,87 +217,14 @@ end:
     av_free(mag);
 }
 
-static int init_segment(AVFilterContext *ctx, AudioFIRSegment *seg,
-                        int offset, int nb_partitions, int part_size)
-{
-    AudioFIRContext *s = ctx->priv;
-
-    seg->rdft  = av_calloc(ctx->inputs[0]->channels, sizeof(*seg->rdft));
-    seg->irdft = av_calloc(ctx->inputs[0]->channels, sizeof(*seg->irdft));
-    if (!seg->rdft || !seg->irdft)
-        return AVERROR(ENOMEM);
-
-    seg->fft_length    = part_size * 2 + 1;
-    seg->part_size     = part_size;
-    seg->block_size    = FFALIGN(seg->fft_length, 32);
-    seg->coeff_size    = FFALIGN(seg->part_size + 1, 32);
-    seg->nb_partitions = nb_partitions;
-    seg->input_size    = offset + s->min_part_size;
-    seg->input_offset  = offset;
-
-    seg->part_index    = av_calloc(ctx->inputs[0]->channels, sizeof(*seg->part_index));
-    seg->output_offset = av_calloc(ctx->inputs[0]->channels, sizeof(*seg->output_offset));
-    if (!seg->part_index || !seg->output_offset)
-        return AVERROR(ENOMEM);
-
-    for (int ch = 0; ch < ctx->inputs[0]->channels && part_size >= 8; ch++) {
-        seg->rdft[ch]  = av_rdft_init(av_log2(2 * part_size), DFT_R2C);
-        seg->irdft[ch] = av_rdft_init(av_log2(2 * part_size), IDFT_C2R);
-        if (!seg->rdft[ch] || !seg->irdft[ch])
-            return AVERROR(ENOMEM);
-    }
-
-    seg->sum    = ff_get_audio_buffer(ctx->inputs[0], seg->fft_length);
-    seg->block  = ff_get_audio_buffer(ctx->inputs[0], seg->nb_partitions * seg->block_size);
-    seg->buffer = ff_get_audio_buffer(ctx->inputs[0], seg->part_size);
-    seg->coeff  = ff_get_audio_buffer(ctx->inputs[1 + s->selir], seg->nb_partitions * seg->coeff_size * 2);
-    seg->input  = ff_get_audio_buffer(ctx->inputs[0], seg->input_size);
-    seg->output = ff_get_audio_buffer(ctx->inputs[0], seg->part_size);
-    if (!seg->buffer || !seg->sum || !seg->block || !seg->coeff || !seg->input || !seg->output)
-        return AVERROR(ENOMEM);
-
-    return 0;
-}
-
-static void uninit_segment(AVFilterContext *ctx, AudioFIRSegment *seg)
-{
-    AudioFIRContext *s = ctx->priv;
-
-    if (seg->rdft) {
-        for (int ch = 0; ch < s->nb_channels; ch++) {
-            av_rdft_end(seg->rdft[ch]);
-        }
-    }
-    av_freep(&seg->rdft);
-
-    if (seg->irdft) {
-        for (int ch = 0; ch < s->nb_channels; ch++) {
-            av_rdft_end(seg->irdft[ch]);
-        }
-    }
-    av_freep(&seg->irdft);
-
-    av_freep(&seg->output_offset);
-    av_freep(&seg->part_index);
-
-    av_frame_free(&seg->block);
-    av_frame_free(&seg->sum);
-    av_frame_free(&seg->buffer);
-    av_frame_free(&seg->coeff);
-    av_frame_free(&seg->input);
-    av_frame_free(&seg->output);
-    seg->input_size = 0;
-}
-
 static int convert_coeffs(AVFilterContext *ctx)
 {
     AudioFIRContext *s = ctx->priv;
-    int ret, i, ch, n, cur_nb_taps;
+    int ret, i, ch, cur_nb_taps;
     float power = 0;
 
     if (!s->nb_taps) {
         int part_size, max_part_size;
-        int left, offset = 0;
 
         s->nb_taps = ff_inlink_queued_samples(ctx->inputs[1 + s->selir]);
         if (s->nb_taps <= 0)
@@ -465,24 +234,27 @@ static int convert_coeffs(AVFilterContext *ctx)
             s->maxp = s->minp;
         }
 
-        left = s->nb_taps;
         part_size = 1 << av_log2(s->minp);
         max_part_size = 1 << av_log2(s->maxp);
 
         s->min_part_size = part_size;
 
-        for (i = 0; left > 0; i++) {
-            int step = part_size == max_part_size ? INT_MAX : 1 + (i == 0);
-            int nb_partitions = FFMIN(step, (left + part_size - 1) / part_size);
+        ret = ff_partconv_init(&s->conv, s->nb_channels, s->nb_channels,
+                               s->one2many ? 1 : s->nb_channels, s->nb_taps,
+                               part_size, max_part_size);
+        if (ret < 0)
+            return ret;
 
-            s->nb_segments = i + 1;
-            ret = init_segment(ctx, &s->seg[i], offset, nb_partitions, part_size);
-            if (ret < 0)
-                return ret;
-            offset += nb_partitions * part_size;
-            left -= nb_partitions * part_size;
-            part_size *= 2;
-            part_size = FFMIN(part_size, max_part_size);
+        for (ch = 0; ch < s->nb_channels; ch++)
+            ff_partconv_map(s->conv, ch, ch, ch * !s->one2many);
+
+        for (i = 0; i < s->conv->nb_segments; i++) {
+            PartConvSegment *seg = &s->conv->seg[i];
+
+            av_log(ctx, AV_LOG_DEBUG, "segment: %d\n", i);
+            av_log(ctx, AV_LOG_DEBUG, "nb_partitions: %d\n", seg->nb_partitions);
+            av_log(ctx, AV_LOG_DEBUG, "partition size: %d\n", seg->part_size);
+            av_log(ctx, AV_LOG_DEBUG, "input_offset: %d\n", seg->input_offset);
         }
     }
 
@@ -544,63 +316,17 @@ static int convert_coeffs(AVFilterContext *ctx)
     }
 
     av_log(ctx, AV_LOG_DEBUG, "nb_taps: %d\n", cur_nb_taps);
-    av_log(ctx, AV_LOG_DEBUG, "nb_segments: %d\n", s->nb_segments);
+    av_log(ctx, AV_LOG_DEBUG, "nb_segments: %d\n", s->conv->nb_segments);
 
     for (ch = 0; ch < ctx->inputs[1 + s->selir]->channels; ch++) {
         float *time = (float *)s->ir[s->selir]->extended_data[!s->one2many * ch];
-        int toffset = 0;
 
         for (i = FFMAX(1, s->length * s->nb_taps); i < s->nb_taps; i++)
             time[i] = 0;
 
-        av_log(ctx, AV_LOG_DEBUG, "channel: %d\n", ch);
-
-        for (int segment = 0; segment < s->nb_segments; segment++) {
-            AudioFIRSegment *seg = &s->seg[segment];
-            float *block = (float *)seg->block->extended_data[ch];
-            FFTComplex *coeff = (FFTComplex *)seg->coeff->extended_data[ch];
-
-            av_log(ctx, AV_LOG_DEBUG, "segment: %d\n", segment);
-
-            for (i = 0; i < seg->nb_partitions; i++) {
-                const float scale = 1.f / seg->part_size;
-                const int coffset = i * seg->coeff_size;
-                const int remaining = s->nb_taps - toffset;
-                const int size = remaining >= seg->part_size ? seg->part_size : remaining;
-
-                if (size < 8) {
-                    for (n = 0; n < size; n++)
-                        coeff[coffset + n].re = time[toffset + n];
-
-                    toffset += size;
-                    continue;
-                }
-
-                memset(block, 0, sizeof(*block) * seg->fft_length);
-                memcpy(block, time + toffset, size * sizeof(*block));
-
-                av_rdft_calc(seg->rdft[0], block);
-
-                coeff[coffset].re = block[0] * scale;
-                coeff[coffset].im = 0;
-                for (n = 1; n < seg->part_size; n++) {
-                    coeff[coffset + n].re = block[2 * n] * scale;
-                    coeff[coffset + n].im = block[2 * n + 1] * scale;
-                }
-                coeff[coffset + seg->part_size].re = block[1] * scale;
-                coeff[coffset + seg->part_size].im = 0;
-
-                toffset += size;
-            }
-
-            av_log(ctx, AV_LOG_DEBUG, "nb_partitions: %d\n", seg->nb_partitions);
-            av_log(ctx, AV_LOG_DEBUG, "partition size: %d\n", seg->part_size);
-            av_log(ctx, AV_LOG_DEBUG, "block size: %d\n", seg->block_size);
-            av_log(ctx, AV_LOG_DEBUG, "fft_length: %d\n", seg->fft_length);
-            av_log(ctx, AV_LOG_DEBUG, "coeff_size: %d\n", seg->coeff_size);
-            av_log(ctx, AV_LOG_DEBUG, "input_size: %d\n", seg->input_size);
-            av_log(ctx, AV_LOG_DEBUG, "input_offset: %d\n", seg->input_offset);
-        }
+        ret = ff_partconv_set_ir(s->conv, ch, time, FFMIN(cur_nb_taps, s->nb_taps));
+        if (ret < 0)
+            return ret;
     }
 
     s->have_coeffs = 1;
@@ -788,9 +514,7 @@ static av_cold void uninit(AVFilterContext *ctx)
 {
     AudioFIRContext *s = ctx->priv;
 
-    for (int i = 0; i < s->nb_segments; i++) {
-        uninit_segment(ctx, &s->seg[i]);
-    }
+    ff_partconv_uninit(&s->conv);
 
     av_freep(&s->fdsp);
 
@@ -823,14 +547,6 @@ static int config_video(AVFilterLink *outlink)
     return 0;
 }
 
-void ff_afir_init(AudioFIRDSPContext *dsp)
-{
-    dsp->fcmul_add = fcmul_add_c;
-
-    if (ARCH_X86)
-        ff_afir_init_x86(dsp);
-}
-
 static av_cold int init(AVFilterContext *ctx)
 {
     AudioFIRContext *s = ctx->priv;
@@ -888,8 +604,6 @@ static av_cold int init(AVFilterContext *ctx)
     if (!s->fdsp)
         return AVERROR(ENOMEM);
 
-    ff_afir_init(&s->afirdsp);
-
     return 0;
 }
 
@@ -167,4 +167,5 @@ const AVFilter ff_af_aformat = {
     .priv_class    = &aformat_class,
     .inputs        = avfilter_af_aformat_inputs,
     .outputs       = avfilter_af_aformat_outputs,
+    .flags_internal = FF_FILTER_FLAG_AUDIO_BATCH,
 };
@@ -48,4 +48,5 @@ const AVFilter ff_af_anull = {
     .description   = NULL_IF_CONFIG_SMALL("Pass the source unchanged to the output."),
     .inputs        = avfilter_af_anull_inputs,
     .outputs       = avfilter_af_anull_outputs,
+    .flags_internal = FF_FILTER_FLAG_AUDIO_BATCH,
 };
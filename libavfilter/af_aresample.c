@@ -154,6 +154,9 @@ static int config_output(AVFilterLink *outlink)
         av_opt_set_int(aresample->swr, "ich", inlink->channels, 0);
     if (!outlink->channel_layout)
         av_opt_set_int(aresample->swr, "och", outlink->channels, 0);
+    /* the generic threads option shadows the one of the resampler */
+    if (ctx->nb_threads > 0)
+        av_opt_set_int(aresample->swr, "threads", ff_filter_get_nb_threads(ctx), 0);
 
     ret = swr_init(aresample->swr);
     if (ret < 0)
@@ -352,4 +355,5 @@ const AVFilter ff_af_aresample = {
     .priv_class    = &aresample_class,
     .inputs        = aresample_inputs,
     .outputs       = aresample_outputs,
+    .flags_internal = FF_FILTER_FLAG_AUDIO_BATCH,
 };
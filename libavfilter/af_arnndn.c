@@ -40,6 +40,7 @@
 #include "libavutil/opt.h"
 #include "libavutil/tx.h"
 #include "avfilter.h"
+#include "af_arnndndsp.h"
 #include "audio.h"
 #include "filters.h"
 #include "formats.h"
@@ -132,6 +133,17 @@ typedef struct DenoiseState {
     RNNState rnn[2];
     AVTXContext *tx, *txi;
     av_tx_fn tx_fn, txi_fn;
+
+    /* analysis of the current frame, kept for evaluating the network
+     * together with other channels and for the synthesis */
+    AVComplexFloat X[FREQ_SIZE];
+    AVComplexFloat P[WINDOW_SIZE];
+    float Ex[NB_BANDS], Ep[NB_BANDS];
+    DECLARE_ALIGNED(32, float, Exp)[NB_BANDS];
+    float features[NB_FEATURES];
+    float g[NB_BANDS];
+    float vad_prob;
+    int silence;
 } DenoiseState;
 
 typedef struct AudioRNNContext {
@@ -149,6 +161,7 @@ typedef struct AudioRNNContext {
     RNNModel *model[2];
 
     AVFloatDSPContext *fdsp;
+    AudioRNNDSPContext dsp;
 } AudioRNNContext;
 
 #define F_ACTIVATION_TANH       0
@@ -257,8 +270,26 @@ static int rnnoise_model_from_file(FILE *f, RNNModel **rnn)
     } \
     } while (0)
 
+#define INPUT_ARRAY2(name, len0, len1) do { \
+    float *values = av_calloc(FFALIGN((len0), 8) * (len1), sizeof(float)); \
+    if (!values) { \
+        rnnoise_model_free(ret); \
+        return AVERROR(ENOMEM); \
+    } \
+    name = values; \
+    for (int j = 0; j < (len0); j++) { \
+        for (int i = 0; i < (len1); i++) { \
+            if (fscanf(f, "%d", &in) != 1) { \
+                rnnoise_model_free(ret); \
+                return AVERROR(EINVAL); \
+            } \
+            values[i * FFALIGN((len0), 8) + j] = in; \
+        } \
+    } \
+    } while (0)
+
 #define INPUT_ARRAY3(name, len0, len1, len2) do { \
-    float *values = av_calloc(FFALIGN((len0), 4) * FFALIGN((len1), 4) * (len2), sizeof(float)); \
+    float *values = av_calloc(FFALIGN((len0), 8) * FFALIGN((len1), 8) * (len2), sizeof(float)); \
     if (!values) { \
         rnnoise_model_free(ret); \
         return AVERROR(ENOMEM); \
@@ -271,7 +302,7 @@ static int rnnoise_model_from_file(FILE *f, RNNModel **rnn)
                     rnnoise_model_free(ret); \
                     return AVERROR(EINVAL); \
                 } \
-                values[j * (len2) * FFALIGN((len0), 4) + i * FFALIGN((len0), 4) + k] = in; \
+                values[j * (len2) * FFALIGN((len0), 8) + i * FFALIGN((len0), 8) + k] = in; \
             } \
         } \
     } \
@@ -291,7 +322,7 @@ static int rnnoise_model_from_file(FILE *f, RNNModel **rnn)
     ret->name ## _size = name->nb_neurons; \
     INPUT_ACTIVATION(name->activation); \
     NEW_LINE(); \
-    INPUT_ARRAY(name->input_weights, name->nb_inputs * name->nb_neurons); \
+    INPUT_ARRAY2(name->input_weights, name->nb_inputs, name->nb_neurons); \
     NEW_LINE(); \
     INPUT_ARRAY(name->bias, name->nb_neurons); \
     NEW_LINE(); \
@@ -1262,138 +1293,218 @@ static inline float sigmoid_approx(float x)
     return .5f + .5f*tansig_approx(.5f*x);
 }
 
-static void compute_dense(const DenseLayer *layer, float *output, const float *input)
+static void dot_rows_c(float *dst, const float *w, ptrdiff_t w_stride,
+                       const float *src, ptrdiff_t len, ptrdiff_t rows)
 {
-    const int N = layer->nb_neurons, M = layer->nb_inputs, stride = N;
+    for (int i = 0; i < rows; i++) {
+        float sum = 0.f;
 
-    for (int i = 0; i < N; i++) {
-        /* Compute update gate. */
-        float sum = layer->bias[i];
+        for (int k = 0; k < len; k++)
+            sum += w[i * w_stride + k] * src[k];
+        dst[i] = sum;
+    }
+}
 
-        for (int j = 0; j < M; j++)
-            sum += layer->input_weights[j * stride + i] * input[j];
+static void dot_rows4_c(float *dst, ptrdiff_t dst_stride,
+                        const float *w, ptrdiff_t w_stride,
+                        const float *src, ptrdiff_t src_stride,
+                        ptrdiff_t len, ptrdiff_t rows)
+{
+    for (int b = 0; b < ARNNDN_BATCH; b++)
+        dot_rows_c(dst + b * dst_stride, w, w_stride, src + b * src_stride, len, rows);
+}
 
-        output[i] = WEIGHTS_SCALE * sum;
-    }
+void ff_arnndn_init(AudioRNNDSPContext *dsp)
+{
+    dsp->dot_rows  = dot_rows_c;
+    dsp->dot_rows4 = dot_rows4_c;
+
+    if (ARCH_X86)
+        ff_arnndn_init_x86(dsp);
+}
+
+/* Multiply the matrix w by the nb vectors of src, writing the products
+ * to rows of MAX_NEURONS floats of dst. */
+static void dot_rows(AudioRNNContext *s, float *dst, const float *w, ptrdiff_t w_stride,
+                     const float *src, ptrdiff_t src_stride, int len, int rows, int nb)
+{
+    int b = 0;
+
+    for (; b + ARNNDN_BATCH <= nb; b += ARNNDN_BATCH)
+        s->dsp.dot_rows4(dst + b * MAX_NEURONS, MAX_NEURONS, w, w_stride,
+                         src + b * src_stride, src_stride, len, rows);
+    for (; b < nb; b++)
+        s->dsp.dot_rows(dst + b * MAX_NEURONS, w, w_stride, src + b * src_stride, len, rows);
+}
+
+static float activate_neuron(int activation, float x)
+{
+    if (activation == ACTIVATION_SIGMOID)
+        return sigmoid_approx(x);
+    else if (activation == ACTIVATION_TANH)
+        return tansig_approx(x);
+    else if (activation == ACTIVATION_RELU)
+        return FFMAX(0, x);
+    av_assert0(0);
+}
+
+static void compute_dense(AudioRNNContext *s, const DenseLayer *layer, float *output,
+                          const float *input, ptrdiff_t input_stride, int nb)
+{
+    const int N = layer->nb_neurons, AM = FFALIGN(layer->nb_inputs, 8);
+
+    dot_rows(s, output, layer->input_weights, AM, input, input_stride, AM, N, nb);
+
+    for (int b = 0; b < nb; b++) {
+        float *out = output + b * MAX_NEURONS;
 
-    if (layer->activation == ACTIVATION_SIGMOID) {
-        for (int i = 0; i < N; i++)
-            output[i] = sigmoid_approx(output[i]);
-    } else if (layer->activation == ACTIVATION_TANH) {
-        for (int i = 0; i < N; i++)
-            output[i] = tansig_approx(output[i]);
-    } else if (layer->activation == ACTIVATION_RELU) {
         for (int i = 0; i < N; i++)
-            output[i] = FFMAX(0, output[i]);
-    } else {
-        av_assert0(0);
+            out[i] = activate_neuron(layer->activation, WEIGHTS_SCALE * (layer->bias[i] + out[i]));
+        /* the next layer reads the output up to a multiple of 8 floats */
+        memset(out + N, 0, (FFALIGN(N, 8) - N) * sizeof(*out));
     }
 }
 
-static void compute_gru(AudioRNNContext *s, const GRULayer *gru, float *state, const float *input)
+static void compute_gru(AudioRNNContext *s, const GRULayer *gru, float *state,
+                        const float *input, ptrdiff_t input_stride, int nb)
 {
-    LOCAL_ALIGNED_32(float, z, [MAX_NEURONS]);
-    LOCAL_ALIGNED_32(float, r, [MAX_NEURONS]);
-    LOCAL_ALIGNED_32(float, h, [MAX_NEURONS]);
+    LOCAL_ALIGNED_32(float, z,  [ARNNDN_BATCH * MAX_NEURONS]);
+    LOCAL_ALIGNED_32(float, r,  [ARNNDN_BATCH * MAX_NEURONS]);
+    LOCAL_ALIGNED_32(float, h,  [ARNNDN_BATCH * MAX_NEURONS]);
+    LOCAL_ALIGNED_32(float, t,  [ARNNDN_BATCH * MAX_NEURONS]);
+    LOCAL_ALIGNED_32(float, rs, [ARNNDN_BATCH * MAX_NEURONS]);
     const int M = gru->nb_inputs;
     const int N = gru->nb_neurons;
-    const int AN = FFALIGN(N, 4);
-    const int AM = FFALIGN(M, 4);
+    const int AN = FFALIGN(N, 8);
+    const int AM = FFALIGN(M, 8);
     const int stride = 3 * AN, istride = 3 * AM;
 
-    for (int i = 0; i < N; i++) {
-        /* Compute update gate. */
-        float sum = gru->bias[i];
+    /* Compute update gate. */
+    dot_rows(s, z, gru->input_weights,     istride, input, input_stride, AM, N, nb);
+    dot_rows(s, t, gru->recurrent_weights, stride,  state, MAX_NEURONS,  AN, N, nb);
+    for (int b = 0; b < nb * MAX_NEURONS; b += MAX_NEURONS)
+        for (int i = 0; i < N; i++)
+            z[b + i] = sigmoid_approx(WEIGHTS_SCALE * (gru->bias[i] + z[b + i] + t[b + i]));
+
+    /* Compute reset gate. */
+    dot_rows(s, r, gru->input_weights + AM,     istride, input, input_stride, AM, N, nb);
+    dot_rows(s, t, gru->recurrent_weights + AN, stride,  state, MAX_NEURONS,  AN, N, nb);
+    for (int b = 0; b < nb * MAX_NEURONS; b += MAX_NEURONS) {
+        for (int i = 0; i < N; i++) {
+            r[b + i]  = sigmoid_approx(WEIGHTS_SCALE * (gru->bias[N + i] + r[b + i] + t[b + i]));
+            rs[b + i] = state[b + i] * r[b + i];
+        }
+        memset(rs + b + N, 0, (AN - N) * sizeof(*rs));
+    }
 
-        sum += s->fdsp->scalarproduct_float(gru->input_weights + i * istride, input, AM);
-        sum += s->fdsp->scalarproduct_float(gru->recurrent_weights + i * stride, state, AN);
-        z[i] = sigmoid_approx(WEIGHTS_SCALE * sum);
+    /* Compute output. */
+    dot_rows(s, h, gru->input_weights + 2 * AM,     istride, input, input_stride, AM, N, nb);
+    dot_rows(s, t, gru->recurrent_weights + 2 * AN, stride,  rs,    MAX_NEURONS,  AN, N, nb);
+    for (int b = 0; b < nb * MAX_NEURONS; b += MAX_NEURONS) {
+        for (int i = 0; i < N; i++) {
+            float sum = gru->bias[2 * N + i] + h[b + i] + t[b + i];
+
+            sum = activate_neuron(gru->activation, WEIGHTS_SCALE * sum);
+            h[b + i] = z[b + i] * state[b + i] + (1.f - z[b + i]) * sum;
+        }
+        RNN_COPY(state + b, h + b, N);
     }
+}
 
-    for (int i = 0; i < N; i++) {
-        /* Compute reset gate. */
-        float sum = gru->bias[N + i];
+#define INPUT_SIZE 42
 
-        sum += s->fdsp->scalarproduct_float(gru->input_weights + AM + i * istride, input, AM);
-        sum += s->fdsp->scalarproduct_float(gru->recurrent_weights + AN + i * stride, state, AN);
-        r[i] = sigmoid_approx(WEIGHTS_SCALE * sum);
+/* Evaluate the network for the current frame of nb channels at once, so
+ * that the weights are loaded once for all of them. */
+static void compute_rnn(AudioRNNContext *s, DenoiseState *const *st, int nb)
+{
+    LOCAL_ALIGNED_32(float, input,         [ARNNDN_BATCH * MAX_NEURONS]);
+    LOCAL_ALIGNED_32(float, dense_out,     [ARNNDN_BATCH * MAX_NEURONS]);
+    LOCAL_ALIGNED_32(float, vad,           [ARNNDN_BATCH * MAX_NEURONS]);
+    LOCAL_ALIGNED_32(float, gains,         [ARNNDN_BATCH * MAX_NEURONS]);
+    LOCAL_ALIGNED_32(float, vad_state,     [ARNNDN_BATCH * MAX_NEURONS]);
+    LOCAL_ALIGNED_32(float, noise_state,   [ARNNDN_BATCH * MAX_NEURONS]);
+    LOCAL_ALIGNED_32(float, denoise_state, [ARNNDN_BATCH * MAX_NEURONS]);
+    LOCAL_ALIGNED_32(float, gru_input,     [ARNNDN_BATCH * MAX_NEURONS * 3]);
+    const RNNModel *model = st[0]->rnn[0].model;
+    const int gru_stride = MAX_NEURONS * 3;
+
+    /* the vectors are read up to a multiple of 8 floats, so pad them with zeros */
+    memset(input,         0, ARNNDN_BATCH * MAX_NEURONS * sizeof(float));
+    memset(vad_state,     0, ARNNDN_BATCH * MAX_NEURONS * sizeof(float));
+    memset(noise_state,   0, ARNNDN_BATCH * MAX_NEURONS * sizeof(float));
+    memset(denoise_state, 0, ARNNDN_BATCH * MAX_NEURONS * sizeof(float));
+    for (int b = 0; b < nb; b++) {
+        const RNNState *rnn = &st[b]->rnn[0];
+
+        memcpy(input + b * MAX_NEURONS, st[b]->features, NB_FEATURES * sizeof(float));
+        memcpy(vad_state     + b * MAX_NEURONS, rnn->vad_gru_state,     model->vad_gru_size     * sizeof(float));
+        memcpy(noise_state   + b * MAX_NEURONS, rnn->noise_gru_state,   model->noise_gru_size   * sizeof(float));
+        memcpy(denoise_state + b * MAX_NEURONS, rnn->denoise_gru_state, model->denoise_gru_size * sizeof(float));
     }
 
-    for (int i = 0; i < N; i++) {
-        /* Compute output. */
-        float sum = gru->bias[2 * N + i];
-
-        sum += s->fdsp->scalarproduct_float(gru->input_weights + 2 * AM + i * istride, input, AM);
-        for (int j = 0; j < N; j++)
-            sum += gru->recurrent_weights[2 * AN + i * stride + j] * state[j] * r[j];
-
-        if (gru->activation == ACTIVATION_SIGMOID)
-            sum = sigmoid_approx(WEIGHTS_SCALE * sum);
-        else if (gru->activation == ACTIVATION_TANH)
-            sum = tansig_approx(WEIGHTS_SCALE * sum);
-        else if (gru->activation == ACTIVATION_RELU)
-            sum = FFMAX(0, WEIGHTS_SCALE * sum);
-        else
-            av_assert0(0);
-        h[i] = z[i] * state[i] + (1.f - z[i]) * sum;
+    compute_dense(s, model->input_dense, dense_out, input, MAX_NEURONS, nb);
+    compute_gru(s, model->vad_gru, vad_state, dense_out, MAX_NEURONS, nb);
+    compute_dense(s, model->vad_output, vad, vad_state, MAX_NEURONS, nb);
+
+    memset(gru_input, 0, ARNNDN_BATCH * gru_stride * sizeof(float));
+    for (int b = 0; b < nb; b++) {
+        float *noise_input = gru_input + b * gru_stride;
+
+        memcpy(noise_input, dense_out + b * MAX_NEURONS, model->input_dense_size * sizeof(float));
+        memcpy(noise_input + model->input_dense_size,
+               vad_state + b * MAX_NEURONS, model->vad_gru_size * sizeof(float));
+        memcpy(noise_input + model->input_dense_size + model->vad_gru_size,
+               input + b * MAX_NEURONS, INPUT_SIZE * sizeof(float));
     }
 
-    RNN_COPY(state, h, N);
-}
+    compute_gru(s, model->noise_gru, noise_state, gru_input, gru_stride, nb);
 
-#define INPUT_SIZE 42
+    memset(gru_input, 0, ARNNDN_BATCH * gru_stride * sizeof(float));
+    for (int b = 0; b < nb; b++) {
+        float *denoise_input = gru_input + b * gru_stride;
 
-static void compute_rnn(AudioRNNContext *s, RNNState *rnn, float *gains, float *vad, const float *input)
-{
-    LOCAL_ALIGNED_32(float, dense_out,     [MAX_NEURONS]);
-    LOCAL_ALIGNED_32(float, noise_input,   [MAX_NEURONS * 3]);
-    LOCAL_ALIGNED_32(float, denoise_input, [MAX_NEURONS * 3]);
-
-    compute_dense(rnn->model->input_dense, dense_out, input);
-    compute_gru(s, rnn->model->vad_gru, rnn->vad_gru_state, dense_out);
-    compute_dense(rnn->model->vad_output, vad, rnn->vad_gru_state);
-
-    memcpy(noise_input, dense_out, rnn->model->input_dense_size * sizeof(float));
-    memcpy(noise_input + rnn->model->input_dense_size,
-           rnn->vad_gru_state, rnn->model->vad_gru_size * sizeof(float));
-    memcpy(noise_input + rnn->model->input_dense_size + rnn->model->vad_gru_size,
-           input, INPUT_SIZE * sizeof(float));
-
-    compute_gru(s, rnn->model->noise_gru, rnn->noise_gru_state, noise_input);
-
-    memcpy(denoise_input, rnn->vad_gru_state, rnn->model->vad_gru_size * sizeof(float));
-    memcpy(denoise_input + rnn->model->vad_gru_size,
-           rnn->noise_gru_state, rnn->model->noise_gru_size * sizeof(float));
-    memcpy(denoise_input + rnn->model->vad_gru_size + rnn->model->noise_gru_size,
-           input, INPUT_SIZE * sizeof(float));
-
-    compute_gru(s, rnn->model->denoise_gru, rnn->denoise_gru_state, denoise_input);
-    compute_dense(rnn->model->denoise_output, gains, rnn->denoise_gru_state);
+        memcpy(denoise_input, vad_state + b * MAX_NEURONS, model->vad_gru_size * sizeof(float));
+        memcpy(denoise_input + model->vad_gru_size,
+               noise_state + b * MAX_NEURONS, model->noise_gru_size * sizeof(float));
+        memcpy(denoise_input + model->vad_gru_size + model->noise_gru_size,
+               input + b * MAX_NEURONS, INPUT_SIZE * sizeof(float));
+    }
+
+    compute_gru(s, model->denoise_gru, denoise_state, gru_input, gru_stride, nb);
+    compute_dense(s, model->denoise_output, gains, denoise_state, MAX_NEURONS, nb);
+
+    for (int b = 0; b < nb; b++) {
+        RNNState *rnn = &st[b]->rnn[0];
+
+        memcpy(rnn->vad_gru_state,     vad_state     + b * MAX_NEURONS, model->vad_gru_size     * sizeof(float));
+        memcpy(rnn->noise_gru_state,   noise_state   + b * MAX_NEURONS, model->noise_gru_size   * sizeof(float));
+        memcpy(rnn->denoise_gru_state, denoise_state + b * MAX_NEURONS, model->denoise_gru_size * sizeof(float));
+        memcpy(st[b]->g, gains + b * MAX_NEURONS, NB_BANDS * sizeof(float));
+        st[b]->vad_prob = vad[b * MAX_NEURONS];
+    }
 }
 
-static float rnnoise_channel(AudioRNNContext *s, DenoiseState *st, float *out, const float *in,
-                             int disabled)
+static void rnnoise_analysis(AudioRNNContext *s, DenoiseState *st, const float *in)
 {
-    AVComplexFloat X[FREQ_SIZE];
-    AVComplexFloat P[WINDOW_SIZE];
     float x[FRAME_SIZE];
-    float Ex[NB_BANDS], Ep[NB_BANDS];
-    LOCAL_ALIGNED_32(float, Exp, [NB_BANDS]);
-    float features[NB_FEATURES];
-    float g[NB_BANDS];
-    float gf[FREQ_SIZE];
-    float vad_prob = 0;
-    float *history = st->history;
     static const float a_hp[2] = {-1.99599, 0.99600};
     static const float b_hp[2] = {-2, 1};
-    int silence;
 
     biquad(x, st->mem_hp_x, in, b_hp, a_hp, FRAME_SIZE);
-    silence = compute_frame_features(s, st, X, P, Ex, Ep, Exp, features, x);
+    st->silence = compute_frame_features(s, st, st->X, st->P, st->Ex, st->Ep, st->Exp,
+                                         st->features, x);
+}
 
-    if (!silence && !disabled) {
-        compute_rnn(s, &st->rnn[0], g, &vad_prob, features);
-        pitch_filter(X, P, Ex, Ep, Exp, g);
+static void rnnoise_synthesis(AudioRNNContext *s, DenoiseState *st, float *out, const float *in,
+                              int denoise)
+{
+    AVComplexFloat *X = st->X;
+    float *g = st->g;
+    float gf[FREQ_SIZE];
+    float *history = st->history;
+
+    if (denoise) {
+        pitch_filter(X, st->P, st->Ex, st->Ep, st->Exp, g);
         for (int i = 0; i < NB_BANDS; i++) {
             float alpha = .6f;
 
@@ -1411,8 +1522,6 @@ static float rnnoise_channel(AudioRNNContext *s, DenoiseState *st, float *out, c
 
     frame_synthesis(s, st, out, X);
     memcpy(history, in, FRAME_SIZE * sizeof(*history));
-
-    return vad_prob;
 }
 
 typedef struct ThreadData {
@@ -1427,12 +1536,29 @@ static int rnnoise_channels(AVFilterContext *ctx, void *arg, int jobnr, int nb_j
     AVFrame *out = td->out;
     const int start = (out->channels * jobnr) / nb_jobs;
     const int end = (out->channels * (jobnr+1)) / nb_jobs;
+    DenoiseState *batch[ARNNDN_BATCH];
+    int nb = 0;
+
+    for (int ch = start; ch < end; ch++)
+        rnnoise_analysis(s, &s->st[ch], (const float *)in->extended_data[ch]);
+
+    for (int ch = start; ch < end && !ctx->is_disabled; ch++) {
+        if (s->st[ch].silence)
+            continue;
+        batch[nb++] = &s->st[ch];
+        if (nb == ARNNDN_BATCH || ch == end - 1) {
+            compute_rnn(s, batch, nb);
+            nb = 0;
+        }
+    }
+    if (nb)
+        compute_rnn(s, batch, nb);
 
     for (int ch = start; ch < end; ch++) {
-        rnnoise_channel(s, &s->st[ch],
-                        (float *)out->extended_data[ch],
-                        (const float *)in->extended_data[ch],
-                        ctx->is_disabled);
+        rnnoise_synthesis(s, &s->st[ch],
+                          (float *)out->extended_data[ch],
+                          (const float *)in->extended_data[ch],
+                          !ctx->is_disabled && !s->st[ch].silence);
     }
 
     return 0;
@@ -1512,6 +1638,7 @@ static av_cold int init(AVFilterContext *ctx)
     s->fdsp = avpriv_float_dsp_alloc(0);
     if (!s->fdsp)
         return AVERROR(ENOMEM);
+    ff_arnndn_init(&s->dsp);
 
     ret = open_model(ctx, &s->model[0]);
     if (ret < 0)
@@ -0,0 +1,53 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFILTER_ARNNDNDSP_H
+#define AVFILTER_ARNNDNDSP_H
+
+#include <stddef.h>
+
+/**
+ * Number of input vectors dot_rows4() multiplies with the same matrix.
+ */
+#define ARNNDN_BATCH 4
+
+typedef struct AudioRNNDSPContext {
+    /**
+     * Multiply a matrix of rows by one vector:
+     * dst[i] = sum of w[i * w_stride + k] * src[k] for k < len.
+     * len and w_stride are multiples of 8, w and src are 32-byte aligned.
+     */
+    void (*dot_rows)(float *dst, const float *w, ptrdiff_t w_stride,
+                     const float *src, ptrdiff_t len, ptrdiff_t rows);
+
+    /**
+     * Same as dot_rows() for ARNNDN_BATCH vectors at once, vector b is read
+     * from src + b * src_stride and written to dst + b * dst_stride.
+     * Every vector gives the exact same result as with dot_rows().
+     * src_stride is a multiple of 8.
+     */
+    void (*dot_rows4)(float *dst, ptrdiff_t dst_stride,
+                      const float *w, ptrdiff_t w_stride,
+                      const float *src, ptrdiff_t src_stride,
+                      ptrdiff_t len, ptrdiff_t rows);
+} AudioRNNDSPContext;
+
+void ff_arnndn_init(AudioRNNDSPContext *s);
+void ff_arnndn_init_x86(AudioRNNDSPContext *s);
+
+#endif /* AVFILTER_ARNNDNDSP_H */
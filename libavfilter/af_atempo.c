@@ -39,13 +39,13 @@
  */
 
 #include <float.h>
-#include "libavcodec/avfft.h"
 #include "libavutil/avassert.h"
 #include "libavutil/avstring.h"
 #include "libavutil/channel_layout.h"
 #include "libavutil/eval.h"
 #include "libavutil/opt.h"
 #include "libavutil/samplefmt.h"
+#include "libavutil/tx.h"
 #include "avfilter.h"
 #include "audio.h"
 #include "internal.h"
@@ -66,8 +66,9 @@ typedef struct AudioFragment {
     int nsamples;
 
     // rDFT transform of the down-mixed mono fragment, used for
-    // fast waveform alignment via correlation in frequency domain:
-    FFTSample *xdat;
+    // fast waveform alignment via correlation in frequency domain,
+    // window + 1 bins:
+    AVComplexFloat *xdat;
 } AudioFragment;
 
 /**
@@ -139,10 +140,20 @@ typedef struct ATempoContext {
     // current state:
     FilterState state;
 
-    // for fast correlation calculation in frequency domain:
-    RDFTContext *real_to_complex;
-    RDFTContext *complex_to_real;
-    FFTSample *correlation;
+    // for fast correlation calculation in frequency domain, the real
+    // transforms of 2 * window samples are done with complex transforms
+    // of window samples:
+    AVTXContext *real_to_complex;
+    AVTXContext *complex_to_real;
+    av_tx_fn r2c_fn, c2r_fn;
+    AVComplexFloat *twiddle;
+    AVComplexFloat *tx_buf;
+    float *correlation;
+
+    // per slice best alignment candidates:
+    int nb_threads;
+    float *best_metric;
+    int *best_offset;
 
     // for managing AVFilterPad.request_frame and AVFilterPad.filter_frame
     AVFrame *dst_buffer;
@@ -234,12 +245,13 @@ static void yae_release_buffers(ATempoContext *atempo)
     av_freep(&atempo->buffer);
     av_freep(&atempo->hann);
     av_freep(&atempo->correlation);
+    av_freep(&atempo->twiddle);
+    av_freep(&atempo->tx_buf);
+    av_freep(&atempo->best_metric);
+    av_freep(&atempo->best_offset);
 
-    av_rdft_end(atempo->real_to_complex);
-    atempo->real_to_complex = NULL;
-
-    av_rdft_end(atempo->complex_to_real);
-    atempo->complex_to_real = NULL;
+    av_tx_uninit(&atempo->real_to_complex);
+    av_tx_uninit(&atempo->complex_to_real);
 }
 
 /* av_realloc is not aligned enough; fortunately, the data does not need to
@@ -266,7 +278,8 @@ static int yae_reset(ATempoContext *atempo,
     const int sample_size = av_get_bytes_per_sample(format);
     uint32_t nlevels  = 0;
     uint32_t pot;
-    int i;
+    float scale = 1.f;
+    int i, ret;
 
     atempo->format   = format;
     atempo->channels = channels;
@@ -288,29 +301,41 @@ static int yae_reset(ATempoContext *atempo,
     // initialize audio fragment buffers:
     RE_MALLOC_OR_FAIL(atempo->frag[0].data, atempo->window * atempo->stride);
     RE_MALLOC_OR_FAIL(atempo->frag[1].data, atempo->window * atempo->stride);
-    RE_MALLOC_OR_FAIL(atempo->frag[0].xdat, atempo->window * sizeof(FFTComplex));
-    RE_MALLOC_OR_FAIL(atempo->frag[1].xdat, atempo->window * sizeof(FFTComplex));
+    RE_MALLOC_OR_FAIL(atempo->frag[0].xdat, (atempo->window + 1) * sizeof(AVComplexFloat));
+    RE_MALLOC_OR_FAIL(atempo->frag[1].xdat, (atempo->window + 1) * sizeof(AVComplexFloat));
 
     // initialize rDFT contexts:
-    av_rdft_end(atempo->real_to_complex);
-    atempo->real_to_complex = NULL;
+    av_tx_uninit(&atempo->real_to_complex);
+    av_tx_uninit(&atempo->complex_to_real);
 
-    av_rdft_end(atempo->complex_to_real);
-    atempo->complex_to_real = NULL;
-
-    atempo->real_to_complex = av_rdft_init(nlevels + 1, DFT_R2C);
-    if (!atempo->real_to_complex) {
+    ret = av_tx_init(&atempo->real_to_complex, &atempo->r2c_fn,
+                     AV_TX_FLOAT_FFT, 0, atempo->window, &scale, 0);
+    if (ret < 0) {
         yae_release_buffers(atempo);
-        return AVERROR(ENOMEM);
+        return ret;
     }
 
-    atempo->complex_to_real = av_rdft_init(nlevels + 1, IDFT_C2R);
-    if (!atempo->complex_to_real) {
+    ret = av_tx_init(&atempo->complex_to_real, &atempo->c2r_fn,
+                     AV_TX_FLOAT_FFT, 1, atempo->window, &scale, 0);
+    if (ret < 0) {
         yae_release_buffers(atempo);
-        return AVERROR(ENOMEM);
+        return ret;
     }
 
-    RE_MALLOC_OR_FAIL(atempo->correlation, atempo->window * sizeof(FFTComplex));
+    RE_MALLOC_OR_FAIL(atempo->correlation, atempo->window * sizeof(AVComplexFloat));
+    RE_MALLOC_OR_FAIL(atempo->tx_buf, atempo->window * sizeof(AVComplexFloat));
+
+    // e^(-i pi k / window), twiddle factors of the 2 * window real transform:
+    RE_MALLOC_OR_FAIL(atempo->twiddle, (atempo->window + 1) * sizeof(AVComplexFloat));
+
+    for (i = 0; i <= atempo->window; i++) {
+        double phi = M_PI * i / atempo->window;
+        atempo->twiddle[i].re =  cos(phi);
+        atempo->twiddle[i].im = -sin(phi);
+    }
+
+    RE_MALLOC_OR_FAIL(atempo->best_metric, atempo->nb_threads * sizeof(*atempo->best_metric));
+    RE_MALLOC_OR_FAIL(atempo->best_offset, atempo->nb_threads * sizeof(*atempo->best_offset));
 
     atempo->ring = atempo->window * 3;
     RE_MALLOC_OR_FAIL(atempo->buffer, atempo->ring * atempo->stride);
@@ -346,9 +371,9 @@ static int yae_update(AVFilterContext *ctx)
 #define yae_init_xdat(scalar_type, scalar_max)                          \
     do {                                                                \
         const uint8_t *src_end = src +                                  \
-            frag->nsamples * atempo->channels * sizeof(scalar_type);    \
+            (end - start) * atempo->channels * sizeof(scalar_type);     \
                                                                         \
-        FFTSample *xdat = frag->xdat;                                   \
+        float *xdat = (float *)frag->xdat + start;                      \
         scalar_type tmp;                                                \
                                                                         \
         if (atempo->channels == 1) {                                    \
@@ -356,27 +381,27 @@ static int yae_update(AVFilterContext *ctx)
                 tmp = *(const scalar_type *)src;                        \
                 src += sizeof(scalar_type);                             \
                                                                         \
-                *xdat = (FFTSample)tmp;                                 \
+                *xdat = (float)tmp;                                     \
             }                                                           \
         } else {                                                        \
-            FFTSample s, max, ti, si;                                   \
+            float s, max, ti, si;                                       \
             int i;                                                      \
                                                                         \
             for (; src < src_end; xdat++) {                             \
                 tmp = *(const scalar_type *)src;                        \
                 src += sizeof(scalar_type);                             \
                                                                         \
-                max = (FFTSample)tmp;                                   \
-                s = FFMIN((FFTSample)scalar_max,                        \
-                          (FFTSample)fabsf(max));                       \
+                max = (float)tmp;                                       \
+                s = FFMIN((float)scalar_max,                            \
+                          (float)fabsf(max));                           \
                                                                         \
                 for (i = 1; i < atempo->channels; i++) {                \
                     tmp = *(const scalar_type *)src;                    \
                     src += sizeof(scalar_type);                         \
                                                                         \
-                    ti = (FFTSample)tmp;                                \
-                    si = FFMIN((FFTSample)scalar_max,                   \
-                               (FFTSample)fabsf(ti));                   \
+                    ti = (float)tmp;                                    \
+                    si = FFMIN((float)scalar_max,                       \
+                               (float)fabsf(ti));                       \
                                                                         \
                     if (s < si) {                                       \
                         s   = si;                                       \
@@ -390,16 +415,28 @@ static int yae_update(AVFilterContext *ctx)
     } while (0)
 
 /**
- * Initialize complex data buffer of a given audio fragment
- * with down-mixed mono data of appropriate scalar type.
+ * Number of slice jobs for a task of the given size, each job should
+ * process at least YAE_SLICE_MIN scalar samples to be worth a thread.
+ * At 44.1 and 48 kHz the window is 2048 samples, so a stereo fragment
+ * is down-mixed by up to 4 jobs and its overlap blended by up to 2.
  */
-static void yae_downmix(ATempoContext *atempo, AudioFragment *frag)
+#define YAE_SLICE_MIN 1024
+
+static int yae_nb_jobs(const ATempoContext *atempo, int64_t size)
 {
-    // shortcuts:
-    const uint8_t *src = frag->data;
+    return av_clip(size / YAE_SLICE_MIN, 1, atempo->nb_threads);
+}
 
-    // init complex data buffer used for FFT and Correlation:
-    memset(frag->xdat, 0, sizeof(FFTComplex) * atempo->window);
+/**
+ * Down-mix one slice of the fragment samples.
+ */
+static int yae_downmix_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    ATempoContext *atempo = ctx->priv;
+    AudioFragment *frag = arg;
+    const int start = (frag->nsamples *  jobnr     ) / nb_jobs;
+    const int end   = (frag->nsamples * (jobnr + 1)) / nb_jobs;
+    const uint8_t *src = frag->data + start * atempo->stride;
 
     if (atempo->format == AV_SAMPLE_FMT_U8) {
         yae_init_xdat(uint8_t, 127);
@@ -412,6 +449,64 @@ static void yae_downmix(ATempoContext *atempo, AudioFragment *frag)
     } else if (atempo->format == AV_SAMPLE_FMT_DBL) {
         yae_init_xdat(double, 1);
     }
+
+    return 0;
+}
+
+/**
+ * Initialize complex data buffer of a given audio fragment
+ * with down-mixed mono data of appropriate scalar type.
+ */
+static void yae_downmix(AVFilterContext *ctx, AudioFragment *frag)
+{
+    ATempoContext *atempo = ctx->priv;
+
+    // init complex data buffer used for FFT and Correlation:
+    memset(frag->xdat, 0, sizeof(AVComplexFloat) * atempo->window);
+
+    ctx->internal->execute(ctx, yae_downmix_slice, frag, NULL,
+                           yae_nb_jobs(atempo, (int64_t)frag->nsamples * atempo->channels));
+}
+
+/**
+ * Apply rDFT to the down-mixed fragment.
+ *
+ * The 2 * window real samples are transformed as window complex samples,
+ * even samples in the real part and odd samples in the imaginary part.
+ * The spectra of both halves are then separated and combined into the
+ * window + 1 non-redundant bins of the real transform, scaled by 2.
+ */
+static void yae_rdft(ATempoContext *atempo, AudioFragment *frag)
+{
+    const AVComplexFloat *tw = atempo->twiddle;
+    const AVComplexFloat *z = atempo->tx_buf;
+    AVComplexFloat *x = frag->xdat;
+    const int window = atempo->window;
+    int k;
+
+    atempo->r2c_fn(atempo->real_to_complex, atempo->tx_buf, frag->xdat,
+                   sizeof(AVComplexFloat));
+
+    x[0].re      = 2.f * (z[0].re + z[0].im);
+    x[0].im      = 0.f;
+    x[window].re = 2.f * (z[0].re - z[0].im);
+    x[window].im = 0.f;
+
+    for (k = 1; k <= window / 2; k++) {
+        const int m = window - k;
+        // even = z[k] + conj(z[m]), odd = -i * (z[k] - conj(z[m])),
+        // both are conjugated for bin m:
+        const float ere = z[k].re + z[m].re;
+        const float eim = z[k].im - z[m].im;
+        const float ore = z[k].im + z[m].im;
+        const float oim = z[m].re - z[k].re;
+
+        x[k].re = ere + tw[k].re * ore - tw[k].im * oim;
+        x[k].im = eim + tw[k].re * oim + tw[k].im * ore;
+
+        x[m].re =  ere + tw[m].re * ore + tw[m].im * oim;
+        x[m].im = -eim - tw[m].re * oim + tw[m].im * ore;
+    }
 }
 
 /**
@@ -595,35 +690,89 @@ static void yae_advance_to_next_frag(ATempoContext *atempo)
 /**
  * Calculate cross-correlation via rDFT.
  *
- * Multiply two vectors of complex numbers (result of real_to_complex rDFT)
- * and transform back via complex_to_real rDFT.
+ * Multiply two vectors of complex numbers (result of the forward rDFT)
+ * and transform back, the inverse real transform of 2 * window samples
+ * is done with an inverse complex transform of window samples.
  */
-static void yae_xcorr_via_rdft(FFTSample *xcorr,
-                               RDFTContext *complex_to_real,
-                               const FFTComplex *xa,
-                               const FFTComplex *xb,
-                               const int window)
+static void yae_xcorr_via_rdft(ATempoContext *atempo,
+                               const AVComplexFloat *xa,
+                               const AVComplexFloat *xb)
 {
-    FFTComplex *xc = (FFTComplex *)xcorr;
+    const AVComplexFloat *tw = atempo->twiddle;
+    AVComplexFloat *y = atempo->tx_buf;
+    const int window = atempo->window;
+    int k;
+
+    for (k = 0; k <= window / 2; k++) {
+        const int m = window - k;
+        // c = xa * conj(xb) at bins k and window - k:
+        const float ckre = xa[k].re * xb[k].re + xa[k].im * xb[k].im;
+        const float ckim = xa[k].im * xb[k].re - xa[k].re * xb[k].im;
+        const float cmre = xa[m].re * xb[m].re + xa[m].im * xb[m].im;
+        const float cmim = xa[m].im * xb[m].re - xa[m].re * xb[m].im;
+
+        // y[k] = (c[k] + conj(c[m])) + i * conj(tw[k]) * (c[k] - conj(c[m])):
+        float ere = ckre + cmre, eim = ckim - cmim;
+        float dre = ckre - cmre, dim = ckim + cmim;
+
+        y[k].re = ere - tw[k].re * dim + tw[k].im * dre;
+        y[k].im = eim + tw[k].re * dre + tw[k].im * dim;
+
+        if (k && m != k) {
+            // and the same for bin m, with the roles of c[k] and c[m] swapped:
+            ere =  ckre + cmre;
+            eim =  cmim - ckim;
+            dre =  cmre - ckre;
+            dim =  cmim + ckim;
+
+            y[m].re = ere - tw[m].re * dim + tw[m].im * dre;
+            y[m].im = eim + tw[m].re * dre + tw[m].im * dim;
+        }
+    }
+
+    // apply inverse rDFT, the even samples end up in the real part and the
+    // odd samples in the imaginary part:
+    atempo->c2r_fn(atempo->complex_to_real, atempo->correlation, y,
+                   sizeof(AVComplexFloat));
+}
+
+typedef struct AlignData {
+    int i0, i1;
+    int window;
+    int drift;
+} AlignData;
+
+/**
+ * Identify the cross-correlation peak within one slice of the search window.
+ */
+static int yae_align_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    ATempoContext *atempo = ctx->priv;
+    const AlignData *td = arg;
+    const int i0 = td->i0, i1 = td->i1;
+    const int start = i0 + ((i1 - i0) *  jobnr     ) / nb_jobs;
+    const int end   = i0 + ((i1 - i0) * (jobnr + 1)) / nb_jobs;
+    const float *xcorr = atempo->correlation + start;
+    int       best_offset = -td->drift;
+    float     best_metric = -FLT_MAX;
     int i;
 
-    // NOTE: first element requires special care -- Given Y = rDFT(X),
-    // Im(Y[0]) and Im(Y[N/2]) are always zero, therefore av_rdft_calc
-    // stores Re(Y[N/2]) in place of Im(Y[0]).
+    for (i = start; i < end; i++, xcorr++) {
+        float metric = *xcorr;
 
-    xc->re = xa->re * xb->re;
-    xc->im = xa->im * xb->im;
-    xa++;
-    xb++;
-    xc++;
+        // normalize:
+        float drifti = (float)(td->drift + i);
+        metric *= drifti * (float)(i - i0) * (float)(i1 - i);
 
-    for (i = 1; i < window; i++, xa++, xb++, xc++) {
-        xc->re = (xa->re * xb->re + xa->im * xb->im);
-        xc->im = (xa->im * xb->re - xa->re * xb->im);
+        if (metric > best_metric) {
+            best_metric = metric;
+            best_offset = i - td->window / 2;
+        }
     }
 
-    // apply inverse rDFT:
-    av_rdft_calc(complex_to_real, xcorr);
+    atempo->best_metric[jobnr] = best_metric;
+    atempo->best_offset[jobnr] = best_offset;
+    return 0;
 }
 
 /**
@@ -632,48 +781,43 @@ static void yae_xcorr_via_rdft(FFTSample *xcorr,
  *
  * @return alignment offset of current fragment relative to previous.
  */
-static int yae_align(AudioFragment *frag,
+static int yae_align(AVFilterContext *ctx,
+                     AudioFragment *frag,
                      const AudioFragment *prev,
                      const int window,
                      const int delta_max,
-                     const int drift,
-                     FFTSample *correlation,
-                     RDFTContext *complex_to_real)
+                     const int drift)
 {
+    ATempoContext *atempo = ctx->priv;
     int       best_offset = -drift;
-    FFTSample best_metric = -FLT_MAX;
-    FFTSample *xcorr;
+    float     best_metric = -FLT_MAX;
+    AlignData td;
+    int nb_jobs, i;
 
-    int i0;
-    int i1;
-    int i;
-
-    yae_xcorr_via_rdft(correlation,
-                       complex_to_real,
-                       (const FFTComplex *)prev->xdat,
-                       (const FFTComplex *)frag->xdat,
-                       window);
+    yae_xcorr_via_rdft(atempo, prev->xdat, frag->xdat);
 
     // identify search window boundaries:
-    i0 = FFMAX(window / 2 - delta_max - drift, 0);
-    i0 = FFMIN(i0, window);
+    td.i0 = FFMAX(window / 2 - delta_max - drift, 0);
+    td.i0 = FFMIN(td.i0, window);
 
-    i1 = FFMIN(window / 2 + delta_max - drift, window - window / 16);
-    i1 = FFMAX(i1, 0);
+    td.i1 = FFMIN(window / 2 + delta_max - drift, window - window / 16);
+    td.i1 = FFMAX(td.i1, 0);
 
-    // identify cross-correlation peaks within search window:
-    xcorr = correlation + i0;
+    td.window = window;
+    td.drift  = drift;
 
-    for (i = i0; i < i1; i++, xcorr++) {
-        FFTSample metric = *xcorr;
+    // identify cross-correlation peaks within search window, the slices
+    // are merged in order so that the first of equal peaks wins:
+    if (td.i1 <= td.i0)
+        return best_offset;
 
-        // normalize:
-        FFTSample drifti = (FFTSample)(drift + i);
-        metric *= drifti * (FFTSample)(i - i0) * (FFTSample)(i1 - i);
+    nb_jobs = yae_nb_jobs(atempo, td.i1 - td.i0);
+    ctx->internal->execute(ctx, yae_align_slice, &td, NULL, nb_jobs);
 
-        if (metric > best_metric) {
-            best_metric = metric;
-            best_offset = i - window / 2;
+    for (i = 0; i < nb_jobs; i++) {
+        if (atempo->best_metric[i] > best_metric) {
+            best_metric = atempo->best_metric[i];
+            best_offset = atempo->best_offset[i];
         }
     }
 
@@ -686,8 +830,9 @@ static int yae_align(AudioFragment *frag,
  *
  * @return alignment correction.
  */
-static int yae_adjust_position(ATempoContext *atempo)
+static int yae_adjust_position(AVFilterContext *ctx)
 {
+    ATempoContext *atempo = ctx->priv;
     const AudioFragment *prev = yae_prev_frag(atempo);
     AudioFragment       *frag = yae_curr_frag(atempo);
 
@@ -701,13 +846,12 @@ static int yae_adjust_position(ATempoContext *atempo)
     const int drift = (int)(prev_output_position - ideal_output_position);
 
     const int delta_max  = atempo->window / 2;
-    const int correction = yae_align(frag,
+    const int correction = yae_align(ctx,
+                                     frag,
                                      prev,
                                      atempo->window,
                                      delta_max,
-                                     drift,
-                                     atempo->correlation,
-                                     atempo->complex_to_real);
+                                     drift);
 
     if (correction) {
         // adjust fragment position:
@@ -720,6 +864,16 @@ static int yae_adjust_position(ATempoContext *atempo)
     return correction;
 }
 
+typedef struct BlendData {
+    const AudioFragment *frag;
+    const uint8_t *a;
+    const uint8_t *b;
+    const float *wa;
+    const float *wb;
+    uint8_t *dst;
+    int nsamples;
+} BlendData;
+
 /**
  * A helper macro for blending the overlap region of previous
  * and current audio fragment.
@@ -729,12 +883,10 @@ static int yae_adjust_position(ATempoContext *atempo)
         const scalar_type *aaa = (const scalar_type *)a;                \
         const scalar_type *bbb = (const scalar_type *)b;                \
                                                                         \
-        scalar_type *out     = (scalar_type *)dst;                      \
-        scalar_type *out_end = (scalar_type *)dst_end;                  \
+        scalar_type *out = (scalar_type *)dst;                          \
         int64_t i;                                                      \
                                                                         \
-        for (i = 0; i < overlap && out < out_end;                       \
-             i++, atempo->position[1]++, wa++, wb++) {                  \
+        for (i = start; i < end; i++, wa++, wb++) {                     \
             float w0 = *wa;                                             \
             float w1 = *wb;                                             \
             int j;                                                      \
@@ -750,9 +902,42 @@ static int yae_adjust_position(ATempoContext *atempo)
                     (scalar_type)(t0 * w0 + t1 * w1);                   \
             }                                                           \
         }                                                               \
-        dst = (uint8_t *)out;                                           \
     } while (0)
 
+/**
+ * Blend one slice of the overlap region.
+ */
+static int yae_blend_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    const ATempoContext *atempo = ctx->priv;
+    const BlendData *td = arg;
+    const AudioFragment *frag = td->frag;
+    const int start = (td->nsamples *  jobnr     ) / nb_jobs;
+    const int end   = (td->nsamples * (jobnr + 1)) / nb_jobs;
+
+    const float *wa = td->wa + start;
+    const float *wb = td->wb + start;
+
+    const uint8_t *a = td->a + start * atempo->stride;
+    const uint8_t *b = td->b + start * atempo->stride;
+
+    uint8_t *dst = td->dst + start * atempo->stride;
+
+    if (atempo->format == AV_SAMPLE_FMT_U8) {
+        yae_blend(uint8_t);
+    } else if (atempo->format == AV_SAMPLE_FMT_S16) {
+        yae_blend(int16_t);
+    } else if (atempo->format == AV_SAMPLE_FMT_S32) {
+        yae_blend(int);
+    } else if (atempo->format == AV_SAMPLE_FMT_FLT) {
+        yae_blend(float);
+    } else if (atempo->format == AV_SAMPLE_FMT_DBL) {
+        yae_blend(double);
+    }
+
+    return 0;
+}
+
 /**
  * Blend the overlap region of previous and current audio fragment
  * and output the results to the given destination buffer.
@@ -761,11 +946,12 @@ static int yae_adjust_position(ATempoContext *atempo)
  *   0 if the overlap region was completely stored in the dst buffer,
  *   AVERROR(EAGAIN) if more destination buffer space is required.
  */
-static int yae_overlap_add(ATempoContext *atempo,
+static int yae_overlap_add(AVFilterContext *ctx,
                            uint8_t **dst_ref,
                            uint8_t *dst_end)
 {
     // shortcuts:
+    ATempoContext *atempo = ctx->priv;
     const AudioFragment *prev = yae_prev_frag(atempo);
     const AudioFragment *frag = yae_curr_frag(atempo);
 
@@ -780,32 +966,28 @@ static int yae_overlap_add(ATempoContext *atempo,
     const int64_t ia = start_here - prev->position[1];
     const int64_t ib = start_here - frag->position[1];
 
-    const float *wa = atempo->hann + ia;
-    const float *wb = atempo->hann + ib;
-
-    const uint8_t *a = prev->data + ia * atempo->stride;
-    const uint8_t *b = frag->data + ib * atempo->stride;
-
-    uint8_t *dst = *dst_ref;
+    BlendData td;
 
     av_assert0(start_here <= stop_here &&
                frag->position[1] <= start_here &&
                overlap <= frag->nsamples);
 
-    if (atempo->format == AV_SAMPLE_FMT_U8) {
-        yae_blend(uint8_t);
-    } else if (atempo->format == AV_SAMPLE_FMT_S16) {
-        yae_blend(int16_t);
-    } else if (atempo->format == AV_SAMPLE_FMT_S32) {
-        yae_blend(int);
-    } else if (atempo->format == AV_SAMPLE_FMT_FLT) {
-        yae_blend(float);
-    } else if (atempo->format == AV_SAMPLE_FMT_DBL) {
-        yae_blend(double);
-    }
+    td.frag     = frag;
+    td.wa       = atempo->hann + ia;
+    td.wb       = atempo->hann + ib;
+    td.a        = prev->data + ia * atempo->stride;
+    td.b        = frag->data + ib * atempo->stride;
+    td.dst      = *dst_ref;
+    td.nsamples = FFMIN(overlap, (dst_end - td.dst) / atempo->stride);
+
+    if (td.nsamples > 0)
+        ctx->internal->execute(ctx, yae_blend_slice, &td, NULL,
+                               yae_nb_jobs(atempo, td.nsamples * atempo->channels));
+
+    atempo->position[1] += td.nsamples;
 
     // pass-back the updated destination buffer pointer:
-    *dst_ref = dst;
+    *dst_ref = td.dst + td.nsamples * atempo->stride;
 
     return atempo->position[1] == stop_here ? 0 : AVERROR(EAGAIN);
 }
@@ -816,12 +998,14 @@ static int yae_overlap_add(ATempoContext *atempo,
  * as it is able to produce or store.
  */
 static void
-yae_apply(ATempoContext *atempo,
+yae_apply(AVFilterContext *ctx,
           const uint8_t **src_ref,
           const uint8_t *src_end,
           uint8_t **dst_ref,
           uint8_t *dst_end)
 {
+    ATempoContext *atempo = ctx->priv;
+
     while (1) {
         if (atempo->state == YAE_LOAD_FRAGMENT) {
             // load additional data for the current fragment:
@@ -830,10 +1014,10 @@ yae_apply(ATempoContext *atempo,
             }
 
             // down-mix to mono:
-            yae_downmix(atempo, yae_curr_frag(atempo));
+            yae_downmix(ctx, yae_curr_frag(atempo));
 
             // apply rDFT:
-            av_rdft_calc(atempo->real_to_complex, yae_curr_frag(atempo)->xdat);
+            yae_rdft(atempo, yae_curr_frag(atempo));
 
             // must load the second fragment before alignment can start:
             if (!atempo->nfrag) {
@@ -846,7 +1030,7 @@ yae_apply(ATempoContext *atempo,
 
         if (atempo->state == YAE_ADJUST_POSITION) {
             // adjust position for better alignment:
-            if (yae_adjust_position(atempo)) {
+            if (yae_adjust_position(ctx)) {
                 // reload the fragment at the corrected position, so that the
                 // Hann window blending would not require normalization:
                 atempo->state = YAE_RELOAD_FRAGMENT;
@@ -862,17 +1046,17 @@ yae_apply(ATempoContext *atempo,
             }
 
             // down-mix to mono:
-            yae_downmix(atempo, yae_curr_frag(atempo));
+            yae_downmix(ctx, yae_curr_frag(atempo));
 
             // apply rDFT:
-            av_rdft_calc(atempo->real_to_complex, yae_curr_frag(atempo)->xdat);
+            yae_rdft(atempo, yae_curr_frag(atempo));
 
             atempo->state = YAE_OUTPUT_OVERLAP_ADD;
         }
 
         if (atempo->state == YAE_OUTPUT_OVERLAP_ADD) {
             // overlap-add and output the result:
-            if (yae_overlap_add(atempo, dst_ref, dst_end) != 0) {
+            if (yae_overlap_add(ctx, dst_ref, dst_end) != 0) {
                 break;
             }
 
@@ -890,10 +1074,11 @@ yae_apply(ATempoContext *atempo,
  *   0 if all data was completely stored in the dst buffer,
  *   AVERROR(EAGAIN) if more destination buffer space is required.
  */
-static int yae_flush(ATempoContext *atempo,
+static int yae_flush(AVFilterContext *ctx,
                      uint8_t **dst_ref,
                      uint8_t *dst_end)
 {
+    ATempoContext *atempo = ctx->priv;
     AudioFragment *frag = yae_curr_frag(atempo);
     int64_t overlap_end;
     int64_t start_here;
@@ -926,13 +1111,13 @@ static int yae_flush(ATempoContext *atempo,
 
         if (atempo->nfrag) {
             // down-mix to mono:
-            yae_downmix(atempo, frag);
+            yae_downmix(ctx, frag);
 
             // apply rDFT:
-            av_rdft_calc(atempo->real_to_complex, frag->xdat);
+            yae_rdft(atempo, frag);
 
             // align current fragment to previous fragment:
-            if (yae_adjust_position(atempo)) {
+            if (yae_adjust_position(ctx)) {
                 // reload the current fragment due to adjusted position:
                 yae_load_frag(atempo, NULL, NULL);
             }
@@ -944,7 +1129,7 @@ static int yae_flush(ATempoContext *atempo,
                                             frag->nsamples);
 
     while (atempo->position[1] < overlap_end) {
-        if (yae_overlap_add(atempo, dst_ref, dst_end) != 0) {
+        if (yae_overlap_add(ctx, dst_ref, dst_end) != 0) {
             return AVERROR(EAGAIN);
         }
     }
@@ -1045,6 +1230,8 @@ static int config_props(AVFilterLink *inlink)
     enum AVSampleFormat format = inlink->format;
     int sample_rate = (int)inlink->sample_rate;
 
+    atempo->nb_threads = ff_filter_get_nb_threads(ctx);
+
     return yae_reset(atempo, format, sample_rate, inlink->channels);
 }
 
@@ -1105,7 +1292,7 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *src_buffer)
             atempo->dst_end = atempo->dst + n_out * atempo->stride;
         }
 
-        yae_apply(atempo, &src, src_end, &atempo->dst, atempo->dst_end);
+        yae_apply(ctx, &src, src_end, &atempo->dst, atempo->dst_end);
 
         if (atempo->dst == atempo->dst_end) {
             int n_samples = ((atempo->dst - atempo->dst_buffer->data[0]) /
@@ -1146,7 +1333,7 @@ static int request_frame(AVFilterLink *outlink)
                 atempo->dst_end = atempo->dst + n_max * atempo->stride;
             }
 
-            err = yae_flush(atempo, &atempo->dst, atempo->dst_end);
+            err = yae_flush(ctx, &atempo->dst, atempo->dst_end);
 
             n_out = ((atempo->dst - atempo->dst_buffer->data[0]) /
                      atempo->stride);
@@ -1213,4 +1400,5 @@ const AVFilter ff_af_atempo = {
     .priv_class      = &atempo_class,
     .inputs          = atempo_inputs,
     .outputs         = atempo_outputs,
+    .flags           = AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -64,11 +64,16 @@
 
 #include "libavutil/avassert.h"
 #include "libavutil/ffmath.h"
+#include "libavutil/mem_internal.h"
 #include "libavutil/opt.h"
 #include "audio.h"
 #include "avfilter.h"
+#include "biquaddsp.h"
 #include "internal.h"
 
+/* number of frames filtered at once, small enough to stay in cache */
+#define BLOCK_SIZE 256
+
 enum FilterType {
     biquad,
     equalizer,
@@ -94,16 +99,14 @@ enum WidthType {
 };
 
 enum TransformType {
-    DI,
-    DII,
-    TDII,
-    LATT,
+    DI   = BIQUAD_DI,
+    DII  = BIQUAD_DII,
+    TDII = BIQUAD_TDII,
+    LATT = BIQUAD_LATT,
     NB_TTYPE,
 };
 
 typedef struct ChanCache {
-    double i1, i2;
-    double o1, o2;
     int clippings;
 } ChanCache;
 
@@ -136,10 +139,14 @@ typedef struct BiquadsContext {
     ChanCache *cache;
     int block_align;
 
-    void (*filter)(struct BiquadsContext *s, const void *ibuf, void *obuf, int len,
-                   double *i1, double *i2, double *o1, double *o2,
-                   double b0, double b1, double b2, double a1, double a2, int *clippings,
-                   int disabled);
+    BiquadDSPContext dsp;
+    DECLARE_ALIGNED(32, double, coeffs)[BIQUAD_NB_COEFFS * BIQUAD_LANES_DBL];
+    double *state;      ///< filter history of each group of channels
+    double *lanes;      ///< interleaved samples of each group of channels
+    int nb_groups;
+
+    void (*filter)(struct BiquadsContext *s, const AVFrame *in, AVFrame *out,
+                   int group, unsigned lanes_mask, int disabled);
 } BiquadsContext;
 
 static int query_formats(AVFilterContext *ctx)
@@ -200,255 +207,98 @@ static int query_formats(AVFilterContext *ctx)
     return ff_set_common_samplerates(ctx, formats);
 }
 
+/* Direct form I used to run over pairs of samples, the last sample of an odd
+ * length frame was summed in another order, keep it for identical output. */
+static void biquad_di_odd_tail(double *lanes, const double *coeffs, double *state)
+{
+    for (int l = 0; l < BIQUAD_LANES_DBL; l++) {
+        const double b0 = coeffs[0 * BIQUAD_LANES_DBL + l];
+        const double b1 = coeffs[1 * BIQUAD_LANES_DBL + l];
+        const double b2 = coeffs[2 * BIQUAD_LANES_DBL + l];
+        const double a1 = coeffs[3 * BIQUAD_LANES_DBL + l];
+        const double a2 = coeffs[4 * BIQUAD_LANES_DBL + l];
+        const double i1 = state[0 * BIQUAD_LANES_DBL + l];
+        const double i2 = state[1 * BIQUAD_LANES_DBL + l];
+        const double o1 = state[2 * BIQUAD_LANES_DBL + l];
+        const double o2 = state[3 * BIQUAD_LANES_DBL + l];
+        const double in = lanes[l];
+        const double o0 = in * b0 + i1 * b1 + i2 * b2 + o1 * a1 + o2 * a2;
+
+        state[0 * BIQUAD_LANES_DBL + l] = in;
+        state[1 * BIQUAD_LANES_DBL + l] = i1;
+        state[2 * BIQUAD_LANES_DBL + l] = o0;
+        state[3 * BIQUAD_LANES_DBL + l] = o1;
+        lanes[l] = o0;
+    }
+}
+
+/* The channels are filtered in groups of BIQUAD_LANES_DBL interleaved lanes,
+ * lanes not set in lanes_mask are copied unfiltered. */
 #define BIQUAD_FILTER(name, type, min, max, need_clipping)                    \
 static void biquad_## name (BiquadsContext *s,                                \
-                            const void *input, void *output, int len,         \
-                            double *in1, double *in2,                         \
-                            double *out1, double *out2,                       \
-                            double b0, double b1, double b2,                  \
-                            double a1, double a2, int *clippings,             \
+                            const AVFrame *in, AVFrame *out,                  \
+                            int group, unsigned lanes_mask,                   \
                             int disabled)                                     \
 {                                                                             \
-    const type *ibuf = input;                                                 \
-    type *obuf = output;                                                      \
-    double i1 = *in1;                                                         \
-    double i2 = *in2;                                                         \
-    double o1 = *out1;                                                        \
-    double o2 = *out2;                                                        \
+    const int first = group * BIQUAD_LANES_DBL;                               \
+    const int nb_lanes = FFMIN(in->channels - first, BIQUAD_LANES_DBL);       \
+    double *lanes = s->lanes + group * BLOCK_SIZE * BIQUAD_LANES_DBL;         \
+    double *state = s->state + group * BIQUAD_NB_STATES * BIQUAD_LANES_DBL;   \
     double wet = s->mix;                                                      \
     double dry = 1. - wet;                                                    \
-    double out;                                                               \
-    int i;                                                                    \
-    a1 = -a1;                                                                 \
-    a2 = -a2;                                                                 \
                                                                               \
-    for (i = 0; i+1 < len; i++) {                                             \
-        o2 = i2 * b2 + i1 * b1 + ibuf[i] * b0 + o2 * a2 + o1 * a1;            \
-        i2 = ibuf[i];                                                         \
-        out = o2 * wet + i2 * dry;                                            \
-        if (disabled) {                                                       \
-            obuf[i] = i2;                                                     \
-        } else if (need_clipping && out < min) {                              \
-            (*clippings)++;                                                   \
-            obuf[i] = min;                                                    \
-        } else if (need_clipping && out > max) {                              \
-            (*clippings)++;                                                   \
-            obuf[i] = max;                                                    \
-        } else {                                                              \
-            obuf[i] = out;                                                    \
-        }                                                                     \
-        i++;                                                                  \
-        o1 = i1 * b2 + i2 * b1 + ibuf[i] * b0 + o1 * a2 + o2 * a1;            \
-        i1 = ibuf[i];                                                         \
-        out = o1 * wet + i1 * dry;                                            \
-        if (disabled) {                                                       \
-            obuf[i] = i1;                                                     \
-        } else if (need_clipping && out < min) {                              \
-            (*clippings)++;                                                   \
-            obuf[i] = min;                                                    \
-        } else if (need_clipping && out > max) {                              \
-            (*clippings)++;                                                   \
-            obuf[i] = max;                                                    \
-        } else {                                                              \
-            obuf[i] = out;                                                    \
-        }                                                                     \
-    }                                                                         \
-    if (i < len) {                                                            \
-        double o0 = ibuf[i] * b0 + i1 * b1 + i2 * b2 + o1 * a1 + o2 * a2;     \
-        i2 = i1;                                                              \
-        i1 = ibuf[i];                                                         \
-        o2 = o1;                                                              \
-        o1 = o0;                                                              \
-        out = o0 * wet + i1 * dry;                                            \
-        if (disabled) {                                                       \
-            obuf[i] = i1;                                                     \
-        } else if (need_clipping && out < min) {                              \
-            (*clippings)++;                                                   \
-            obuf[i] = min;                                                    \
-        } else if (need_clipping && out > max) {                              \
-            (*clippings)++;                                                   \
-            obuf[i] = max;                                                    \
-        } else {                                                              \
-            obuf[i] = out;                                                    \
-        }                                                                     \
-    }                                                                         \
-    *in1  = i1;                                                               \
-    *in2  = i2;                                                               \
-    *out1 = o1;                                                               \
-    *out2 = o2;                                                               \
-}
-
-BIQUAD_FILTER(s16, int16_t, INT16_MIN, INT16_MAX, 1)
-BIQUAD_FILTER(s32, int32_t, INT32_MIN, INT32_MAX, 1)
-BIQUAD_FILTER(flt, float,   -1., 1., 0)
-BIQUAD_FILTER(dbl, double,  -1., 1., 0)
-
-#define BIQUAD_DII_FILTER(name, type, min, max, need_clipping)                \
-static void biquad_dii_## name (BiquadsContext *s,                            \
-                            const void *input, void *output, int len,         \
-                            double *z1, double *z2,                           \
-                            double *unused1, double *unused2,                 \
-                            double b0, double b1, double b2,                  \
-                            double a1, double a2, int *clippings,             \
-                            int disabled)                                     \
-{                                                                             \
-    const type *ibuf = input;                                                 \
-    type *obuf = output;                                                      \
-    double w1 = *z1;                                                          \
-    double w2 = *z2;                                                          \
-    double wet = s->mix;                                                      \
-    double dry = 1. - wet;                                                    \
-    double in, out, w0;                                                       \
+    for (int offset = 0; offset < in->nb_samples; offset += BLOCK_SIZE) {     \
+        const int len = FFMIN(in->nb_samples - offset, BLOCK_SIZE);           \
+        const int tail = s->transform_type == DI && (in->nb_samples & 1) &&   \
+                         offset + len == in->nb_samples;                      \
                                                                               \
-    a1 = -a1;                                                                 \
-    a2 = -a2;                                                                 \
+        for (int l = 0; l < nb_lanes; l++) {                                  \
+            const type *ibuf = (const type *)in->extended_data[first + l] + offset; \
                                                                               \
-    for (int i = 0; i < len; i++) {                                           \
-        in = ibuf[i];                                                         \
-        w0 = in + a1 * w1 + a2 * w2;                                          \
-        out = b0 * w0 + b1 * w1 + b2 * w2;                                    \
-        w2 = w1;                                                              \
-        w1 = w0;                                                              \
-        out = out * wet + in * dry;                                           \
-        if (disabled) {                                                       \
-            obuf[i] = in;                                                     \
-        } else if (need_clipping && out < min) {                              \
-            (*clippings)++;                                                   \
-            obuf[i] = min;                                                    \
-        } else if (need_clipping && out > max) {                              \
-            (*clippings)++;                                                   \
-            obuf[i] = max;                                                    \
-        } else {                                                              \
-            obuf[i] = out;                                                    \
+            for (int i = 0; i < len; i++)                                     \
+                lanes[i * BIQUAD_LANES_DBL + l] = ibuf[i];                    \
         }                                                                     \
-    }                                                                         \
-    *z1 = w1;                                                                 \
-    *z2 = w2;                                                                 \
-}
-
-BIQUAD_DII_FILTER(s16, int16_t, INT16_MIN, INT16_MAX, 1)
-BIQUAD_DII_FILTER(s32, int32_t, INT32_MIN, INT32_MAX, 1)
-BIQUAD_DII_FILTER(flt, float,   -1., 1., 0)
-BIQUAD_DII_FILTER(dbl, double,  -1., 1., 0)
-
-#define BIQUAD_TDII_FILTER(name, type, min, max, need_clipping)               \
-static void biquad_tdii_## name (BiquadsContext *s,                           \
-                            const void *input, void *output, int len,         \
-                            double *z1, double *z2,                           \
-                            double *unused1, double *unused2,                 \
-                            double b0, double b1, double b2,                  \
-                            double a1, double a2, int *clippings,             \
-                            int disabled)                                     \
-{                                                                             \
-    const type *ibuf = input;                                                 \
-    type *obuf = output;                                                      \
-    double w1 = *z1;                                                          \
-    double w2 = *z2;                                                          \
-    double wet = s->mix;                                                      \
-    double dry = 1. - wet;                                                    \
-    double in, out;                                                           \
                                                                               \
-    a1 = -a1;                                                                 \
-    a2 = -a2;                                                                 \
+        s->dsp.filter_dbl[s->transform_type](lanes, len - tail,               \
+                                             s->coeffs, state, 1);            \
+        if (tail)                                                             \
+            biquad_di_odd_tail(lanes + (len - 1) * BIQUAD_LANES_DBL,          \
+                               s->coeffs, state);                             \
                                                                               \
-    for (int i = 0; i < len; i++) {                                           \
-        in = ibuf[i];                                                         \
-        out = b0 * in + w1;                                                   \
-        w1 = b1 * in + w2 + a1 * out;                                         \
-        w2 = b2 * in + a2 * out;                                              \
-        out = out * wet + in * dry;                                           \
-        if (disabled) {                                                       \
-            obuf[i] = in;                                                     \
-        } else if (need_clipping && out < min) {                              \
-            (*clippings)++;                                                   \
-            obuf[i] = min;                                                    \
-        } else if (need_clipping && out > max) {                              \
-            (*clippings)++;                                                   \
-            obuf[i] = max;                                                    \
-        } else {                                                              \
-            obuf[i] = out;                                                    \
-        }                                                                     \
-    }                                                                         \
-    *z1 = w1;                                                                 \
-    *z2 = w2;                                                                 \
-}
-
-BIQUAD_TDII_FILTER(s16, int16_t, INT16_MIN, INT16_MAX, 1)
-BIQUAD_TDII_FILTER(s32, int32_t, INT32_MIN, INT32_MAX, 1)
-BIQUAD_TDII_FILTER(flt, float,   -1., 1., 0)
-BIQUAD_TDII_FILTER(dbl, double,  -1., 1., 0)
-
-#define BIQUAD_LATT_FILTER(name, type, min, max, need_clipping)               \
-static void biquad_latt_## name (BiquadsContext *s,                           \
-                           const void *input, void *output, int len,          \
-                           double *z1, double *z2,                            \
-                           double *unused1, double *unused2,                  \
-                           double v0, double v1, double v2,                   \
-                           double k0, double k1, int *clippings,              \
-                           int disabled)                                      \
-{                                                                             \
-    const type *ibuf = input;                                                 \
-    type *obuf = output;                                                      \
-    double s0 = *z1;                                                          \
-    double s1 = *z2;                                                          \
-    double wet = s->mix;                                                      \
-    double dry = 1. - wet;                                                    \
-    double in, out;                                                           \
-    double t0, t1;                                                            \
+        for (int l = 0; l < nb_lanes; l++) {                                  \
+            const type *ibuf = (const type *)in->extended_data[first + l] + offset; \
+            type *obuf = (type *)out->extended_data[first + l] + offset;      \
+            int *clippings = &s->cache[first + l].clippings;                  \
                                                                               \
-    for (int i = 0; i < len; i++) {                                           \
-        out  = 0.;                                                            \
-        in   = ibuf[i];                                                       \
-        t0   = in - k1 * s0;                                                  \
-        t1   = t0 * k1 + s0;                                                  \
-        out += t1 * v2;                                                       \
+            if (!(lanes_mask & (1 << l))) {                                   \
+                if (in != out)                                                \
+                    memcpy(obuf, ibuf, len * sizeof(*obuf));                  \
+                continue;                                                     \
+            }                                                                 \
                                                                               \
-        t0    = t0 - k0 * s1;                                                 \
-        t1    = t0 * k0 + s1;                                                 \
-        out  += t1 * v1;                                                      \
+            for (int i = 0; i < len; i++) {                                   \
+                double res = lanes[i * BIQUAD_LANES_DBL + l] * wet + ibuf[i] * dry; \
                                                                               \
-        out  += t0 * v0;                                                      \
-        s0    = t1;                                                           \
-        s1    = t0;                                                           \
-                                                                              \
-        out = out * wet + in * dry;                                           \
-        if (disabled) {                                                       \
-            obuf[i] = in;                                                     \
-        } else if (need_clipping && out < min) {                              \
-            (*clippings)++;                                                   \
-            obuf[i] = min;                                                    \
-        } else if (need_clipping && out > max) {                              \
-            (*clippings)++;                                                   \
-            obuf[i] = max;                                                    \
-        } else {                                                              \
-            obuf[i] = out;                                                    \
+                if (disabled) {                                               \
+                    obuf[i] = ibuf[i];                                        \
+                } else if (need_clipping && res < min) {                      \
+                    (*clippings)++;                                           \
+                    obuf[i] = min;                                            \
+                } else if (need_clipping && res > max) {                      \
+                    (*clippings)++;                                           \
+                    obuf[i] = max;                                            \
+                } else {                                                      \
+                    obuf[i] = res;                                            \
+                }                                                             \
+            }                                                                 \
         }                                                                     \
     }                                                                         \
-    *z1 = s0;                                                                 \
-    *z2 = s1;                                                                 \
 }
 
-BIQUAD_LATT_FILTER(s16, int16_t, INT16_MIN, INT16_MAX, 1)
-BIQUAD_LATT_FILTER(s32, int32_t, INT32_MIN, INT32_MAX, 1)
-BIQUAD_LATT_FILTER(flt, float,   -1., 1., 0)
-BIQUAD_LATT_FILTER(dbl, double,  -1., 1., 0)
-
-static void convert_dir2latt(BiquadsContext *s)
-{
-    double k0, k1, v0, v1, v2;
-
-    k1 = s->a2;
-    k0 = s->a1 / (1. + k1);
-    v2 = s->b2;
-    v1 = s->b1 - v2 * s->a1;
-    v0 = s->b0 - v1 * k0 - v2 * k1;
-
-    s->a1 = k0;
-    s->a2 = k1;
-    s->b0 = v0;
-    s->b1 = v1;
-    s->b2 = v2;
-}
+BIQUAD_FILTER(s16, int16_t, INT16_MIN, INT16_MAX, 1)
+BIQUAD_FILTER(s32, int32_t, INT32_MIN, INT32_MAX, 1)
+BIQUAD_FILTER(flt, float,   -1., 1., 0)
+BIQUAD_FILTER(dbl, double,  -1., 1., 0)
 
 static int config_filter(AVFilterLink *outlink, int reset)
 {
@@ -669,83 +519,37 @@ static int config_filter(AVFilterLink *outlink, int reset)
     if (reset)
         memset(s->cache, 0, sizeof(ChanCache) * inlink->channels);
 
-    switch (s->transform_type) {
-    case DI:
-        switch (inlink->format) {
-        case AV_SAMPLE_FMT_S16P:
-            s->filter = biquad_s16;
-            break;
-        case AV_SAMPLE_FMT_S32P:
-            s->filter = biquad_s32;
-            break;
-        case AV_SAMPLE_FMT_FLTP:
-            s->filter = biquad_flt;
-            break;
-        case AV_SAMPLE_FMT_DBLP:
-            s->filter = biquad_dbl;
-            break;
-        default: av_assert0(0);
-        }
+    if (reset || !s->state) {
+        s->nb_groups = (inlink->channels + BIQUAD_LANES_DBL - 1) / BIQUAD_LANES_DBL;
+        av_freep(&s->state);
+        av_freep(&s->lanes);
+        s->state = av_calloc(s->nb_groups, BIQUAD_NB_STATES * BIQUAD_LANES_DBL * sizeof(*s->state));
+        s->lanes = av_calloc(s->nb_groups, BLOCK_SIZE * BIQUAD_LANES_DBL * sizeof(*s->lanes));
+        if (!s->state || !s->lanes)
+            return AVERROR(ENOMEM);
+    }
+
+    ff_biquaddsp_init(&s->dsp);
+    ff_biquaddsp_set_section_dbl(s->coeffs, 0, -1, s->transform_type,
+                                 s->b0, s->b1, s->b2, s->a1, s->a2);
+
+    switch (inlink->format) {
+    case AV_SAMPLE_FMT_S16P:
+        s->filter = biquad_s16;
         break;
-    case DII:
-        switch (inlink->format) {
-        case AV_SAMPLE_FMT_S16P:
-            s->filter = biquad_dii_s16;
-            break;
-        case AV_SAMPLE_FMT_S32P:
-            s->filter = biquad_dii_s32;
-            break;
-        case AV_SAMPLE_FMT_FLTP:
-            s->filter = biquad_dii_flt;
-            break;
-        case AV_SAMPLE_FMT_DBLP:
-            s->filter = biquad_dii_dbl;
-            break;
-        default: av_assert0(0);
-        }
+    case AV_SAMPLE_FMT_S32P:
+        s->filter = biquad_s32;
         break;
-    case TDII:
-        switch (inlink->format) {
-        case AV_SAMPLE_FMT_S16P:
-            s->filter = biquad_tdii_s16;
-            break;
-        case AV_SAMPLE_FMT_S32P:
-            s->filter = biquad_tdii_s32;
-            break;
-        case AV_SAMPLE_FMT_FLTP:
-            s->filter = biquad_tdii_flt;
-            break;
-        case AV_SAMPLE_FMT_DBLP:
-            s->filter = biquad_tdii_dbl;
-            break;
-        default: av_assert0(0);
-        }
+    case AV_SAMPLE_FMT_FLTP:
+        s->filter = biquad_flt;
         break;
-    case LATT:
-        switch (inlink->format) {
-        case AV_SAMPLE_FMT_S16P:
-            s->filter = biquad_latt_s16;
-            break;
-        case AV_SAMPLE_FMT_S32P:
-            s->filter = biquad_latt_s32;
-            break;
-        case AV_SAMPLE_FMT_FLTP:
-            s->filter = biquad_latt_flt;
-            break;
-        case AV_SAMPLE_FMT_DBLP:
-            s->filter = biquad_latt_dbl;
-            break;
-        default: av_assert0(0);
-        }
+    case AV_SAMPLE_FMT_DBLP:
+        s->filter = biquad_dbl;
         break;
-    default:
-        av_assert0(0);
-     }
-
-     s->block_align = av_get_bytes_per_sample(inlink->format);
+    default: av_assert0(0);
+    }
 
-     if (s->transform_type == LATT)
-         convert_dir2latt(s);
+    s->block_align = av_get_bytes_per_sample(inlink->format);
 
     return 0;
 }
@@ -766,21 +570,27 @@ static int filter_channel(AVFilterContext *ctx, void *arg, int jobnr, int nb_job
     AVFrame *buf = td->in;
     AVFrame *out_buf = td->out;
     BiquadsContext *s = ctx->priv;
-    const int start = (buf->channels * jobnr) / nb_jobs;
-    const int end = (buf->channels * (jobnr+1)) / nb_jobs;
-    int ch;
+    const int start = (s->nb_groups * jobnr) / nb_jobs;
+    const int end = (s->nb_groups * (jobnr+1)) / nb_jobs;
+
+    for (int group = start; group < end; group++) {
+        const int first = group * BIQUAD_LANES_DBL;
+        const int last = FFMIN(first + BIQUAD_LANES_DBL, buf->channels);
+        unsigned lanes_mask = 0;
+
+        for (int ch = first; ch < last; ch++) {
+            if (av_channel_layout_extract_channel(inlink->channel_layout, ch) & s->channels)
+                lanes_mask |= 1 << (ch - first);
+        }
 
-    for (ch = start; ch < end; ch++) {
-        if (!((av_channel_layout_extract_channel(inlink->channel_layout, ch) & s->channels))) {
-            if (buf != out_buf)
+        if (!lanes_mask) {
+            for (int ch = first; ch < last && buf != out_buf; ch++)
                 memcpy(out_buf->extended_data[ch], buf->extended_data[ch],
                        buf->nb_samples * s->block_align);
             continue;
         }
 
-        s->filter(s, buf->extended_data[ch], out_buf->extended_data[ch], buf->nb_samples,
-                  &s->cache[ch].i1, &s->cache[ch].i2, &s->cache[ch].o1, &s->cache[ch].o2,
-                  s->b0, s->b1, s->b2, s->a1, s->a2, &s->cache[ch].clippings, ctx->is_disabled);
+        s->filter(s, buf, out_buf, group, lanes_mask, ctx->is_disabled);
     }
 
     return 0;
@@ -811,7 +621,7 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *buf)
 
     td.in = buf;
     td.out = out_buf;
-    ctx->internal->execute(ctx, filter_channel, &td, NULL, FFMIN(outlink->channels, ff_filter_get_nb_threads(ctx)));
+    ctx->internal->execute(ctx, filter_channel, &td, NULL, FFMIN(s->nb_groups, ff_filter_get_nb_threads(ctx)));
 
     for (ch = 0; ch < outlink->channels; ch++) {
         if (s->cache[ch].clippings > 0)
@@ -844,6 +654,8 @@ static av_cold void uninit(AVFilterContext *ctx)
     BiquadsContext *s = ctx->priv;
 
     av_freep(&s->cache);
+    av_freep(&s->state);
+    av_freep(&s->lanes);
 }
 
 static const AVFilterPad inputs[] = {
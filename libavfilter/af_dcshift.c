@@ -170,4 +170,5 @@ const AVFilter ff_af_dcshift = {
     .inputs         = dcshift_inputs,
     .outputs        = dcshift_outputs,
     .flags          = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC,
+    .flags_internal = FF_FILTER_FLAG_AUDIO_BATCH,
 };
@@ -25,12 +25,12 @@
 #include "libavutil/float_dsp.h"
 #include "libavutil/intmath.h"
 #include "libavutil/opt.h"
-#include "libavcodec/avfft.h"
 
 #include "avfilter.h"
 #include "filters.h"
 #include "internal.h"
 #include "audio.h"
+#include "partconv.h"
 
 #define TIME_DOMAIN      0
 #define FREQUENCY_DOMAIN 1
@@ -63,17 +63,13 @@ typedef struct HeadphoneContext {
     int write[2];
 
     int buffer_length;
-    int n_fft;
     int size;
     int hrir_fmt;
 
     float *data_ir[2];
     float *temp_src[2];
-    FFTComplex *temp_fft[2];
-    FFTComplex *temp_afft[2];
 
-    FFTContext *fft[2], *ifft[2];
-    FFTComplex *data_hrtf[2];
+    PartConvContext *conv;
 
     float (*scalarproduct_float)(const float *v1, const float *v2, int len);
     struct hrir_inputs {
@@ -130,8 +126,6 @@ typedef struct ThreadData {
     int *n_clippings;
     float **ringbuffer;
     float **temp_src;
-    FFTComplex **temp_fft;
-    FFTComplex **temp_afft;
 } ThreadData;
 
 static int headphone_convolute(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
@@ -205,94 +199,35 @@ static int headphone_convolute(AVFilterContext *ctx, void *arg, int jobnr, int n
     return 0;
 }
 
-static int headphone_fast_convolute(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+static int headphone_fast_convolute(AVFilterContext *ctx, AVFrame *in, AVFrame *out,
+                                    int *n_clippings)
 {
     HeadphoneContext *s = ctx->priv;
-    ThreadData *td = arg;
-    AVFrame *in = td->in, *out = td->out;
-    int offset = jobnr;
-    int *write = &td->write[jobnr];
-    FFTComplex *hrtf = s->data_hrtf[jobnr];
-    int *n_clippings = &td->n_clippings[jobnr];
-    float *ringbuffer = td->ringbuffer[jobnr];
-    const int ir_len = s->ir_len;
     const float *src = (const float *)in->data[0];
+    const float *in_ptr[64];
     float *dst = (float *)out->data[0];
+    float *out_ptr[2] = { dst, dst + 1 };
     const int in_channels = in->channels;
-    const int buffer_length = s->buffer_length;
-    const uint32_t modulo = (uint32_t)buffer_length - 1;
-    FFTComplex *fft_in = s->temp_fft[jobnr];
-    FFTComplex *fft_acc = s->temp_afft[jobnr];
-    FFTContext *ifft = s->ifft[jobnr];
-    FFTContext *fft = s->fft[jobnr];
-    const int n_fft = s->n_fft;
-    const float fft_scale = 1.0f / s->n_fft;
-    FFTComplex *hrtf_offset;
-    int wr = *write;
-    int n_read;
-    int i, j;
-
-    dst += offset;
-
-    n_read = FFMIN(ir_len, in->nb_samples);
-    for (j = 0; j < n_read; j++) {
-        dst[2 * j]     = ringbuffer[wr];
-        ringbuffer[wr] = 0.0;
-        wr  = (wr + 1) & modulo;
-    }
+    int ret;
 
-    for (j = n_read; j < in->nb_samples; j++) {
-        dst[2 * j] = 0;
-    }
-
-    memset(fft_acc, 0, sizeof(FFTComplex) * n_fft);
-
-    for (i = 0; i < in_channels; i++) {
-        if (i == s->lfe_channel) {
-            for (j = 0; j < in->nb_samples; j++) {
-                dst[2 * j] += src[i + j * in_channels] * s->gain_lfe;
-            }
-            continue;
-        }
-
-        offset = i * n_fft;
-        hrtf_offset = hrtf + offset;
+    for (int i = 0; i < in_channels; i++)
+        in_ptr[i] = i == s->lfe_channel ? NULL : src + i;
 
-        memset(fft_in, 0, sizeof(FFTComplex) * n_fft);
-
-        for (j = 0; j < in->nb_samples; j++) {
-            fft_in[j].re = src[j * in_channels + i];
-        }
+    ret = ff_partconv_process(ctx, s->conv, out_ptr, 2, in_ptr, in_channels, in->nb_samples);
+    if (ret < 0)
+        return ret;
 
-        av_fft_permute(fft, fft_in);
-        av_fft_calc(fft, fft_in);
-        for (j = 0; j < n_fft; j++) {
-            const FFTComplex *hcomplex = hrtf_offset + j;
-            const float re = fft_in[j].re;
-            const float im = fft_in[j].im;
+    for (int j = 0; j < in->nb_samples; j++) {
+        if (s->lfe_channel >= 0) {
+            const float lfe = src[j * in_channels + s->lfe_channel] * s->gain_lfe;
 
-            fft_acc[j].re += re * hcomplex->re - im * hcomplex->im;
-            fft_acc[j].im += re * hcomplex->im + im * hcomplex->re;
+            dst[2 * j    ] += lfe;
+            dst[2 * j + 1] += lfe;
         }
+        n_clippings[0] += fabsf(dst[2 * j    ]) > 1;
+        n_clippings[1] += fabsf(dst[2 * j + 1]) > 1;
     }
 
-    av_fft_permute(ifft, fft_acc);
-    av_fft_calc(ifft, fft_acc);
-
-    for (j = 0; j < in->nb_samples; j++) {
-        dst[2 * j] += fft_acc[j].re * fft_scale;
-        if (fabsf(dst[2 * j]) > 1)
-            n_clippings[0]++;
-    }
-
-    for (j = 0; j < ir_len - 1; j++) {
-        int write_pos = (wr + j) & modulo;
-
-        *(ringbuffer + write_pos) += fft_acc[in->nb_samples + j].re * fft_scale;
-    }
-
-    *write = wr;
-
     return 0;
 }
 
@@ -331,13 +266,16 @@ static int headphone_frame(HeadphoneContext *s, AVFrame *in, AVFilterLink *outli
     td.in = in; td.out = out; td.write = s->write;
     td.ir = s->data_ir; td.n_clippings = n_clippings;
     td.ringbuffer = s->ringbuffer; td.temp_src = s->temp_src;
-    td.temp_fft = s->temp_fft;
-    td.temp_afft = s->temp_afft;
 
     if (s->type == TIME_DOMAIN) {
         ctx->internal->execute(ctx, headphone_convolute, &td, NULL, 2);
     } else {
-        ctx->internal->execute(ctx, headphone_fast_convolute, &td, NULL, 2);
+        int ret = headphone_fast_convolute(ctx, in, out, n_clippings);
+        if (ret < 0) {
+            av_frame_free(&in);
+            av_frame_free(&out);
+            return ret;
+        }
     }
     emms_c();
 
@@ -356,9 +294,9 @@ static int convert_coeffs(AVFilterContext *ctx, AVFilterLink *inlink)
     const int ir_len = s->ir_len;
     int nb_input_channels = ctx->inputs[0]->channels;
     float gain_lin = expf((s->gain - 3 * nb_input_channels) / 20 * M_LN10);
-    AVFrame *frame;
+    AVFrame *frame = NULL;
+    float *hrir[2] = { NULL };
     int ret = 0;
-    int n_fft;
     int i, j, k;
 
     s->air_len = 1 << (32 - ff_clz(ir_len));
@@ -366,44 +304,15 @@ static int convert_coeffs(AVFilterContext *ctx, AVFilterLink *inlink)
         s->air_len = FFALIGN(s->air_len, 32);
     }
     s->buffer_length = 1 << (32 - ff_clz(s->air_len));
-    s->n_fft = n_fft = 1 << (32 - ff_clz(ir_len + s->size));
-
-    if (s->type == FREQUENCY_DOMAIN) {
-        s->fft[0] = av_fft_init(av_log2(s->n_fft), 0);
-        s->fft[1] = av_fft_init(av_log2(s->n_fft), 0);
-        s->ifft[0] = av_fft_init(av_log2(s->n_fft), 1);
-        s->ifft[1] = av_fft_init(av_log2(s->n_fft), 1);
-
-        if (!s->fft[0] || !s->fft[1] || !s->ifft[0] || !s->ifft[1]) {
-            av_log(ctx, AV_LOG_ERROR, "Unable to create FFT contexts of size %d.\n", s->n_fft);
-            ret = AVERROR(ENOMEM);
-            goto fail;
-        }
-    }
 
     if (s->type == TIME_DOMAIN) {
         s->ringbuffer[0] = av_calloc(s->buffer_length, sizeof(float) * nb_input_channels);
         s->ringbuffer[1] = av_calloc(s->buffer_length, sizeof(float) * nb_input_channels);
-    } else {
-        s->ringbuffer[0] = av_calloc(s->buffer_length, sizeof(float));
-        s->ringbuffer[1] = av_calloc(s->buffer_length, sizeof(float));
-        s->temp_fft[0] = av_calloc(s->n_fft, sizeof(FFTComplex));
-        s->temp_fft[1] = av_calloc(s->n_fft, sizeof(FFTComplex));
-        s->temp_afft[0] = av_calloc(s->n_fft, sizeof(FFTComplex));
-        s->temp_afft[1] = av_calloc(s->n_fft, sizeof(FFTComplex));
-        if (!s->temp_fft[0] || !s->temp_fft[1] ||
-            !s->temp_afft[0] || !s->temp_afft[1]) {
+        if (!s->ringbuffer[0] || !s->ringbuffer[1]) {
             ret = AVERROR(ENOMEM);
             goto fail;
         }
-    }
-
-    if (!s->ringbuffer[0] || !s->ringbuffer[1]) {
-        ret = AVERROR(ENOMEM);
-        goto fail;
-    }
 
-    if (s->type == TIME_DOMAIN) {
         s->temp_src[0] = av_calloc(s->air_len, sizeof(float));
         s->temp_src[1] = av_calloc(s->air_len, sizeof(float));
 
@@ -414,9 +323,24 @@ static int convert_coeffs(AVFilterContext *ctx, AVFilterLink *inlink)
             goto fail;
         }
     } else {
-        s->data_hrtf[0] = av_calloc(n_fft, sizeof(*s->data_hrtf[0]) * nb_input_channels);
-        s->data_hrtf[1] = av_calloc(n_fft, sizeof(*s->data_hrtf[1]) * nb_input_channels);
-        if (!s->data_hrtf[0] || !s->data_hrtf[1]) {
+        /* The input channels of one ear use IRs ear * nb_input_channels + channel,
+         * the head is convolved in blocks of the frame size and the tail of
+         * long responses in bigger partitions. */
+        ret = ff_partconv_init(&s->conv, nb_input_channels, 2, 2 * nb_input_channels,
+                               ir_len, s->size, FFMAX(s->size, 8192));
+        if (ret < 0)
+            goto fail;
+
+        for (i = 0; i < nb_input_channels; i++) {
+            if (i == s->lfe_channel)
+                continue;
+            ff_partconv_map(s->conv, 0, i, i);
+            ff_partconv_map(s->conv, 1, i, nb_input_channels + i);
+        }
+
+        hrir[0] = av_calloc(ir_len, sizeof(*hrir[0]));
+        hrir[1] = av_calloc(ir_len, sizeof(*hrir[1]));
+        if (!hrir[0] || !hrir[1]) {
             ret = AVERROR(ENOMEM);
             goto fail;
         }
@@ -445,18 +369,14 @@ static int convert_coeffs(AVFilterContext *ctx, AVFilterLink *inlink)
                     data_ir_r[j] = ptr[len * 2 - j * 2 - 1] * gain_lin;
                 }
             } else {
-                FFTComplex *fft_in_l = s->data_hrtf[0] + idx * n_fft;
-                FFTComplex *fft_in_r = s->data_hrtf[1] + idx * n_fft;
-
                 for (j = 0; j < len; j++) {
-                    fft_in_l[j].re = ptr[j * 2    ] * gain_lin;
-                    fft_in_r[j].re = ptr[j * 2 + 1] * gain_lin;
+                    hrir[0][j] = ptr[j * 2    ] * gain_lin;
+                    hrir[1][j] = ptr[j * 2 + 1] * gain_lin;
                 }
 
-                av_fft_permute(s->fft[0], fft_in_l);
-                av_fft_calc(s->fft[0], fft_in_l);
-                av_fft_permute(s->fft[0], fft_in_r);
-                av_fft_calc(s->fft[0], fft_in_r);
+                if ((ret = ff_partconv_set_ir(s->conv, idx, hrir[0], len)) < 0 ||
+                    (ret = ff_partconv_set_ir(s->conv, nb_input_channels + idx, hrir[1], len)) < 0)
+                    goto fail;
             }
         } else {
             int I, N = ctx->inputs[1]->channels;
@@ -477,18 +397,14 @@ static int convert_coeffs(AVFilterContext *ctx, AVFilterLink *inlink)
                         data_ir_r[j] = ptr[len * N - j * N - N + I + 1] * gain_lin;
                     }
                 } else {
-                    FFTComplex *fft_in_l = s->data_hrtf[0] + idx * n_fft;
-                    FFTComplex *fft_in_r = s->data_hrtf[1] + idx * n_fft;
-
                     for (j = 0; j < len; j++) {
-                        fft_in_l[j].re = ptr[j * N + I    ] * gain_lin;
-                        fft_in_r[j].re = ptr[j * N + I + 1] * gain_lin;
+                        hrir[0][j] = ptr[j * N + I    ] * gain_lin;
+                        hrir[1][j] = ptr[j * N + I + 1] * gain_lin;
                     }
 
-                    av_fft_permute(s->fft[0], fft_in_l);
-                    av_fft_calc(s->fft[0], fft_in_l);
-                    av_fft_permute(s->fft[0], fft_in_r);
-                    av_fft_calc(s->fft[0], fft_in_r);
+                    if ((ret = ff_partconv_set_ir(s->conv, idx, hrir[0], len)) < 0 ||
+                        (ret = ff_partconv_set_ir(s->conv, nb_input_channels + idx, hrir[1], len)) < 0)
+                        goto fail;
                 }
             }
         }
@@ -497,6 +413,9 @@ static int convert_coeffs(AVFilterContext *ctx, AVFilterLink *inlink)
     s->have_hrirs = 1;
 
 fail:
+    av_frame_free(&frame);
+    av_freep(&hrir[0]);
+    av_freep(&hrir[1]);
     return ret;
 }
 
@@ -695,22 +614,13 @@ static av_cold void uninit(AVFilterContext *ctx)
 {
     HeadphoneContext *s = ctx->priv;
 
-    av_fft_end(s->ifft[0]);
-    av_fft_end(s->ifft[1]);
-    av_fft_end(s->fft[0]);
-    av_fft_end(s->fft[1]);
+    ff_partconv_uninit(&s->conv);
     av_freep(&s->data_ir[0]);
     av_freep(&s->data_ir[1]);
     av_freep(&s->ringbuffer[0]);
     av_freep(&s->ringbuffer[1]);
     av_freep(&s->temp_src[0]);
     av_freep(&s->temp_src[1]);
-    av_freep(&s->temp_fft[0]);
-    av_freep(&s->temp_fft[1]);
-    av_freep(&s->temp_afft[0]);
-    av_freep(&s->temp_afft[1]);
-    av_freep(&s->data_hrtf[0]);
-    av_freep(&s->data_hrtf[1]);
 
     for (unsigned i = 1; i < ctx->nb_inputs; i++)
         av_freep(&ctx->input_pads[i].name);
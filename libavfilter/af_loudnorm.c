@@ -20,17 +20,21 @@
 
 /* http://k.ylo.ph/2016/04/04/loudnorm.html */
 
+#include "libavutil/float_dsp.h"
 #include "libavutil/opt.h"
+#include "libavutil/samplefmt.h"
 #include "avfilter.h"
 #include "internal.h"
 #include "audio.h"
 #include "ebur128.h"
+#include "ebur128dsp.h"
 
 enum FrameType {
     FIRST_FRAME,
     INNER_FRAME,
     FINAL_FRAME,
     LINEAR_MODE,
+    STREAMING_MODE,
     FRAME_NB
 };
 
@@ -62,6 +66,7 @@ typedef struct LoudNormContext {
     int linear;
     int dual_mono;
     enum PrintFormat print_format;
+    int64_t lookahead;
 
     double *buf;
     int buf_size;
@@ -91,6 +96,31 @@ typedef struct LoudNormContext {
     int prev_nb_samples;
     int channels;
 
+    /* streaming mode, the audio is processed in blocks of block_size
+     * frames stored in buf, a ring buffer of nb_blocks blocks */
+    AVFloatDSPContext *fdsp;
+    EBUR128DSPContext dsp;
+    int block_size;
+    int block_stride;
+    int block_fill;
+    int nb_blocks;
+    int blocks_in_100ms;
+    int lookahead_blocks;
+    int limiter_blocks;
+    int64_t block_count;
+    double *ramp;
+    double *tmp;
+    double *block_gains;
+    double gain;
+    double gain_next;
+    double gain_norm;
+    int gain_pos;
+    double env;
+    double release_coeff;
+    int64_t nb_samples_in;
+    int64_t nb_samples_out;
+    int flushing;
+
     FFEBUR128State *r128_in;
     FFEBUR128State *r128_out;
 } LoudNormContext;
@@ -119,6 +149,7 @@ static const AVOption loudnorm_options[] = {
     {     "none",         0,                                   0,                        AV_OPT_TYPE_CONST,   {.i64 =  NONE},     0,         0,  FLAGS, "print_format" },
     {     "json",         0,                                   0,                        AV_OPT_TYPE_CONST,   {.i64 =  JSON},     0,         0,  FLAGS, "print_format" },
     {     "summary",      0,                                   0,                        AV_OPT_TYPE_CONST,   {.i64 =  SUMMARY},  0,         0,  FLAGS, "print_format" },
+    { "lookahead",        "set lookahead for streaming mode",  OFFSET(lookahead),        AV_OPT_TYPE_DURATION,{.i64 =  0},        0,   1000000,  FLAGS },
     { NULL }
 };
 
@@ -406,6 +437,177 @@ static void true_peak_limiter(LoudNormContext *s, double *out, int nb_samples, i
     }
 }
 
+static void update_gain(LoudNormContext *s)
+{
+    const int nb_weights = 11 + s->lookahead_blocks;
+    int64_t nb_100ms = s->block_count / s->blocks_in_100ms;
+    double global, shortterm, relative_threshold, env_global, env_shortterm;
+    int i, index;
+
+    s->gain = s->gain_next;
+    s->gain_pos = 0;
+    if (s->flushing)
+        return;
+
+    ff_ebur128_loudness_global(s->r128_in, &global);
+    ff_ebur128_loudness_shortterm(s->r128_in, &shortterm);
+    ff_ebur128_relative_threshold(s->r128_in, &relative_threshold);
+
+    /* the short term window is only partially filled at the start */
+    if (nb_100ms < 30)
+        shortterm += 10. * log10(30. / nb_100ms);
+
+    if (shortterm < relative_threshold || shortterm <= -70. || global <= -70.) {
+        s->delta[s->index] = s->prev_delta;
+    } else {
+        env_global = fabs(shortterm - global) < (s->target_lra / 2.) ? shortterm - global : (s->target_lra / 2.) * ((shortterm - global) < 0 ? -1 : 1);
+        env_shortterm = s->target_i - shortterm;
+        s->delta[s->index] = pow(10., (env_global + env_shortterm) / 20.);
+    }
+    s->prev_delta = s->delta[s->index];
+
+    /* gaussian window centered lookahead_blocks before the newest delta */
+    index = s->index - nb_weights + 1;
+    if (index < 0)
+        index += 30;
+    s->gain_next = 0.;
+    for (i = 0; i < nb_weights; i++)
+        s->gain_next += s->delta[(index + i) < 30 ? (index + i) : (index + i - 30)] * s->weights[i];
+    s->gain_next *= s->gain_norm;
+
+    s->index++;
+    if (s->index >= 30)
+        s->index -= 30;
+}
+
+/* gain from a to a + delta using the ramp of one block */
+static void apply_ramp(LoudNormContext *s, double *buf, double a, double delta)
+{
+    s->fdsp->vector_dmul(s->tmp, buf, s->ramp, s->block_stride);
+    s->fdsp->vector_dmul_scalar(buf, buf, a, s->block_stride);
+    s->fdsp->vector_dmac_scalar(buf, s->tmp, delta, s->block_stride);
+}
+
+/**
+ * Process the block that was just filled. A block is measured as soon as
+ * it is filled, gets the loudness gain lookahead_blocks 100ms periods later
+ * and the limiter gain limiter_blocks blocks after that.
+ *
+ * @return 1 if a block was written to dst, 0 otherwise
+ */
+static int process_block(LoudNormContext *s, double *dst)
+{
+    const int len = s->block_size * s->channels;
+    const int limiter_blocks = s->limiter_blocks;
+    const double ceiling = s->target_tp;
+    int64_t agc_block = s->block_count - (int64_t)s->lookahead_blocks * s->blocks_in_100ms;
+    int64_t out_block = agc_block - limiter_blocks;
+    double *buf;
+    int i, j;
+
+    if (!s->flushing) {
+        buf = s->buf + (s->block_count % s->nb_blocks) * s->block_stride;
+        ff_ebur128_add_frames_double(s->r128_in, buf, s->block_size);
+    }
+
+    if (agc_block >= 0) {
+        const double gain_range = s->block_size * s->blocks_in_100ms;
+        double peak;
+
+        buf = s->buf + (agc_block % s->nb_blocks) * s->block_stride;
+        apply_ramp(s, buf,
+                   (s->gain + (s->gain_next - s->gain) * s->gain_pos / gain_range) * s->offset,
+                   (s->gain_next - s->gain) * s->block_size / gain_range * s->offset);
+        s->gain_pos += s->block_size;
+
+        peak = ff_ebur128dsp_find_peak(&s->dsp, buf, len);
+        s->block_gains[agc_block % (limiter_blocks + 1)] = peak > ceiling ? ceiling / peak : 1.;
+    }
+
+    s->block_count++;
+    if (!(s->block_count % s->blocks_in_100ms))
+        update_gain(s);
+
+    if (out_block >= 0) {
+        double env = s->env + (1. - s->env) * s->release_coeff;
+
+        /* every gain lowers its block and ramps linearly back up to 1
+         * over the previous blocks, the block gains then guarantee that
+         * the interpolated gain never exceeds the gain of any block */
+        for (j = 0; j <= limiter_blocks; j++) {
+            double g = s->block_gains[(out_block + j) % (limiter_blocks + 1)];
+            env = FFMIN(env, g + (1. - g) * FFMAX(j - 1, 0) / limiter_blocks);
+        }
+
+        buf = s->buf + (out_block % s->nb_blocks) * s->block_stride;
+        apply_ramp(s, buf, s->env, env - s->env);
+        s->env = env;
+
+        for (i = 0; i < len; i++)
+            dst[i] = av_clipd(buf[i], -ceiling, ceiling);
+        return 1;
+    }
+
+    return 0;
+}
+
+static int filter_frame_streaming(AVFilterLink *inlink, AVFrame *in)
+{
+    AVFilterContext *ctx = inlink->dst;
+    LoudNormContext *s = ctx->priv;
+    AVFilterLink *outlink = ctx->outputs[0];
+    const int channels = inlink->channels;
+    const int nb_blocks = (s->block_fill + in->nb_samples) / s->block_size;
+    const int64_t delay = s->nb_blocks - 1;
+    const double *src = (const double *)in->data[0];
+    int nb_out_blocks, nb_samples = in->nb_samples;
+    AVFrame *out = NULL;
+    double *dst = NULL;
+
+    if (s->pts == AV_NOPTS_VALUE)
+        s->pts = in->pts;
+
+    nb_out_blocks = FFMAX(s->block_count + nb_blocks - FFMAX(s->block_count, delay), 0);
+    if (nb_out_blocks) {
+        out = ff_get_audio_buffer(outlink, nb_out_blocks * s->block_size);
+        if (!out) {
+            av_frame_free(&in);
+            return AVERROR(ENOMEM);
+        }
+        av_frame_copy_props(out, in);
+        dst = (double *)out->data[0];
+    }
+
+    while (nb_samples > 0) {
+        int n = FFMIN(s->block_size - s->block_fill, nb_samples);
+        double *buf = s->buf + (s->block_count % s->nb_blocks) * s->block_stride;
+
+        memcpy(buf + s->block_fill * channels, src, n * channels * sizeof(*src));
+        src += n * channels;
+        nb_samples -= n;
+        s->block_fill += n;
+        if (s->block_fill == s->block_size) {
+            s->block_fill = 0;
+            if (process_block(s, dst))
+                dst += s->block_size * channels;
+        }
+    }
+
+    if (!s->flushing)
+        s->nb_samples_in += in->nb_samples;
+    av_frame_free(&in);
+    if (!out)
+        return 0;
+
+    out->nb_samples = FFMIN(out->nb_samples, s->nb_samples_in - s->nb_samples_out);
+    ff_ebur128_add_frames_double(s->r128_out, (const double *)out->data[0], out->nb_samples);
+    out->pts = s->pts;
+    s->pts += out->nb_samples;
+    s->nb_samples_out += out->nb_samples;
+
+    return ff_filter_frame(outlink, out);
+}
+
 static int filter_frame(AVFilterLink *inlink, AVFrame *in)
 {
     AVFilterContext *ctx = inlink->dst;
@@ -420,6 +622,9 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
     double gain, gain_next, env_global, env_shortterm,
     global, shortterm, lra, relative_threshold;
 
+    if (s->frame_type == STREAMING_MODE)
+        return filter_frame_streaming(inlink, in);
+
     if (av_frame_is_writable(in)) {
         out = in;
     } else {
@@ -645,7 +850,22 @@ static int request_frame(AVFilterLink *outlink)
     LoudNormContext *s = ctx->priv;
 
     ret = ff_request_frame(inlink);
-    if (ret == AVERROR_EOF && s->frame_type == INNER_FRAME) {
+    if (ret == AVERROR_EOF && s->frame_type == STREAMING_MODE &&
+        s->nb_samples_out < s->nb_samples_in) {
+        /* push silence until all buffered blocks are out of the limiter */
+        int nb_samples = FFALIGN(s->nb_samples_in, s->block_size) - s->nb_samples_in +
+                         (s->nb_blocks - 1) * s->block_size;
+        AVFrame *frame = ff_get_audio_buffer(outlink, nb_samples);
+
+        if (!frame)
+            return AVERROR(ENOMEM);
+        av_samples_set_silence(frame->extended_data, 0, nb_samples,
+                               inlink->channels, frame->format);
+        frame->pts = AV_NOPTS_VALUE;
+
+        s->flushing = 1;
+        ret = filter_frame(inlink, frame);
+    } else if (ret == AVERROR_EOF && s->frame_type == INNER_FRAME) {
         double *src;
         double *buf;
         int nb_samples, n, c, offset;
@@ -725,6 +945,67 @@ static int query_formats(AVFilterContext *ctx)
     return 0;
 }
 
+static int config_input_streaming(AVFilterLink *inlink)
+{
+    AVFilterContext *ctx = inlink->dst;
+    LoudNormContext *s = ctx->priv;
+    const int channels = inlink->channels;
+    int64_t lookahead;
+    double weight_sum = 0.;
+    int i, n, c;
+
+    s->block_size = frame_size(inlink->sample_rate, 1);
+    s->blocks_in_100ms = frame_size(inlink->sample_rate, 100) / s->block_size;
+    s->limiter_blocks = frame_size(inlink->sample_rate, 10) / s->block_size;
+    s->block_stride = FFALIGN(s->block_size * channels, 16);
+
+    /* the limiter lookahead comes on top of the loudness gain one */
+    lookahead = av_rescale(s->lookahead, inlink->sample_rate, AV_TIME_BASE);
+    s->lookahead_blocks = FFMIN(lookahead / (s->blocks_in_100ms * s->block_size), 10);
+    s->nb_blocks = s->lookahead_blocks * s->blocks_in_100ms + s->limiter_blocks + 1;
+
+    s->fdsp = avpriv_float_dsp_alloc(0);
+    if (!s->fdsp)
+        return AVERROR(ENOMEM);
+    ff_ebur128dsp_init(&s->dsp);
+
+    s->buf = av_calloc(s->nb_blocks, s->block_stride * sizeof(*s->buf));
+    s->ramp = av_calloc(s->block_stride, sizeof(*s->ramp));
+    s->tmp = av_calloc(s->block_stride, sizeof(*s->tmp));
+    s->block_gains = av_calloc(s->limiter_blocks + 1, sizeof(*s->block_gains));
+    if (!s->buf || !s->ramp || !s->tmp || !s->block_gains)
+        return AVERROR(ENOMEM);
+
+    for (n = 0; n < s->block_size; n++) {
+        for (c = 0; c < channels; c++)
+            s->ramp[n * channels + c] = (double)n / s->block_size;
+    }
+    for (i = 0; i <= s->limiter_blocks; i++)
+        s->block_gains[i] = 1.;
+
+    init_gaussian_filter(s);
+    for (i = 0; i < 11 + s->lookahead_blocks; i++)
+        weight_sum += s->weights[i];
+    s->gain_norm = 1. / weight_sum;
+
+    s->gain = s->measured_i != 0. ? pow(10., (s->target_i - s->measured_i) / 20.) : 1.;
+    for (i = 0; i < 30; i++)
+        s->delta[i] = s->gain;
+    s->prev_delta = s->gain;
+    s->gain_next = s->gain;
+    s->index = 0;
+
+    s->pts = AV_NOPTS_VALUE;
+    s->channels = channels;
+    s->env = 1.;
+    s->offset = pow(10., s->offset / 20.);
+    s->target_tp = pow(10., s->target_tp / 20.);
+    s->release_length = frame_size(inlink->sample_rate, 100);
+    s->release_coeff = 1. - exp(-(double)s->block_size / s->release_length);
+
+    return 0;
+}
+
 static int config_input(AVFilterLink *inlink)
 {
     AVFilterContext *ctx = inlink->dst;
@@ -743,6 +1024,9 @@ static int config_input(AVFilterLink *inlink)
         ff_ebur128_set_channel(s->r128_out, 0, FF_EBUR128_DUAL_MONO);
     }
 
+    if (s->frame_type == STREAMING_MODE)
+        return config_input_streaming(inlink);
+
     s->buf_size = frame_size(inlink->sample_rate, 3000) * inlink->channels;
     s->buf = av_malloc_array(s->buf_size, sizeof(*s->buf));
     if (!s->buf)
@@ -783,7 +1067,7 @@ static int config_input(AVFilterLink *inlink)
 static av_cold int init(AVFilterContext *ctx)
 {
     LoudNormContext *s = ctx->priv;
-    s->frame_type = FIRST_FRAME;
+    s->frame_type = s->lookahead ? STREAMING_MODE : FIRST_FRAME;
 
     if (s->linear) {
         double offset, offset_tp;
@@ -792,6 +1076,9 @@ static av_cold int init(AVFilterContext *ctx)
 
         if (s->measured_tp != 99 && s->measured_thresh != -70 && s->measured_lra != 0 && s->measured_i != 0) {
             if ((offset_tp <= s->target_tp) && (s->measured_lra <= s->target_lra)) {
+                if (s->lookahead)
+                    av_log(ctx, AV_LOG_WARNING, "Linear normalization is possible "
+                           "with the measured values, lookahead is ignored.\n");
                 s->frame_type = LINEAR_MODE;
                 s->offset = offset;
             }
@@ -856,7 +1143,8 @@ static av_cold void uninit(AVFilterContext *ctx)
             20. * log10(tp_out),
             lra_out,
             thresh_out,
-            s->frame_type == LINEAR_MODE ? "linear" : "dynamic",
+            s->frame_type == LINEAR_MODE    ? "linear"    :
+            s->frame_type == STREAMING_MODE ? "streaming" : "dynamic",
             s->target_i - i_out
         );
         break;
@@ -884,7 +1172,8 @@ static av_cold void uninit(AVFilterContext *ctx)
             20. * log10(tp_out),
             lra_out,
             thresh_out,
-            s->frame_type == LINEAR_MODE ? "Linear" : "Dynamic",
+            s->frame_type == LINEAR_MODE    ? "Linear"    :
+            s->frame_type == STREAMING_MODE ? "Streaming" : "Dynamic",
             s->target_i - i_out
         );
         break;
@@ -898,6 +1187,10 @@ end:
     av_freep(&s->limiter_buf);
     av_freep(&s->prev_smp);
     av_freep(&s->buf);
+    av_freep(&s->fdsp);
+    av_freep(&s->ramp);
+    av_freep(&s->tmp);
+    av_freep(&s->block_gains);
 }
 
 static const AVFilterPad avfilter_af_loudnorm_inputs[] = {
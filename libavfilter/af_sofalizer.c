@@ -28,7 +28,6 @@
 #include <math.h>
 #include <mysofa.h>
 
-#include "libavcodec/avfft.h"
 #include "libavutil/avstring.h"
 #include "libavutil/channel_layout.h"
 #include "libavutil/float_dsp.h"
@@ -38,6 +37,7 @@
 #include "filters.h"
 #include "internal.h"
 #include "audio.h"
+#include "partconv.h"
 
 #define TIME_DOMAIN      0
 #define FREQUENCY_DOMAIN 1
@@ -81,7 +81,6 @@ typedef struct SOFAlizerContext {
     int write[2];               /* current write position to ringbuffer */
     int buffer_length;          /* is: longest IR plus max. delay in all SOFA files */
                                 /* then choose next power of 2 */
-    int n_fft;                  /* number of samples in one FFT block */
     int nb_samples;
 
                                 /* netCDF variables */
@@ -90,8 +89,6 @@ typedef struct SOFAlizerContext {
     float *data_ir[2];          /* IRs for all channels to be convolved */
                                 /* (this excludes the LFE) */
     float *temp_src[2];
-    FFTComplex *temp_fft[2];    /* Array to hold FFT values */
-    FFTComplex *temp_afft[2];   /* Array to accumulate FFT values prior to IFFT */
 
                          /* control variables */
     float gain;          /* filter gain (in dB) */
@@ -108,8 +105,7 @@ typedef struct SOFAlizerContext {
 
     VirtualSpeaker vspkrpos[64];
 
-    FFTContext *fft[2], *ifft[2];
-    FFTComplex *data_hrtf[2];
+    PartConvContext *conv;      /* convolution of all channels with the HRTFs */
 
     AVFloatDSPContext *fdsp;
 } SOFAlizerContext;
@@ -333,8 +329,6 @@ typedef struct ThreadData {
     int *n_clippings;
     float **ringbuffer;
     float **temp_src;
-    FFTComplex **temp_fft;
-    FFTComplex **temp_afft;
 } ThreadData;
 
 static int sofalizer_convolute(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
@@ -437,141 +431,52 @@ static int sofalizer_convolute(AVFilterContext *ctx, void *arg, int jobnr, int n
     return 0;
 }
 
-static int sofalizer_fast_convolute(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+static int sofalizer_fast_convolute(AVFilterContext *ctx, AVFrame *in, AVFrame *out,
+                                    int *n_clippings)
 {
     SOFAlizerContext *s = ctx->priv;
-    ThreadData *td = arg;
-    AVFrame *in = td->in, *out = td->out;
-    int offset = jobnr;
-    int *write = &td->write[jobnr];
-    FFTComplex *hrtf = s->data_hrtf[jobnr]; /* get pointers to current HRTF data */
-    int *n_clippings = &td->n_clippings[jobnr];
-    float *ringbuffer = td->ringbuffer[jobnr];
-    const int ir_samples = s->sofa.ir_samples; /* length of one IR */
     const int planar = in->format == AV_SAMPLE_FMT_FLTP;
     const int mult = 1 + !planar;
-    float *dst = (float *)out->extended_data[jobnr * planar]; /* get pointer to audio output buffer */
     const int in_channels = s->n_conv; /* number of input channels */
-    /* ring buffer length is: longest IR plus max. delay -> next power of 2 */
-    const int buffer_length = s->buffer_length;
-    /* -1 for AND instead of MODULO (applied to powers of 2): */
-    const uint32_t modulo = (uint32_t)buffer_length - 1;
-    FFTComplex *fft_in = s->temp_fft[jobnr]; /* temporary array for FFT input/output data */
-    FFTComplex *fft_acc = s->temp_afft[jobnr];
-    FFTContext *ifft = s->ifft[jobnr];
-    FFTContext *fft = s->fft[jobnr];
-    const int n_conv = s->n_conv;
-    const int n_fft = s->n_fft;
-    const float fft_scale = 1.0f / s->n_fft;
-    FFTComplex *hrtf_offset;
-    int wr = *write;
-    int n_read;
-    int i, j;
-
-    if (!planar)
-        dst += offset;
-
-    /* find minimum between number of samples and output buffer length:
-     * (important, if one IR is longer than the output buffer) */
-    n_read = FFMIN(ir_samples, in->nb_samples);
-    for (j = 0; j < n_read; j++) {
-        /* initialize output buf with saved signal from overflow buf */
-        dst[mult * j]  = ringbuffer[wr];
-        ringbuffer[wr] = 0.0f; /* re-set read samples to zero */
-        /* update ringbuffer read/write position */
-        wr  = (wr + 1) & modulo;
-    }
-
-    /* initialize rest of output buffer with 0 */
-    for (j = n_read; j < in->nb_samples; j++) {
-        dst[mult * j] = 0;
-    }
-
-    /* fill FFT accumulation with 0 */
-    memset(fft_acc, 0, sizeof(FFTComplex) * n_fft);
-
-    for (i = 0; i < n_conv; i++) {
-        const float *src = (const float *)in->extended_data[i * planar]; /* get pointer to audio input buffer */
-
-        if (i == s->lfe_channel) { /* LFE */
-            if (in->format == AV_SAMPLE_FMT_FLT) {
-                for (j = 0; j < in->nb_samples; j++) {
-                    /* apply gain to LFE signal and add to output buffer */
-                    dst[2 * j] += src[i + j * in_channels] * s->gain_lfe;
-                }
-            } else {
-                for (j = 0; j < in->nb_samples; j++) {
-                    /* apply gain to LFE signal and add to output buffer */
-                    dst[j] += src[j] * s->gain_lfe;
-                }
-            }
-            continue;
-        }
-
-        /* outer loop: go through all input channels to be convolved */
-        offset = i * n_fft; /* no. samples already processed */
-        hrtf_offset = hrtf + offset;
+    const float *src[64];
+    float *dst[2];
+    int ret, i, j;
+
+    /* interleaved samples are read and written with a stride */
+    for (i = 0; i < in_channels; i++) {
+        src[i] = planar ? (const float *)in->extended_data[i] : (const float *)in->data[0] + i;
+        if (i == s->lfe_channel)
+            src[i] = NULL;
+    }
+    for (i = 0; i < 2; i++)
+        dst[i] = planar ? (float *)out->extended_data[i] : (float *)out->data[0] + i;
+
+    /* convolve all channels with the HRTFs of both ears */
+    ret = ff_partconv_process(ctx, s->conv, dst, mult, src,
+                              planar ? 1 : in_channels, in->nb_samples);
+    if (ret < 0)
+        return ret;
 
-        /* fill FFT input with 0 (we want to zero-pad) */
-        memset(fft_in, 0, sizeof(FFTComplex) * n_fft);
+    for (i = 0; i < 2; i++) {
+        if (s->lfe_channel >= 0) {
+            const float *lfe = planar ? (const float *)in->extended_data[s->lfe_channel] :
+                                        (const float *)in->data[0] + s->lfe_channel;
 
-        if (in->format == AV_SAMPLE_FMT_FLT) {
             for (j = 0; j < in->nb_samples; j++) {
-                /* prepare input for FFT */
-                /* write all samples of current input channel to FFT input array */
-                fft_in[j].re = src[j * in_channels + i];
-            }
-        } else {
-            for (j = 0; j < in->nb_samples; j++) {
-                /* prepare input for FFT */
-                /* write all samples of current input channel to FFT input array */
-                fft_in[j].re = src[j];
+                /* apply gain to LFE signal and add to output buffer */
+                dst[i][mult * j] += lfe[(planar ? 1 : in_channels) * j] * s->gain_lfe;
             }
         }
 
-        /* transform input signal of current channel to frequency domain */
-        av_fft_permute(fft, fft_in);
-        av_fft_calc(fft, fft_in);
-        for (j = 0; j < n_fft; j++) {
-            const FFTComplex *hcomplex = hrtf_offset + j;
-            const float re = fft_in[j].re;
-            const float im = fft_in[j].im;
-
-            /* complex multiplication of input signal and HRTFs */
-            /* output channel (real): */
-            fft_acc[j].re += re * hcomplex->re - im * hcomplex->im;
-            /* output channel (imag): */
-            fft_acc[j].im += re * hcomplex->im + im * hcomplex->re;
-        }
-    }
-
-    /* transform output signal of current channel back to time domain */
-    av_fft_permute(ifft, fft_acc);
-    av_fft_calc(ifft, fft_acc);
-
-    for (j = 0; j < in->nb_samples; j++) {
-        /* write output signal of current channel to output buffer */
-        dst[mult * j] += fft_acc[j].re * fft_scale;
-    }
-
-    for (j = 0; j < ir_samples - 1; j++) { /* overflow length is IR length - 1 */
-        /* write the rest of output signal to overflow buffer */
-        int write_pos = (wr + j) & modulo;
-
-        *(ringbuffer + write_pos) += fft_acc[in->nb_samples + j].re * fft_scale;
-    }
-
-    /* go through all samples of current output buffer: count clippings */
-    for (i = 0; i < out->nb_samples; i++) {
-        /* clippings counter */
-        if (fabsf(dst[i * mult]) > 1) { /* if current output sample > 1 */
-            n_clippings[0]++;
+        /* go through all samples of current output buffer: count clippings */
+        for (j = 0; j < out->nb_samples; j++) {
+            /* clippings counter */
+            if (fabsf(dst[i][mult * j]) > 1) { /* if current output sample > 1 */
+                n_clippings[i]++;
+            }
         }
     }
 
-    /* remember read/write position in ringbuffer for next call */
-    *write = wr;
-
     return 0;
 }
 
@@ -594,13 +499,16 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
     td.in = in; td.out = out; td.write = s->write;
     td.delay = s->delay; td.ir = s->data_ir; td.n_clippings = n_clippings;
     td.ringbuffer = s->ringbuffer; td.temp_src = s->temp_src;
-    td.temp_fft = s->temp_fft;
-    td.temp_afft = s->temp_afft;
 
     if (s->type == TIME_DOMAIN) {
         ctx->internal->execute(ctx, sofalizer_convolute, &td, NULL, 2);
     } else if (s->type == FREQUENCY_DOMAIN) {
-        ctx->internal->execute(ctx, sofalizer_fast_convolute, &td, NULL, 2);
+        int ret = sofalizer_fast_convolute(ctx, in, out, n_clippings);
+        if (ret < 0) {
+            av_frame_free(&in);
+            av_frame_free(&out);
+            return ret;
+        }
     }
     emms_c();
 
@@ -731,15 +639,12 @@ static int load_data(AVFilterContext *ctx, int azim, int elev, float radius, int
     int n_samples;
     int ir_samples;
     int n_conv = s->n_conv; /* no. channels to convolve */
-    int n_fft;
     float delay_l; /* broadband delay for each IR */
     float delay_r;
     int nb_input_channels = ctx->inputs[0]->channels; /* no. input channels */
     float gain_lin = expf((s->gain - 3 * nb_input_channels) / 20 * M_LN10); /* gain - 3dB/channel */
-    FFTComplex *data_hrtf_l = NULL;
-    FFTComplex *data_hrtf_r = NULL;
-    FFTComplex *fft_in_l = NULL;
-    FFTComplex *fft_in_r = NULL;
+    float *hrir_l = NULL;
+    float *hrir_r = NULL;
     float *data_ir_l = NULL;
     float *data_ir_r = NULL;
     int offset = 0; /* used for faster pointer arithmetics in for-loop */
@@ -839,59 +744,36 @@ static int load_data(AVFilterContext *ctx, int azim, int elev, float radius, int
     /* buffer length is longest IR plus max. delay -> next power of 2
        (32 - count leading zeros gives required exponent)  */
     s->buffer_length = 1 << (32 - ff_clz(n_max));
-    s->n_fft = n_fft = 1 << (32 - ff_clz(n_max + s->framesize));
-
-    if (s->type == FREQUENCY_DOMAIN) {
-        av_fft_end(s->fft[0]);
-        av_fft_end(s->fft[1]);
-        s->fft[0] = av_fft_init(av_log2(s->n_fft), 0);
-        s->fft[1] = av_fft_init(av_log2(s->n_fft), 0);
-        av_fft_end(s->ifft[0]);
-        av_fft_end(s->ifft[1]);
-        s->ifft[0] = av_fft_init(av_log2(s->n_fft), 1);
-        s->ifft[1] = av_fft_init(av_log2(s->n_fft), 1);
-
-        if (!s->fft[0] || !s->fft[1] || !s->ifft[0] || !s->ifft[1]) {
-            av_log(ctx, AV_LOG_ERROR, "Unable to create FFT contexts of size %d.\n", s->n_fft);
-            ret = AVERROR(ENOMEM);
-            goto fail;
-        }
-    }
 
     if (s->type == TIME_DOMAIN) {
         s->ringbuffer[0] = av_calloc(s->buffer_length, sizeof(float) * nb_input_channels);
         s->ringbuffer[1] = av_calloc(s->buffer_length, sizeof(float) * nb_input_channels);
-    } else if (s->type == FREQUENCY_DOMAIN) {
-        /* get temporary HRTF memory for L and R channel */
-        data_hrtf_l = av_malloc_array(n_fft, sizeof(*data_hrtf_l) * n_conv);
-        data_hrtf_r = av_malloc_array(n_fft, sizeof(*data_hrtf_r) * n_conv);
-        if (!data_hrtf_r || !data_hrtf_l) {
+        if (!s->ringbuffer[0] || !s->ringbuffer[1]) {
             ret = AVERROR(ENOMEM);
             goto fail;
         }
-
-        s->ringbuffer[0] = av_calloc(s->buffer_length, sizeof(float));
-        s->ringbuffer[1] = av_calloc(s->buffer_length, sizeof(float));
-        s->temp_fft[0] = av_malloc_array(s->n_fft, sizeof(FFTComplex));
-        s->temp_fft[1] = av_malloc_array(s->n_fft, sizeof(FFTComplex));
-        s->temp_afft[0] = av_malloc_array(s->n_fft, sizeof(FFTComplex));
-        s->temp_afft[1] = av_malloc_array(s->n_fft, sizeof(FFTComplex));
-        if (!s->temp_fft[0] || !s->temp_fft[1] ||
-            !s->temp_afft[0] || !s->temp_afft[1]) {
-            ret = AVERROR(ENOMEM);
+    } else if (s->type == FREQUENCY_DOMAIN) {
+        /* IRs 0 to n_conv - 1 are for the left ear, the others for the right
+         * ear, the IRs are shifted by the delays so they are longer than
+         * ir_samples */
+        ff_partconv_uninit(&s->conv);
+        ret = ff_partconv_init(&s->conv, n_conv, 2, 2 * n_conv,
+                               ir_samples + s->sofa.max_delay,
+                               s->framesize, FFMAX(s->framesize, 8192));
+        if (ret < 0)
             goto fail;
-        }
-    }
 
-    if (!s->ringbuffer[0] || !s->ringbuffer[1]) {
-        ret = AVERROR(ENOMEM);
-        goto fail;
-    }
+        for (i = 0; i < n_conv; i++) {
+            if (i == s->lfe_channel)
+                continue;
+            ff_partconv_map(s->conv, 0, i, i);
+            ff_partconv_map(s->conv, 1, i, n_conv + i);
+        }
 
-    if (s->type == FREQUENCY_DOMAIN) {
-        fft_in_l = av_calloc(n_fft, sizeof(*fft_in_l));
-        fft_in_r = av_calloc(n_fft, sizeof(*fft_in_r));
-        if (!fft_in_l || !fft_in_r) {
+        /* get temporary HRIR memory for L and R channel */
+        hrir_l = av_calloc(ir_samples + s->sofa.max_delay, sizeof(*hrir_l));
+        hrir_r = av_calloc(ir_samples + s->sofa.max_delay, sizeof(*hrir_r));
+        if (!hrir_l || !hrir_r) {
             ret = AVERROR(ENOMEM);
             goto fail;
         }
@@ -913,53 +795,31 @@ static int load_data(AVFilterContext *ctx, int azim, int elev, float radius, int
                 s->data_ir[1][offset + j] = rir[ir_samples - 1 - j] * gain_lin;
             }
         } else if (s->type == FREQUENCY_DOMAIN) {
-            memset(fft_in_l, 0, n_fft * sizeof(*fft_in_l));
-            memset(fft_in_r, 0, n_fft * sizeof(*fft_in_r));
+            memset(hrir_l, 0, s->delay[0][i] * sizeof(*hrir_l));
+            memset(hrir_r, 0, s->delay[1][i] * sizeof(*hrir_r));
 
-            offset = i * n_fft; /* no. samples already written */
             for (j = 0; j < ir_samples; j++) {
                 /* load non-reversed IRs of the specified source position
                  * sample-by-sample and apply gain,
-                 * L channel is loaded to real part, R channel to imag part,
                  * IRs are shifted by L and R delay */
-                fft_in_l[s->delay[0][i] + j].re = lir[j] * gain_lin;
-                fft_in_r[s->delay[1][i] + j].re = rir[j] * gain_lin;
+                hrir_l[s->delay[0][i] + j] = lir[j] * gain_lin;
+                hrir_r[s->delay[1][i] + j] = rir[j] * gain_lin;
             }
 
             /* actually transform to frequency domain (IRs -> HRTFs) */
-            av_fft_permute(s->fft[0], fft_in_l);
-            av_fft_calc(s->fft[0], fft_in_l);
-            memcpy(data_hrtf_l + offset, fft_in_l, n_fft * sizeof(*fft_in_l));
-            av_fft_permute(s->fft[0], fft_in_r);
-            av_fft_calc(s->fft[0], fft_in_r);
-            memcpy(data_hrtf_r + offset, fft_in_r, n_fft * sizeof(*fft_in_r));
-        }
-    }
-
-    if (s->type == FREQUENCY_DOMAIN) {
-        s->data_hrtf[0] = av_malloc_array(n_fft * s->n_conv, sizeof(FFTComplex));
-        s->data_hrtf[1] = av_malloc_array(n_fft * s->n_conv, sizeof(FFTComplex));
-        if (!s->data_hrtf[0] || !s->data_hrtf[1]) {
-            ret = AVERROR(ENOMEM);
-            goto fail;
+            if ((ret = ff_partconv_set_ir(s->conv, i, hrir_l, s->delay[0][i] + ir_samples)) < 0 ||
+                (ret = ff_partconv_set_ir(s->conv, n_conv + i, hrir_r, s->delay[1][i] + ir_samples)) < 0)
+                goto fail;
         }
-
-        memcpy(s->data_hrtf[0], data_hrtf_l, /* copy HRTF data to */
-            sizeof(FFTComplex) * n_conv * n_fft); /* filter struct */
-        memcpy(s->data_hrtf[1], data_hrtf_r,
-            sizeof(FFTComplex) * n_conv * n_fft);
     }
 
 fail:
-    av_freep(&data_hrtf_l); /* free temporary HRTF memory */
-    av_freep(&data_hrtf_r);
+    av_freep(&hrir_l); /* free temporary HRIR memory */
+    av_freep(&hrir_r);
 
     av_freep(&data_ir_l); /* free temprary IR memory */
     av_freep(&data_ir_r);
 
-    av_freep(&fft_in_l); /* free temporary FFT memory */
-    av_freep(&fft_in_r);
-
     return ret;
 }
 
@@ -1023,14 +883,7 @@ static av_cold void uninit(AVFilterContext *ctx)
     SOFAlizerContext *s = ctx->priv;
 
     close_sofa(&s->sofa);
-    av_fft_end(s->ifft[0]);
-    av_fft_end(s->ifft[1]);
-    av_fft_end(s->fft[0]);
-    av_fft_end(s->fft[1]);
-    s->ifft[0] = NULL;
-    s->ifft[1] = NULL;
-    s->fft[0] = NULL;
-    s->fft[1] = NULL;
+    ff_partconv_uninit(&s->conv);
     av_freep(&s->delay[0]);
     av_freep(&s->delay[1]);
     av_freep(&s->data_ir[0]);
@@ -1041,12 +894,6 @@ static av_cold void uninit(AVFilterContext *ctx)
     av_freep(&s->speaker_elev);
     av_freep(&s->temp_src[0]);
     av_freep(&s->temp_src[1]);
-    av_freep(&s->temp_afft[0]);
-    av_freep(&s->temp_afft[1]);
-    av_freep(&s->temp_fft[0]);
-    av_freep(&s->temp_fft[1]);
-    av_freep(&s->data_hrtf[0]);
-    av_freep(&s->data_hrtf[1]);
     av_freep(&s->fdsp);
 }
 
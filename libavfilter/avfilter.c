@@ -33,6 +33,8 @@
 #include "libavutil/rational.h"
 #include "libavutil/samplefmt.h"
 #include "libavutil/thread.h"
+#include "libavutil/time.h"
+#include "libavutil/trace.h"
 
 #define FF_INTERNAL_FIELDS 1
 #include "framequeue.h"
@@ -185,6 +187,8 @@ void avfilter_link_free(AVFilterLink **link)
 
 void ff_filter_set_ready(AVFilterContext *filter, unsigned priority)
 {
+    if (!filter->ready && priority && filter->graph->collect_stats)
+        filter->internal->ready_time = av_gettime_relative();
     filter->ready = FFMAX(filter->ready, priority);
 }
 
@@ -620,6 +624,22 @@ static int default_execute(AVFilterContext *ctx, avfilter_action_func *func, voi
     return 0;
 }
 
+static int stats_execute(AVFilterContext *ctx, avfilter_action_func *func, void *arg,
+                         int *ret, int nb_jobs)
+{
+    ctx->internal->stats.nb_executes++;
+    ctx->internal->stats.nb_slices += nb_jobs;
+    return ctx->internal->stats_execute(ctx, func, arg, ret, nb_jobs);
+}
+
+void ff_filter_stats_init(AVFilterContext *ctx)
+{
+    if (ctx->internal->execute == stats_execute)
+        return;
+    ctx->internal->stats_execute = ctx->internal->execute;
+    ctx->internal->execute       = stats_execute;
+}
+
 AVFilterContext *ff_filter_alloc(const AVFilter *filter, const char *inst_name)
 {
     AVFilterContext *ret;
@@ -766,6 +786,57 @@ int ff_filter_get_nb_threads(AVFilterContext *ctx)
     return ctx->graph->nb_threads;
 }
 
+void ff_filter_stats_alloc(AVFilterLink *link, const AVFrame *frame)
+{
+    AVFilterContext *ctx = link->src;
+    int i;
+
+    if (!ctx->graph->collect_stats)
+        return;
+    for (i = 0; i < FF_ARRAY_ELEMS(frame->buf) && frame->buf[i]; i++)
+        ctx->internal->stats.bytes_requested += frame->buf[i]->size;
+    for (i = 0; i < frame->nb_extended_buf; i++)
+        ctx->internal->stats.bytes_requested += frame->extended_buf[i]->size;
+}
+
+int avfilter_get_stats(const AVFilterContext *filter, AVFilterStats *stats)
+{
+    int i;
+
+    if (!filter->graph || !filter->graph->collect_stats)
+        return AVERROR(ENOSYS);
+
+    *stats = filter->internal->stats;
+    stats->frame_count_in = stats->frame_count_out = stats->max_queued_frames = 0;
+    for (i = 0; i < filter->nb_inputs; i++) {
+        const AVFilterLink *link = filter->inputs[i];
+        if (!link)
+            continue;
+        stats->frame_count_in   += link->frame_count_out;
+        stats->max_queued_frames = FFMAX(stats->max_queued_frames,
+                                         link->max_queued_frames);
+    }
+    for (i = 0; i < filter->nb_outputs; i++)
+        if (filter->outputs[i])
+            stats->frame_count_out += filter->outputs[i]->frame_count_in;
+
+    return 0;
+}
+
+int avfilter_link_get_stats(const AVFilterLink *link, AVFilterLinkStats *stats)
+{
+    if (!link->dst->graph || !link->dst->graph->collect_stats)
+        return AVERROR(ENOSYS);
+
+    stats->frame_count_in     = link->frame_count_in;
+    stats->frame_count_out    = link->frame_count_out;
+    stats->queued_frames      = ff_framequeue_queued_frames(&link->fifo);
+    stats->max_queued_frames  = link->max_queued_frames;
+    stats->max_queued_samples = link->max_queued_samples;
+
+    return 0;
+}
+
 static int process_options(AVFilterContext *ctx, AVDictionary **options,
                            const char *args)
 {
@@ -1008,6 +1079,10 @@ int ff_filter_frame(AVFilterLink *link, AVFrame *frame)
             av_log(link->dst, AV_LOG_ERROR, "Sample rate change is not supported\n");
             goto error;
         }
+        if (!link->src->nb_inputs && link->dst->graph->audio_batch_samples) {
+            AVFilterGraphInternal *gi = link->dst->graph->internal;
+            gi->max_source_samples = FFMAX(gi->max_source_samples, frame->nb_samples);
+        }
     }
 
     link->frame_blocked_in = link->frame_wanted_out = 0;
@@ -1018,6 +1093,12 @@ int ff_filter_frame(AVFilterLink *link, AVFrame *frame)
         av_frame_free(&frame);
         return ret;
     }
+    if (link->dst->graph->collect_stats) {
+        link->max_queued_frames  = FFMAX(link->max_queued_frames,
+                                         ff_framequeue_queued_frames(&link->fifo));
+        link->max_queued_samples = FFMAX(link->max_queued_samples,
+                                         ff_framequeue_queued_samples(&link->fifo));
+    }
     ff_filter_set_ready(link->dst, 300);
     return 0;
 
@@ -1315,14 +1396,28 @@ static int ff_filter_activate_default(AVFilterContext *filter)
 
 int ff_filter_activate(AVFilterContext *filter)
 {
+    AVFilterStats *stats = filter->graph->collect_stats ? &filter->internal->stats : NULL;
+    int64_t trace_start, start = 0;
     int ret;
 
     /* Generic timeline support is not yet implemented but should be easy */
     av_assert1(!(filter->filter->flags & AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC &&
                  filter->filter->activate));
+    if (stats) {
+        start = av_gettime_relative();
+        if (filter->ready)
+            stats->wait_time += start - filter->internal->ready_time;
+    }
     filter->ready = 0;
+    trace_start = av_trace_begin();
     ret = filter->filter->activate ? filter->filter->activate(filter) :
           ff_filter_activate_default(filter);
+    av_trace_end(trace_start, AV_TRACE_STAGE_FILTER,
+                 filter->name ? filter->name : filter->filter->name, -1);
+    if (stats) {
+        stats->nb_activations++;
+        stats->activate_time += av_gettime_relative() - start;
+    }
     if (ret == FFERROR_NOT_READY)
         ret = 0;
     return ret;
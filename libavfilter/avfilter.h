@@ -644,6 +644,13 @@ struct AVFilterLink {
      */
     int status_out;
 
+    /**
+     * Highest number of frames and samples queued in fifo, only updated
+     * if the graph collects statistics.
+     */
+    size_t max_queued_frames;
+    uint64_t max_queued_samples;
+
 #endif /* FF_INTERNAL_FIELDS */
 
 };
@@ -673,6 +680,55 @@ void avfilter_link_free(AVFilterLink **link);
  */
 int avfilter_config_links(AVFilterContext *filter);
 
+/**
+ * Performance counters of a filter instance, collected if
+ * AVFilterGraph.collect_stats is set. All times are in microseconds.
+ */
+typedef struct AVFilterStats {
+    int64_t nb_activations;    ///< number of times the filter was activated
+    int64_t activate_time;     ///< time spent in activation, including the filter_frame() and request_frame() callbacks
+    int64_t wait_time;         ///< time between the filter becoming ready and being activated
+    int64_t nb_executes;       ///< number of slice threaded execute() calls
+    int64_t nb_slices;         ///< number of slice jobs run by those calls
+    int64_t frame_count_in;    ///< frames received on all inputs
+    int64_t frame_count_out;   ///< frames sent on all outputs
+    /**
+     * total size of the buffers of the frames obtained for the output links;
+     * buffers reused from a pool are counted each time they are handed out,
+     * so this is not the amount of memory actually allocated
+     */
+    int64_t bytes_requested;
+    int64_t max_queued_frames; ///< highest number of frames queued on a single input
+} AVFilterStats;
+
+/**
+ * Queue statistics of a link, collected if AVFilterGraph.collect_stats is
+ * set.
+ */
+typedef struct AVFilterLinkStats {
+    int64_t frame_count_in;     ///< frames sent to the link
+    int64_t frame_count_out;    ///< frames taken out of the link
+    int64_t queued_frames;      ///< frames currently waiting in the link
+    int64_t max_queued_frames;  ///< highest number of frames waiting in the link
+    int64_t max_queued_samples; ///< highest number of samples waiting in the link
+} AVFilterLinkStats;
+
+/**
+ * Get the performance counters of a filter instance.
+ *
+ * @return 0 on success, AVERROR(ENOSYS) if the graph of the filter does
+ *         not collect statistics
+ */
+int avfilter_get_stats(const AVFilterContext *filter, AVFilterStats *stats);
+
+/**
+ * Get the queue statistics of a link.
+ *
+ * @return 0 on success, AVERROR(ENOSYS) if the graph of the link does
+ *         not collect statistics
+ */
+int avfilter_link_get_stats(const AVFilterLink *link, AVFilterLinkStats *stats);
+
 #define AVFILTER_CMD_FLAG_ONE   1 ///< Stop once a filter understood the command (for target=all for example), fast filters are favored automatically
 #define AVFILTER_CMD_FLAG_FAST  2 ///< Only execute command when its fast (like a video out that supports contrast adjustment in hw)
 
@@ -851,6 +907,27 @@ typedef struct AVFilterGraph {
 
     char *aresample_swr_opts; ///< swr options to use for the auto-inserted aresample filters, Access ONLY through AVOptions
 
+    /**
+     * If set, collect the performance counters returned by
+     * avfilter_get_stats() and avfilter_link_get_stats() for every filter
+     * and link of this graph. Must be set before avfilter_graph_config()
+     * and not changed afterwards.
+     */
+    int collect_stats;
+
+    /**
+     * If set, the audio inputs of the filters whose output does not depend
+     * on how their input is split into frames coalesce the queued frames
+     * into frames of this many samples, reducing the per-frame overhead of
+     * filter chains fed with small frames. Filters that evaluate anything
+     * per frame, filters with a timeline expression and all the filters
+     * before them keep their input framing. Sinks without a frame size set with
+     * av_buffersink_set_frame_size() split them back into frames no larger
+     * than the ones produced by the sources of the graph.
+     * Must be set before avfilter_graph_config().
+     */
+    int audio_batch_samples;
+
     /**
      * Private fields
      *
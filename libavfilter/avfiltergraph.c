@@ -56,6 +56,10 @@ static const AVOption filtergraph_options[] = {
         AV_OPT_TYPE_STRING, {.str = NULL}, 0, 0, F|V },
     {"aresample_swr_opts"   , "default aresample filter options"    , OFFSET(aresample_swr_opts)    ,
         AV_OPT_TYPE_STRING, {.str = NULL}, 0, 0, F|A },
+    { "collect_stats", "Collect per-filter and per-link statistics", OFFSET(collect_stats),
+        AV_OPT_TYPE_BOOL,  { .i64 = 0 }, 0, 1, F|V|A },
+    { "audio_batch_samples", "Coalesce audio into frames of this many samples", OFFSET(audio_batch_samples),
+        AV_OPT_TYPE_INT,   { .i64 = 0 }, 0, INT_MAX, F|A },
     { NULL },
 };
 
@@ -263,6 +267,64 @@ static int graph_config_links(AVFilterGraph *graph, AVClass *log_ctx)
     return 0;
 }
 
+/**
+ * Check that the output of a filter and of all the filters after it up to
+ * the sinks does not depend on the framing of the audio reaching it.
+ * A timeline expression is evaluated per frame, so it makes a filter
+ * framing dependent too.
+ */
+static int audio_batch_safe(AVFilterContext *f)
+{
+    unsigned i;
+
+    if (!f->nb_outputs)
+        return 1;
+    if (!(f->filter->flags_internal & FF_FILTER_FLAG_AUDIO_BATCH) ||
+        f->filter->activate || f->enable_str)
+        return 0;
+    for (i = 0; i < f->nb_outputs; i++)
+        if (!f->outputs[i] || !audio_batch_safe(f->outputs[i]->dst))
+            return 0;
+    return 1;
+}
+
+static void graph_config_audio_batching(AVFilterGraph *graph)
+{
+    AVFilterContext *f;
+    AVFilterLink *l;
+    unsigned i, j;
+
+    if (!graph->audio_batch_samples)
+        return;
+
+    /* A batched filter passes the batch framing on to the filters after
+       it, so only filters followed by framing independent filters up to
+       the sinks are batched. Inputs already asking for a frame size are
+       left alone. */
+    for (i = 0; i < graph->nb_filters; i++) {
+        f = graph->filters[i];
+        if (!f->nb_outputs || !audio_batch_safe(f))
+            continue;
+        for (j = 0; j < f->nb_inputs; j++) {
+            l = f->inputs[j];
+            if (l->type != AVMEDIA_TYPE_AUDIO || l->min_samples)
+                continue;
+            l->min_samples = graph->audio_batch_samples;
+            l->max_samples = graph->audio_batch_samples;
+        }
+    }
+}
+
+static void graph_config_stats(AVFilterGraph *graph)
+{
+    unsigned i;
+
+    if (!graph->collect_stats)
+        return;
+    for (i = 0; i < graph->nb_filters; i++)
+        ff_filter_stats_init(graph->filters[i]);
+}
+
 static int graph_check_links(AVFilterGraph *graph, AVClass *log_ctx)
 {
     AVFilterContext *f;
@@ -1220,8 +1282,10 @@ int avfilter_graph_config(AVFilterGraph *graphctx, void *log_ctx)
         return ret;
     if ((ret = graph_config_formats(graphctx, log_ctx)))
         return ret;
+    graph_config_stats(graphctx);
     if ((ret = graph_config_links(graphctx, log_ctx)))
         return ret;
+    graph_config_audio_batching(graphctx);
     if ((ret = graph_check_links(graphctx, log_ctx)))
         return ret;
     if ((ret = graph_config_pointers(graphctx, log_ctx)))
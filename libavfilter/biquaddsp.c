@@ -0,0 +1,204 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "config.h"
+#include "libavutil/attributes.h"
+#include "biquaddsp.h"
+
+static void section_coeffs(double c[BIQUAD_NB_COEFFS], enum BiquadForm form,
+                           double b0, double b1, double b2, double a1, double a2)
+{
+    if (form == BIQUAD_LATT) {
+        double k0, k1, v0, v1, v2;
+
+        k1 = a2;
+        k0 = a1 / (1. + k1);
+        v2 = b2;
+        v1 = b1 - v2 * a1;
+        v0 = b0 - v1 * k0 - v2 * k1;
+
+        c[0] = v0;
+        c[1] = v1;
+        c[2] = v2;
+        c[3] = k0;
+        c[4] = k1;
+    } else {
+        /* the feedback coefficients are stored negated */
+        c[0] =  b0;
+        c[1] =  b1;
+        c[2] =  b2;
+        c[3] = -a1;
+        c[4] = -a2;
+    }
+}
+
+#define BIQUAD_FUNCS(name, type, lanes)                                            \
+void ff_biquaddsp_set_section_## name(type *coeffs, int section, int lane,          \
+                                      enum BiquadForm form,                         \
+                                      double b0, double b1, double b2,              \
+                                      double a1, double a2)                         \
+{                                                                                   \
+    const int first = lane < 0 ? 0 : lane;                                          \
+    const int last  = lane < 0 ? lanes - 1 : lane;                                  \
+    double c[BIQUAD_NB_COEFFS];                                                     \
+                                                                                    \
+    section_coeffs(c, form, b0, b1, b2, a1, a2);                                    \
+    coeffs += section * BIQUAD_NB_COEFFS * lanes;                                   \
+    for (int i = 0; i < BIQUAD_NB_COEFFS; i++)                                      \
+        for (int l = first; l <= last; l++)                                         \
+            coeffs[i * lanes + l] = c[i];                                           \
+}                                                                                   \
+                                                                                    \
+static void filter_di_## name(type *buf, ptrdiff_t len, const type *coeffs,         \
+                              type *state, int nb_sections)                         \
+{                                                                                   \
+    for (int s = 0; s < nb_sections; s++) {                                         \
+        for (int l = 0; l < lanes; l++) {                                           \
+            const type b0 = coeffs[0 * lanes + l], b1 = coeffs[1 * lanes + l];     \
+            const type b2 = coeffs[2 * lanes + l], a1 = coeffs[3 * lanes + l];     \
+            const type a2 = coeffs[4 * lanes + l];                                  \
+            type i1 = state[0 * lanes + l], i2 = state[1 * lanes + l];              \
+            type o1 = state[2 * lanes + l], o2 = state[3 * lanes + l];              \
+                                                                                    \
+            for (int n = 0; n < len; n++) {                                         \
+                const type in = buf[n * lanes + l];                                 \
+                const type out = i2 * b2 + i1 * b1 + in * b0 + o2 * a2 + o1 * a1;   \
+                                                                                    \
+                i2 = i1;                                                            \
+                i1 = in;                                                            \
+                o2 = o1;                                                            \
+                o1 = out;                                                           \
+                buf[n * lanes + l] = out;                                           \
+            }                                                                       \
+                                                                                    \
+            state[0 * lanes + l] = i1;                                              \
+            state[1 * lanes + l] = i2;                                              \
+            state[2 * lanes + l] = o1;                                              \
+            state[3 * lanes + l] = o2;                                              \
+        }                                                                           \
+        coeffs += BIQUAD_NB_COEFFS * lanes;                                         \
+        state  += BIQUAD_NB_STATES * lanes;                                         \
+    }                                                                               \
+}                                                                                   \
+                                                                                    \
+static void filter_dii_## name(type *buf, ptrdiff_t len, const type *coeffs,        \
+                               type *state, int nb_sections)                        \
+{                                                                                   \
+    for (int s = 0; s < nb_sections; s++) {                                         \
+        for (int l = 0; l < lanes; l++) {                                           \
+            const type b0 = coeffs[0 * lanes + l], b1 = coeffs[1 * lanes + l];     \
+            const type b2 = coeffs[2 * lanes + l], a1 = coeffs[3 * lanes + l];     \
+            const type a2 = coeffs[4 * lanes + l];                                  \
+            type w1 = state[0 * lanes + l], w2 = state[1 * lanes + l];              \
+                                                                                    \
+            for (int n = 0; n < len; n++) {                                         \
+                const type w0 = buf[n * lanes + l] + a1 * w1 + a2 * w2;             \
+                                                                                    \
+                buf[n * lanes + l] = b0 * w0 + b1 * w1 + b2 * w2;                   \
+                w2 = w1;                                                            \
+                w1 = w0;                                                            \
+            }                                                                       \
+                                                                                    \
+            state[0 * lanes + l] = w1;                                              \
+            state[1 * lanes + l] = w2;                                              \
+        }                                                                           \
+        coeffs += BIQUAD_NB_COEFFS * lanes;                                         \
+        state  += BIQUAD_NB_STATES * lanes;                                         \
+    }                                                                               \
+}                                                                                   \
+                                                                                    \
+static void filter_tdii_## name(type *buf, ptrdiff_t len, const type *coeffs,       \
+                                type *state, int nb_sections)                       \
+{                                                                                   \
+    for (int s = 0; s < nb_sections; s++) {                                         \
+        for (int l = 0; l < lanes; l++) {                                           \
+            const type b0 = coeffs[0 * lanes + l], b1 = coeffs[1 * lanes + l];     \
+            const type b2 = coeffs[2 * lanes + l], a1 = coeffs[3 * lanes + l];     \
+            const type a2 = coeffs[4 * lanes + l];                                  \
+            type z1 = state[0 * lanes + l], z2 = state[1 * lanes + l];              \
+                                                                                    \
+            for (int n = 0; n < len; n++) {                                         \
+                const type in = buf[n * lanes + l];                                 \
+                const type out = b0 * in + z1;                                      \
+                                                                                    \
+                z1 = b1 * in + z2 + a1 * out;                                       \
+                z2 = b2 * in + a2 * out;                                            \
+                buf[n * lanes + l] = out;                                           \
+            }                                                                       \
+                                                                                    \
+            state[0 * lanes + l] = z1;                                              \
+            state[1 * lanes + l] = z2;                                              \
+        }                                                                           \
+        coeffs += BIQUAD_NB_COEFFS * lanes;                                         \
+        state  += BIQUAD_NB_STATES * lanes;                                         \
+    }                                                                               \
+}                                                                                   \
+                                                                                    \
+static void filter_latt_## name(type *buf, ptrdiff_t len, const type *coeffs,       \
+                                type *state, int nb_sections)                       \
+{                                                                                   \
+    for (int s = 0; s < nb_sections; s++) {                                         \
+        for (int l = 0; l < lanes; l++) {                                           \
+            const type v0 = coeffs[0 * lanes + l], v1 = coeffs[1 * lanes + l];     \
+            const type v2 = coeffs[2 * lanes + l], k0 = coeffs[3 * lanes + l];     \
+            const type k1 = coeffs[4 * lanes + l];                                  \
+            type s0 = state[0 * lanes + l], s1 = state[1 * lanes + l];              \
+                                                                                    \
+            for (int n = 0; n < len; n++) {                                         \
+                type t0, t1, out;                                                   \
+                                                                                    \
+                t0  = buf[n * lanes + l] - k1 * s0;                                 \
+                t1  = t0 * k1 + s0;                                                 \
+                out = t1 * v2;                                                      \
+                                                                                    \
+                t0   = t0 - k0 * s1;                                                \
+                t1   = t0 * k0 + s1;                                                \
+                out += t1 * v1;                                                     \
+                                                                                    \
+                out += t0 * v0;                                                     \
+                s0   = t1;                                                          \
+                s1   = t0;                                                          \
+                buf[n * lanes + l] = out;                                           \
+            }                                                                       \
+                                                                                    \
+            state[0 * lanes + l] = s0;                                              \
+            state[1 * lanes + l] = s1;                                              \
+        }                                                                           \
+        coeffs += BIQUAD_NB_COEFFS * lanes;                                         \
+        state  += BIQUAD_NB_STATES * lanes;                                         \
+    }                                                                               \
+}
+
+BIQUAD_FUNCS(flt, float,  BIQUAD_LANES_FLT)
+BIQUAD_FUNCS(dbl, double, BIQUAD_LANES_DBL)
+
+av_cold void ff_biquaddsp_init(BiquadDSPContext *dsp)
+{
+    dsp->filter_dbl[BIQUAD_DI]   = filter_di_dbl;
+    dsp->filter_dbl[BIQUAD_DII]  = filter_dii_dbl;
+    dsp->filter_dbl[BIQUAD_TDII] = filter_tdii_dbl;
+    dsp->filter_dbl[BIQUAD_LATT] = filter_latt_dbl;
+
+    dsp->filter_flt[BIQUAD_DI]   = filter_di_flt;
+    dsp->filter_flt[BIQUAD_DII]  = filter_dii_flt;
+    dsp->filter_flt[BIQUAD_TDII] = filter_tdii_flt;
+    dsp->filter_flt[BIQUAD_LATT] = filter_latt_flt;
+
+    if (ARCH_X86)
+        ff_biquaddsp_init_x86(dsp);
+}
@@ -0,0 +1,85 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Cascaded biquad filters shared by the IIR audio filters
+ *
+ * Samples are stored interleaved in groups of BIQUAD_LANES_FLT floats or
+ * BIQUAD_LANES_DBL doubles, one channel per lane, so that every channel of
+ * a group runs in its own SIMD lane. Every lane computes the same operations
+ * in the same order as the C version, which keeps the results bit-exact.
+ */
+
+#ifndef AVFILTER_BIQUADDSP_H
+#define AVFILTER_BIQUADDSP_H
+
+#include <stddef.h>
+
+/** Number of channels filtered together, one 32-byte vector per frame. */
+#define BIQUAD_LANES_FLT   8
+#define BIQUAD_LANES_DBL   4
+
+/** Coefficients of a section, b0, b1, b2, a1, a2 for the direct forms. */
+#define BIQUAD_NB_COEFFS   5
+
+/** History of a section, only direct form I uses all of it. */
+#define BIQUAD_NB_STATES   4
+
+enum BiquadForm {
+    BIQUAD_DI,          ///< direct form I
+    BIQUAD_DII,         ///< direct form II
+    BIQUAD_TDII,        ///< transposed direct form II
+    BIQUAD_LATT,        ///< lattice-ladder form
+    BIQUAD_NB_FORMS,
+};
+
+typedef struct BiquadDSPContext {
+    /**
+     * Filter len frames of buf in place with nb_sections cascaded sections.
+     *
+     * @param coeffs BIQUAD_NB_COEFFS vectors per section, one element per
+     *               lane, see ff_biquaddsp_set_section_dbl()
+     * @param state  BIQUAD_NB_STATES vectors per section, updated
+     */
+    void (*filter_dbl[BIQUAD_NB_FORMS])(double *buf, ptrdiff_t len, const double *coeffs,
+                                        double *state, int nb_sections);
+    void (*filter_flt[BIQUAD_NB_FORMS])(float *buf, ptrdiff_t len, const float *coeffs,
+                                        float *state, int nb_sections);
+} BiquadDSPContext;
+
+/**
+ * Store the coefficients of the normalized section
+ * (b0 + b1 z^-1 + b2 z^-2) / (1 + a1 z^-1 + a2 z^-2)
+ * in the layout expected by the filter of the given form.
+ *
+ * @param lane channel of the group to set, or -1 for all of them
+ */
+void ff_biquaddsp_set_section_dbl(double *coeffs, int section, int lane,
+                                  enum BiquadForm form,
+                                  double b0, double b1, double b2,
+                                  double a1, double a2);
+void ff_biquaddsp_set_section_flt(float *coeffs, int section, int lane,
+                                  enum BiquadForm form,
+                                  double b0, double b1, double b2,
+                                  double a1, double a2);
+
+void ff_biquaddsp_init(BiquadDSPContext *dsp);
+void ff_biquaddsp_init_x86(BiquadDSPContext *dsp);
+
+#endif /* AVFILTER_BIQUADDSP_H */
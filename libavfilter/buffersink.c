@@ -104,7 +104,8 @@ static int return_or_keep_frame(BufferSinkContext *buf, AVFrame *out, AVFrame *i
     }
 }
 
-static int get_frame_internal(AVFilterContext *ctx, AVFrame *frame, int flags, int samples)
+static int get_frame_internal(AVFilterContext *ctx, AVFrame *frame, int flags,
+                              int min_samples, int max_samples)
 {
     BufferSinkContext *buf = ctx->priv;
     AVFilterLink *inlink = ctx->inputs[0];
@@ -116,8 +117,8 @@ static int get_frame_internal(AVFilterContext *ctx, AVFrame *frame, int flags, i
         return return_or_keep_frame(buf, frame, buf->peeked_frame, flags);
 
     while (1) {
-        ret = samples ? ff_inlink_consume_samples(inlink, samples, samples, &cur_frame) :
-                        ff_inlink_consume_frame(inlink, &cur_frame);
+        ret = max_samples ? ff_inlink_consume_samples(inlink, FFMAX(min_samples, 1), max_samples, &cur_frame) :
+                            ff_inlink_consume_frame(inlink, &cur_frame);
         if (ret < 0) {
             return ret;
         } else if (ret) {
@@ -139,13 +140,19 @@ static int get_frame_internal(AVFilterContext *ctx, AVFrame *frame, int flags, i
 
 int attribute_align_arg av_buffersink_get_frame_flags(AVFilterContext *ctx, AVFrame *frame, int flags)
 {
-    return get_frame_internal(ctx, frame, flags, ctx->inputs[0]->min_samples);
+    AVFilterLink *inlink = ctx->inputs[0];
+    int max_samples = inlink->min_samples;
+
+    if (!max_samples && inlink->type == AVMEDIA_TYPE_AUDIO &&
+        ctx->graph->audio_batch_samples)
+        max_samples = ctx->graph->internal->max_source_samples;
+    return get_frame_internal(ctx, frame, flags, inlink->min_samples, max_samples);
 }
 
 int attribute_align_arg av_buffersink_get_samples(AVFilterContext *ctx,
                                                   AVFrame *frame, int nb_samples)
 {
-    return get_frame_internal(ctx, frame, 0, nb_samples);
+    return get_frame_internal(ctx, frame, 0, nb_samples, nb_samples);
 }
 
 #if FF_API_BUFFERSINK_ALLOC
@@ -21,6 +21,8 @@
 
 #include <string.h>
 
+#include "config.h"
+
 #include "libavutil/avassert.h"
 #include "libavutil/avutil.h"
 #include "libavutil/colorspace.h"
@@ -81,6 +83,111 @@ int ff_fill_rgba_map(uint8_t *rgba_map, enum AVPixelFormat pix_fmt)
     return 0;
 }
 
+#define RD8(p)     (*(p))
+#define WR8(p, v)  (*(p) = (v))
+#define RD16(p)    AV_RL16(p)
+#define WR16(p, v) AV_WL16(p, v)
+
+#define DEFINE_BLEND_ROW(bits, nb_comp, type, shift)                           \
+static int blend_row ## bits ## _ ## nb_comp(uint8_t *dst8, const uint32_t *tau, \
+                                            const uint32_t *asrc, int len)     \
+{                                                                              \
+    type *dst = (type *)dst8;                                                  \
+    uint32_t t[nb_comp], s[nb_comp];                                           \
+    int x, c;                                                                  \
+                                                                               \
+    /* local copies, so that the compiler knows dst does not alias them */     \
+    for (c = 0; c < nb_comp; c++) {                                            \
+        t[c] = tau[c];                                                         \
+        s[c] = asrc[c];                                                        \
+    }                                                                          \
+    for (x = 0; x < len; x += nb_comp) {                                       \
+        for (c = 0; c < nb_comp; c++)                                          \
+            WR ## bits(dst + x + c,                                            \
+                       (RD ## bits(dst + x + c) * t[c] + s[c]) >> shift);      \
+    }                                                                          \
+    return len;                                                                \
+}
+
+DEFINE_BLEND_ROW(8,  1, uint8_t,  24)
+DEFINE_BLEND_ROW(8,  2, uint8_t,  24)
+DEFINE_BLEND_ROW(8,  3, uint8_t,  24)
+DEFINE_BLEND_ROW(8,  4, uint8_t,  24)
+DEFINE_BLEND_ROW(16, 1, uint16_t, 16)
+DEFINE_BLEND_ROW(16, 2, uint16_t, 16)
+
+#define DEFINE_BLEND_MASK_ROW(nb_comp)                                         \
+static int blend_mask_row8_ ## nb_comp(uint8_t *dst, const uint8_t *mask,     \
+                                       const uint32_t *alpha,                 \
+                                       const uint32_t *src, int w)            \
+{                                                                              \
+    uint32_t al[nb_comp], s[nb_comp];                                          \
+    int x, c;                                                                  \
+                                                                               \
+    for (c = 0; c < nb_comp; c++) {                                            \
+        al[c] = alpha[c];                                                      \
+        s[c]  = src[c];                                                        \
+    }                                                                          \
+    for (x = 0; x < w; x++) {                                                  \
+        for (c = 0; c < nb_comp; c++) {                                        \
+            unsigned a = mask[x] * al[c];                                      \
+            dst[c] = ((0x1010101 - a) * dst[c] + a * s[c]) >> 24;              \
+        }                                                                      \
+        dst += nb_comp;                                                        \
+    }                                                                          \
+    return w;                                                                  \
+}
+
+DEFINE_BLEND_MASK_ROW(1)
+DEFINE_BLEND_MASK_ROW(2)
+DEFINE_BLEND_MASK_ROW(3)
+DEFINE_BLEND_MASK_ROW(4)
+
+/* Pick a row blending function specialized for the component size and
+   count of the plane, if all its components are separate bytes or words. */
+static void init_blend_row(FFDrawContext *draw)
+{
+    const AVPixFmtDescriptor *desc = draw->desc;
+    const int bytes = desc->comp[0].depth > 8 ? 2 : 1;
+    unsigned plane, i, j;
+
+    for (i = 0; i < desc->nb_components; i++) {
+        const AVComponentDescriptor *c = &desc->comp[i];
+
+        if ((c->depth > 8 ? 2 : 1) != bytes || c->offset % bytes)
+            return;
+        for (j = 0; j < i; j++)
+            if (desc->comp[j].plane  == c->plane &&
+                desc->comp[j].offset == c->offset)
+                return;
+    }
+    for (plane = 0; plane < draw->nb_planes; plane++) {
+        int nb_comp = draw->pixelstep[plane] / bytes;
+
+        if (draw->pixelstep[plane] % bytes)
+            continue;
+        if (bytes == 1) {
+            switch (nb_comp) {
+            case 1: draw->blend_row[plane] = blend_row8_1; break;
+            case 2: draw->blend_row[plane] = blend_row8_2; break;
+            case 3: draw->blend_row[plane] = blend_row8_3; break;
+            case 4: draw->blend_row[plane] = blend_row8_4; break;
+            }
+            switch (nb_comp) {
+            case 1: draw->blend_mask_row[plane] = blend_mask_row8_1; break;
+            case 2: draw->blend_mask_row[plane] = blend_mask_row8_2; break;
+            case 3: draw->blend_mask_row[plane] = blend_mask_row8_3; break;
+            case 4: draw->blend_mask_row[plane] = blend_mask_row8_4; break;
+            }
+        } else {
+            switch (nb_comp) {
+            case 1: draw->blend_row[plane] = blend_row16_1; break;
+            case 2: draw->blend_row[plane] = blend_row16_2; break;
+            }
+        }
+    }
+}
+
 int ff_draw_init(FFDrawContext *draw, enum AVPixelFormat format, unsigned flags)
 {
     const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(format);
@@ -93,8 +200,6 @@ int ff_draw_init(FFDrawContext *draw, enum AVPixelFormat format, unsigned flags)
         return AVERROR(EINVAL);
     if (desc->flags & ~(AV_PIX_FMT_FLAG_PLANAR | AV_PIX_FMT_FLAG_RGB | AV_PIX_FMT_FLAG_ALPHA))
         return AVERROR(ENOSYS);
-    if (format == AV_PIX_FMT_P010LE || format == AV_PIX_FMT_P010BE || format == AV_PIX_FMT_P016LE || format == AV_PIX_FMT_P016BE)
-        return AVERROR(ENOSYS);
     if (format == AV_PIX_FMT_YUVJ420P || format == AV_PIX_FMT_YUVJ422P || format == AV_PIX_FMT_YUVJ444P ||
         format == AV_PIX_FMT_YUVJ411P || format == AV_PIX_FMT_YUVJ440P)
         full_range = 1;
@@ -131,6 +236,9 @@ int ff_draw_init(FFDrawContext *draw, enum AVPixelFormat format, unsigned flags)
     for (i = 0; i < (desc->nb_components - !!(desc->flags & AV_PIX_FMT_FLAG_ALPHA && !(flags & FF_DRAW_PROCESS_ALPHA))); i++)
         draw->comp_mask[desc->comp[i].plane] |=
             1 << desc->comp[i].offset;
+    init_blend_row(draw);
+    if (ARCH_X86)
+        ff_draw_init_x86(draw);
     return 0;
 }
 
@@ -166,7 +274,7 @@ void ff_draw_color(FFDrawContext *draw, FFDrawColor *color, const uint8_t rgba[4
         color->comp[3].u8[0] = rgba[3];
 #define EXPAND(compn) \
         if (desc->comp[compn].depth > 8) \
-            color->comp[desc->comp[compn].plane].u16[desc->comp[compn].offset] = \
+            color->comp[desc->comp[compn].plane].u16[desc->comp[compn].offset >> 1] = \
             color->comp[desc->comp[compn].plane].u8[desc->comp[compn].offset] << \
                 (draw->desc->comp[compn].depth + draw->desc->comp[compn].shift - 8)
         EXPAND(3);
@@ -182,8 +290,10 @@ void ff_draw_color(FFDrawContext *draw, FFDrawColor *color, const uint8_t rgba[4
         const AVPixFmtDescriptor *desc = draw->desc;
         color->comp[0].u8[0] = RGB_TO_Y_CCIR(rgba[0], rgba[1], rgba[2]);
         EXPAND(0);
-        color->comp[1].u8[0] = rgba[3];
-        EXPAND(1);
+        if (desc->nb_components > 1) {
+            color->comp[desc->comp[1].plane].u8[desc->comp[1].offset] = rgba[3];
+            EXPAND(1);
+        }
     } else {
         av_log(NULL, AV_LOG_WARNING,
                "Color conversion not implemented for %s\n", draw->desc->name);
@@ -235,19 +345,21 @@ void ff_fill_rectangle(FFDrawContext *draw, FFDrawColor *color,
         hp = AV_CEIL_RSHIFT(h, draw->vsub[plane]);
         if (!hp)
             return;
-        p = p0;
 
         if (HAVE_BIGENDIAN && draw->desc->comp[0].depth > 8) {
             for (x = 0; 2*x < draw->pixelstep[plane]; x++)
                 color_tmp.comp[plane].u16[x] = av_bswap16(color_tmp.comp[plane].u16[x]);
         }
 
-        /* copy first line from color */
-        for (x = 0; x < wp; x++) {
-            memcpy(p, color_tmp.comp[plane].u8, draw->pixelstep[plane]);
-            p += draw->pixelstep[plane];
-        }
+        /* copy first line from color, doubling the filled part each time */
         wp *= draw->pixelstep[plane];
+        if (wp > 0 && draw->pixelstep[plane] == 1) {
+            memset(p0, color_tmp.comp[plane].u8[0], wp);
+        } else if (wp > 0) {
+            memcpy(p0, color_tmp.comp[plane].u8, draw->pixelstep[plane]);
+            for (x = draw->pixelstep[plane]; x < wp; x += x)
+                memcpy(p0 + x, p0, FFMIN(x, wp - x));
+        }
         /* copy next lines from first line */
         p = p0 + dst_linesize[plane];
         for (y = 1; y < hp; y++) {
@@ -348,6 +460,68 @@ static void blend_line16(uint8_t *dst, unsigned src, unsigned alpha,
     }
 }
 
+static void blend_row(FFDrawContext *draw, int plane, uint8_t *dst,
+                      const uint32_t *tau, const uint32_t *asrc, int len)
+{
+    const int bytes   = draw->desc->comp[0].depth > 8 ? 2 : 1;
+    const int nb_comp = draw->pixelstep[plane] / bytes;
+    int x = draw->blend_row[plane](dst, tau, asrc, len);
+
+    for (; x < len; x++) {
+        if (bytes == 1)
+            dst[x] = (dst[x] * tau[x % nb_comp] + asrc[x % nb_comp]) >> 24;
+        else
+            AV_WL16(dst + 2 * x, (AV_RL16(dst + 2 * x) * tau[x % nb_comp] +
+                                  asrc[x % nb_comp]) >> 16);
+    }
+}
+
+/**
+ * Blend h rows of a plane using the specialized row function.
+ * Unused components get a neutral factor, so whole pixels can be processed.
+ */
+static void blend_rows(FFDrawContext *draw, FFDrawColor *color, int plane,
+                       uint8_t *p, int linesize, unsigned alpha,
+                       int w, int h, int left, int right)
+{
+    const int bytes   = draw->desc->comp[0].depth > 8 ? 2 : 1;
+    const int step    = draw->pixelstep[plane];
+    const int nb_comp = step / bytes;
+    const unsigned one = bytes == 1 ? 0x1010101 : 0x10001;
+    const unsigned a[3] = { (left  * alpha) >> draw->hsub[plane], alpha,
+                            (right * alpha) >> draw->hsub[plane] };
+    uint32_t tau[3][8], asrc[3][8];
+    int i, k, y;
+
+    for (i = 0; i < 8; i++) {
+        int comp = i % nb_comp;
+        unsigned src = bytes == 1 ? color->comp[plane].u8[comp] :
+                                    color->comp[plane].u16[comp];
+
+        for (k = 0; k < 3; k++) {
+            if (component_used(draw, plane, comp * bytes)) {
+                tau[k][i]  = one - a[k];
+                asrc[k][i] = src * a[k];
+            } else {
+                tau[k][i]  = one;
+                asrc[k][i] = 0;
+            }
+        }
+    }
+    for (y = 0; y < h; y++) {
+        uint8_t *d = p;
+
+        if (left) {
+            blend_row(draw, plane, d, tau[0], asrc[0], nb_comp);
+            d += step;
+        }
+        blend_row(draw, plane, d, tau[1], asrc[1], w * nb_comp);
+        if (right)
+            blend_row(draw, plane, d + w * step, tau[2], asrc[2], nb_comp);
+        p += linesize;
+    }
+}
+
 void ff_blend_rectangle(FFDrawContext *draw, FFDrawColor *color,
                         uint8_t *dst[], int dst_linesize[],
                         int dst_w, int dst_h,
@@ -380,6 +554,21 @@ void ff_blend_rectangle(FFDrawContext *draw, FFDrawColor *color,
         y_sub = y0;
         subsampling_bounds(draw->hsub[plane], &x_sub, &w_sub, &left, &right);
         subsampling_bounds(draw->vsub[plane], &y_sub, &h_sub, &top, &bottom);
+        if (draw->blend_row[plane]) {
+            p = p0;
+            if (top) {
+                blend_rows(draw, color, plane, p, dst_linesize[plane],
+                           alpha >> 1, w_sub, 1, left, right);
+                p += dst_linesize[plane];
+            }
+            blend_rows(draw, color, plane, p, dst_linesize[plane],
+                       alpha, w_sub, h_sub, left, right);
+            p += h_sub * dst_linesize[plane];
+            if (bottom)
+                blend_rows(draw, color, plane, p, dst_linesize[plane],
+                           alpha >> 1, w_sub, 1, left, right);
+            continue;
+        }
         for (comp = 0; comp < nb_comp; comp++) {
             const int depth = draw->desc->comp[comp].depth;
 
@@ -392,7 +581,7 @@ void ff_blend_rectangle(FFDrawContext *draw, FFDrawColor *color,
                                draw->pixelstep[plane], w_sub,
                                draw->hsub[plane], left, right);
                 } else {
-                    blend_line16(p, color->comp[plane].u16[comp], alpha >> 1,
+                    blend_line16(p, color->comp[plane].u16[comp >> 1], alpha >> 1,
                                  draw->pixelstep[plane], w_sub,
                                  draw->hsub[plane], left, right);
                 }
@@ -407,7 +596,7 @@ void ff_blend_rectangle(FFDrawContext *draw, FFDrawColor *color,
                 }
             } else {
                 for (y = 0; y < h_sub; y++) {
-                    blend_line16(p, color->comp[plane].u16[comp], alpha,
+                    blend_line16(p, color->comp[plane].u16[comp >> 1], alpha,
                                  draw->pixelstep[plane], w_sub,
                                  draw->hsub[plane], left, right);
                     p += dst_linesize[plane];
@@ -419,7 +608,7 @@ void ff_blend_rectangle(FFDrawContext *draw, FFDrawColor *color,
                                draw->pixelstep[plane], w_sub,
                                draw->hsub[plane], left, right);
                 } else {
-                    blend_line16(p, color->comp[plane].u16[comp], alpha >> 1,
+                    blend_line16(p, color->comp[plane].u16[comp >> 1], alpha >> 1,
                                  draw->pixelstep[plane], w_sub,
                                  draw->hsub[plane], left, right);
                 }
@@ -525,6 +714,37 @@ static void blend_line_hv(uint8_t *dst, int dst_delta,
                     right, hband, hsub + vsub, xm);
 }
 
+/**
+ * Blend h rows of a plane without subsampling through an 8-bit mask,
+ * using the specialized row function.
+ */
+static void blend_mask_rows(FFDrawContext *draw, FFDrawColor *color, int plane,
+                            uint8_t *p, int linesize, unsigned alpha,
+                            const uint8_t *mask, int mask_linesize, int w, int h)
+{
+    const int nb_comp = draw->pixelstep[plane];
+    uint32_t al[8], src[8];
+    int i, x, y, c;
+
+    for (i = 0; i < 8; i++) {
+        c = i % nb_comp;
+        al[i]  = component_used(draw, plane, c) ? alpha : 0;
+        src[i] = color->comp[plane].u8[c];
+    }
+    for (y = 0; y < h; y++) {
+        x = draw->blend_mask_row[plane](p, mask, al, src, w);
+        for (; x < w; x++) {
+            for (c = 0; c < nb_comp; c++) {
+                uint8_t *d = p + x * nb_comp + c;
+                unsigned a = mask[x] * al[c];
+                *d = ((0x1010101 - a) * *d + a * src[c]) >> 24;
+            }
+        }
+        p    += linesize;
+        mask += mask_linesize;
+    }
+}
+
 void ff_blend_mask(FFDrawContext *draw, FFDrawColor *color,
                    uint8_t *dst[], int dst_linesize[], int dst_w, int dst_h,
                    const uint8_t *mask,  int mask_linesize, int mask_w, int mask_h,
@@ -558,6 +778,12 @@ void ff_blend_mask(FFDrawContext *draw, FFDrawColor *color,
         y_sub = y0;
         subsampling_bounds(draw->hsub[plane], &x_sub, &w_sub, &left, &right);
         subsampling_bounds(draw->vsub[plane], &y_sub, &h_sub, &top, &bottom);
+        if (draw->blend_mask_row[plane] && l2depth == 3 &&
+            !draw->hsub[plane] && !draw->vsub[plane]) {
+            blend_mask_rows(draw, color, plane, p0, dst_linesize[plane], alpha,
+                            mask + xm0, mask_linesize, mask_w, mask_h);
+            continue;
+        }
         for (comp = 0; comp < nb_comp; comp++) {
             const int depth = draw->desc->comp[comp].depth;
 
@@ -574,7 +800,7 @@ void ff_blend_mask(FFDrawContext *draw, FFDrawColor *color,
                                   xm0, left, right, top);
                 } else {
                     blend_line_hv16(p, draw->pixelstep[plane],
-                                    color->comp[plane].u16[comp], alpha,
+                                    color->comp[plane].u16[comp >> 1], alpha,
                                     m, mask_linesize, l2depth, w_sub,
                                     draw->hsub[plane], draw->vsub[plane],
                                     xm0, left, right, top);
@@ -595,7 +821,7 @@ void ff_blend_mask(FFDrawContext *draw, FFDrawColor *color,
             } else {
                 for (y = 0; y < h_sub; y++) {
                     blend_line_hv16(p, draw->pixelstep[plane],
-                                    color->comp[plane].u16[comp], alpha,
+                                    color->comp[plane].u16[comp >> 1], alpha,
                                     m, mask_linesize, l2depth, w_sub,
                                     draw->hsub[plane], draw->vsub[plane],
                                     xm0, left, right, 1 << draw->vsub[plane]);
@@ -612,7 +838,7 @@ void ff_blend_mask(FFDrawContext *draw, FFDrawColor *color,
                                   xm0, left, right, bottom);
                 } else {
                     blend_line_hv16(p, draw->pixelstep[plane],
-                                    color->comp[plane].u16[comp], alpha,
+                                    color->comp[plane].u16[comp >> 1], alpha,
                                     m, mask_linesize, l2depth, w_sub,
                                     draw->hsub[plane], draw->vsub[plane],
                                     xm0, left, right, bottom);
@@ -44,6 +44,32 @@ typedef struct FFDrawContext {
     uint8_t vsub_max;
     int full_range;
     unsigned flags;
+
+    /**
+     * Blend len components of one row of a plane with an uniform color:
+     * dst[i] = (dst[i] * tau[i % n] + asrc[i % n]) >> 24 for 8-bit formats,
+     * >> 16 for 16-bit ones, with n components per pixel. tau and asrc hold
+     * one entry per component, repeated to fill 8 entries.
+     * NULL if the plane layout has no specialized version.
+     * @return number of components processed, the remaining ones are left
+     *         to the caller
+     */
+    int (*blend_row[MAX_PLANES])(uint8_t *dst, const uint32_t *tau,
+                                 const uint32_t *asrc, int len);
+
+    /**
+     * Blend w pixels of one row of a plane of an 8-bit format with an
+     * uniform color through an 8 bits per pixel mask, for planes without
+     * subsampling: a = mask[x] * alpha[c],
+     * dst = (dst * (0x1010101 - a) + src[c] * a) >> 24 for each component c.
+     * alpha and src hold one entry per component, repeated to fill 8 entries.
+     * NULL if the plane layout has no specialized version.
+     * @return number of pixels processed, the remaining ones are left
+     *         to the caller
+     */
+    int (*blend_mask_row[MAX_PLANES])(uint8_t *dst, const uint8_t *mask,
+                                      const uint32_t *alpha,
+                                      const uint32_t *src, int w);
 } FFDrawContext;
 
 typedef struct FFDrawColor {
@@ -70,6 +96,8 @@ typedef struct FFDrawColor {
  */
 int ff_draw_init(FFDrawContext *draw, enum AVPixelFormat format, unsigned flags);
 
+void ff_draw_init_x86(FFDrawContext *draw);
+
 /**
  * Prepare a color.
  */
@@ -42,6 +42,7 @@
 */
 
 #include "ebur128.h"
+#include "ebur128dsp.h"
 
 #include <float.h>
 #include <limits.h>
@@ -65,12 +66,15 @@
 #define MINUS_20DB            pow(10.0, -20.0 / 10.0)
 
 struct FFEBUR128StateInternal {
-    /** Filtered audio data (used as ring buffer). */
+    /** Energy of the filtered audio data (used as ring buffer). */
     double *audio_data;
     /** Size of audio_data array. */
     size_t audio_data_frames;
     /** Current index for audio_data. */
     size_t audio_data_index;
+    /** Number of doubles per frame in audio_data, channels padded to
+     *  EBUR128_LANES. */
+    size_t stride;
     /** How many frames are needed for a gating block. Will correspond to 400ms
      *  of audio at initialization, and 100ms after the first block (75% overlap
      *  as specified in the 2011 revision of BS1770). */
@@ -79,12 +83,24 @@ struct FFEBUR128StateInternal {
     int *channel_map;
     /** How many samples fit in 100ms (rounded). */
     unsigned long samples_in_100ms;
-    /** BS.1770 filter coefficients (nominator). */
-    double b[5];
-    /** BS.1770 filter coefficients (denominator). */
-    double a[5];
-    /** BS.1770 filter state. */
-    double v[5][5];
+    /** Weighted energy sums of the last 100ms blocks (used as ring buffer),
+     *  gating and short term blocks are assembled from them. */
+    double block_sums[30];
+    /** Current index for block_sums. */
+    size_t block_sums_index;
+    /** How many frames of the current 100ms block have been filtered. */
+    unsigned long block_frames;
+    /** Sum of the histogram energies of all gating blocks and their count,
+     *  used for the relative threshold. */
+    double block_energy_total;
+    unsigned long block_energy_count;
+    /** BS.1770 filter coefficients, repeated for every lane. */
+    DECLARE_ALIGNED(32, double, coeffs)[EBUR128_NB_COEFFS * EBUR128_LANES];
+    /** BS.1770 filter state, stride values per row. */
+    double *filter_state;
+    /** Per-channel energy sums of a gating block. */
+    double *channel_sums;
+    EBUR128DSPContext dsp;
     /** Histograms, used to calculate LRA. */
     unsigned long *block_energy_histogram;
     unsigned long *short_term_block_energy_histogram;
@@ -94,8 +110,6 @@ struct FFEBUR128StateInternal {
     double *sample_peak;
     /** The maximum window duration in ms. */
     unsigned long window;
-    /** Data pointer array for interleaved data */
-    void **data_ptrs;
 };
 
 static AVOnce histogram_init = AV_ONCE_INIT;
@@ -104,52 +118,11 @@ static DECLARE_ALIGNED(32, double, histogram_energy_boundaries)[1001];
 
 static void ebur128_init_filter(FFEBUR128State * st)
 {
-    int i, j;
-
-    double f0 = 1681.974450955533;
-    double G = 3.999843853973347;
-    double Q = 0.7071752369554196;
-
-    double K = tan(M_PI * f0 / (double) st->samplerate);
-    double Vh = pow(10.0, G / 20.0);
-    double Vb = pow(Vh, 0.4996667741545416);
-
-    double pb[3] = { 0.0, 0.0, 0.0 };
-    double pa[3] = { 1.0, 0.0, 0.0 };
-    double rb[3] = { 1.0, -2.0, 1.0 };
-    double ra[3] = { 1.0, 0.0, 0.0 };
-
-    double a0 = 1.0 + K / Q + K * K;
-    pb[0] = (Vh + Vb * K / Q + K * K) / a0;
-    pb[1] = 2.0 * (K * K - Vh) / a0;
-    pb[2] = (Vh - Vb * K / Q + K * K) / a0;
-    pa[1] = 2.0 * (K * K - 1.0) / a0;
-    pa[2] = (1.0 - K / Q + K * K) / a0;
-
-    f0 = 38.13547087602444;
-    Q = 0.5003270373238773;
-    K = tan(M_PI * f0 / (double) st->samplerate);
-
-    ra[1] = 2.0 * (K * K - 1.0) / (1.0 + K / Q + K * K);
-    ra[2] = (1.0 - K / Q + K * K) / (1.0 + K / Q + K * K);
-
-    st->d->b[0] = pb[0] * rb[0];
-    st->d->b[1] = pb[0] * rb[1] + pb[1] * rb[0];
-    st->d->b[2] = pb[0] * rb[2] + pb[1] * rb[1] + pb[2] * rb[0];
-    st->d->b[3] = pb[1] * rb[2] + pb[2] * rb[1];
-    st->d->b[4] = pb[2] * rb[2];
-
-    st->d->a[0] = pa[0] * ra[0];
-    st->d->a[1] = pa[0] * ra[1] + pa[1] * ra[0];
-    st->d->a[2] = pa[0] * ra[2] + pa[1] * ra[1] + pa[2] * ra[0];
-    st->d->a[3] = pa[1] * ra[2] + pa[2] * ra[1];
-    st->d->a[4] = pa[2] * ra[2];
-
-    for (i = 0; i < 5; ++i) {
-        for (j = 0; j < 5; ++j) {
-            st->d->v[i][j] = 0.0;
-        }
-    }
+    double coeffs[EBUR128_NB_COEFFS];
+
+    ff_ebur128dsp_filter_coeffs(coeffs, st->samplerate);
+    ff_ebur128dsp_set_coeffs(st->d->coeffs, coeffs);
+    ff_ebur128dsp_init(&st->d->dsp);
 }
 
 static int ebur128_init_channel_map(FFEBUR128State * st)
@@ -228,11 +201,12 @@ FFEBUR128State *ff_ebur128_init(unsigned int channels,
         av_malloc(sizeof(*st->d));
     CHECK_ERROR(!st->d, 0, free_state)
     st->channels = channels;
+    st->d->stride = FFALIGN(channels, EBUR128_LANES);
     errcode = ebur128_init_channel_map(st);
     CHECK_ERROR(errcode, 0, free_internal)
 
     st->d->sample_peak =
-        (double *) av_mallocz_array(channels, sizeof(*st->d->sample_peak));
+        (double *) av_mallocz_array(st->d->stride, sizeof(*st->d->sample_peak));
     CHECK_ERROR(!st->d->sample_peak, 0, free_channel_map)
 
     st->samplerate = samplerate;
@@ -254,19 +228,29 @@ FFEBUR128State *ff_ebur128_init(unsigned int channels,
     }
     st->d->audio_data =
         (double *) av_mallocz_array(st->d->audio_data_frames,
-                                    st->channels * sizeof(*st->d->audio_data));
+                                    st->d->stride * sizeof(*st->d->audio_data));
     CHECK_ERROR(!st->d->audio_data, 0, free_sample_peak)
 
+    st->d->filter_state =
+        av_mallocz_array(EBUR128_NB_STATES + 1, st->d->stride * sizeof(*st->d->filter_state));
+    CHECK_ERROR(!st->d->filter_state, 0, free_audio_data)
+    st->d->channel_sums = st->d->filter_state + EBUR128_NB_STATES * st->d->stride;
+
     ebur128_init_filter(st);
 
     st->d->block_energy_histogram =
         av_mallocz(1000 * sizeof(*st->d->block_energy_histogram));
-    CHECK_ERROR(!st->d->block_energy_histogram, 0, free_audio_data)
+    CHECK_ERROR(!st->d->block_energy_histogram, 0, free_filter_state)
     st->d->short_term_block_energy_histogram =
         av_mallocz(1000 * sizeof(*st->d->short_term_block_energy_histogram));
     CHECK_ERROR(!st->d->short_term_block_energy_histogram, 0,
                 free_block_energy_histogram)
     st->d->short_term_frame_counter = 0;
+    memset(st->d->block_sums, 0, sizeof(st->d->block_sums));
+    st->d->block_sums_index = 0;
+    st->d->block_frames = 0;
+    st->d->block_energy_total = 0.0;
+    st->d->block_energy_count = 0;
 
     /* the first block needs 400ms of audio data */
     st->d->needed_frames = st->d->samples_in_100ms * 4;
@@ -276,16 +260,14 @@ FFEBUR128State *ff_ebur128_init(unsigned int channels,
     if (ff_thread_once(&histogram_init, &init_histogram) != 0)
         goto free_short_term_block_energy_histogram;
 
-    st->d->data_ptrs = av_malloc_array(channels, sizeof(*st->d->data_ptrs));
-    CHECK_ERROR(!st->d->data_ptrs, 0,
-                free_short_term_block_energy_histogram);
-
     return st;
 
 free_short_term_block_energy_histogram:
     av_free(st->d->short_term_block_energy_histogram);
 free_block_energy_histogram:
     av_free(st->d->block_energy_histogram);
+free_filter_state:
+    av_free(st->d->filter_state);
 free_audio_data:
     av_free(st->d->audio_data);
 free_sample_peak:
@@ -305,64 +287,32 @@ void ff_ebur128_destroy(FFEBUR128State ** st)
     av_free((*st)->d->block_energy_histogram);
     av_free((*st)->d->short_term_block_energy_histogram);
     av_free((*st)->d->audio_data);
+    av_free((*st)->d->filter_state);
     av_free((*st)->d->channel_map);
     av_free((*st)->d->sample_peak);
-    av_free((*st)->d->data_ptrs);
     av_free((*st)->d);
     av_free(*st);
     *st = NULL;
 }
 
-#define EBUR128_FILTER(type, scaling_factor)                                       \
-static void ebur128_filter_##type(FFEBUR128State* st, const type** srcs,           \
-                                  size_t src_index, size_t frames,                 \
-                                  int stride) {                                    \
-    double* audio_data = st->d->audio_data + st->d->audio_data_index;              \
-    size_t i, c;                                                                   \
-                                                                                   \
-    if ((st->mode & FF_EBUR128_MODE_SAMPLE_PEAK) == FF_EBUR128_MODE_SAMPLE_PEAK) { \
-        for (c = 0; c < st->channels; ++c) {                                       \
-            double max = 0.0;                                                      \
-            for (i = 0; i < frames; ++i) {                                         \
-                type v = srcs[c][src_index + i * stride];                          \
-                if (v > max) {                                                     \
-                    max =        v;                                                \
-                } else if (-v > max) {                                             \
-                    max = -1.0 * v;                                                \
-                }                                                                  \
-            }                                                                      \
-            max /= scaling_factor;                                                 \
-            if (max > st->d->sample_peak[c]) st->d->sample_peak[c] = max;          \
-        }                                                                          \
-    }                                                                              \
-    for (c = 0; c < st->channels; ++c) {                                           \
-        int ci = st->d->channel_map[c] - 1;                                        \
-        if (ci < 0) continue;                                                      \
-        else if (ci == FF_EBUR128_DUAL_MONO - 1) ci = 0; /*dual mono */            \
-        for (i = 0; i < frames; ++i) {                                             \
-            st->d->v[ci][0] = (double) (srcs[c][src_index + i * stride] / scaling_factor) \
-                         - st->d->a[1] * st->d->v[ci][1]                           \
-                         - st->d->a[2] * st->d->v[ci][2]                           \
-                         - st->d->a[3] * st->d->v[ci][3]                           \
-                         - st->d->a[4] * st->d->v[ci][4];                          \
-            audio_data[i * st->channels + c] =                                     \
-                           st->d->b[0] * st->d->v[ci][0]                           \
-                         + st->d->b[1] * st->d->v[ci][1]                           \
-                         + st->d->b[2] * st->d->v[ci][2]                           \
-                         + st->d->b[3] * st->d->v[ci][3]                           \
-                         + st->d->b[4] * st->d->v[ci][4];                          \
-            st->d->v[ci][4] = st->d->v[ci][3];                                     \
-            st->d->v[ci][3] = st->d->v[ci][2];                                     \
-            st->d->v[ci][2] = st->d->v[ci][1];                                     \
-            st->d->v[ci][1] = st->d->v[ci][0];                                     \
-        }                                                                          \
-        st->d->v[ci][4] = fabs(st->d->v[ci][4]) < DBL_MIN ? 0.0 : st->d->v[ci][4]; \
-        st->d->v[ci][3] = fabs(st->d->v[ci][3]) < DBL_MIN ? 0.0 : st->d->v[ci][3]; \
-        st->d->v[ci][2] = fabs(st->d->v[ci][2]) < DBL_MIN ? 0.0 : st->d->v[ci][2]; \
-        st->d->v[ci][1] = fabs(st->d->v[ci][1]) < DBL_MIN ? 0.0 : st->d->v[ci][1]; \
-    }                                                                              \
+static void ebur128_filter(FFEBUR128State * st, const double *src,
+                           size_t frames)
+{
+    struct FFEBUR128StateInternal *d = st->d;
+    double *audio_data = d->audio_data + d->audio_data_index;
+    size_t i;
+
+    /* the samples are K-weighted in place in the ring buffer */
+    ff_ebur128dsp_pad_channels(audio_data, d->stride, src, st->channels, frames);
+    if ((st->mode & FF_EBUR128_MODE_SAMPLE_PEAK) == FF_EBUR128_MODE_SAMPLE_PEAK)
+        d->dsp.peak(d->sample_peak, audio_data, frames, d->stride);
+    d->dsp.filter(audio_data, audio_data, frames, d->stride,
+                  d->coeffs, d->filter_state);
+    for (i = 0; i < EBUR128_NB_STATES * d->stride; i++) {
+        if (fabs(d->filter_state[i]) < DBL_MIN)
+            d->filter_state[i] = 0.0;
+    }
 }
-EBUR128_FILTER(double, 1.0)
 
 static double ebur128_energy_to_loudness(double energy)
 {
@@ -387,40 +337,30 @@ static size_t find_histogram_index(double energy)
     return index_min;
 }
 
-static void ebur128_calc_gating_block(FFEBUR128State * st,
-                                      size_t frames_per_block,
-                                      double *optional_output)
+static double ebur128_weighted_sum(FFEBUR128State * st,
+                                   size_t frames_per_block)
 {
-    size_t i, c;
+    struct FFEBUR128StateInternal *d = st->d;
+    size_t index = d->audio_data_index / d->stride;
+    size_t c;
     double sum = 0.0;
     double channel_sum;
+
+    memset(d->channel_sums, 0, d->stride * sizeof(*d->channel_sums));
+    if (index < frames_per_block) {
+        d->dsp.sum(d->channel_sums, d->audio_data, index, d->stride);
+        d->dsp.sum(d->channel_sums,
+                   d->audio_data + (d->audio_data_frames - (frames_per_block - index)) * d->stride,
+                   frames_per_block - index, d->stride);
+    } else {
+        d->dsp.sum(d->channel_sums, d->audio_data + (index - frames_per_block) * d->stride,
+                   frames_per_block, d->stride);
+    }
+
     for (c = 0; c < st->channels; ++c) {
         if (st->d->channel_map[c] == FF_EBUR128_UNUSED)
             continue;
-        channel_sum = 0.0;
-        if (st->d->audio_data_index < frames_per_block * st->channels) {
-            for (i = 0; i < st->d->audio_data_index / st->channels; ++i) {
-                channel_sum += st->d->audio_data[i * st->channels + c] *
-                    st->d->audio_data[i * st->channels + c];
-            }
-            for (i = st->d->audio_data_frames -
-                 (frames_per_block -
-                  st->d->audio_data_index / st->channels);
-                 i < st->d->audio_data_frames; ++i) {
-                channel_sum += st->d->audio_data[i * st->channels + c] *
-                    st->d->audio_data[i * st->channels + c];
-            }
-        } else {
-            for (i =
-                 st->d->audio_data_index / st->channels - frames_per_block;
-                 i < st->d->audio_data_index / st->channels; ++i) {
-                channel_sum +=
-                    st->d->audio_data[i * st->channels +
-                                      c] * st->d->audio_data[i *
-                                                             st->channels +
-                                                             c];
-            }
-        }
+        channel_sum = d->channel_sums[c];
         if (st->d->channel_map[c] == FF_EBUR128_Mp110 ||
             st->d->channel_map[c] == FF_EBUR128_Mm110 ||
             st->d->channel_map[c] == FF_EBUR128_Mp060 ||
@@ -433,11 +373,34 @@ static void ebur128_calc_gating_block(FFEBUR128State * st,
         }
         sum += channel_sum;
     }
-    sum /= (double) frames_per_block;
-    if (optional_output) {
-        *optional_output = sum;
-    } else if (sum >= histogram_energy_boundaries[0]) {
-        ++st->d->block_energy_histogram[find_histogram_index(sum)];
+    return sum;
+}
+
+/* Sum the energy of the last nb_blocks complete 100ms blocks. */
+static double ebur128_blocks_energy(FFEBUR128State * st, size_t nb_blocks)
+{
+    struct FFEBUR128StateInternal *d = st->d;
+    size_t index = d->block_sums_index;
+    double sum = 0.0;
+    size_t i;
+
+    for (i = 0; i < nb_blocks; i++) {
+        index = index ? index - 1 : FF_ARRAY_ELEMS(d->block_sums) - 1;
+        sum += d->block_sums[index];
+    }
+    return sum / (double) (nb_blocks * d->samples_in_100ms);
+}
+
+static void ebur128_calc_gating_block(FFEBUR128State * st)
+{
+    struct FFEBUR128StateInternal *d = st->d;
+    double sum = ebur128_blocks_energy(st, 4);
+
+    if (sum >= histogram_energy_boundaries[0]) {
+        size_t index = find_histogram_index(sum);
+        ++d->block_energy_histogram[index];
+        d->block_energy_total += histogram_energies[index];
+        d->block_energy_count++;
     }
 }
 
@@ -455,75 +418,81 @@ int ff_ebur128_set_channel(FFEBUR128State * st,
     return 0;
 }
 
-static int ebur128_energy_shortterm(FFEBUR128State * st, double *out);
-#define EBUR128_ADD_FRAMES_PLANAR(type)                                                \
-static void ebur128_add_frames_planar_##type(FFEBUR128State* st, const type** srcs,    \
-                                 size_t frames, int stride) {                          \
-    size_t src_index = 0;                                                              \
-    while (frames > 0) {                                                               \
-        if (frames >= st->d->needed_frames) {                                          \
-            ebur128_filter_##type(st, srcs, src_index, st->d->needed_frames, stride);  \
-            src_index += st->d->needed_frames * stride;                                \
-            frames -= st->d->needed_frames;                                            \
-            st->d->audio_data_index += st->d->needed_frames * st->channels;            \
-            /* calculate the new gating block */                                       \
-            if ((st->mode & FF_EBUR128_MODE_I) == FF_EBUR128_MODE_I) {                 \
-                ebur128_calc_gating_block(st, st->d->samples_in_100ms * 4, NULL);      \
-            }                                                                          \
-            if ((st->mode & FF_EBUR128_MODE_LRA) == FF_EBUR128_MODE_LRA) {             \
-                st->d->short_term_frame_counter += st->d->needed_frames;               \
-                if (st->d->short_term_frame_counter == st->d->samples_in_100ms * 30) { \
-                    double st_energy;                                                  \
-                    ebur128_energy_shortterm(st, &st_energy);                          \
-                    if (st_energy >= histogram_energy_boundaries[0]) {                 \
-                        ++st->d->short_term_block_energy_histogram[                    \
-                                                    find_histogram_index(st_energy)];  \
-                    }                                                                  \
-                    st->d->short_term_frame_counter = st->d->samples_in_100ms * 20;    \
-                }                                                                      \
-            }                                                                          \
-            /* 100ms are needed for all blocks besides the first one */                \
-            st->d->needed_frames = st->d->samples_in_100ms;                            \
-            /* reset audio_data_index when buffer full */                              \
-            if (st->d->audio_data_index == st->d->audio_data_frames * st->channels) {  \
-                st->d->audio_data_index = 0;                                           \
-            }                                                                          \
-        } else {                                                                       \
-            ebur128_filter_##type(st, srcs, src_index, frames, stride);                \
-            st->d->audio_data_index += frames * st->channels;                          \
-            if ((st->mode & FF_EBUR128_MODE_LRA) == FF_EBUR128_MODE_LRA) {             \
-                st->d->short_term_frame_counter += frames;                             \
-            }                                                                          \
-            st->d->needed_frames -= frames;                                            \
-            frames = 0;                                                                \
-        }                                                                              \
-    }                                                                                  \
+/* Filter frames that do not cross a 100ms block boundary. */
+static void ebur128_add_block_frames(FFEBUR128State * st, const double *src,
+                                     size_t frames)
+{
+    struct FFEBUR128StateInternal *d = st->d;
+
+    ebur128_filter(st, src, frames);
+    d->audio_data_index += frames * d->stride;
+    d->block_frames += frames;
+    if (d->block_frames == d->samples_in_100ms) {
+        /* blocks never wrap around as the ring buffer holds whole blocks */
+        d->block_sums[d->block_sums_index] =
+            ebur128_weighted_sum(st, d->samples_in_100ms);
+        d->block_sums_index = (d->block_sums_index + 1) % FF_ARRAY_ELEMS(d->block_sums);
+        d->block_frames = 0;
+    }
 }
-EBUR128_ADD_FRAMES_PLANAR(double)
-#define FF_EBUR128_ADD_FRAMES(type)                                            \
-void ff_ebur128_add_frames_##type(FFEBUR128State* st, const type* src,         \
-                                    size_t frames) {                           \
-  int i;                                                                       \
-  const type **buf = (const type**)st->d->data_ptrs;                           \
-  for (i = 0; i < st->channels; i++)                                           \
-    buf[i] = src + i;                                                          \
-  ebur128_add_frames_planar_##type(st, buf, frames, st->channels);             \
+
+static int ebur128_energy_shortterm(FFEBUR128State * st, double *out);
+void ff_ebur128_add_frames_double(FFEBUR128State * st, const double *src,
+                                  size_t frames)
+{
+    while (frames > 0) {
+        size_t block_left = st->d->samples_in_100ms - st->d->block_frames;
+
+        if (frames >= st->d->needed_frames && st->d->needed_frames <= block_left) {
+            ebur128_add_block_frames(st, src, st->d->needed_frames);
+            src += st->d->needed_frames * st->channels;
+            frames -= st->d->needed_frames;
+            /* calculate the new gating block */
+            if ((st->mode & FF_EBUR128_MODE_I) == FF_EBUR128_MODE_I) {
+                ebur128_calc_gating_block(st);
+            }
+            if ((st->mode & FF_EBUR128_MODE_LRA) == FF_EBUR128_MODE_LRA) {
+                st->d->short_term_frame_counter += st->d->needed_frames;
+                if (st->d->short_term_frame_counter == st->d->samples_in_100ms * 30) {
+                    double st_energy;
+                    ebur128_energy_shortterm(st, &st_energy);
+                    if (st_energy >= histogram_energy_boundaries[0]) {
+                        ++st->d->short_term_block_energy_histogram[
+                                                    find_histogram_index(st_energy)];
+                    }
+                    st->d->short_term_frame_counter = st->d->samples_in_100ms * 20;
+                }
+            }
+            /* 100ms are needed for all blocks besides the first one */
+            st->d->needed_frames = st->d->samples_in_100ms;
+            /* reset audio_data_index when buffer full */
+            if (st->d->audio_data_index == st->d->audio_data_frames * st->d->stride) {
+                st->d->audio_data_index = 0;
+            }
+        } else {
+            size_t len = FFMIN(FFMIN(frames, st->d->needed_frames), block_left);
+
+            ebur128_add_block_frames(st, src, len);
+            src += len * st->channels;
+            if ((st->mode & FF_EBUR128_MODE_LRA) == FF_EBUR128_MODE_LRA) {
+                st->d->short_term_frame_counter += len;
+            }
+            st->d->needed_frames -= len;
+            frames -= len;
+        }
+    }
 }
-FF_EBUR128_ADD_FRAMES(double)
 
 static int ebur128_calc_relative_threshold(FFEBUR128State **sts, size_t size,
                                            double *relative_threshold)
 {
-    size_t i, j;
+    size_t i;
     int above_thresh_counter = 0;
     *relative_threshold = 0.0;
 
     for (i = 0; i < size; i++) {
-        unsigned long *block_energy_histogram = sts[i]->d->block_energy_histogram;
-        for (j = 0; j < 1000; ++j) {
-            *relative_threshold += block_energy_histogram[j] * histogram_energies[j];
-            above_thresh_counter += block_energy_histogram[j];
-        }
+        *relative_threshold += sts[i]->d->block_energy_total;
+        above_thresh_counter += sts[i]->d->block_energy_count;
     }
 
     if (above_thresh_counter != 0) {
@@ -600,10 +569,18 @@ int ff_ebur128_loudness_global(FFEBUR128State * st, double *out)
 static int ebur128_energy_in_interval(FFEBUR128State * st,
                                       size_t interval_frames, double *out)
 {
-    if (interval_frames > st->d->audio_data_frames) {
+    struct FFEBUR128StateInternal *d = st->d;
+
+    if (interval_frames > d->audio_data_frames) {
         return AVERROR(EINVAL);
     }
-    ebur128_calc_gating_block(st, interval_frames, out);
+    /* on block boundaries the interval is made of whole 100ms blocks */
+    if (!d->block_frames && !(interval_frames % d->samples_in_100ms) &&
+        interval_frames / d->samples_in_100ms <= FF_ARRAY_ELEMS(d->block_sums)) {
+        *out = ebur128_blocks_energy(st, interval_frames / d->samples_in_100ms);
+    } else {
+        *out = ebur128_weighted_sum(st, interval_frames) / (double) interval_frames;
+    }
     return 0;
 }
 
@@ -0,0 +1,155 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "config.h"
+#include "libavutil/attributes.h"
+#include "libavutil/common.h"
+#include "libavutil/mem_internal.h"
+#include "ebur128dsp.h"
+
+av_cold void ff_ebur128dsp_filter_coeffs(double coeffs[EBUR128_NB_COEFFS], double samplerate)
+{
+    double f0 = 1681.974450955533;
+    double G  = 3.999843853973347;
+    double Q  = 0.7071752369554196;
+
+    double K  = tan(M_PI * f0 / samplerate);
+    double Vh = pow(10.0, G / 20.0);
+    double Vb = pow(Vh, 0.4996667741545416);
+    double a0 = 1.0 + K / Q + K * K;
+
+    /* pre-filter */
+    coeffs[0] = (Vh + Vb * K / Q + K * K) / a0;
+    coeffs[1] = 2.0 * (K * K - Vh) / a0;
+    coeffs[2] = (Vh - Vb * K / Q + K * K) / a0;
+    coeffs[3] = 2.0 * (K * K - 1.0) / a0;
+    coeffs[4] = (1.0 - K / Q + K * K) / a0;
+
+    f0 = 38.13547087602444;
+    Q  = 0.5003270373238773;
+    K  = tan(M_PI * f0 / samplerate);
+
+    /* RLB-filter */
+    coeffs[5] =  1.0;
+    coeffs[6] = -2.0;
+    coeffs[7] =  1.0;
+    coeffs[8] = 2.0 * (K * K - 1.0) / (1.0 + K / Q + K * K);
+    coeffs[9] = (1.0 - K / Q + K * K) / (1.0 + K / Q + K * K);
+}
+
+void ff_ebur128dsp_set_coeffs(double *dst, const double coeffs[EBUR128_NB_COEFFS])
+{
+    for (int i = 0; i < EBUR128_NB_COEFFS; i++)
+        for (int j = 0; j < EBUR128_LANES; j++)
+            dst[i * EBUR128_LANES + j] = coeffs[i];
+}
+
+void ff_ebur128dsp_pad_channels(double *dst, ptrdiff_t stride, const double *src,
+                                int channels, int len)
+{
+    for (int i = 0; i < len; i++) {
+        memcpy(dst, src, channels * sizeof(*dst));
+        memset(dst + channels, 0, (stride - channels) * sizeof(*dst));
+        dst += stride;
+        src += channels;
+    }
+}
+
+double ff_ebur128dsp_find_peak(const EBUR128DSPContext *dsp, const double *src, int len)
+{
+    LOCAL_ALIGNED_32(double, peaks, [EBUR128_LANES]);
+    double peak = 0.0;
+    int i = len & ~(EBUR128_LANES - 1);
+
+    memset(peaks, 0, EBUR128_LANES * sizeof(*peaks));
+    /* consecutive samples of a channel are spread over the lanes */
+    dsp->peak(peaks, src, i / EBUR128_LANES, EBUR128_LANES);
+    for (; i < len; i++)
+        peaks[0] = FFMAX(peaks[0], fabs(src[i]));
+    for (i = 0; i < EBUR128_LANES; i++)
+        peak = FFMAX(peak, peaks[i]);
+    return peak;
+}
+
+static void filter_c(double *dst, const double *src, ptrdiff_t len, ptrdiff_t stride,
+                     const double *coeffs, double *state)
+{
+    const double pre_b0 = coeffs[0 * EBUR128_LANES], pre_b1 = coeffs[1 * EBUR128_LANES];
+    const double pre_b2 = coeffs[2 * EBUR128_LANES], pre_a1 = coeffs[3 * EBUR128_LANES];
+    const double pre_a2 = coeffs[4 * EBUR128_LANES], rlb_b0 = coeffs[5 * EBUR128_LANES];
+    const double rlb_b1 = coeffs[6 * EBUR128_LANES], rlb_b2 = coeffs[7 * EBUR128_LANES];
+    const double rlb_a1 = coeffs[8 * EBUR128_LANES], rlb_a2 = coeffs[9 * EBUR128_LANES];
+
+    for (int c = 0; c < stride; c++) {
+        double x1 = state[0 * stride + c], x2 = state[1 * stride + c];
+        double y1 = state[2 * stride + c], y2 = state[3 * stride + c];
+        double z1 = state[4 * stride + c], z2 = state[5 * stride + c];
+
+        for (int i = 0; i < len; i++) {
+            const double x0 = src[i * stride + c];
+            const double y0 = x0 * pre_b0 + x1 * pre_b1 + x2 * pre_b2 - y1 * pre_a1 - y2 * pre_a2;
+            const double z0 = y0 * rlb_b0 + y1 * rlb_b1 + y2 * rlb_b2 - z1 * rlb_a1 - z2 * rlb_a2;
+
+            x2 = x1;
+            x1 = x0;
+            y2 = y1;
+            y1 = y0;
+            z2 = z1;
+            z1 = z0;
+            dst[i * stride + c] = z0 * z0;
+        }
+
+        state[0 * stride + c] = x1;
+        state[1 * stride + c] = x2;
+        state[2 * stride + c] = y1;
+        state[3 * stride + c] = y2;
+        state[4 * stride + c] = z1;
+        state[5 * stride + c] = z2;
+    }
+}
+
+static void sum_c(double *sums, const double *src, ptrdiff_t len, ptrdiff_t stride)
+{
+    for (int i = 0; i < len; i++) {
+        for (int c = 0; c < stride; c++)
+            sums[c] += src[c];
+        src += stride;
+    }
+}
+
+static void peak_c(double *peaks, const double *src, ptrdiff_t len, ptrdiff_t stride)
+{
+    for (int i = 0; i < len; i++) {
+        for (int c = 0; c < stride; c++)
+            peaks[c] = FFMAX(peaks[c], fabs(src[c]));
+        src += stride;
+    }
+}
+
+av_cold void ff_ebur128dsp_init(EBUR128DSPContext *dsp)
+{
+    dsp->filter = filter_c;
+    dsp->sum    = sum_c;
+    dsp->peak   = peak_c;
+
+    if (ARCH_X86)
+        ff_ebur128dsp_init_x86(dsp);
+}
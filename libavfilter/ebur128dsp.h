@@ -0,0 +1,93 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * EBU R128 / ITU BS.1770 measurement functions shared by the loudness filters
+ *
+ * All functions work on samples stored interleaved with a stride of
+ * EBUR128_LANES aligned channels, so that every channel runs in its own SIMD
+ * lane and gives bit-exact results whatever the implementation.
+ */
+
+#ifndef AVFILTER_EBUR128DSP_H
+#define AVFILTER_EBUR128DSP_H
+
+#include <stddef.h>
+
+/** Alignment of the channel stride and of all buffers, in doubles. */
+#define EBUR128_LANES       4
+
+/** Coefficients b0, b1, b2, a1, a2 of the pre-filter then of the RLB-filter. */
+#define EBUR128_NB_COEFFS  10
+
+/** Per-channel filter history: x[i-1], x[i-2], y[i-1], y[i-2], z[i-1], z[i-2]. */
+#define EBUR128_NB_STATES   6
+
+typedef struct EBUR128DSPContext {
+    /**
+     * K-weight len frames of src with the pre-filter and RLB-filter biquads
+     * and store the energy (squared filtered value) of every sample to dst.
+     * dst may be equal to src.
+     *
+     * @param stride number of doubles per frame, a multiple of EBUR128_LANES
+     * @param coeffs EBUR128_NB_COEFFS coefficients, each one repeated
+     *               EBUR128_LANES times (see ff_ebur128dsp_set_coeffs())
+     * @param state  EBUR128_NB_STATES rows of stride doubles, updated
+     */
+    void (*filter)(double *dst, const double *src, ptrdiff_t len, ptrdiff_t stride,
+                   const double *coeffs, double *state);
+
+    /**
+     * Add len frames of src to sums, each channel being summed in order.
+     */
+    void (*sum)(double *sums, const double *src, ptrdiff_t len, ptrdiff_t stride);
+
+    /**
+     * Update peaks with the largest absolute value of each channel of src.
+     */
+    void (*peak)(double *peaks, const double *src, ptrdiff_t len, ptrdiff_t stride);
+} EBUR128DSPContext;
+
+/**
+ * Compute the BS.1770 K-weighting coefficients for the given sample rate.
+ */
+void ff_ebur128dsp_filter_coeffs(double coeffs[EBUR128_NB_COEFFS], double samplerate);
+
+/**
+ * Repeat coefficients into every lane, as expected by filter().
+ */
+void ff_ebur128dsp_set_coeffs(double *dst, const double coeffs[EBUR128_NB_COEFFS]);
+
+/**
+ * Copy len frames of channels interleaved samples to dst using stride.
+ * The padding channels of dst are set to 0.
+ */
+void ff_ebur128dsp_pad_channels(double *dst, ptrdiff_t stride, const double *src,
+                                int channels, int len);
+
+/**
+ * Return the largest absolute value of len samples of one channel.
+ * src must be aligned to EBUR128_LANES doubles.
+ */
+double ff_ebur128dsp_find_peak(const EBUR128DSPContext *dsp, const double *src, int len);
+
+void ff_ebur128dsp_init(EBUR128DSPContext *dsp);
+void ff_ebur128dsp_init_x86(EBUR128DSPContext *dsp);
+
+#endif /* AVFILTER_EBUR128DSP_H */
@@ -34,12 +34,14 @@
 #include "libavutil/channel_layout.h"
 #include "libavutil/dict.h"
 #include "libavutil/ffmath.h"
+#include "libavutil/mem_internal.h"
 #include "libavutil/xga_font_data.h"
 #include "libavutil/opt.h"
 #include "libavutil/timestamp.h"
 #include "libswresample/swresample.h"
 #include "audio.h"
 #include "avfilter.h"
+#include "ebur128dsp.h"
 #include "formats.h"
 #include "internal.h"
 
@@ -101,7 +103,7 @@ typedef struct EBUR128Context {
 #if CONFIG_SWRESAMPLE
     SwrContext *swr_ctx;            ///< over-sampling context for true peak metering
     double *swr_buf;                ///< resampled audio data for true peak metering
-    int swr_linesize;
+    double *swr_planes[MAX_CHANNELS]; ///< swr_buf plane of each channel
 #endif
 
     /* video  */
@@ -123,11 +125,12 @@ typedef struct EBUR128Context {
     double *ch_weighting;           ///< channel weighting mapping
     int sample_count;               ///< sample count used for refresh frequency, reset at refresh
 
-    /* Filter caches.
-     * The mult by 3 in the following is for X[i], X[i-1] and X[i-2] */
-    double x[MAX_CHANNELS * 3];     ///< 3 input samples cache for each channel
-    double y[MAX_CHANNELS * 3];     ///< 3 pre-filter samples cache for each channel
-    double z[MAX_CHANNELS * 3];     ///< 3 RLB-filter samples cache for each channel
+    /* K-weighting filter */
+    EBUR128DSPContext dsp;
+    int stride;                     ///< number of channels padded to EBUR128_LANES
+    double *filter_state;           ///< filter history of each channel
+    double *bins;                   ///< energies of up to 100ms of filtered samples
+    DECLARE_ALIGNED(32, double, coeffs)[EBUR128_NB_COEFFS * EBUR128_LANES];
 
 #define I400_BINS  (48000 * 4 / 10)
 #define I3000_BINS (48000 * 3)
@@ -413,11 +416,22 @@ static int config_audio_output(AVFilterLink *outlink)
                    AV_CH_SIDE_LEFT                          |AV_CH_SIDE_RIGHT| \
                    AV_CH_SURROUND_DIRECT_LEFT               |AV_CH_SURROUND_DIRECT_RIGHT)
 
+    static const double coeffs[EBUR128_NB_COEFFS] = {
+        PRE_B0, PRE_B1, PRE_B2, PRE_A1, PRE_A2,
+        RLB_B0, RLB_B1, RLB_B2, RLB_A1, RLB_A2,
+    };
+
     ebur128->nb_channels  = nb_channels;
+    ebur128->stride       = FFALIGN(nb_channels, EBUR128_LANES);
     ebur128->ch_weighting = av_calloc(nb_channels, sizeof(*ebur128->ch_weighting));
-    if (!ebur128->ch_weighting)
+    ebur128->filter_state = av_calloc(EBUR128_NB_STATES * ebur128->stride, sizeof(*ebur128->filter_state));
+    ebur128->bins         = av_malloc_array(4800 * ebur128->stride, sizeof(*ebur128->bins));
+    if (!ebur128->ch_weighting || !ebur128->filter_state || !ebur128->bins)
         return AVERROR(ENOMEM);
 
+    ff_ebur128dsp_init(&ebur128->dsp);
+    ff_ebur128dsp_set_coeffs(ebur128->coeffs, coeffs);
+
     for (i = 0; i < nb_channels; i++) {
         /* channel weighting */
         const uint64_t chl = av_channel_layout_extract_channel(outlink->channel_layout, i);
@@ -457,16 +471,19 @@ static int config_audio_output(AVFilterLink *outlink)
 
         av_opt_set_int(ebur128->swr_ctx, "out_channel_layout",    outlink->channel_layout, 0);
         av_opt_set_int(ebur128->swr_ctx, "out_sample_rate",       192000, 0);
-        av_opt_set_sample_fmt(ebur128->swr_ctx, "out_sample_fmt", outlink->format, 0);
+        av_opt_set_sample_fmt(ebur128->swr_ctx, "out_sample_fmt", AV_SAMPLE_FMT_DBLP, 0);
 
         ret = swr_init(ebur128->swr_ctx);
         if (ret < 0)
             return ret;
+
+        for (i = 0; i < nb_channels; i++)
+            ebur128->swr_planes[i] = ebur128->swr_buf + i * 19200;
     }
 #endif
 
     if (ebur128->peak_mode & PEAK_MODE_SAMPLES_PEAKS) {
-        ebur128->sample_peaks = av_calloc(nb_channels, sizeof(*ebur128->sample_peaks));
+        ebur128->sample_peaks = av_calloc(ebur128->stride, sizeof(*ebur128->sample_peaks));
         if (!ebur128->sample_peaks)
             return AVERROR(ENOMEM);
     }
@@ -589,87 +606,80 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *insamples)
 
 #if CONFIG_SWRESAMPLE
     if (ebur128->peak_mode & PEAK_MODE_TRUE_PEAKS) {
-        const double *swr_samples = ebur128->swr_buf;
-        int ret = swr_convert(ebur128->swr_ctx, (uint8_t**)&ebur128->swr_buf, 19200,
+        int ret = swr_convert(ebur128->swr_ctx, (uint8_t**)ebur128->swr_planes, 19200,
                               (const uint8_t **)insamples->data, nb_samples);
         if (ret < 0)
             return ret;
-        for (ch = 0; ch < nb_channels; ch++)
-            ebur128->true_peaks_per_frame[ch] = 0.0;
-        for (idx_insample = 0; idx_insample < ret; idx_insample++) {
-            for (ch = 0; ch < nb_channels; ch++) {
-                ebur128->true_peaks[ch] = FFMAX(ebur128->true_peaks[ch], fabs(*swr_samples));
-                ebur128->true_peaks_per_frame[ch] = FFMAX(ebur128->true_peaks_per_frame[ch],
-                                                          fabs(*swr_samples));
-                swr_samples++;
-            }
+        for (ch = 0; ch < nb_channels; ch++) {
+            double peak = ff_ebur128dsp_find_peak(&ebur128->dsp, ebur128->swr_planes[ch], ret);
+
+            ebur128->true_peaks[ch] = FFMAX(ebur128->true_peaks[ch], peak);
+            ebur128->true_peaks_per_frame[ch] = peak;
         }
     }
 #endif
 
-    for (idx_insample = 0; idx_insample < nb_samples; idx_insample++) {
-        const int bin_id_400  = ebur128->i400.cache_pos;
-        const int bin_id_3000 = ebur128->i3000.cache_pos;
-
-#define MOVE_TO_NEXT_CACHED_ENTRY(time) do {                \
-    ebur128->i##time.cache_pos++;                           \
-    if (ebur128->i##time.cache_pos == I##time##_BINS) {     \
-        ebur128->i##time.filled    = 1;                     \
-        ebur128->i##time.cache_pos = 0;                     \
-    }                                                       \
-} while (0)
+    for (idx_insample = 0; idx_insample < nb_samples;) {
+        const int stride = ebur128->stride;
+        /* process the samples up to the next 100ms boundary at once */
+        const int len = FFMIN(nb_samples - idx_insample, 4800 - ebur128->sample_count);
+        double *bins = ebur128->bins;
 
-        MOVE_TO_NEXT_CACHED_ENTRY(400);
-        MOVE_TO_NEXT_CACHED_ENTRY(3000);
+        ff_ebur128dsp_pad_channels(bins, stride, samples, nb_channels, len);
+        samples += len * nb_channels;
+        if (ebur128->peak_mode & PEAK_MODE_SAMPLES_PEAKS)
+            ebur128->dsp.peak(ebur128->sample_peaks, bins, len, stride);
+        ebur128->dsp.filter(bins, bins, len, stride, ebur128->coeffs, ebur128->filter_state);
 
         for (ch = 0; ch < nb_channels; ch++) {
-            double bin;
-
-            if (ebur128->peak_mode & PEAK_MODE_SAMPLES_PEAKS)
-                ebur128->sample_peaks[ch] = FFMAX(ebur128->sample_peaks[ch], fabs(*samples));
-
-            ebur128->x[ch * 3] = *samples++; // set X[i]
+            int bin_id_400  = ebur128->i400.cache_pos;
+            int bin_id_3000 = ebur128->i3000.cache_pos;
 
             if (!ebur128->ch_weighting[ch])
                 continue;
 
-            /* Y[i] = X[i]*b0 + X[i-1]*b1 + X[i-2]*b2 - Y[i-1]*a1 - Y[i-2]*a2 */
-#define FILTER(Y, X, name) do {                                                 \
-            double *dst = ebur128->Y + ch*3;                                    \
-            double *src = ebur128->X + ch*3;                                    \
-            dst[2] = dst[1];                                                    \
-            dst[1] = dst[0];                                                    \
-            dst[0] = src[0]*name##_B0 + src[1]*name##_B1 + src[2]*name##_B2     \
-                                      - dst[1]*name##_A1 - dst[2]*name##_A2;    \
-} while (0)
+            for (i = 0; i < len; i++) {
+                const double bin = bins[i * stride + ch];
 
-            // TODO: merge both filters in one?
-            FILTER(y, x, PRE);  // apply pre-filter
-            ebur128->x[ch * 3 + 2] = ebur128->x[ch * 3 + 1];
-            ebur128->x[ch * 3 + 1] = ebur128->x[ch * 3    ];
-            FILTER(z, y, RLB);  // apply RLB-filter
+                /* add the new value, and limit the sum to the cache size (400ms or 3s)
+                 * by removing the oldest one */
+                ebur128->i400.sum [ch] = ebur128->i400.sum [ch] + bin - ebur128->i400.cache [ch][bin_id_400];
+                ebur128->i3000.sum[ch] = ebur128->i3000.sum[ch] + bin - ebur128->i3000.cache[ch][bin_id_3000];
 
-            bin = ebur128->z[ch * 3] * ebur128->z[ch * 3];
+                /* override old cache entry with the new value */
+                ebur128->i400.cache [ch][bin_id_400 ] = bin;
+                ebur128->i3000.cache[ch][bin_id_3000] = bin;
 
-            /* add the new value, and limit the sum to the cache size (400ms or 3s)
-             * by removing the oldest one */
-            ebur128->i400.sum [ch] = ebur128->i400.sum [ch] + bin - ebur128->i400.cache [ch][bin_id_400];
-            ebur128->i3000.sum[ch] = ebur128->i3000.sum[ch] + bin - ebur128->i3000.cache[ch][bin_id_3000];
-
-            /* override old cache entry with the new value */
-            ebur128->i400.cache [ch][bin_id_400 ] = bin;
-            ebur128->i3000.cache[ch][bin_id_3000] = bin;
+                if (++bin_id_400  == I400_BINS)
+                    bin_id_400  = 0;
+                if (++bin_id_3000 == I3000_BINS)
+                    bin_id_3000 = 0;
+            }
         }
 
+#define MOVE_TO_NEXT_CACHED_ENTRIES(time, n) do {           \
+    ebur128->i##time.cache_pos += n;                        \
+    if (ebur128->i##time.cache_pos >= I##time##_BINS) {     \
+        ebur128->i##time.filled     = 1;                    \
+        ebur128->i##time.cache_pos -= I##time##_BINS;       \
+    }                                                       \
+} while (0)
+
+        MOVE_TO_NEXT_CACHED_ENTRIES(400,  len);
+        MOVE_TO_NEXT_CACHED_ENTRIES(3000, len);
+
+        idx_insample          += len;
+        ebur128->sample_count += len;
+
         /* For integrated loudness, gating blocks are 400ms long with 75%
          * overlap (see BS.1770-2 p5), so a re-computation is needed each 100ms
          * (4800 samples at 48kHz). */
-        if (++ebur128->sample_count == 4800) {
+        if (ebur128->sample_count == 4800) {
             double loudness_400, loudness_3000;
             double power_400 = 1e-12, power_3000 = 1e-12;
             AVFilterLink *outlink = ctx->outputs[0];
             const int64_t pts = insamples->pts +
-                av_rescale_q(idx_insample, (AVRational){ 1, inlink->sample_rate },
+                av_rescale_q(idx_insample - 1, (AVRational){ 1, inlink->sample_rate },
                              outlink->time_base);
 
             ebur128->sample_count = 0;
@@ -973,6 +983,8 @@ static av_cold void uninit(AVFilterContext *ctx)
 
     av_freep(&ebur128->y_line_ref);
     av_freep(&ebur128->ch_weighting);
+    av_freep(&ebur128->filter_state);
+    av_freep(&ebur128->bins);
     av_freep(&ebur128->true_peaks);
     av_freep(&ebur128->sample_peaks);
     av_freep(&ebur128->true_peaks_per_frame);
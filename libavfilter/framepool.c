@@ -93,17 +93,20 @@ FFFramePool *ff_frame_pool_video_init(AVBufferRef* (*alloc)(size_t size),
 
     for (i = 0; i < 4 && pool->linesize[i]; i++) {
         int h = FFALIGN(pool->height, 32);
+        size_t size;
         if (i == 1 || i == 2)
             h = AV_CEIL_RSHIFT(h, desc->log2_chroma_h);
 
-        pool->pools[i] = av_buffer_pool_init(pool->linesize[i] * h + 16 + 16 - 1,
-                                             alloc);
+        size = pool->linesize[i] * h + 16 + 16 - 1;
+        pool->pools[i] = alloc ? av_buffer_pool_init(size, alloc) :
+                                 av_buffer_pool_init_frame(size);
         if (!pool->pools[i])
             goto fail;
     }
 
     if (desc->flags & AV_PIX_FMT_FLAG_PAL) {
-        pool->pools[1] = av_buffer_pool_init(AVPALETTE_SIZE, alloc);
+        pool->pools[1] = av_buffer_pool_init(AVPALETTE_SIZE,
+                                             alloc ? alloc : av_buffer_allocz);
         if (!pool->pools[1])
             goto fail;
     }
@@ -36,8 +36,8 @@ typedef struct FFFramePool FFFramePool;
  * Allocate and initialize a video frame pool.
  *
  * @param alloc a function that will be used to allocate new frame buffers when
- * the pool is empty. May be NULL, then the default allocator will be used
- * (av_buffer_alloc()).
+ * the pool is empty. May be NULL, then the planes are allocated with the
+ * zero-initializing frame buffer allocator (av_buffer_pool_init_frame()).
  * @param width width of each frame in this pool
  * @param height height of each frame in this pool
  * @param format format of each frame in this pool
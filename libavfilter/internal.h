@@ -130,12 +130,46 @@ struct AVFilterGraphInternal {
     void *thread;
     avfilter_execute_func *thread_execute;
     FFFrameQueueGlobal frame_queues;
+
+    /**
+     * Largest audio frame sent by a source filter, used to split the
+     * coalesced frames back at the sinks if audio_batch_samples is set.
+     */
+    int max_source_samples;
 };
 
 struct AVFilterInternal {
     avfilter_execute_func *execute;
+
+    /**
+     * Execute callback wrapped by execute if the graph collects statistics.
+     */
+    avfilter_execute_func *stats_execute;
+
+    /**
+     * Counters owned by the filter, only updated if the graph collects
+     * statistics. Frame and queue counts are taken from the links.
+     */
+    AVFilterStats stats;
+
+    /**
+     * Time at which the filter last became ready.
+     */
+    int64_t ready_time;
 };
 
+/**
+ * Start counting the execute() calls of a filter, done for all the filters
+ * of a graph collecting statistics when it is configured.
+ */
+void ff_filter_stats_init(AVFilterContext *ctx);
+
+/**
+ * Account the buffers of a frame obtained for a link, pooled or not, to the
+ * statistics of its source filter.
+ */
+void ff_filter_stats_alloc(AVFilterLink *link, const AVFrame *frame);
+
 /**
  * Tell if an integer is contained in the provided -1-terminated list of integers.
  * This is useful for determining (for instance) if an AVPixelFormat is in an
@@ -338,6 +372,13 @@ void ff_filter_graph_remove_filter(AVFilterGraph *graph, AVFilterContext *filter
  */
 #define FF_FILTER_FLAG_HWFRAME_AWARE (1 << 0)
 
+/**
+ * The output of the filter does not depend on how its audio input is split
+ * into frames, so AVFilterGraph.audio_batch_samples may coalesce it. Only
+ * valid for filters using the default activation.
+ */
+#define FF_FILTER_FLAG_AUDIO_BATCH   (1 << 1)
+
 /**
  * Run one round of processing on a filter graph.
  */
@@ -0,0 +1,572 @@
+/*
+ * Copyright (c) 2017 Paul B Mahol
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <string.h>
+
+#include "libavutil/attributes.h"
+#include "libavutil/common.h"
+#include "libavutil/mem.h"
+
+#include "internal.h"
+#include "partconv.h"
+
+static void fcmul_add_c(float *sum, const float *t, const float *c, ptrdiff_t len)
+{
+    int n;
+
+    for (n = 0; n < len; n++) {
+        const float cre = c[2 * n    ];
+        const float cim = c[2 * n + 1];
+        const float tre = t[2 * n    ];
+        const float tim = t[2 * n + 1];
+
+        sum[2 * n    ] += tre * cre - tim * cim;
+        sum[2 * n + 1] += tre * cim + tim * cre;
+    }
+
+    sum[2 * n] += t[2 * n] * c[2 * n];
+}
+
+av_cold void ff_afir_init(AudioFIRDSPContext *dsp)
+{
+    dsp->fcmul_add = fcmul_add_c;
+
+    if (ARCH_X86)
+        ff_afir_init_x86(dsp);
+}
+
+static int init_segment(PartConvContext *pc, PartConvSegment *seg,
+                        int offset, int nb_partitions, int part_size)
+{
+    const int nb_pairs = pc->nb_outputs * pc->nb_inputs;
+
+    seg->part_size     = part_size;
+    seg->nb_partitions = nb_partitions;
+    seg->input_offset  = offset;
+
+    seg->block  = av_calloc(nb_pairs, sizeof(*seg->block));
+    seg->coeff  = av_calloc(pc->nb_irs, sizeof(*seg->coeff));
+    seg->sum    = av_calloc(pc->nb_outputs, sizeof(*seg->sum));
+    seg->buffer = av_calloc(pc->nb_outputs, sizeof(*seg->buffer));
+    seg->output = av_calloc(pc->nb_outputs, sizeof(*seg->output));
+    seg->frame  = av_calloc(pc->nb_outputs, sizeof(*seg->frame));
+    seg->rdft   = av_calloc(pc->nb_outputs, sizeof(*seg->rdft));
+    seg->irdft  = av_calloc(pc->nb_outputs, sizeof(*seg->irdft));
+    if (!seg->block || !seg->coeff || !seg->sum || !seg->buffer ||
+        !seg->output || !seg->frame || !seg->rdft || !seg->irdft)
+        return AVERROR(ENOMEM);
+
+    /* Partitions smaller than 8 samples are convolved in the time domain. */
+    if (part_size < 8) {
+        for (int ir = 0; ir < pc->nb_irs; ir++) {
+            seg->coeff[ir] = av_calloc(nb_partitions * part_size, sizeof(**seg->coeff));
+            if (!seg->coeff[ir])
+                return AVERROR(ENOMEM);
+        }
+        for (int out = 0; out < pc->nb_outputs; out++) {
+            seg->output[out] = av_calloc(part_size, sizeof(**seg->output));
+            if (!seg->output[out])
+                return AVERROR(ENOMEM);
+        }
+        return 0;
+    }
+
+    /* The FFT must hold the linear convolution of a block and a partition,
+     * rounding it up to a power of 2 allows any partition size. */
+    seg->fft_length = 1 << (av_log2(2 * part_size - 1) + 1);
+    seg->block_size = FFALIGN(seg->fft_length + 1, 16);
+
+    for (int i = 0; i < nb_pairs; i++) {
+        if (pc->ir_map[i] < 0)
+            continue;
+        seg->block[i] = av_calloc(nb_partitions * seg->block_size, sizeof(**seg->block));
+        if (!seg->block[i])
+            return AVERROR(ENOMEM);
+    }
+
+    for (int ir = 0; ir < pc->nb_irs; ir++) {
+        seg->coeff[ir] = av_calloc(nb_partitions * seg->block_size, sizeof(**seg->coeff));
+        if (!seg->coeff[ir])
+            return AVERROR(ENOMEM);
+    }
+
+    for (int out = 0; out < pc->nb_outputs; out++) {
+        seg->sum[out]    = av_calloc(seg->block_size, sizeof(**seg->sum));
+        seg->buffer[out] = av_calloc(part_size, sizeof(**seg->buffer));
+        seg->output[out] = av_calloc(part_size, sizeof(**seg->output));
+        seg->rdft[out]   = av_rdft_init(av_log2(seg->fft_length), DFT_R2C);
+        seg->irdft[out]  = av_rdft_init(av_log2(seg->fft_length), IDFT_C2R);
+        if (!seg->sum[out] || !seg->buffer[out] || !seg->output[out] ||
+            !seg->rdft[out] || !seg->irdft[out])
+            return AVERROR(ENOMEM);
+    }
+
+    return 0;
+}
+
+static void uninit_segment(PartConvContext *pc, PartConvSegment *seg)
+{
+    if (seg->block) {
+        for (int i = 0; i < pc->nb_outputs * pc->nb_inputs; i++)
+            av_freep(&seg->block[i]);
+    }
+    if (seg->coeff) {
+        for (int ir = 0; ir < pc->nb_irs; ir++)
+            av_freep(&seg->coeff[ir]);
+    }
+    for (int out = 0; out < pc->nb_outputs; out++) {
+        if (seg->sum)
+            av_freep(&seg->sum[out]);
+        if (seg->buffer)
+            av_freep(&seg->buffer[out]);
+        if (seg->output)
+            av_freep(&seg->output[out]);
+        if (seg->frame)
+            av_freep(&seg->frame[out]);
+        if (seg->rdft)
+            av_rdft_end(seg->rdft[out]);
+        if (seg->irdft)
+            av_rdft_end(seg->irdft[out]);
+    }
+
+    av_freep(&seg->block);
+    av_freep(&seg->coeff);
+    av_freep(&seg->sum);
+    av_freep(&seg->buffer);
+    av_freep(&seg->output);
+    av_freep(&seg->frame);
+    av_freep(&seg->rdft);
+    av_freep(&seg->irdft);
+}
+
+av_cold int ff_partconv_init(PartConvContext **ppc, int nb_inputs, int nb_outputs,
+                             int nb_irs, int ir_len, int min_part_size, int max_part_size)
+{
+    PartConvContext *pc;
+    int left = ir_len, offset = 0, part_size = min_part_size;
+
+    if (nb_inputs <= 0 || nb_outputs <= 0 || nb_irs <= 0 ||
+        ir_len <= 0 || min_part_size <= 0)
+        return AVERROR(EINVAL);
+
+    pc = av_mallocz(sizeof(*pc));
+    if (!pc)
+        return AVERROR(ENOMEM);
+    *ppc = pc;
+
+    pc->nb_inputs     = nb_inputs;
+    pc->nb_outputs    = nb_outputs;
+    pc->nb_irs        = nb_irs;
+    pc->ir_len        = ir_len;
+    pc->min_part_size = min_part_size;
+    max_part_size     = FFMAX(max_part_size, min_part_size);
+
+    pc->ir_map = av_malloc_array(nb_outputs * nb_inputs, sizeof(*pc->ir_map));
+    pc->seg    = av_calloc(32, sizeof(*pc->seg));
+    if (!pc->ir_map || !pc->seg)
+        return AVERROR(ENOMEM);
+    for (int i = 0; i < nb_outputs * nb_inputs; i++)
+        pc->ir_map[i] = -1;
+
+    for (int i = 0; left > 0; i++) {
+        PartConvSegment *seg = &pc->seg[i];
+        const int last = part_size > max_part_size / 2 || i == 31;
+        const int step = last ? INT_MAX : 1 + (i == 0);
+        const int nb_partitions = FFMIN(step, (left + part_size - 1) / part_size);
+
+        seg->part_size     = part_size;
+        seg->nb_partitions = nb_partitions;
+        seg->input_offset  = offset;
+        pc->nb_segments    = i + 1;
+
+        pc->history_len = FFMAX(pc->history_len, offset + min_part_size +
+                                (part_size < 8) * nb_partitions * part_size);
+
+        offset += nb_partitions * part_size;
+        left   -= nb_partitions * part_size;
+        if (!last)
+            part_size *= 2;
+    }
+
+    pc->history   = av_calloc(nb_inputs, sizeof(*pc->history));
+    pc->jobs_rets = av_calloc(pc->nb_segments * nb_outputs, sizeof(*pc->jobs_rets));
+    if (!pc->history || !pc->jobs_rets)
+        return AVERROR(ENOMEM);
+    pc->history_pos = pc->history_len;
+
+    ff_afir_init(&pc->afirdsp);
+
+    return 0;
+}
+
+void ff_partconv_map(PartConvContext *pc, int output, int input, int ir)
+{
+    pc->ir_map[output * pc->nb_inputs + input] = ir;
+}
+
+static int init_segments(PartConvContext *pc)
+{
+    for (int i = 0; i < pc->nb_segments; i++) {
+        PartConvSegment *seg = &pc->seg[i];
+        int ret = init_segment(pc, seg, seg->input_offset,
+                               seg->nb_partitions, seg->part_size);
+        if (ret < 0)
+            return ret;
+    }
+
+    return 0;
+}
+
+int ff_partconv_set_ir(PartConvContext *pc, int ir, const float *taps, int len)
+{
+    int toffset = 0;
+
+    if (!pc->seg[0].coeff) {
+        int ret = init_segments(pc);
+        if (ret < 0)
+            return ret;
+    }
+
+    len = FFMIN(len, pc->ir_len);
+
+    for (int segment = 0; segment < pc->nb_segments; segment++) {
+        PartConvSegment *seg = &pc->seg[segment];
+        float *coeff = seg->coeff[ir];
+
+        for (int i = 0; i < seg->nb_partitions; i++, toffset += seg->part_size) {
+            const int size = av_clip(len - toffset, 0, seg->part_size);
+
+            if (seg->part_size < 8) {
+                float *dst = coeff + i * seg->part_size;
+
+                memset(dst, 0, seg->part_size * sizeof(*dst));
+                if (size > 0)
+                    memcpy(dst, taps + toffset, size * sizeof(*dst));
+            } else {
+                /* The inverse transform scales by half the transform length. */
+                const float scale = 2.f / seg->fft_length;
+                float *block = coeff + i * seg->block_size;
+
+                memset(block, 0, seg->block_size * sizeof(*block));
+                if (size > 0)
+                    memcpy(block, taps + toffset, size * sizeof(*block));
+
+                av_rdft_calc(seg->rdft[0], block);
+                block[seg->fft_length] = block[1];
+                block[1] = 0;
+                for (int n = 0; n <= seg->fft_length; n++)
+                    block[n] *= scale;
+            }
+        }
+    }
+
+    return 0;
+}
+
+static void segment_quantum(PartConvContext *pc, PartConvSegment *seg,
+                            int out, int pos, int part_index)
+{
+    const int nb_inputs = pc->nb_inputs;
+    const int min_part_size = pc->min_part_size;
+    const int part_size = seg->part_size;
+    float *dst = seg->output[out];
+
+    if (part_size < 8) {
+        const int nb_taps = seg->nb_partitions * part_size;
+
+        memset(dst, 0, part_size * sizeof(*dst));
+        for (int in = 0; in < nb_inputs; in++) {
+            const int ir = pc->ir_map[out * nb_inputs + in];
+            const float *coeff, *src;
+
+            if (ir < 0)
+                continue;
+
+            coeff = seg->coeff[ir];
+            src = pc->history[in] + pos - min_part_size - seg->input_offset;
+            for (int n = 0; n < part_size; n++) {
+                float sum = 0.f;
+
+                for (int k = 0; k < nb_taps; k++)
+                    sum += coeff[k] * src[n - k];
+                dst[n] += sum;
+            }
+        }
+    } else {
+        const int fft_length = seg->fft_length;
+        float *sum = seg->sum[out];
+        float *buf = seg->buffer[out];
+
+        memset(sum, 0, (fft_length + 1) * sizeof(*sum));
+        for (int in = 0; in < nb_inputs; in++) {
+            const int ir = pc->ir_map[out * nb_inputs + in];
+            const float *src, *coeff;
+            float *block;
+            int j;
+
+            if (ir < 0)
+                continue;
+
+            src   = pc->history[in] + pos - min_part_size - seg->input_offset;
+            coeff = seg->coeff[ir];
+            block = seg->block[out * nb_inputs + in] + part_index * seg->block_size;
+
+            memcpy(block, src, part_size * sizeof(*block));
+            memset(block + part_size, 0, (fft_length - part_size) * sizeof(*block));
+            av_rdft_calc(seg->rdft[out], block);
+            block[fft_length] = block[1];
+            block[1] = 0;
+
+            j = part_index;
+            for (int i = 0; i < seg->nb_partitions; i++) {
+                block = seg->block[out * nb_inputs + in] + j * seg->block_size;
+
+                pc->afirdsp.fcmul_add(sum, block, coeff + i * seg->block_size, fft_length / 2);
+
+                if (j == 0)
+                    j = seg->nb_partitions;
+                j--;
+            }
+        }
+
+        sum[1] = sum[fft_length];
+        av_rdft_calc(seg->irdft[out], sum);
+
+        for (int n = 0; n < part_size; n++)
+            dst[n] = buf[n] + sum[n];
+        memcpy(buf, sum + part_size, part_size * sizeof(*buf));
+    }
+}
+
+typedef struct ThreadData {
+    PartConvContext *pc;
+    float *const *dst;
+    int dst_stride;
+    int nb_samples;
+} ThreadData;
+
+static int convolve_segments(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    ThreadData *td = arg;
+    PartConvContext *pc = td->pc;
+    const int nb_items = pc->nb_segments * pc->nb_outputs;
+    const int min_part_size = pc->min_part_size;
+
+    /* Start with the biggest partitions, they are the most expensive. */
+    for (int item = jobnr; item < nb_items; item += nb_jobs) {
+        PartConvSegment *seg = &pc->seg[pc->nb_segments - 1 - item / pc->nb_outputs];
+        const int out = item % pc->nb_outputs;
+        int output_offset = seg->output_offset;
+        int part_index = seg->part_index;
+        float *frame = seg->frame[out];
+
+        for (int q = 0; q < pc->nb_quanta; q++) {
+            const int pos = pc->base + (q + 1) * min_part_size;
+
+            output_offset += min_part_size;
+            if (output_offset == seg->part_size) {
+                output_offset = 0;
+                segment_quantum(pc, seg, out, pos, part_index);
+                part_index = (part_index + 1) % seg->nb_partitions;
+            }
+
+            memcpy(frame + q * min_part_size, seg->output[out] + output_offset,
+                   min_part_size * sizeof(*frame));
+        }
+    }
+
+    return 0;
+}
+
+static int sum_segments(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    ThreadData *td = arg;
+    PartConvContext *pc = td->pc;
+    const int start = (pc->nb_outputs * jobnr) / nb_jobs;
+    const int end = (pc->nb_outputs * (jobnr+1)) / nb_jobs;
+    const int nb_samples = td->nb_samples;
+    const int stride = td->dst_stride;
+
+    for (int out = start; out < end; out++) {
+        const float *frame = pc->seg[0].frame[out];
+        float *dst = td->dst[out];
+
+        for (int n = 0; n < nb_samples; n++)
+            dst[n * stride] = frame[n];
+
+        for (int segment = 1; segment < pc->nb_segments; segment++) {
+            frame = pc->seg[segment].frame[out];
+            for (int n = 0; n < nb_samples; n++)
+                dst[n * stride] += frame[n];
+        }
+    }
+
+    return 0;
+}
+
+static int prepare_buffers(PartConvContext *pc, int size)
+{
+    if (pc->history_pos + size > pc->history_size) {
+        const int history_len = pc->history_len;
+
+        if (pc->history_size > 0) {
+            for (int in = 0; in < pc->nb_inputs; in++) {
+                float *history = pc->history[in];
+
+                memmove(history, history + pc->history_pos - history_len,
+                        history_len * sizeof(*history));
+            }
+        }
+        pc->history_pos = history_len;
+
+        if (history_len + size > pc->history_size) {
+            const int history_size = FFMAX(2 * history_len, history_len + size);
+
+            for (int in = 0; in < pc->nb_inputs; in++) {
+                pc->history[in] = av_realloc_f(pc->history[in], history_size,
+                                               sizeof(*pc->history[in]));
+                if (!pc->history[in])
+                    return AVERROR(ENOMEM);
+                if (!pc->history_size)
+                    memset(pc->history[in], 0, history_len * sizeof(*pc->history[in]));
+            }
+            pc->history_size = history_size;
+        }
+    }
+
+    if (size > pc->frame_size) {
+        for (int segment = 0; segment < pc->nb_segments; segment++) {
+            PartConvSegment *seg = &pc->seg[segment];
+
+            for (int out = 0; out < pc->nb_outputs; out++) {
+                av_freep(&seg->frame[out]);
+                seg->frame[out] = av_malloc_array(size, sizeof(*seg->frame[out]));
+                if (!seg->frame[out])
+                    return AVERROR(ENOMEM);
+            }
+        }
+        pc->frame_size = size;
+    }
+
+    return 0;
+}
+
+static int execute_jobs(AVFilterContext *ctx, PartConvContext *pc,
+                        avfilter_action_func *func, ThreadData *td, int nb_jobs)
+{
+    memset(pc->jobs_rets, 0, nb_jobs * sizeof(*pc->jobs_rets));
+    ctx->internal->execute(ctx, func, td, pc->jobs_rets, nb_jobs);
+    for (int i = 0; i < nb_jobs; i++) {
+        if (pc->jobs_rets[i] < 0)
+            return pc->jobs_rets[i];
+    }
+
+    return 0;
+}
+
+int ff_partconv_process(AVFilterContext *ctx, PartConvContext *pc,
+                        float *const *dst, int dst_stride,
+                        const float *const *src, int src_stride,
+                        int nb_samples)
+{
+    const int min_part_size = pc->min_part_size;
+    const int nb_quanta = (nb_samples + min_part_size - 1) / min_part_size;
+    const int size = nb_quanta * min_part_size;
+    const int nb_threads = ff_filter_get_nb_threads(ctx);
+    ThreadData td;
+    int ret;
+
+    if (!pc->seg[0].coeff) {
+        ret = init_segments(pc);
+        if (ret < 0)
+            return ret;
+    }
+
+    ret = prepare_buffers(pc, size);
+    if (ret < 0)
+        return ret;
+
+    for (int in = 0; in < pc->nb_inputs; in++) {
+        float *history = pc->history[in] + pc->history_pos;
+        int n = 0;
+
+        if (src[in]) {
+            for (; n < nb_samples; n++)
+                history[n] = src[in][n * src_stride];
+        }
+        memset(history + n, 0, (size - n) * sizeof(*history));
+    }
+
+    pc->base      = pc->history_pos;
+    pc->nb_quanta = nb_quanta;
+
+    td.pc         = pc;
+    td.dst        = dst;
+    td.dst_stride = dst_stride;
+    td.nb_samples = nb_samples;
+
+    ret = execute_jobs(ctx, pc, convolve_segments, &td,
+                       FFMIN(pc->nb_segments * pc->nb_outputs, nb_threads));
+    if (ret < 0)
+        return ret;
+    ret = execute_jobs(ctx, pc, sum_segments, &td,
+                       FFMIN(pc->nb_outputs, nb_threads));
+    if (ret < 0)
+        return ret;
+
+    for (int segment = 0; segment < pc->nb_segments; segment++) {
+        PartConvSegment *seg = &pc->seg[segment];
+
+        for (int q = 0; q < nb_quanta; q++) {
+            seg->output_offset += min_part_size;
+            if (seg->output_offset == seg->part_size) {
+                seg->output_offset = 0;
+                seg->part_index = (seg->part_index + 1) % seg->nb_partitions;
+            }
+        }
+    }
+
+    pc->history_pos += size;
+
+    return 0;
+}
+
+av_cold void ff_partconv_uninit(PartConvContext **ppc)
+{
+    PartConvContext *pc = *ppc;
+
+    if (!pc)
+        return;
+
+    if (pc->seg) {
+        for (int i = 0; i < pc->nb_segments; i++)
+            uninit_segment(pc, &pc->seg[i]);
+    }
+    if (pc->history) {
+        for (int in = 0; in < pc->nb_inputs; in++)
+            av_freep(&pc->history[in]);
+    }
+
+    av_freep(&pc->history);
+    av_freep(&pc->seg);
+    av_freep(&pc->ir_map);
+    av_freep(&pc->jobs_rets);
+    av_freep(ppc);
+}
@@ -0,0 +1,127 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Non-uniform partitioned convolution
+ *
+ * The impulse responses are split into segments of growing partition size:
+ * the head of the response uses partitions of the processing quantum, which
+ * keeps the filter free of latency, while the tail uses large partitions
+ * which are much cheaper per sample. Every output is the sum of its inputs
+ * convolved with the impulse response mapped to each input/output pair.
+ */
+
+#ifndef AVFILTER_PARTCONV_H
+#define AVFILTER_PARTCONV_H
+
+#include "libavcodec/avfft.h"
+
+#include "af_afirdsp.h"
+#include "avfilter.h"
+
+typedef struct PartConvSegment {
+    int nb_partitions;
+    int part_size;
+    int fft_length;
+    int block_size;
+    int input_offset;
+
+    int part_index;
+    int output_offset;
+
+    float **block;      ///< frequency domain delay line of each input/output pair
+    float **coeff;      ///< partitions of each impulse response
+    float **sum;
+    float **buffer;
+    float **output;
+    float **frame;      ///< output of the segment for the whole frame
+
+    RDFTContext **rdft, **irdft;
+} PartConvSegment;
+
+typedef struct PartConvContext {
+    int nb_inputs;
+    int nb_outputs;
+    int nb_irs;
+    int ir_len;
+    int min_part_size;
+
+    int *ir_map;
+
+    PartConvSegment *seg;
+    int nb_segments;
+
+    float **history;
+    int history_len;
+    int history_size;
+    int history_pos;
+
+    int frame_size;
+    int nb_quanta;
+    int base;
+
+    int *jobs_rets;
+
+    AudioFIRDSPContext afirdsp;
+} PartConvContext;
+
+/**
+ * Allocate a convolution engine.
+ *
+ * @param nb_irs         number of impulse responses set with ff_partconv_set_ir()
+ * @param ir_len         maximal length of the impulse responses
+ * @param min_part_size  size of the first partitions, this is the processing
+ *                       quantum of ff_partconv_process()
+ * @param max_part_size  maximal partition size, the partition size doubles
+ *                       for each segment until it is reached
+ */
+int ff_partconv_init(PartConvContext **pc, int nb_inputs, int nb_outputs,
+                     int nb_irs, int ir_len, int min_part_size, int max_part_size);
+
+/**
+ * Convolve input with impulse response ir and add it to output.
+ * Must be called for every used pair before the first ff_partconv_set_ir().
+ */
+void ff_partconv_map(PartConvContext *pc, int output, int input, int ir);
+
+/**
+ * Set impulse response ir, len must not be bigger than the length given
+ * to ff_partconv_init(), the remaining taps are zero.
+ * May be called again at any time between two ff_partconv_process().
+ */
+int ff_partconv_set_ir(PartConvContext *pc, int ir, const float *taps, int len);
+
+/**
+ * Convolve nb_samples samples of every input and write the outputs.
+ * nb_samples must be a multiple of the minimal partition size except for
+ * the last call. The segments of all outputs are processed in parallel
+ * with the threads of ctx.
+ *
+ * @param dst        output samples, written every dst_stride floats
+ * @param src        input samples, read every src_stride floats,
+ *                   NULL inputs are treated as silence
+ */
+int ff_partconv_process(AVFilterContext *ctx, PartConvContext *pc,
+                        float *const *dst, int dst_stride,
+                        const float *const *src, int src_stride,
+                        int nb_samples);
+
+void ff_partconv_uninit(PartConvContext **pc);
+
+#endif /* AVFILTER_PARTCONV_H */
@@ -75,7 +75,8 @@ static int thread_execute(AVFilterContext *ctx, avfilter_action_func *func,
 
 static int thread_init_internal(ThreadContext *c, int nb_threads)
 {
-    nb_threads = avpriv_slicethread_create(&c->thread, c, worker_func, NULL, nb_threads);
+    nb_threads = avpriv_slicethread_create_shared(&c->thread, c, worker_func, nb_threads,
+                                                  AVPRIV_SLICETHREAD_PRIORITY_NORMAL);
     if (nb_threads <= 1)
         avpriv_slicethread_free(&c->thread);
     return FFMAX(nb_threads, 1);
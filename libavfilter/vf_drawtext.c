@@ -141,6 +141,17 @@ enum expansion_mode {
     EXP_STRFTIME,
 };
 
+/**
+ * 8-bit coverage of a whole text run, rendered once from the glyph bitmaps
+ * and blended in one pass for as long as the text does not change.
+ */
+typedef struct TextMask {
+    uint8_t *data;
+    int linesize;
+    int x, y;                       ///< position relative to the text origin
+    int w, h;
+} TextMask;
+
 typedef struct DrawTextContext {
     const AVClass *class;
     int exp_mode;                   ///< expansion mode to use for the text
@@ -206,6 +217,14 @@ typedef struct DrawTextContext {
     int text_shaping;               ///< 1 to shape the text before drawing it
 #endif
     AVDictionary *metadata;
+
+    TextMask text_mask;             ///< prerendered text run
+    TextMask border_mask;           ///< prerendered border of the text run
+    char *mask_text;                ///< text the masks were rendered for
+    unsigned int mask_fontsize;     ///< font size the masks were rendered for
+
+    int *jobs_rets;                 ///< return values of the drawing jobs
+    int nb_jobs;                    ///< size of jobs_rets
 } DrawTextContext;
 
 #define OFFSET(x) offsetof(DrawTextContext, x)
@@ -858,6 +877,11 @@ static av_cold void uninit(AVFilterContext *ctx)
 
     av_bprint_finalize(&s->expanded_text, NULL);
     av_bprint_finalize(&s->expanded_fontcolor, NULL);
+
+    av_freep(&s->text_mask.data);
+    av_freep(&s->border_mask.data);
+    av_freep(&s->mask_text);
+    av_freep(&s->jobs_rets);
 }
 
 static int config_input(AVFilterLink *inlink)
@@ -885,6 +909,12 @@ static int config_input(AVFilterLink *inlink)
 
     av_lfg_init(&s->prng, av_get_random_seed());
 
+    av_freep(&s->jobs_rets);
+    s->nb_jobs   = FFMAX(1, FFMIN(inlink->h, ff_filter_get_nb_threads(ctx)));
+    s->jobs_rets = av_calloc(s->nb_jobs, sizeof(*s->jobs_rets));
+    if (!s->jobs_rets)
+        return AVERROR(ENOMEM);
+
     av_expr_free(s->x_pexpr);
     av_expr_free(s->y_pexpr);
     av_expr_free(s->a_pexpr);
@@ -1248,8 +1278,137 @@ static int expand_text(AVFilterContext *ctx, char *text, AVBPrint *bp)
     return 0;
 }
 
-static int draw_glyphs(DrawTextContext *s, AVFrame *frame,
-                       int width, int height,
+typedef struct ThreadData {
+    AVFrame *frame;
+    int width, height;
+    int y_start, y_end;             ///< rows touched by the drawing
+    int box_w, box_h;
+    int use_masks;
+    FFDrawColor fontcolor;
+    FFDrawColor shadowcolor;
+    FFDrawColor bordercolor;
+    FFDrawColor boxcolor;
+} ThreadData;
+
+/**
+ * Render the glyphs of the expanded text, or their borders, into one mask.
+ *
+ * @return 0 on success, 1 if the mask would be too large, in which case the
+ *         glyphs are drawn one by one, a negative error code otherwise
+ */
+static int render_text_mask(DrawTextContext *s, TextMask *mask, int borderw)
+{
+    char *text = s->expanded_text.str;
+    int x0 = INT_MAX, y0 = INT_MAX, x1 = INT_MIN, y1 = INT_MIN;
+    uint32_t code = 0;
+    int pass, i, x, y;
+    uint8_t *p;
+
+    av_freep(&mask->data);
+    mask->w = mask->h = 0;
+
+    /* first pass: bounding box of the bitmaps, second pass: rendering */
+    for (pass = 0; pass < 2; pass++) {
+        for (i = 0, p = text; *p; i++) {
+            const FT_Bitmap *bitmap;
+            Glyph dummy = { 0 }, *glyph;
+            int gx, gy;
+
+            GET_UTF8(code, *p ? *p++ : 0, code = 0xfffd; goto continue_on_invalid;);
+continue_on_invalid:
+
+            if (code == '\n' || code == '\r' || code == '\t')
+                continue;
+
+            dummy.code = code;
+            dummy.fontsize = s->fontsize;
+            glyph = av_tree_find(s->glyphs, &dummy, glyph_cmp, NULL);
+
+            bitmap = borderw ? &glyph->border_bitmap : &glyph->bitmap;
+
+            if (glyph->bitmap.pixel_mode != FT_PIXEL_MODE_MONO &&
+                glyph->bitmap.pixel_mode != FT_PIXEL_MODE_GRAY)
+                return AVERROR(EINVAL);
+            if (!bitmap->width || !bitmap->rows)
+                continue;
+
+            gx = s->positions[i].x - borderw;
+            gy = s->positions[i].y - borderw;
+
+            if (!pass) {
+                x0 = FFMIN(x0, gx);
+                y0 = FFMIN(y0, gy);
+                x1 = FFMAX(x1, gx + (int)bitmap->width);
+                y1 = FFMAX(y1, gy + (int)bitmap->rows);
+                continue;
+            }
+
+            for (y = 0; y < bitmap->rows; y++) {
+                const uint8_t *src = bitmap->buffer + y * bitmap->pitch;
+                uint8_t *dst = mask->data + (gy - mask->y + y) * mask->linesize +
+                               gx - mask->x;
+
+                for (x = 0; x < bitmap->width; x++) {
+                    int v = bitmap->pixel_mode == FT_PIXEL_MODE_MONO ?
+                            (src[x >> 3] >> (~x & 7) & 1) * 255 : src[x];
+                    dst[x] = FFMAX(dst[x], v);
+                }
+            }
+        }
+
+        if (!pass) {
+            if (x0 >= x1 || y0 >= y1)
+                return 0;
+            if ((int64_t)(x1 - x0) * (y1 - y0) > INT_MAX)
+                return 1;
+            mask->x        = x0;
+            mask->y        = y0;
+            mask->w        = x1 - x0;
+            mask->h        = y1 - y0;
+            mask->linesize = mask->w;
+            mask->data     = av_mallocz(mask->w * mask->h);
+            if (!mask->data)
+                return AVERROR(ENOMEM);
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Render the text masks again if the text or the font size changed.
+ *
+ * @return 0 if the masks can be used, 1 if the glyphs must be drawn one by
+ *         one, a negative error code otherwise
+ */
+static int update_text_masks(DrawTextContext *s)
+{
+    int ret;
+
+    if (s->mask_text && s->mask_fontsize == s->fontsize &&
+        !strcmp(s->mask_text, s->expanded_text.str))
+        return 0;
+
+    av_freep(&s->mask_text);
+    if ((ret = render_text_mask(s, &s->text_mask, 0)) ||
+        (s->borderw && (ret = render_text_mask(s, &s->border_mask, s->borderw))))
+        goto fail;
+    s->mask_text = av_strdup(s->expanded_text.str);
+    if (!s->mask_text) {
+        ret = AVERROR(ENOMEM);
+        goto fail;
+    }
+    s->mask_fontsize = s->fontsize;
+    return 0;
+
+fail:
+    av_freep(&s->text_mask.data);
+    av_freep(&s->border_mask.data);
+    return ret;
+}
+
+static int draw_glyphs(DrawTextContext *s, uint8_t *data[4], int linesize[4],
+                       int width, int height, int use_masks,
                        FFDrawColor *color,
                        int x, int y, int borderw)
 {
@@ -1259,6 +1418,16 @@ static int draw_glyphs(DrawTextContext *s, AVFrame *frame,
     uint8_t *p;
     Glyph *glyph = NULL;
 
+    if (use_masks) {
+        const TextMask *mask = borderw ? &s->border_mask : &s->text_mask;
+
+        if (mask->data)
+            ff_blend_mask(&s->dc, color, data, linesize, width, height,
+                          mask->data, mask->linesize, mask->w, mask->h, 3, 0,
+                          s->x + x + mask->x, s->y + y + mask->y);
+        return 0;
+    }
+
     for (i = 0, p = text; *p; i++) {
         FT_Bitmap bitmap;
         Glyph dummy = { 0 };
@@ -1283,7 +1452,7 @@ continue_on_invalid:
         y1 = s->positions[i].y+s->y+y - borderw;
 
         ff_blend_mask(&s->dc, color,
-                      frame->data, frame->linesize, width, height,
+                      data, linesize, width, height,
                       bitmap.buffer, bitmap.pitch,
                       bitmap.width, bitmap.rows,
                       bitmap.pixel_mode == FT_PIXEL_MODE_MONO ? 0 : 3,
@@ -1293,6 +1462,48 @@ continue_on_invalid:
     return 0;
 }
 
+static int draw_text_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    DrawTextContext *s = ctx->priv;
+    ThreadData *td = arg;
+    AVFrame *frame = td->frame;
+    const int vsub = s->dc.vsub_max;
+    const int rows = (td->y_end - td->y_start + (1 << vsub) - 1) >> vsub;
+    const int slice_start = td->y_start + ((rows *  jobnr     ) / nb_jobs << vsub);
+    const int slice_end   = FFMIN(td->y_start + ((rows * (jobnr + 1)) / nb_jobs << vsub),
+                                  td->y_end);
+    const int h = slice_end - slice_start;
+    uint8_t *data[4] = { NULL };
+    int plane, ret;
+
+    for (plane = 0; plane < s->dc.nb_planes; plane++)
+        data[plane] = frame->data[plane] +
+                      (slice_start >> s->dc.vsub[plane]) * frame->linesize[plane];
+
+    /* draw box */
+    if (s->draw_box)
+        ff_blend_rectangle(&s->dc, &td->boxcolor,
+                           data, frame->linesize, td->width, h,
+                           s->x - s->boxborderw, s->y - s->boxborderw - slice_start,
+                           td->box_w + s->boxborderw * 2, td->box_h + s->boxborderw * 2);
+
+    if (s->shadowx || s->shadowy) {
+        if ((ret = draw_glyphs(s, data, frame->linesize, td->width, h, td->use_masks,
+                               &td->shadowcolor, s->shadowx, s->shadowy - slice_start, 0)) < 0)
+            return ret;
+    }
+
+    if (s->borderw) {
+        if ((ret = draw_glyphs(s, data, frame->linesize, td->width, h, td->use_masks,
+                               &td->bordercolor, 0, -slice_start, s->borderw)) < 0)
+            return ret;
+    }
+    if ((ret = draw_glyphs(s, data, frame->linesize, td->width, h, td->use_masks,
+                           &td->fontcolor, 0, -slice_start, 0)) < 0)
+        return ret;
+
+    return 0;
+}
 
 static void update_color_with_alpha(DrawTextContext *s, FFDrawColor *color, const FFDrawColor incolor)
 {
@@ -1333,16 +1544,13 @@ static int draw_text(AVFilterContext *ctx, AVFrame *frame,
     FT_Vector delta;
     Glyph *glyph = NULL, *prev_glyph = NULL;
     Glyph dummy = { 0 };
+    ThreadData td = { 0 };
+    int nb_jobs;
 
     time_t now = time(0);
     struct tm ltime;
     AVBPrint *bp = &s->expanded_text;
 
-    FFDrawColor fontcolor;
-    FFDrawColor shadowcolor;
-    FFDrawColor bordercolor;
-    FFDrawColor boxcolor;
-
     av_bprint_clear(bp);
 
     if(s->basetime != AV_NOPTS_VALUE)
@@ -1484,10 +1692,10 @@ continue_on_invalid2:
     }
 
     update_alpha(s);
-    update_color_with_alpha(s, &fontcolor  , s->fontcolor  );
-    update_color_with_alpha(s, &shadowcolor, s->shadowcolor);
-    update_color_with_alpha(s, &bordercolor, s->bordercolor);
-    update_color_with_alpha(s, &boxcolor   , s->boxcolor   );
+    update_color_with_alpha(s, &td.fontcolor  , s->fontcolor  );
+    update_color_with_alpha(s, &td.shadowcolor, s->shadowcolor);
+    update_color_with_alpha(s, &td.bordercolor, s->bordercolor);
+    update_color_with_alpha(s, &td.boxcolor   , s->boxcolor   );
 
     box_w = max_text_line_w;
     box_h = y + s->max_glyph_h;
@@ -1518,27 +1726,51 @@ continue_on_invalid2:
             s->y = FFMAX(height - box_h - offsetbottom, 0);
     }
 
-    /* draw box */
-    if (s->draw_box)
-        ff_blend_rectangle(&s->dc, &boxcolor,
-                           frame->data, frame->linesize, width, height,
-                           s->x - s->boxborderw, s->y - s->boxborderw,
-                           box_w + s->boxborderw * 2, box_h + s->boxborderw * 2);
+    td.frame     = frame;
+    td.width     = width;
+    td.height    = height;
+    td.box_w     = box_w;
+    td.box_h     = box_h;
 
-    if (s->shadowx || s->shadowy) {
-        if ((ret = draw_glyphs(s, frame, width, height,
-                               &shadowcolor, s->shadowx, s->shadowy, 0)) < 0)
-            return ret;
+    if ((ret = update_text_masks(s)) < 0)
+        return ret;
+    td.use_masks = !ret;
+
+    /* only slice the rows that are drawn on */
+    td.y_start = 0;
+    td.y_end   = height;
+    if (td.use_masks) {
+        const TextMask *m = &s->text_mask, *bm = &s->border_mask;
+        int y0 = INT_MAX, y1 = INT_MIN;
+
+        if (s->draw_box) {
+            y0 = s->y - s->boxborderw;
+            y1 = s->y + box_h + s->boxborderw;
+        }
+        if (m->data) {
+            y0 = FFMIN(y0, s->y + m->y);
+            y1 = FFMAX(y1, s->y + m->y + m->h);
+            if (s->shadowx || s->shadowy) {
+                y0 = FFMIN(y0, s->y + s->shadowy + m->y);
+                y1 = FFMAX(y1, s->y + s->shadowy + m->y + m->h);
+            }
+        }
+        if (s->borderw && bm->data) {
+            y0 = FFMIN(y0, s->y + bm->y);
+            y1 = FFMAX(y1, s->y + bm->y + bm->h);
+        }
+        td.y_start = ff_draw_round_to_sub(&s->dc, 1, -1, av_clip(y0, 0, height));
+        td.y_end   = av_clip(y1, td.y_start, height);
     }
+    if (td.y_start >= td.y_end)
+        return 0;
 
-    if (s->borderw) {
-        if ((ret = draw_glyphs(s, frame, width, height,
-                               &bordercolor, 0, 0, s->borderw)) < 0)
-            return ret;
-    }
-    if ((ret = draw_glyphs(s, frame, width, height,
-                           &fontcolor, 0, 0, 0)) < 0)
-        return ret;
+    nb_jobs = FFMAX(FFMIN(s->nb_jobs, (td.y_end - td.y_start) >> s->dc.vsub_max), 1);
+    memset(s->jobs_rets, 0, nb_jobs * sizeof(*s->jobs_rets));
+    ctx->internal->execute(ctx, draw_text_slice, &td, s->jobs_rets, nb_jobs);
+    for (i = 0; i < nb_jobs; i++)
+        if (s->jobs_rets[i] < 0)
+            return s->jobs_rets[i];
 
     return 0;
 }
@@ -1600,7 +1832,10 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *frame)
             s->x = bbox->x;
             s->y = bbox->y - s->fontsize;
         }
-        draw_text(ctx, frame, frame->width, frame->height);
+        if ((ret = draw_text(ctx, frame, frame->width, frame->height)) < 0) {
+            av_frame_free(&frame);
+            return ret;
+        }
     }
 
     av_log(ctx, AV_LOG_DEBUG, "n:%d t:%f text_w:%d text_h:%d x:%d y:%d\n",
@@ -1641,5 +1876,5 @@ const AVFilter ff_vf_drawtext = {
     .inputs        = avfilter_vf_drawtext_inputs,
     .outputs       = avfilter_vf_drawtext_outputs,
     .process_command = command,
-    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC,
+    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC | AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -26,6 +26,7 @@
 #include "libavutil/motion_vector.h"
 #include "libavutil/opt.h"
 #include "libavutil/pixdesc.h"
+#include "libavutil/pixelutils.h"
 #include "avfilter.h"
 #include "formats.h"
 #include "internal.h"
@@ -292,17 +293,18 @@ static uint64_t get_sbad_ob(AVMotionEstContext *me_ctx, int x, int y, int x_mv,
     int y_max = me_ctx->y_max - me_ctx->mb_size / 2;
     int mv_x1 = x_mv - x;
     int mv_y1 = y_mv - y;
-    int mv_x, mv_y, i, j;
-    uint64_t sbad = 0;
+    int mv_x, mv_y;
+    uint64_t sbad;
 
     x = av_clip(x, x_min, x_max);
     y = av_clip(y, y_min, y_max);
     mv_x = av_clip(x_mv - x, -FFMIN(x - x_min, x_max - x), FFMIN(x - x_min, x_max - x));
     mv_y = av_clip(y_mv - y, -FFMIN(y - y_min, y_max - y), FFMIN(y - y_min, y_max - y));
 
-    for (j = -me_ctx->mb_size / 2; j < me_ctx->mb_size * 3 / 2; j++)
-        for (i = -me_ctx->mb_size / 2; i < me_ctx->mb_size * 3 / 2; i++)
-            sbad += FFABS(data_cur[x + mv_x + i + (y + mv_y + j) * linesize] - data_next[x - mv_x + i + (y - mv_y + j) * linesize]);
+    x -= me_ctx->mb_size / 2;
+    y -= me_ctx->mb_size / 2;
+    sbad = me_ctx->sad(data_cur  + x + mv_x + (y + mv_y) * linesize, linesize,
+                       data_next + x - mv_x + (y - mv_y) * linesize, linesize);
 
     return sbad + (FFABS(mv_x1 - me_ctx->pred_x) + FFABS(mv_y1 - me_ctx->pred_y)) * COST_PRED_SCALE;
 }
@@ -318,17 +320,15 @@ static uint64_t get_sad_ob(AVMotionEstContext *me_ctx, int x, int y, int x_mv, i
     int y_max = me_ctx->y_max - me_ctx->mb_size / 2;
     int mv_x = x_mv - x;
     int mv_y = y_mv - y;
-    int i, j;
-    uint64_t sad = 0;
+    uint64_t sad;
 
-    x = av_clip(x, x_min, x_max);
-    y = av_clip(y, y_min, y_max);
-    x_mv = av_clip(x_mv, x_min, x_max);
-    y_mv = av_clip(y_mv, y_min, y_max);
+    x = av_clip(x, x_min, x_max) - me_ctx->mb_size / 2;
+    y = av_clip(y, y_min, y_max) - me_ctx->mb_size / 2;
+    x_mv = av_clip(x_mv, x_min, x_max) - me_ctx->mb_size / 2;
+    y_mv = av_clip(y_mv, y_min, y_max) - me_ctx->mb_size / 2;
 
-    for (j = -me_ctx->mb_size / 2; j < me_ctx->mb_size * 3 / 2; j++)
-        for (i = -me_ctx->mb_size / 2; i < me_ctx->mb_size * 3 / 2; i++)
-            sad += FFABS(data_ref[x_mv + i + (y_mv + j) * linesize] - data_cur[x + i + (y + j) * linesize]);
+    sad = me_ctx->sad(data_ref + x_mv + y_mv * linesize, linesize,
+                      data_cur + x    + y    * linesize, linesize);
 
     return sad + (FFABS(mv_x - me_ctx->pred_x) + FFABS(mv_y - me_ctx->pred_y)) * COST_PRED_SCALE;
 }
@@ -377,6 +377,12 @@ static int config_input(AVFilterLink *inlink)
         else if (mi_ctx->me_mode == ME_MODE_BILAT)
             me_ctx->get_cost = &get_sbad_ob;
 
+        /* the overlapped block costs compare twice the macroblock size */
+        me_ctx->sad = av_pixelutils_get_sad_fn(mi_ctx->log2_mb_size + 1,
+                                               mi_ctx->log2_mb_size + 1, 0, inlink->dst);
+        if (!me_ctx->sad)
+            return AVERROR(EINVAL);
+
         mi_ctx->pixel_mvs = av_mallocz_array(width * height, sizeof(PixelMVS));
         mi_ctx->pixel_weights = av_mallocz_array(width * height, sizeof(PixelWeights));
         mi_ctx->pixel_refs = av_mallocz_array(width * height, sizeof(PixelRefs));
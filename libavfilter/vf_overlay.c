@@ -174,7 +174,7 @@ static int query_formats(AVFilterContext *ctx)
     };
 
     static const enum AVPixelFormat main_pix_fmts_yuv420p10[] = {
-        AV_PIX_FMT_YUV420P10, AV_PIX_FMT_YUVA420P10,
+        AV_PIX_FMT_YUV420P10, AV_PIX_FMT_YUVA420P10, AV_PIX_FMT_P010,
         AV_PIX_FMT_NONE
     };
     static const enum AVPixelFormat overlay_pix_fmts_yuv420p10[] = {
@@ -329,6 +329,9 @@ static int config_output(AVFilterLink *outlink)
     outlink->h = ctx->inputs[MAIN]->h;
     outlink->time_base = ctx->inputs[MAIN]->time_base;
 
+    ff_overlay_init(s, s->format, ctx->inputs[MAIN]->format,
+                    s->alpha_format, s->main_has_alpha);
+
     return ff_framesync_configure(&s->fs);
 }
 
@@ -384,8 +387,16 @@ static av_always_inline void blend_slice_packed_rgb(AVFilterContext *ctx,
         j = FFMAX(-x, 0);
         S = sp + j     * sstep;
         d = dp + (x+j) * dstep;
+        jmax = FFMIN(-x + dst_w, src_w);
+
+        if (s->blend_row[0]) {
+            int c = s->blend_row[0](d, d, S, S, jmax - j, 0, 0);
 
-        for (jmax = FFMIN(-x + dst_w, src_w); j < jmax; j++) {
+            S += c * sstep;
+            d += c * dstep;
+            j += c;
+        }
+        for (; j < jmax; j++) {
             alpha = S[sa];
 
             // if the main channel has an alpha channel, alpha has to be calculated
@@ -433,6 +444,193 @@ static av_always_inline void blend_slice_packed_rgb(AVFilterContext *ctx,
     }
 }
 
+#define DEFINE_BLEND_ROW(depth, nbits)                                                                     \
+static av_always_inline int blend_row_##depth##_##nbits##bits(uint8_t *dst, uint8_t *dst_a,                \
+                                         uint8_t *src, uint8_t *src_a,                                     \
+                                         int w, ptrdiff_t alinesize,                                       \
+                                         ptrdiff_t dalinesize,                                             \
+                                         int hsub, int vsub,                                               \
+                                         int dst_step, int dst_shift,                                      \
+                                         int main_has_alpha,                                               \
+                                         int straight,                                                     \
+                                         int yuv)                                                          \
+{                                                                                                          \
+    uint##depth##_t *d = (uint##depth##_t *)dst;                                                           \
+    const uint##depth##_t *s  = (const uint##depth##_t *)src;                                              \
+    const uint##depth##_t *a  = (const uint##depth##_t *)src_a;                                            \
+    const uint##depth##_t *da = (const uint##depth##_t *)dst_a;                                            \
+    const ptrdiff_t als  = alinesize  / (depth / 8);                                                       \
+    const ptrdiff_t dals = dalinesize / (depth / 8);                                                       \
+    const int max = (1 << nbits) - 1;                                                                      \
+    const int mid = (1 << (nbits -1));                                                                     \
+    int k;                                                                                                 \
+                                                                                                           \
+    for (k = 0; k < w; k++) {                                                                              \
+        int alpha_v, alpha_h, alpha;                                                                       \
+        int v = *d >> dst_shift;                                                                           \
+                                                                                                           \
+        /* average alpha for color components, improve quality */                                          \
+        if (hsub && vsub) {                                                                                \
+            alpha = (a[0] + a[als] +                                                                       \
+                     a[1] + a[als+1]) >> 2;                                                                \
+        } else if (hsub || vsub) {                                                                         \
+            alpha_h = hsub ? (a[0] + a[1]) >> 1 : a[0];                                                    \
+            alpha_v = vsub ? (a[0] + a[als]) >> 1 : a[0];                                                  \
+            alpha = (alpha_v + alpha_h) >> 1;                                                              \
+        } else                                                                                             \
+            alpha = a[0];                                                                                  \
+        /* if the main channel has an alpha channel, alpha has to be calculated */                         \
+        /* to create an un-premultiplied (straight) alpha value */                                         \
+        if (main_has_alpha && alpha != 0 && alpha != max) {                                                \
+            /* average alpha for color components, improve quality */                                      \
+            uint8_t alpha_d;                                                                               \
+            if (hsub && vsub) {                                                                            \
+                alpha_d = (da[0] + da[dals] +                                                              \
+                           da[1] + da[dals+1]) >> 2;                                                       \
+            } else if (hsub || vsub) {                                                                     \
+                alpha_h = hsub ? (da[0] + da[1]) >> 1 : da[0];                                             \
+                alpha_v = vsub ? (da[0] + da[dals]) >> 1 : da[0];                                          \
+                alpha_d = (alpha_v + alpha_h) >> 1;                                                        \
+            } else                                                                                         \
+                alpha_d = da[0];                                                                           \
+            alpha = UNPREMULTIPLY_ALPHA(alpha, alpha_d);                                                   \
+        }                                                                                                  \
+        if (straight) {                                                                                    \
+            if (nbits > 8)                                                                                 \
+                v = (v * (max - alpha) + *s * alpha) / max;                                                \
+            else                                                                                           \
+                v = FAST_DIV255(v * (255 - alpha) + *s * alpha);                                           \
+        } else {                                                                                           \
+            if (nbits > 8) {                                                                               \
+                if (yuv)                                                                                   \
+                    v = av_clip((v * (max - alpha) + *s * alpha) / max + *s - mid, -mid, mid) + mid;       \
+                else                                                                                       \
+                    v = FFMIN((v * (max - alpha) + *s * alpha) / max + *s, max);                           \
+            } else {                                                                                       \
+                if (yuv)                                                                                   \
+                    v = av_clip(FAST_DIV255((v - mid) * (max - alpha)) + *s - mid, -mid, mid) + mid;       \
+                else                                                                                       \
+                    v = FFMIN(FAST_DIV255(v * (max - alpha)) + *s, max);                                   \
+            }                                                                                              \
+        }                                                                                                  \
+        *d = v << dst_shift;                                                                               \
+        s++;                                                                                               \
+        d += dst_step;                                                                                     \
+        da += 1 << hsub;                                                                                   \
+        a += 1 << hsub;                                                                                    \
+    }                                                                                                      \
+    return w;                                                                                              \
+}
+DEFINE_BLEND_ROW(8, 8)
+DEFINE_BLEND_ROW(16, 10)
+
+/**
+ * Blend as many pixels of a row as the subsampled alpha of the row can be
+ * averaged for, i.e. all but the last one with horizontal subsampling.
+ */
+#define DEFINE_BLEND_ROW_FUNC(name, depth, nbits, hsub, vsub, dst_step, dst_shift,                         \
+                              main_has_alpha, straight, yuv)                                               \
+static int blend_row_##name(uint8_t *d, uint8_t *da, uint8_t *s, uint8_t *a,                               \
+                            int w, ptrdiff_t alinesize, ptrdiff_t dalinesize)                              \
+{                                                                                                          \
+    return blend_row_##depth##_##nbits##bits(d, da, s, a, FFMAX(w - hsub, 0), alinesize, dalinesize,       \
+                                             hsub, vsub, dst_step, dst_shift,                              \
+                                             main_has_alpha, straight, yuv);                               \
+}
+
+#define DEFINE_BLEND_ROW_FUNCS_8(hv, hsub, vsub, a, main_has_alpha)                                        \
+DEFINE_BLEND_ROW_FUNC(8_##hv##a,      8, 8, hsub, vsub, 1, 0, main_has_alpha, 1, 0)                        \
+DEFINE_BLEND_ROW_FUNC(8_##hv##_pm##a, 8, 8, hsub, vsub, 1, 0, main_has_alpha, 0, 0)                        \
+DEFINE_BLEND_ROW_FUNC(8_##hv##_pmuv##a, 8, 8, hsub, vsub, 1, 0, main_has_alpha, 0, 1)
+
+DEFINE_BLEND_ROW_FUNCS_8(44, 0, 0,       , 0)
+DEFINE_BLEND_ROW_FUNCS_8(22, 1, 0,       , 0)
+DEFINE_BLEND_ROW_FUNCS_8(20, 1, 1,       , 0)
+DEFINE_BLEND_ROW_FUNCS_8(44, 0, 0, _alpha, 1)
+DEFINE_BLEND_ROW_FUNCS_8(22, 1, 0, _alpha, 1)
+DEFINE_BLEND_ROW_FUNCS_8(20, 1, 1, _alpha, 1)
+DEFINE_BLEND_ROW_FUNC(8_20_nv,         8,  8, 1, 1, 2, 0, 0, 1, 0)
+DEFINE_BLEND_ROW_FUNC(8_20_pmuv_nv,    8,  8, 1, 1, 2, 0, 0, 0, 1)
+DEFINE_BLEND_ROW_FUNC(16_44,          16, 10, 0, 0, 1, 0, 0, 1, 0)
+DEFINE_BLEND_ROW_FUNC(16_22,          16, 10, 1, 0, 1, 0, 0, 1, 0)
+DEFINE_BLEND_ROW_FUNC(16_20,          16, 10, 1, 1, 1, 0, 0, 1, 0)
+DEFINE_BLEND_ROW_FUNC(16_44_alpha,    16, 10, 0, 0, 1, 0, 1, 1, 0)
+DEFINE_BLEND_ROW_FUNC(16_22_alpha,    16, 10, 1, 0, 1, 0, 1, 1, 0)
+DEFINE_BLEND_ROW_FUNC(16_20_alpha,    16, 10, 1, 1, 1, 0, 1, 1, 0)
+DEFINE_BLEND_ROW_FUNC(16_44_p010,     16, 10, 0, 0, 1, 6, 0, 1, 0)
+DEFINE_BLEND_ROW_FUNC(16_20_p010,     16, 10, 1, 1, 2, 6, 0, 1, 0)
+
+/**
+ * Blend a row of packed RGB with alpha onto a main row with the same layout
+ * and an alpha channel, ia being the offset of the alpha component.
+ */
+static av_always_inline int blend_row_packed_rgba(uint8_t *d, const uint8_t *S, int w,
+                                                  int ia, int is_straight)
+{
+    int i, c;
+
+    for (i = 0; i < w; i++) {
+        int alpha = S[ia];
+
+        if (alpha != 0 && alpha != 255)
+            alpha = UNPREMULTIPLY_ALPHA(alpha, d[ia]);
+
+        for (c = 0; c < 4; c++) {
+            if (c == ia)
+                continue;
+            switch (alpha) {
+            case 0:
+                break;
+            case 255:
+                d[c] = S[c];
+                break;
+            default:
+                d[c] = is_straight ? FAST_DIV255(d[c] * (255 - alpha) + S[c] * alpha) :
+                       FFMIN(FAST_DIV255(d[c] * (255 - alpha)) + S[c], 255);
+            }
+        }
+        switch (alpha) {
+        case 0:
+            break;
+        case 255:
+            d[ia] = S[ia];
+            break;
+        default:
+            d[ia] += FAST_DIV255((255 - d[ia]) * S[ia]);
+        }
+        d += 4;
+        S += 4;
+    }
+    return w;
+}
+
+#define DEFINE_BLEND_ROW_PACKED(name, ia, is_straight)                                                     \
+static int blend_row_##name(uint8_t *d, uint8_t *da, uint8_t *s, uint8_t *a,                               \
+                            int w, ptrdiff_t alinesize, ptrdiff_t dalinesize)                              \
+{                                                                                                          \
+    return blend_row_packed_rgba(d, s, w, ia, is_straight);                                                \
+}
+
+DEFINE_BLEND_ROW_PACKED(argb,    0, 1)
+DEFINE_BLEND_ROW_PACKED(rgba,    3, 1)
+DEFINE_BLEND_ROW_PACKED(argb_pm, 0, 0)
+DEFINE_BLEND_ROW_PACKED(rgba_pm, 3, 0)
+
+/*
+ * Composite the alpha plane: the unpremultiplied alpha is 0 only where the
+ * overlay alpha is 0, and 255 where it is 255 or the main alpha is 0, so
+ * main_alpha += (1-main_alpha) * overlay_alpha gives the same result there.
+ */
+static int blend_row_alpha_8(uint8_t *d, uint8_t *da, uint8_t *s, uint8_t *a,
+                             int w, ptrdiff_t alinesize, ptrdiff_t dalinesize)
+{
+    int i;
+
+    for (i = 0; i < w; i++)
+        d[i] += FAST_DIV255((255 - d[i]) * s[i]);
+    return w;
+}
+
 #define DEFINE_BLEND_PLANE(depth, nbits)                                                                   \
 static av_always_inline void blend_plane_##depth##_##nbits##bits(AVFilterContext *ctx,                     \
                                          AVFrame *dst, const AVFrame *src,                                 \
@@ -444,6 +642,7 @@ static av_always_inline void blend_plane_##depth##_##nbits##bits(AVFilterContext
                                          int dst_plane,                                                    \
                                          int dst_offset,                                                   \
                                          int dst_step,                                                     \
+                                         int dst_shift,                                                    \
                                          int straight,                                                     \
                                          int yuv,                                                          \
                                          int jobnr,                                                        \
@@ -459,8 +658,6 @@ static av_always_inline void blend_plane_##depth##_##nbits##bits(AVFilterContext
     uint##depth##_t *s, *sp, *d, *dp, *dap, *a, *da, *ap;                                                  \
     int jmax, j, k, kmax;                                                                                  \
     int slice_start, slice_end;                                                                            \
-    const uint##depth##_t max = (1 << nbits) - 1;                                                          \
-    const uint##depth##_t mid = (1 << (nbits -1)) ;                                                        \
     int bytes = depth / 8;                                                                                 \
                                                                                                            \
     dst_step /= bytes;                                                                                     \
@@ -485,9 +682,9 @@ static av_always_inline void blend_plane_##depth##_##nbits##bits(AVFilterContext
         da = dap + ((xp+k) << hsub);                                                                       \
         kmax = FFMIN(-xp + dst_wp, src_wp);                                                                \
                                                                                                            \
-        if (nbits == 8 && ((vsub && j+1 < src_hp) || !vsub) && octx->blend_row[i]) {                       \
+        if (((vsub && j+1 < src_hp) || !vsub) && octx->blend_row[i]) {                                     \
             int c = octx->blend_row[i]((uint8_t*)d, (uint8_t*)da, (uint8_t*)s,                             \
-                    (uint8_t*)a, kmax - k, src->linesize[3]);                                              \
+                    (uint8_t*)a, kmax - k, src->linesize[3], dst->linesize[3]);                            \
                                                                                                            \
             s += c;                                                                                        \
             d += dst_step * c;                                                                             \
@@ -496,56 +693,11 @@ static av_always_inline void blend_plane_##depth##_##nbits##bits(AVFilterContext
             k += c;                                                                                        \
         }                                                                                                  \
         for (; k < kmax; k++) {                                                                            \
-            int alpha_v, alpha_h, alpha;                                                                   \
-                                                                                                           \
-            /* average alpha for color components, improve quality */                                      \
-            if (hsub && vsub && j+1 < src_hp && k+1 < src_wp) {                                            \
-                alpha = (a[0] + a[src->linesize[3]] +                                                      \
-                         a[1] + a[src->linesize[3]+1]) >> 2;                                               \
-            } else if (hsub || vsub) {                                                                     \
-                alpha_h = hsub && k+1 < src_wp ?                                                           \
-                    (a[0] + a[1]) >> 1 : a[0];                                                             \
-                alpha_v = vsub && j+1 < src_hp ?                                                           \
-                    (a[0] + a[src->linesize[3]]) >> 1 : a[0];                                              \
-                alpha = (alpha_v + alpha_h) >> 1;                                                          \
-            } else                                                                                         \
-                alpha = a[0];                                                                              \
-            /* if the main channel has an alpha channel, alpha has to be calculated */                     \
-            /* to create an un-premultiplied (straight) alpha value */                                     \
-            if (main_has_alpha && alpha != 0 && alpha != max) {                                            \
-                /* average alpha for color components, improve quality */                                  \
-                uint8_t alpha_d;                                                                           \
-                if (hsub && vsub && j+1 < src_hp && k+1 < src_wp) {                                        \
-                    alpha_d = (da[0] + da[dst->linesize[3]] +                                              \
-                               da[1] + da[dst->linesize[3]+1]) >> 2;                                       \
-                } else if (hsub || vsub) {                                                                 \
-                    alpha_h = hsub && k+1 < src_wp ?                                                       \
-                        (da[0] + da[1]) >> 1 : da[0];                                                      \
-                    alpha_v = vsub && j+1 < src_hp ?                                                       \
-                        (da[0] + da[dst->linesize[3]]) >> 1 : da[0];                                       \
-                    alpha_d = (alpha_v + alpha_h) >> 1;                                                    \
-                } else                                                                                     \
-                    alpha_d = da[0];                                                                       \
-                alpha = UNPREMULTIPLY_ALPHA(alpha, alpha_d);                                               \
-            }                                                                                              \
-            if (straight) {                                                                                \
-                if (nbits > 8)                                                                             \
-                   *d = (*d * (max - alpha) + *s * alpha) / max;                                           \
-                else                                                                                       \
-                    *d = FAST_DIV255(*d * (255 - alpha) + *s * alpha);                                     \
-            } else {                                                                                       \
-                if (nbits > 8) {                                                                           \
-                    if (i && yuv)                                                                          \
-                        *d = av_clip((*d * (max - alpha) + *s * alpha) / max + *s - mid, -mid, mid) + mid; \
-                    else                                                                                   \
-                        *d = FFMIN((*d * (max - alpha) + *s * alpha) / max + *s, max);                     \
-                } else {                                                                                   \
-                    if (i && yuv)                                                                          \
-                        *d = av_clip(FAST_DIV255((*d - mid) * (max - alpha)) + *s - mid, -mid, mid) + mid; \
-                    else                                                                                   \
-                        *d = FFMIN(FAST_DIV255(*d * (max - alpha)) + *s, max);                             \
-                }                                                                                          \
-            }                                                                                              \
+            blend_row_##depth##_##nbits##bits((uint8_t*)d, (uint8_t*)da, (uint8_t*)s, (uint8_t*)a, 1,      \
+                                              src->linesize[3], dst->linesize[3],                          \
+                                              hsub && k+1 < src_wp, vsub && j+1 < src_hp,                  \
+                                              dst_step, dst_shift, main_has_alpha,                         \
+                                              straight, i && yuv);                                         \
             s++;                                                                                           \
             d += dst_step;                                                                                 \
             da += 1 << hsub;                                                                               \
@@ -561,7 +713,8 @@ DEFINE_BLEND_PLANE(8, 8)
 DEFINE_BLEND_PLANE(16, 10)
 
 #define DEFINE_ALPHA_COMPOSITE(depth, nbits)                                                               \
-static inline void alpha_composite_##depth##_##nbits##bits(const AVFrame *src, const AVFrame *dst,         \
+static inline void alpha_composite_##depth##_##nbits##bits(OverlayContext *octx,                           \
+                                   const AVFrame *src, const AVFrame *dst,                                 \
                                    int src_w, int src_h,                                                   \
                                    int dst_w, int dst_h,                                                   \
                                    int x, int y,                                                           \
@@ -586,8 +739,17 @@ static inline void alpha_composite_##depth##_##nbits##bits(const AVFrame *src, c
         j = FFMAX(-x, 0);                                                                                  \
         s = sa + j;                                                                                        \
         d = da + x+j;                                                                                      \
+        jmax = FFMIN(-x + dst_w, src_w);                                                                   \
+                                                                                                           \
+        if (octx->blend_row[3]) {                                                                          \
+            int c = octx->blend_row[3]((uint8_t*)d, (uint8_t*)d, (uint8_t*)s, (uint8_t*)s,                 \
+                                       jmax - j, 0, 0);                                                    \
                                                                                                            \
-        for (jmax = FFMIN(-x + dst_w, src_w); j < jmax; j++) {                                             \
+            s += c;                                                                                        \
+            d += c;                                                                                        \
+            j += c;                                                                                        \
+        }                                                                                                  \
+        for (; j < jmax; j++) {                                                                            \
             alpha = *s;                                                                                    \
             if (alpha != 0 && alpha != max) {                                                              \
                 uint8_t alpha_d = *d;                                                                      \
@@ -629,16 +791,19 @@ static av_always_inline void blend_slice_yuv_##depth##_##nbits##bits(AVFilterCon
                                                                                                            \
     blend_plane_##depth##_##nbits##bits(ctx, dst, src, src_w, src_h, dst_w, dst_h, 0, 0,       0,          \
                 x, y, main_has_alpha, s->main_desc->comp[0].plane, s->main_desc->comp[0].offset,           \
-                s->main_desc->comp[0].step, is_straight, 1, jobnr, nb_jobs);                               \
+                s->main_desc->comp[0].step, s->main_desc->comp[0].shift, is_straight, 1,                   \
+                jobnr, nb_jobs);                                                                           \
     blend_plane_##depth##_##nbits##bits(ctx, dst, src, src_w, src_h, dst_w, dst_h, 1, hsub, vsub,          \
                 x, y, main_has_alpha, s->main_desc->comp[1].plane, s->main_desc->comp[1].offset,           \
-                s->main_desc->comp[1].step, is_straight, 1, jobnr, nb_jobs);                               \
+                s->main_desc->comp[1].step, s->main_desc->comp[1].shift, is_straight, 1,                   \
+                jobnr, nb_jobs);                                                                           \
     blend_plane_##depth##_##nbits##bits(ctx, dst, src, src_w, src_h, dst_w, dst_h, 2, hsub, vsub,          \
                 x, y, main_has_alpha, s->main_desc->comp[2].plane, s->main_desc->comp[2].offset,           \
-                s->main_desc->comp[2].step, is_straight, 1, jobnr, nb_jobs);                               \
+                s->main_desc->comp[2].step, s->main_desc->comp[2].shift, is_straight, 1,                   \
+                jobnr, nb_jobs);                                                                           \
                                                                                                            \
     if (main_has_alpha)                                                                                    \
-        alpha_composite_##depth##_##nbits##bits(src, dst, src_w, src_h, dst_w, dst_h, x, y,                \
+        alpha_composite_##depth##_##nbits##bits(s, src, dst, src_w, src_h, dst_w, dst_h, x, y,             \
                                                 jobnr, nb_jobs);                                           \
 }
 DEFINE_BLEND_SLICE_YUV(8, 8)
@@ -660,17 +825,20 @@ static av_always_inline void blend_slice_planar_rgb(AVFilterContext *ctx,
     const int dst_h = dst->height;
 
     blend_plane_8_8bits(ctx, dst, src, src_w, src_h, dst_w, dst_h, 0, 0,   0, x, y, main_has_alpha,
-                s->main_desc->comp[1].plane, s->main_desc->comp[1].offset, s->main_desc->comp[1].step, is_straight, 0,
+                s->main_desc->comp[1].plane, s->main_desc->comp[1].offset, s->main_desc->comp[1].step,
+                s->main_desc->comp[1].shift, is_straight, 0,
                 jobnr, nb_jobs);
     blend_plane_8_8bits(ctx, dst, src, src_w, src_h, dst_w, dst_h, 1, hsub, vsub, x, y, main_has_alpha,
-                s->main_desc->comp[2].plane, s->main_desc->comp[2].offset, s->main_desc->comp[2].step, is_straight, 0,
+                s->main_desc->comp[2].plane, s->main_desc->comp[2].offset, s->main_desc->comp[2].step,
+                s->main_desc->comp[2].shift, is_straight, 0,
                 jobnr, nb_jobs);
     blend_plane_8_8bits(ctx, dst, src, src_w, src_h, dst_w, dst_h, 2, hsub, vsub, x, y, main_has_alpha,
-                s->main_desc->comp[0].plane, s->main_desc->comp[0].offset, s->main_desc->comp[0].step, is_straight, 0,
+                s->main_desc->comp[0].plane, s->main_desc->comp[0].offset, s->main_desc->comp[0].step,
+                s->main_desc->comp[0].shift, is_straight, 0,
                 jobnr, nb_jobs);
 
     if (main_has_alpha)
-        alpha_composite_8_8bits(src, dst, src_w, src_h, dst_w, dst_h, x, y, jobnr, nb_jobs);
+        alpha_composite_8_8bits(s, src, dst, src_w, src_h, dst_w, dst_h, x, y, jobnr, nb_jobs);
 }
 
 static int blend_slice_yuv420(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
@@ -865,6 +1033,72 @@ static int blend_slice_rgba_pm(AVFilterContext *ctx, void *arg, int jobnr, int n
     return 0;
 }
 
+av_cold void ff_overlay_init(OverlayContext *s, int format, int pix_format,
+                             int alpha_format, int main_has_alpha)
+{
+    static int (*const blend_rows_8[2][3][3])(uint8_t *d, uint8_t *da, uint8_t *s, uint8_t *a,
+                                              int w, ptrdiff_t alinesize, ptrdiff_t dalinesize) = {
+        {
+            { blend_row_8_44,      blend_row_8_22,      blend_row_8_20      },
+            { blend_row_8_44_pm,   blend_row_8_22_pm,   blend_row_8_20_pm   },
+            { blend_row_8_44_pmuv, blend_row_8_22_pmuv, blend_row_8_20_pmuv },
+        }, {
+            { blend_row_8_44_alpha,      blend_row_8_22_alpha,      blend_row_8_20_alpha      },
+            { blend_row_8_44_pm_alpha,   blend_row_8_22_pm_alpha,   blend_row_8_20_pm_alpha   },
+            { blend_row_8_44_pmuv_alpha, blend_row_8_22_pmuv_alpha, blend_row_8_20_pmuv_alpha },
+        },
+    };
+    static int (*const blend_rows_16[2][3])(uint8_t *d, uint8_t *da, uint8_t *s, uint8_t *a,
+                                            int w, ptrdiff_t alinesize, ptrdiff_t dalinesize) = {
+        { blend_row_16_44,       blend_row_16_22,       blend_row_16_20       },
+        { blend_row_16_44_alpha, blend_row_16_22_alpha, blend_row_16_20_alpha },
+    };
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(pix_format);
+    const int yuv = !(desc->flags & AV_PIX_FMT_FLAG_RGB);
+    int i;
+
+    memset(s->blend_row, 0, sizeof(s->blend_row));
+
+    if (!(desc->flags & AV_PIX_FMT_FLAG_PLANAR) && !yuv) {
+        /* packed RGB, only with the same component order on both inputs */
+        const int ia = s->main_rgba_map[A];
+
+        if (main_has_alpha && s->main_pix_step[0] == 4 && s->overlay_pix_step[0] == 4 &&
+            !memcmp(s->main_rgba_map, s->overlay_rgba_map, sizeof(s->main_rgba_map)) &&
+            (ia == 0 || ia == 3)) {
+            if (ia == 0)
+                s->blend_row[0] = alpha_format ? blend_row_argb_pm : blend_row_argb;
+            else
+                s->blend_row[0] = alpha_format ? blend_row_rgba_pm : blend_row_rgba;
+        }
+    } else if (desc->comp[0].depth == 8) {
+        for (i = 0; i < 3; i++) {
+            int hv   = i ? desc->log2_chroma_w + desc->log2_chroma_h : 0;
+            int mode = alpha_format ? 1 + (yuv && i) : 0;
+
+            if (desc->comp[i].step != 1)
+                s->blend_row[i] = alpha_format ? blend_row_8_20_pmuv_nv : blend_row_8_20_nv;
+            else
+                s->blend_row[i] = blend_rows_8[main_has_alpha][mode][hv];
+        }
+        if (main_has_alpha)
+            s->blend_row[3] = blend_row_alpha_8;
+    } else {
+        /* premultiplied alpha is not supported with more than 8 bits */
+        for (i = 0; i < 3; i++) {
+            int hv = i ? desc->log2_chroma_w + desc->log2_chroma_h : 0;
+
+            if (desc->comp[i].shift)
+                s->blend_row[i] = i ? blend_row_16_20_p010 : blend_row_16_44_p010;
+            else
+                s->blend_row[i] = blend_rows_16[main_has_alpha][hv];
+        }
+    }
+
+    if (ARCH_X86)
+        ff_overlay_init_x86(s, format, pix_format, alpha_format, main_has_alpha);
+}
+
 static int config_input_main(AVFilterLink *inlink)
 {
     OverlayContext *s = inlink->dst->priv;
@@ -982,10 +1216,6 @@ static int config_input_main(AVFilterLink *inlink)
     }
 
 end:
-    if (ARCH_X86)
-        ff_overlay_init_x86(s, s->format, inlink->format,
-                            s->alpha_format, s->main_has_alpha);
-
     return 0;
 }
 
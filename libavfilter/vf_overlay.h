@@ -77,11 +77,26 @@ typedef struct OverlayContext {
 
     AVExpr *x_pexpr, *y_pexpr;
 
+    /**
+     * Blend a row of an overlay plane onto the main plane, the main alpha
+     * plane for plane 3, or the packed pixels of a row into plane 0.
+     * a and da point to the overlay and main alpha at the position of the
+     * first pixel, alinesize and dalinesize are the linesizes of the alpha
+     * planes. Return the number of pixels blended, the remaining pixels of
+     * the row being blended by the caller.
+     */
     int (*blend_row[4])(uint8_t *d, uint8_t *da, uint8_t *s, uint8_t *a, int w,
-                        ptrdiff_t alinesize);
+                        ptrdiff_t alinesize, ptrdiff_t dalinesize);
     int (*blend_slice)(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs);
 } OverlayContext;
 
+/**
+ * Set the row blending functions for the given main pixel format, after
+ * the pixel steps and RGBA maps of both inputs have been set.
+ */
+void ff_overlay_init(OverlayContext *s, int format, int pix_format,
+                     int alpha_format, int main_has_alpha);
+
 void ff_overlay_init_x86(OverlayContext *s, int format, int pix_format,
                          int alpha_format, int main_has_alpha);
 
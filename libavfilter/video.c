@@ -34,6 +34,8 @@
 #include "video.h"
 
 #define BUFFER_ALIGN 32
+/* memory poisoning builds keep plain av_malloc() buffers for the planes */
+#define POOL_ALLOC (CONFIG_MEMORY_POISONING ? av_buffer_allocz : NULL)
 
 
 AVFrame *ff_null_get_video_buffer(AVFilterLink *link, int w, int h)
@@ -65,7 +67,7 @@ AVFrame *ff_default_get_video_buffer(AVFilterLink *link, int w, int h)
     }
 
     if (!link->frame_pool) {
-        link->frame_pool = ff_frame_pool_video_init(av_buffer_allocz, w, h,
+        link->frame_pool = ff_frame_pool_video_init(POOL_ALLOC, w, h,
                                                     link->format, BUFFER_ALIGN);
         if (!link->frame_pool)
             return NULL;
@@ -80,7 +82,7 @@ AVFrame *ff_default_get_video_buffer(AVFilterLink *link, int w, int h)
             pool_format != link->format || pool_align != BUFFER_ALIGN) {
 
             ff_frame_pool_uninit((FFFramePool **)&link->frame_pool);
-            link->frame_pool = ff_frame_pool_video_init(av_buffer_allocz, w, h,
+            link->frame_pool = ff_frame_pool_video_init(POOL_ALLOC, w, h,
                                                         link->format, BUFFER_ALIGN);
             if (!link->frame_pool)
                 return NULL;
@@ -92,6 +94,7 @@ AVFrame *ff_default_get_video_buffer(AVFilterLink *link, int w, int h)
         return NULL;
 
     frame->sample_aspect_ratio = link->sample_aspect_ratio;
+    ff_filter_stats_alloc(link, frame);
 
     return frame;
 }
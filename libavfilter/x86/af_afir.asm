@@ -36,10 +36,22 @@ cglobal fcmul_add, 4,4,6, sum, t, c, len
     neg       lenq
 ALIGN 16
 .loop:
-    movsldup  m0, [tq + lenq]
-    movsldup  m3, [tq + lenq+mmsize]
     movaps    m1, [cq + lenq]
     movaps    m4, [cq + lenq+mmsize]
+%if cpuflag(fma3)
+    movshdup  m2, [tq + lenq]
+    movshdup  m5, [tq + lenq+mmsize]
+    shufps    m0, m1, m1, 0xb1
+    shufps    m3, m4, m4, 0xb1
+    mulps     m2, m2, m0
+    mulps     m5, m5, m3
+    movsldup  m0, [tq + lenq]
+    movsldup  m3, [tq + lenq+mmsize]
+    fmaddsubps m0, m0, m1, m2
+    fmaddsubps m3, m3, m4, m5
+%else
+    movsldup  m0, [tq + lenq]
+    movsldup  m3, [tq + lenq+mmsize]
     mulps     m0, m0, m1
     mulps     m3, m3, m4
     shufps    m1, m1, m1, 0xb1
@@ -50,6 +62,7 @@ ALIGN 16
     mulps     m5, m5, m4
     addsubps  m0, m0, m2
     addsubps  m3, m3, m5
+%endif
     addps     m0, m0, [sumq + lenq]
     addps     m3, m3, [sumq + lenq+mmsize]
     movaps    [sumq + lenq], m0
@@ -67,3 +80,7 @@ INIT_XMM sse3
 FCMUL_ADD
 INIT_YMM avx
 FCMUL_ADD
+%if HAVE_FMA3_EXTERNAL
+INIT_YMM fma3
+FCMUL_ADD
+%endif
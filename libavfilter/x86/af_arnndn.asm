@@ -0,0 +1,132 @@
+;*****************************************************************************
+;* x86-optimized functions for arnndn filter
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;******************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION .text
+
+; m%1 += m%2 * [%3], m%4 is clobbered without fma3
+%macro MAC 4
+%if cpuflag(fma3)
+    fmaddps        m%1, m%2, %3, m%1
+%else
+    mulps          m%4, m%2, %3
+    addps          m%1, m%4
+%endif
+%endmacro
+
+; sum the lanes of m%1 and store the sum to %2, m%3 is clobbered
+%macro HSUM_STORE 3
+%if mmsize == 32
+    vextractf128  xm%3, m%1, 1
+    addps         xm%1, xm%3
+%endif
+    movhlps       xm%3, xm%1
+    addps         xm%1, xm%3
+    shufps        xm%3, xm%1, xm%1, q0001
+    addss         xm%1, xm%3
+    movss           %2, xm%1
+%endmacro
+
+%macro DOT_ROWS_FNS 0
+;------------------------------------------------------------------------------
+; void ff_arnndn_dot_rows(float *dst, const float *w, ptrdiff_t w_stride,
+;                         const float *src, ptrdiff_t len, ptrdiff_t rows)
+;------------------------------------------------------------------------------
+cglobal arnndn_dot_rows, 6, 7, 3, dst, w, w_stride, src, len, rows, k
+    shl      w_strideq, 2
+    shl           lenq, 2
+    add             wq, lenq
+    add           srcq, lenq
+    neg           lenq
+
+.row:
+    mov             kq, lenq
+    xorps           m0, m0, m0
+
+.loop:
+    mova            m1, [wq + kq]
+    MAC              0, 1, [srcq + kq], 2
+    add             kq, mmsize
+    jl .loop
+
+    HSUM_STORE       0, [dstq], 1
+    add           dstq, 4
+    add             wq, w_strideq
+    dec          rowsq
+    jg .row
+    RET
+
+;------------------------------------------------------------------------------
+; void ff_arnndn_dot_rows4(float *dst, ptrdiff_t dst_stride,
+;                          const float *w, ptrdiff_t w_stride,
+;                          const float *src, ptrdiff_t src_stride,
+;                          ptrdiff_t len, ptrdiff_t rows)
+;------------------------------------------------------------------------------
+cglobal arnndn_dot_rows4, 8, 13, 6, dst, dst_stride, w, w_stride, src, src_stride, len, rows, k, src1, src2, src3, dst2
+    shl    dst_strideq, 2
+    shl      w_strideq, 2
+    shl    src_strideq, 2
+    shl           lenq, 2
+    add             wq, lenq
+    add           srcq, lenq
+    neg           lenq
+    lea          src1q, [srcq + src_strideq]
+    lea          src2q, [srcq + src_strideq * 2]
+    lea          src3q, [src2q + src_strideq]
+    lea          dst2q, [dstq + dst_strideq * 2]
+
+.row:
+    mov             kq, lenq
+    xorps           m0, m0, m0
+    xorps           m1, m1, m1
+    xorps           m2, m2, m2
+    xorps           m3, m3, m3
+
+.loop:
+    mova            m4, [wq + kq]
+    MAC              0, 4, [srcq  + kq], 5
+    MAC              1, 4, [src1q + kq], 5
+    MAC              2, 4, [src2q + kq], 5
+    MAC              3, 4, [src3q + kq], 5
+    add             kq, mmsize
+    jl .loop
+
+    HSUM_STORE       0, [dstq], 5
+    HSUM_STORE       1, [dstq + dst_strideq], 5
+    HSUM_STORE       2, [dst2q], 5
+    HSUM_STORE       3, [dst2q + dst_strideq], 5
+    add           dstq, 4
+    add          dst2q, 4
+    add             wq, w_strideq
+    dec          rowsq
+    jg .row
+    RET
+%endmacro
+
+%if ARCH_X86_64
+INIT_XMM sse
+DOT_ROWS_FNS
+
+%if HAVE_FMA3_EXTERNAL
+INIT_YMM fma3
+DOT_ROWS_FNS
+%endif
+%endif
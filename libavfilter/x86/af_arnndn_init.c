@@ -0,0 +1,53 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "config.h"
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/x86/cpu.h"
+#include "libavfilter/af_arnndndsp.h"
+
+void ff_arnndn_dot_rows_sse(float *dst, const float *w, ptrdiff_t w_stride,
+                            const float *src, ptrdiff_t len, ptrdiff_t rows);
+void ff_arnndn_dot_rows_fma3(float *dst, const float *w, ptrdiff_t w_stride,
+                             const float *src, ptrdiff_t len, ptrdiff_t rows);
+void ff_arnndn_dot_rows4_sse(float *dst, ptrdiff_t dst_stride,
+                             const float *w, ptrdiff_t w_stride,
+                             const float *src, ptrdiff_t src_stride,
+                             ptrdiff_t len, ptrdiff_t rows);
+void ff_arnndn_dot_rows4_fma3(float *dst, ptrdiff_t dst_stride,
+                              const float *w, ptrdiff_t w_stride,
+                              const float *src, ptrdiff_t src_stride,
+                              ptrdiff_t len, ptrdiff_t rows);
+
+av_cold void ff_arnndn_init_x86(AudioRNNDSPContext *s)
+{
+    int cpu_flags = av_get_cpu_flags();
+
+    /* both functions must be replaced together, as a vector has to give the
+     * same result whether it is part of a batch or not */
+    if (ARCH_X86_64 && EXTERNAL_SSE(cpu_flags)) {
+        s->dot_rows  = ff_arnndn_dot_rows_sse;
+        s->dot_rows4 = ff_arnndn_dot_rows4_sse;
+    }
+
+    if (ARCH_X86_64 && EXTERNAL_FMA3_FAST(cpu_flags)) {
+        s->dot_rows  = ff_arnndn_dot_rows_fma3;
+        s->dot_rows4 = ff_arnndn_dot_rows4_fma3;
+    }
+}
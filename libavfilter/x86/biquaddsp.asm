@@ -0,0 +1,194 @@
+;******************************************************************************
+;* SIMD cascaded biquad filters
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;******************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION .text
+
+; every coefficient and state is a vector of BIQUAD_LANES_FLT floats or
+; BIQUAD_LANES_DBL doubles, BIQUAD_NB_COEFFS and BIQUAD_NB_STATES per section
+%define COEFF(x)       [coeffsq + (x) * mmsize]
+%define COEFFS_SIZE    (5 * mmsize)
+%define STATES_SIZE    (4 * mmsize)
+
+; No fma is used in these functions, every lane has to compute exactly the
+; same operations in the same order as the C version.
+;
+; Two sections are run per pass over the buffer: the recursion of each one
+; is a long dependency chain, the chains of two sections are independent
+; and overlap in the pipeline.
+
+; %1 s/d, %2 input, %3 output, %4 first coefficient, %5-%8 i1, i2, o1, o2
+%macro SECTION_DI 8
+    ; out = i2 * b2 + i1 * b1 + in * b0 + o2 * a2 + o1 * a1
+    mulp%1          %3, %6, COEFF(%4 + 2)
+    mulp%1         m10, %5, COEFF(%4 + 1)
+    addp%1          %3, m10
+    mulp%1         m10, %2, COEFF(%4 + 0)
+    addp%1          %3, m10
+    mulp%1         m10, %8, COEFF(%4 + 4)
+    addp%1          %3, m10
+    mulp%1         m10, %7, COEFF(%4 + 3)
+    addp%1          %3, m10
+    mova            %6, %5
+    mova            %5, %2
+    mova            %8, %7
+    mova            %7, %3
+%endmacro
+
+; %1 s/d, %2 input, %3 output, %4 first coefficient, %5-%6 w1, w2, %7-%8 unused
+%macro SECTION_DII 8
+    ; w0 = in + a1 * w1 + a2 * w2
+    mulp%1         m10, %5, COEFF(%4 + 3)
+    addp%1         m10, %2
+    mulp%1         m11, %6, COEFF(%4 + 4)
+    addp%1         m10, m11
+    ; out = b0 * w0 + b1 * w1 + b2 * w2
+    mulp%1          %3, m10, COEFF(%4 + 0)
+    mulp%1         m11, %5, COEFF(%4 + 1)
+    addp%1          %3, m11
+    mulp%1         m11, %6, COEFF(%4 + 2)
+    addp%1          %3, m11
+    mova            %6, %5
+    mova            %5, m10
+%endmacro
+
+; %1 s/d, %2 input, %3 output, %4 first coefficient, %5-%6 z1, z2, %7-%8 unused
+%macro SECTION_TDII 8
+    ; out = b0 * in + z1
+    mulp%1          %3, %2, COEFF(%4 + 0)
+    addp%1          %3, %5
+    ; z1 = b1 * in + z2 + a1 * out
+    mulp%1         m10, %2, COEFF(%4 + 1)
+    addp%1         m10, %6
+    mulp%1         m11, %3, COEFF(%4 + 3)
+    addp%1          %5, m10, m11
+    ; z2 = b2 * in + a2 * out
+    mulp%1         m10, %2, COEFF(%4 + 2)
+    mulp%1         m11, %3, COEFF(%4 + 4)
+    addp%1          %6, m10, m11
+%endmacro
+
+; %1 s/d, %2 input, %3 output, %4 first coefficient, %5-%6 s0, s1, %7-%8 unused
+; the coefficients are v0, v1, v2, k0, k1
+%macro SECTION_LATT 8
+    ; t0 = in - k1 * s0, t1 = t0 * k1 + s0, out = t1 * v2
+    mulp%1         m10, %5, COEFF(%4 + 4)
+    subp%1         m10, %2, m10
+    mulp%1         m11, m10, COEFF(%4 + 4)
+    addp%1         m11, %5
+    mulp%1          %3, m11, COEFF(%4 + 2)
+    ; t0 = t0 - k0 * s1, t1 = t0 * k0 + s1, out += t1 * v1
+    mulp%1         m11, %6, COEFF(%4 + 3)
+    subp%1         m10, m11
+    mulp%1         m11, m10, COEFF(%4 + 3)
+    addp%1          %5, m11, %6
+    mulp%1         m11, %5, COEFF(%4 + 1)
+    addp%1          %3, m11
+    ; out += t0 * v0
+    mulp%1         m11, m10, COEFF(%4 + 0)
+    addp%1          %3, m11
+    mova            %6, m10
+%endmacro
+
+; %1 number of states, %2 offset, %3-%6 registers
+%macro LOAD_STATES 6
+    mova            %3, [stateq + %2]
+    mova            %4, [stateq + %2 + mmsize]
+%if %1 > 2
+    mova            %5, [stateq + %2 + mmsize * 2]
+    mova            %6, [stateq + %2 + mmsize * 3]
+%endif
+%endmacro
+
+%macro STORE_STATES 6
+    mova [stateq + %2], %3
+    mova [stateq + %2 + mmsize], %4
+%if %1 > 2
+    mova [stateq + %2 + mmsize * 2], %5
+    mova [stateq + %2 + mmsize * 3], %6
+%endif
+%endmacro
+
+;------------------------------------------------------------------------------
+; void ff_biquad_<form>_<type>(type *buf, ptrdiff_t len, const type *coeffs,
+;                              type *state, int nb_sections)
+;------------------------------------------------------------------------------
+; %1 form, %2 section macro, %3 number of states, %4 flt/dbl, %5 s/d
+%macro BIQUAD_FN 5
+cglobal biquad_%1_%4, 5, 6, 12, buf, len, coeffs, state, nb, n
+    shl           lenq, 5
+    test          lenq, lenq
+    jz .end
+
+.pair:
+    cmp            nbd, 2
+    jl .single
+    LOAD_STATES    %3, 0,           m0, m1, m2, m3
+    LOAD_STATES    %3, STATES_SIZE, m4, m5, m6, m7
+    xor             nq, nq
+
+.pair_loop:
+    mova            m8, [bufq + nq]
+    SECTION_%2     %5, m8, m9, 0, m0, m1, m2, m3
+    SECTION_%2     %5, m9, m8, 5, m4, m5, m6, m7
+    mova [bufq + nq], m8
+    add             nq, mmsize
+    cmp             nq, lenq
+    jl .pair_loop
+
+    STORE_STATES   %3, 0,           m0, m1, m2, m3
+    STORE_STATES   %3, STATES_SIZE, m4, m5, m6, m7
+    add        coeffsq, COEFFS_SIZE * 2
+    add         stateq, STATES_SIZE * 2
+    sub            nbd, 2
+    jmp .pair
+
+.single:
+    test           nbd, nbd
+    jz .end
+    LOAD_STATES    %3, 0, m0, m1, m2, m3
+    xor             nq, nq
+
+.single_loop:
+    mova            m8, [bufq + nq]
+    SECTION_%2     %5, m8, m9, 0, m0, m1, m2, m3
+    mova [bufq + nq], m9
+    add             nq, mmsize
+    cmp             nq, lenq
+    jl .single_loop
+
+    STORE_STATES   %3, 0, m0, m1, m2, m3
+
+.end:
+    RET
+%endmacro
+
+%if ARCH_X86_64 && HAVE_AVX_EXTERNAL
+INIT_YMM avx
+BIQUAD_FN di,   DI,   4, flt, s
+BIQUAD_FN di,   DI,   4, dbl, d
+BIQUAD_FN dii,  DII,  2, flt, s
+BIQUAD_FN dii,  DII,  2, dbl, d
+BIQUAD_FN tdii, TDII, 2, flt, s
+BIQUAD_FN tdii, TDII, 2, dbl, d
+BIQUAD_FN latt, LATT, 2, flt, s
+BIQUAD_FN latt, LATT, 2, dbl, d
+%endif
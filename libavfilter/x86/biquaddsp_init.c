@@ -0,0 +1,51 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "config.h"
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/x86/cpu.h"
+#include "libavfilter/biquaddsp.h"
+
+#define BIQUAD_FUNCS(form, opt)                                                       \
+void ff_biquad_##form##_flt_##opt(float *buf, ptrdiff_t len, const float *coeffs,     \
+                                  float *state, int nb_sections);                     \
+void ff_biquad_##form##_dbl_##opt(double *buf, ptrdiff_t len, const double *coeffs,   \
+                                  double *state, int nb_sections);
+
+BIQUAD_FUNCS(di,   avx)
+BIQUAD_FUNCS(dii,  avx)
+BIQUAD_FUNCS(tdii, avx)
+BIQUAD_FUNCS(latt, avx)
+
+av_cold void ff_biquaddsp_init_x86(BiquadDSPContext *dsp)
+{
+    int cpu_flags = av_get_cpu_flags();
+
+    if (ARCH_X86_64 && EXTERNAL_AVX_FAST(cpu_flags)) {
+        dsp->filter_flt[BIQUAD_DI]   = ff_biquad_di_flt_avx;
+        dsp->filter_flt[BIQUAD_DII]  = ff_biquad_dii_flt_avx;
+        dsp->filter_flt[BIQUAD_TDII] = ff_biquad_tdii_flt_avx;
+        dsp->filter_flt[BIQUAD_LATT] = ff_biquad_latt_flt_avx;
+
+        dsp->filter_dbl[BIQUAD_DI]   = ff_biquad_di_dbl_avx;
+        dsp->filter_dbl[BIQUAD_DII]  = ff_biquad_dii_dbl_avx;
+        dsp->filter_dbl[BIQUAD_TDII] = ff_biquad_tdii_dbl_avx;
+        dsp->filter_dbl[BIQUAD_LATT] = ff_biquad_latt_dbl_avx;
+    }
+}
@@ -0,0 +1,134 @@
+;*****************************************************************************
+;* x86-optimized functions for drawutils
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;*****************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION_RODATA
+
+pd_0x1010101: dd 0x1010101
+
+SECTION .text
+
+; int ff_draw_blend_row8(uint8_t *dst, const uint32_t *tau,
+;                        const uint32_t *asrc, int len)
+; dst[i] = (dst[i] * tau[i & 7] + asrc[i & 7]) >> 24, 16 bytes per iteration
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+cglobal draw_blend_row8, 4, 5, 6, 0, d, tau, asrc, w, x
+    xor          xq, xq
+    movsxdifnidn wq, wd
+    and          wq, ~15
+    jz .end
+    movu         m4, [tauq]
+    movu         m5, [asrcq]
+    .loop:
+        pmovzxbd     m0, [dq+xq]
+        pmovzxbd     m1, [dq+xq+8]
+        pmulld       m0, m4
+        pmulld       m1, m4
+        paddd        m0, m5
+        paddd        m1, m5
+        psrld        m0, 24
+        psrld        m1, 24
+        packusdw     m0, m1
+        vpermq       m0, m0, q3120
+        vextracti128 xm1, m0, 1
+        packuswb     xm0, xm1
+        movu   [dq+xq], xm0
+        add          xq, 16
+        cmp          xq, wq
+        jl .loop
+
+    .end:
+    mov    eax, xd
+    RET
+
+; int ff_draw_blend_row16(uint8_t *dst, const uint32_t *tau,
+;                         const uint32_t *asrc, int len)
+; same on little-endian words with >> 16, 16 words per iteration
+cglobal draw_blend_row16, 4, 5, 6, 0, d, tau, asrc, w, x
+    xor          xq, xq
+    movsxdifnidn wq, wd
+    and          wq, ~15
+    jz .end
+    movu         m4, [tauq]
+    movu         m5, [asrcq]
+    .loop:
+        pmovzxwd     m0, [dq+2*xq]
+        pmovzxwd     m1, [dq+2*xq+16]
+        pmulld       m0, m4
+        pmulld       m1, m4
+        paddd        m0, m5
+        paddd        m1, m5
+        psrld        m0, 16
+        psrld        m1, 16
+        packusdw     m0, m1
+        vpermq       m0, m0, q3120
+        movu [dq+2*xq], m0
+        add          xq, 16
+        cmp          xq, wq
+        jl .loop
+
+    .end:
+    mov    eax, xd
+    RET
+
+; int ff_draw_blend_mask_row8(uint8_t *dst, const uint8_t *mask,
+;                             const uint32_t *alpha, const uint32_t *src, int w)
+; one component per pixel: a = mask[x] * alpha[0],
+; dst[x] = (dst[x] * (0x1010101 - a) + src[0] * a) >> 24, 16 pixels per iteration
+cglobal draw_blend_mask_row8, 5, 6, 8, 0, d, m, alpha, src, w, x
+    xor          xq, xq
+    movsxdifnidn wq, wd
+    and          wq, ~15
+    jz .end
+    vpbroadcastd m5, [alphaq]
+    vpbroadcastd m6, [srcq]
+    vpbroadcastd m7, [pd_0x1010101]
+    .loop:
+        pmovzxbd     m0, [mq+xq]
+        pmovzxbd     m1, [mq+xq+8]
+        pmulld       m0, m5
+        pmulld       m1, m5
+        pmovzxbd     m2, [dq+xq]
+        pmovzxbd     m3, [dq+xq+8]
+        psubd        m4, m7, m0
+        pmulld       m2, m4
+        psubd        m4, m7, m1
+        pmulld       m3, m4
+        pmulld       m0, m6
+        pmulld       m1, m6
+        paddd        m0, m2
+        paddd        m1, m3
+        psrld        m0, 24
+        psrld        m1, 24
+        packusdw     m0, m1
+        vpermq       m0, m0, q3120
+        vextracti128 xm1, m0, 1
+        packuswb     xm0, xm1
+        movu   [dq+xq], xm0
+        add          xq, 16
+        cmp          xq, wq
+        jl .loop
+
+    .end:
+    mov    eax, xd
+    RET
+%endif
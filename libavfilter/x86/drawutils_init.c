@@ -0,0 +1,53 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/pixdesc.h"
+#include "libavutil/x86/cpu.h"
+#include "libavfilter/drawutils.h"
+
+int ff_draw_blend_row8_avx2(uint8_t *dst, const uint32_t *tau,
+                            const uint32_t *asrc, int len);
+int ff_draw_blend_row16_avx2(uint8_t *dst, const uint32_t *tau,
+                             const uint32_t *asrc, int len);
+int ff_draw_blend_mask_row8_avx2(uint8_t *dst, const uint8_t *mask,
+                                 const uint32_t *alpha, const uint32_t *src,
+                                 int w);
+
+av_cold void ff_draw_init_x86(FFDrawContext *draw)
+{
+    int cpu_flags = av_get_cpu_flags();
+    int bytes = draw->desc->comp[0].depth > 8 ? 2 : 1;
+    int plane;
+
+    for (plane = 0; plane < draw->nb_planes; plane++) {
+        int nb_comp = draw->pixelstep[plane] / bytes;
+
+        if (draw->blend_mask_row[plane] && nb_comp == 1 &&
+            EXTERNAL_AVX2_FAST(cpu_flags))
+            draw->blend_mask_row[plane] = ff_draw_blend_mask_row8_avx2;
+
+        /* the factors are loaded as a vector of 8 entries */
+        if (!draw->blend_row[plane] || 8 % nb_comp)
+            continue;
+        if (EXTERNAL_AVX2_FAST(cpu_flags))
+            draw->blend_row[plane] = bytes == 1 ? ff_draw_blend_row8_avx2 :
+                                                  ff_draw_blend_row16_avx2;
+    }
+}
@@ -0,0 +1,179 @@
+;******************************************************************************
+;* SIMD EBU R128 measurement functions
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;******************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION_RODATA 32
+
+pq_abs_mask: times 4 dq 0x7fffffffffffffff
+
+SECTION .text
+
+; every coefficient is repeated in EBUR128_LANES doubles
+%define COEFF(x) [coeffsq + (x) * 32]
+
+; No fma is used in these functions, every lane has to compute exactly the
+; same operations in the same order as the C version.
+
+%macro EBUR128_FNS 0
+;------------------------------------------------------------------------------
+; void ff_ebur128_filter(double *dst, const double *src, ptrdiff_t len,
+;                        ptrdiff_t stride, const double *coeffs, double *state)
+;------------------------------------------------------------------------------
+cglobal ebur128_filter, 6, 9, 10, dst, src, len, stride, coeffs, state, i, j, off
+    shl        strideq, 3
+    xor             jq, jq
+
+.lanes:
+    lea           offq, [stateq + jq]
+    mova            m1, [offq]
+    mova            m2, [offq + strideq]
+    lea           offq, [offq + strideq * 2]
+    mova            m3, [offq]
+    mova            m4, [offq + strideq]
+    lea           offq, [offq + strideq * 2]
+    mova            m5, [offq]
+    mova            m6, [offq + strideq]
+
+    mov             iq, lenq
+    mov           offq, jq
+    test            iq, iq
+    jle .store
+
+.loop:
+    ; y[i] = x[i]*b0 + x[i-1]*b1 + x[i-2]*b2 - y[i-1]*a1 - y[i-2]*a2
+    mova            m0, [srcq + offq]
+    mulpd           m7, m0, COEFF(0)
+    mulpd           m9, m1, COEFF(1)
+    addpd           m7, m9
+    mulpd           m9, m2, COEFF(2)
+    addpd           m7, m9
+    mulpd           m9, m3, COEFF(3)
+    subpd           m7, m9
+    mulpd           m9, m4, COEFF(4)
+    subpd           m7, m9
+    mova            m2, m1
+    mova            m1, m0
+
+    ; z[i] = y[i]*b0 + y[i-1]*b1 + y[i-2]*b2 - z[i-1]*a1 - z[i-2]*a2
+    mulpd           m8, m7, COEFF(5)
+    mulpd           m9, m3, COEFF(6)
+    addpd           m8, m9
+    mulpd           m9, m4, COEFF(7)
+    addpd           m8, m9
+    mulpd           m9, m5, COEFF(8)
+    subpd           m8, m9
+    mulpd           m9, m6, COEFF(9)
+    subpd           m8, m9
+    mova            m4, m3
+    mova            m3, m7
+    mova            m6, m5
+    mova            m5, m8
+
+    mulpd           m8, m8
+    mova  [dstq + offq], m8
+    add           offq, strideq
+    dec             iq
+    jg .loop
+
+.store:
+    lea           offq, [stateq + jq]
+    mova        [offq], m1
+    mova  [offq + strideq], m2
+    lea           offq, [offq + strideq * 2]
+    mova        [offq], m3
+    mova  [offq + strideq], m4
+    lea           offq, [offq + strideq * 2]
+    mova        [offq], m5
+    mova  [offq + strideq], m6
+
+    add             jq, mmsize
+    cmp             jq, strideq
+    jl .lanes
+    RET
+
+;------------------------------------------------------------------------------
+; void ff_ebur128_sum(double *sums, const double *src, ptrdiff_t len,
+;                     ptrdiff_t stride)
+;------------------------------------------------------------------------------
+cglobal ebur128_sum, 4, 7, 1, sums, src, len, stride, i, j, off
+    shl        strideq, 3
+    xor             jq, jq
+
+.lanes:
+    mova            m0, [sumsq + jq]
+    mov             iq, lenq
+    mov           offq, jq
+    test            iq, iq
+    jle .store
+
+.loop:
+    addpd           m0, [srcq + offq]
+    add           offq, strideq
+    dec             iq
+    jg .loop
+
+.store:
+    mova  [sumsq + jq], m0
+    add             jq, mmsize
+    cmp             jq, strideq
+    jl .lanes
+    RET
+
+;------------------------------------------------------------------------------
+; void ff_ebur128_peak(double *peaks, const double *src, ptrdiff_t len,
+;                      ptrdiff_t stride)
+;------------------------------------------------------------------------------
+cglobal ebur128_peak, 4, 7, 3, peaks, src, len, stride, i, j, off
+    shl        strideq, 3
+    xor             jq, jq
+    mova            m2, [pq_abs_mask]
+
+.lanes:
+    mova            m0, [peaksq + jq]
+    mov             iq, lenq
+    mov           offq, jq
+    test            iq, iq
+    jle .store
+
+.loop:
+    andpd           m1, m2, [srcq + offq]
+    maxpd           m0, m1
+    add           offq, strideq
+    dec             iq
+    jg .loop
+
+.store:
+    mova [peaksq + jq], m0
+    add             jq, mmsize
+    cmp             jq, strideq
+    jl .lanes
+    RET
+%endmacro
+
+%if ARCH_X86_64
+INIT_XMM sse2
+EBUR128_FNS
+
+%if HAVE_AVX_EXTERNAL
+INIT_YMM avx
+EBUR128_FNS
+%endif
+%endif
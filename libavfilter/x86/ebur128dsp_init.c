@@ -0,0 +1,51 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "config.h"
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/x86/cpu.h"
+#include "libavfilter/ebur128dsp.h"
+
+#define EBUR128_FUNCS(opt)                                                          \
+void ff_ebur128_filter_##opt(double *dst, const double *src, ptrdiff_t len,        \
+                             ptrdiff_t stride, const double *coeffs, double *state); \
+void ff_ebur128_sum_##opt(double *sums, const double *src, ptrdiff_t len,          \
+                          ptrdiff_t stride);                                        \
+void ff_ebur128_peak_##opt(double *peaks, const double *src, ptrdiff_t len,        \
+                           ptrdiff_t stride);
+
+EBUR128_FUNCS(sse2)
+EBUR128_FUNCS(avx)
+
+av_cold void ff_ebur128dsp_init_x86(EBUR128DSPContext *dsp)
+{
+    int cpu_flags = av_get_cpu_flags();
+
+    if (ARCH_X86_64 && EXTERNAL_SSE2(cpu_flags)) {
+        dsp->filter = ff_ebur128_filter_sse2;
+        dsp->sum    = ff_ebur128_sum_sse2;
+        dsp->peak   = ff_ebur128_peak_sse2;
+    }
+
+    if (ARCH_X86_64 && EXTERNAL_AVX_FAST(cpu_flags)) {
+        dsp->filter = ff_ebur128_filter_avx;
+        dsp->sum    = ff_ebur128_sum_avx;
+        dsp->peak   = ff_ebur128_peak_avx;
+    }
+}
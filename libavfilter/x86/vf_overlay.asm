@@ -23,12 +23,20 @@
 
 %include "libavutil/x86/x86util.asm"
 
-SECTION_RODATA
+SECTION_RODATA 32
 
-pb_1:     times 16 db 1
-pw_128:   times  8 dw 128
-pw_255:   times  8 dw 255
-pw_257:   times  8 dw 257
+pb_1:      times 32 db 1
+pw_1:      times 16 dw 1
+pw_128:    times 16 dw 128
+pw_m128:   times 16 dw -128
+pw_255:    times 16 dw 255
+pw_257:    times 16 dw 257
+pw_alpha0: times  4 dw -1, 0, 0, 0
+pw_alpha3: times  4 dw 0, 0, 0, -1
+pd_1:      times  8 dd 1
+pd_1023:   times  8 dd 1023
+pd_65535:  times  8 dd 65535
+ps_65025:  times  8 dd 65025.0
 
 SECTION .text
 
@@ -142,3 +150,326 @@ cglobal overlay_row_20, 6, 7, 7, 0, d, da, s, a, w, r, x
     .end:
     mov    eax, xd
     RET
+
+%if HAVE_AVX2_EXTERNAL && ARCH_X86_64
+; average the alpha of the pixels a chroma sample covers, see blend_row_8_8bits()
+; %1 = dst, %2 = alpha row, %3 = next alpha row, %4 = tmp
+%macro OVERLAY_ALPHA 4
+%if hv == 44
+    pmovzxbw    %1, [%2q+xq]
+%elif hv == 22
+    movu        %1, [%2q+2*xq]
+    psrlw       %4, %1, 8
+    pand        %1, m15
+    paddw       %4, %1
+    psrlw       %4, 1
+    paddw       %1, %4
+    psrlw       %1, 1
+%else
+    movu        %1, [%2q+2*xq]
+    movu        %4, [%3q+2*xq]
+    pmaddubsw   %1, m12
+    pmaddubsw   %4, m12
+    paddw       %1, %4
+    psrlw       %1, 2
+%endif
+%endmacro
+
+; turn the overlay alpha in %1 into straight alpha for a main input with alpha
+; %2 in the same unit, i.e. UNPREMULTIPLY_ALPHA() unless %1 is 0 or 255;
+; the quotient is below 2^24 and exact in single precision
+%macro UNPREMULTIPLY 2
+    pcmpeqw     m2, %1, m11
+    pcmpeqw     m3, %1, m15
+    por         m2, m3
+    psubw       m3, m15, %2
+    punpcklwd   m4, %1, %2
+    punpckhwd   m5, %1, %2
+    punpcklwd   m6, m3, m15
+    punpckhwd   m7, m3, m15
+    pmaddwd     m4, m6
+    pmaddwd     m5, m7
+    cvtdq2ps    m4, m4
+    cvtdq2ps    m5, m5
+    punpcklwd   m6, %1, m11
+    punpckhwd   m7, %1, m11
+    cvtdq2ps    m6, m6
+    cvtdq2ps    m7, m7
+    mulps       m6, m10
+    mulps       m7, m10
+    divps       m6, m4
+    divps       m7, m5
+    cvttps2dq   m6, m6
+    cvttps2dq   m7, m7
+    packusdw    m6, m7
+    pblendvb    %1, m6, %1, m2
+%endmacro
+
+; %1 = name, %2 = hsub + vsub (44, 22, 20),
+; %3 = 0 straight, 1 premultiplied, 2 premultiplied with signed chroma, %4 = main has alpha
+%macro OVERLAY_ROW 4
+%assign hv %2
+cglobal overlay_row_%1, 7, 8, 16, d, da, s, a, w, als, dals, x
+    xor          xd, xd
+    movsxdifnidn wq, wd
+%if hv != 44
+    sub          wq, 1
+%endif
+    and          wq, ~(mmsize/2 - 1)
+    jle .end
+%if hv == 20
+    add        alsq, aq
+    add       dalsq, daq
+    mova        m12, [pb_1]
+%endif
+%if %4
+    pxor        m11, m11
+    mova        m10, [ps_65025]
+%endif
+%if %3 == 2
+    mova         m9, [pw_m128]
+%endif
+    mova        m15, [pw_255]
+    mova        m14, [pw_128]
+    mova        m13, [pw_257]
+.loop:
+    OVERLAY_ALPHA m0, a, als, m1
+%if %4
+    OVERLAY_ALPHA m1, da, dals, m2
+    UNPREMULTIPLY m0, m1
+%endif
+    pmovzxbw     m1, [sq+xq]
+    pmovzxbw     m2, [dq+xq]
+    pxor         m3, m0, m15
+%if %3 == 0
+    pmullw       m1, m0
+    pmullw       m2, m3
+    paddw        m1, m14
+    paddw        m1, m2
+    pmulhuw      m1, m13
+%elif %3 == 1
+    pmullw       m2, m3
+    paddw        m2, m14
+    pmulhuw      m2, m13
+    paddw        m1, m2
+%else
+    psubw        m2, m14
+    pmullw       m2, m3
+    paddw        m2, m14
+    pmulhw       m2, m13
+    psubw        m1, m14
+    paddw        m1, m2
+    pmaxsw       m1, m9
+    pminsw       m1, m14
+    paddw        m1, m14
+    pand         m1, m15
+%endif
+    packuswb     m1, m1
+    vpermq       m1, m1, q3120
+    movu    [dq+xq], xm1
+    add          xq, mmsize/2
+    cmp          xq, wq
+    jl .loop
+
+.end:
+    mov         eax, xd
+    RET
+%endmacro
+
+INIT_YMM avx2
+OVERLAY_ROW 44,            44, 0, 0
+OVERLAY_ROW 22,            22, 0, 0
+OVERLAY_ROW 20,            20, 0, 0
+OVERLAY_ROW 44_pm,         44, 1, 0
+OVERLAY_ROW 22_pm,         22, 1, 0
+OVERLAY_ROW 20_pm,         20, 1, 0
+OVERLAY_ROW 44_pmuv,       44, 2, 0
+OVERLAY_ROW 22_pmuv,       22, 2, 0
+OVERLAY_ROW 20_pmuv,       20, 2, 0
+OVERLAY_ROW 44_alpha,      44, 0, 1
+OVERLAY_ROW 22_alpha,      22, 0, 1
+OVERLAY_ROW 20_alpha,      20, 0, 1
+OVERLAY_ROW 44_pm_alpha,   44, 1, 1
+OVERLAY_ROW 22_pm_alpha,   22, 1, 1
+OVERLAY_ROW 20_pm_alpha,   20, 1, 1
+OVERLAY_ROW 44_pmuv_alpha, 44, 2, 1
+OVERLAY_ROW 22_pmuv_alpha, 22, 2, 1
+OVERLAY_ROW 20_pmuv_alpha, 20, 2, 1
+
+; composite the main alpha plane: d += (255 - d) * s / 255
+cglobal overlay_row_alpha, 5, 6, 6, d, da, s, a, w, x
+    xor          xd, xd
+    movsxdifnidn wq, wd
+    and          wq, ~(mmsize/2 - 1)
+    jle .end
+    mova         m3, [pw_255]
+    mova         m4, [pw_128]
+    mova         m5, [pw_257]
+.loop:
+    pmovzxbw     m0, [dq+xq]
+    pmovzxbw     m1, [sq+xq]
+    pxor         m2, m0, m3
+    pmullw       m1, m2
+    paddw        m1, m4
+    pmulhuw      m1, m5
+    paddw        m0, m1
+    packuswb     m0, m0
+    vpermq       m0, m0, q3120
+    movu    [dq+xq], xm0
+    add          xq, mmsize/2
+    cmp          xq, wq
+    jl .loop
+
+.end:
+    mov         eax, xd
+    RET
+
+; packed RGB with alpha on both inputs, 4 pixels per iteration
+; %1 = name, %2 = alpha byte offset (0 or 3), %3 = premultiplied
+%macro OVERLAY_ROW_PACKED 3
+cglobal overlay_row_%1, 5, 6, 16, d, da, s, a, w, x
+    xor          xd, xd
+    movsxdifnidn wq, wd
+    shl          wq, 2
+    and          wq, ~(mmsize/2 - 1)
+    jle .end
+    pxor        m11, m11
+    mova        m10, [ps_65025]
+    mova         m9, [pw_alpha%2]
+    mova        m15, [pw_255]
+    mova        m14, [pw_128]
+    mova        m13, [pw_257]
+.loop:
+    pmovzxbw     m8, [sq+xq]
+    pmovzxbw    m12, [dq+xq]
+    pshuflw      m0, m8, q%2%2%2%2
+    pshufhw      m0, m0, q%2%2%2%2
+    pshuflw      m1, m12, q%2%2%2%2
+    pshufhw      m1, m1, q%2%2%2%2
+    UNPREMULTIPLY m0, m1
+%if %3
+    pcmpeqw      m2, m0, m11
+%endif
+    pxor         m3, m0, m15
+    pmullw       m4, m12, m3
+    paddw        m4, m14
+%if %3
+    pmulhuw      m4, m13
+    paddw        m4, m8
+%else
+    pmullw       m1, m8, m0
+    paddw        m4, m1
+    pmulhuw      m4, m13
+%endif
+    pxor         m1, m12, m15
+    pmullw       m1, m8
+    paddw        m1, m14
+    pmulhuw      m1, m13
+    paddw        m1, m12
+    pblendvb     m4, m4, m1, m9
+%if %3
+    pblendvb     m4, m4, m12, m2
+%endif
+    packuswb     m4, m4
+    vpermq       m4, m4, q3120
+    movu    [dq+xq], xm4
+    add          xq, mmsize/2
+    cmp          xq, wq
+    jl .loop
+
+.end:
+    shr          xd, 2
+    mov         eax, xd
+    RET
+%endmacro
+
+OVERLAY_ROW_PACKED argb,    0, 0
+OVERLAY_ROW_PACKED rgba,    3, 0
+OVERLAY_ROW_PACKED argb_pm, 0, 1
+OVERLAY_ROW_PACKED rgba_pm, 3, 1
+
+; 10 bits per component in 16 bits, straight alpha and a main input without
+; alpha, 8 pixels per iteration;
+; %1 = name, %2 = hsub + vsub (44, 22, 20), %3 = main pixel step in words,
+; %4 = shift of the main components
+%macro OVERLAY_ROW_16 4
+cglobal overlay_row_%1, 6, 7, 10, d, da, s, a, w, als, x
+    xor          xd, xd
+    movsxdifnidn wq, wd
+%if %2 != 44
+    sub          wq, 1
+%endif
+    and          wq, ~(mmsize/4 - 1)
+    jle .end
+%if %2 == 20
+    add        alsq, aq
+    mova         m7, [pw_1]
+%endif
+%if %2 != 44 || %3 == 2
+    mova         m8, [pd_65535]
+%endif
+    mova         m9, [pd_1023]
+.loop:
+%if %2 == 44
+    pmovzxwd     m0, [aq+2*xq]
+%elif %2 == 22
+    movu         m0, [aq+4*xq]
+    psrld        m1, m0, 16
+    pand         m0, m8
+    paddd        m1, m0
+    psrld        m1, 1
+    paddd        m0, m1
+    psrld        m0, 1
+%else
+    movu         m0, [aq+4*xq]
+    movu         m1, [alsq+4*xq]
+    pmaddwd      m0, m7
+    pmaddwd      m1, m7
+    paddd        m0, m1
+    psrld        m0, 2
+%endif
+%if %3 == 2
+    movu         m6, [dq+4*xq]
+    pand         m1, m6, m8
+%else
+    pmovzxwd     m1, [dq+2*xq]
+%endif
+%if %4
+    psrld        m1, %4
+%endif
+    pmovzxwd     m2, [sq+2*xq]
+    psubd        m3, m9, m0
+    pmulld       m1, m3
+    pmulld       m2, m0
+    paddd        m1, m2
+    ; x / 1023 == (x + (x >> 10) + 1) >> 10 for x <= 1023 * 1023
+    psrld        m2, m1, 10
+    paddd        m1, m2
+    paddd        m1, [pd_1]
+    psrld        m1, 10
+%if %4
+    pslld        m1, %4
+%endif
+%if %3 == 2
+    pblendw      m1, m6, m1, 0x55
+    movu  [dq+4*xq], m1
+%else
+    packusdw     m1, m1
+    vpermq       m1, m1, q3120
+    movu  [dq+2*xq], xm1
+%endif
+    add          xq, mmsize/4
+    cmp          xq, wq
+    jl .loop
+
+.end:
+    mov         eax, xd
+    RET
+%endmacro
+
+OVERLAY_ROW_16 44_10,   44, 1, 0
+OVERLAY_ROW_16 22_10,   22, 1, 0
+OVERLAY_ROW_16 20_10,   20, 1, 0
+OVERLAY_ROW_16 44_p010, 44, 1, 6
+OVERLAY_ROW_16 20_p010, 20, 2, 6
+%endif
@@ -20,17 +20,105 @@
 
 #include "libavutil/attributes.h"
 #include "libavutil/cpu.h"
+#include "libavutil/pixdesc.h"
 #include "libavutil/x86/cpu.h"
 #include "libavfilter/vf_overlay.h"
 
 int ff_overlay_row_44_sse4(uint8_t *d, uint8_t *da, uint8_t *s, uint8_t *a,
-                           int w, ptrdiff_t alinesize);
+                           int w, ptrdiff_t alinesize, ptrdiff_t dalinesize);
 
 int ff_overlay_row_20_sse4(uint8_t *d, uint8_t *da, uint8_t *s, uint8_t *a,
-                           int w, ptrdiff_t alinesize);
+                           int w, ptrdiff_t alinesize, ptrdiff_t dalinesize);
 
 int ff_overlay_row_22_sse4(uint8_t *d, uint8_t *da, uint8_t *s, uint8_t *a,
-                           int w, ptrdiff_t alinesize);
+                           int w, ptrdiff_t alinesize, ptrdiff_t dalinesize);
+
+#define OVERLAY_ROW_FUNC(name)                                                  \
+int ff_overlay_row_##name##_avx2(uint8_t *d, uint8_t *da, uint8_t *s, uint8_t *a, \
+                                 int w, ptrdiff_t alinesize, ptrdiff_t dalinesize)
+
+OVERLAY_ROW_FUNC(44);
+OVERLAY_ROW_FUNC(22);
+OVERLAY_ROW_FUNC(20);
+OVERLAY_ROW_FUNC(44_pm);
+OVERLAY_ROW_FUNC(22_pm);
+OVERLAY_ROW_FUNC(20_pm);
+OVERLAY_ROW_FUNC(44_pmuv);
+OVERLAY_ROW_FUNC(22_pmuv);
+OVERLAY_ROW_FUNC(20_pmuv);
+OVERLAY_ROW_FUNC(44_alpha);
+OVERLAY_ROW_FUNC(22_alpha);
+OVERLAY_ROW_FUNC(20_alpha);
+OVERLAY_ROW_FUNC(44_pm_alpha);
+OVERLAY_ROW_FUNC(22_pm_alpha);
+OVERLAY_ROW_FUNC(20_pm_alpha);
+OVERLAY_ROW_FUNC(44_pmuv_alpha);
+OVERLAY_ROW_FUNC(22_pmuv_alpha);
+OVERLAY_ROW_FUNC(20_pmuv_alpha);
+OVERLAY_ROW_FUNC(alpha);
+OVERLAY_ROW_FUNC(argb);
+OVERLAY_ROW_FUNC(rgba);
+OVERLAY_ROW_FUNC(argb_pm);
+OVERLAY_ROW_FUNC(rgba_pm);
+OVERLAY_ROW_FUNC(44_10);
+OVERLAY_ROW_FUNC(22_10);
+OVERLAY_ROW_FUNC(20_10);
+OVERLAY_ROW_FUNC(44_p010);
+OVERLAY_ROW_FUNC(20_p010);
+
+static av_cold void overlay_init_avx2(OverlayContext *s, int pix_format,
+                                      int alpha_format, int main_has_alpha)
+{
+    typedef int (*BlendRowFunc)(uint8_t *d, uint8_t *da, uint8_t *s, uint8_t *a,
+                                int w, ptrdiff_t alinesize, ptrdiff_t dalinesize);
+    static const BlendRowFunc rows_8[2][3][3] = {
+        {
+            { ff_overlay_row_44_avx2,      ff_overlay_row_22_avx2,      ff_overlay_row_20_avx2      },
+            { ff_overlay_row_44_pm_avx2,   ff_overlay_row_22_pm_avx2,   ff_overlay_row_20_pm_avx2   },
+            { ff_overlay_row_44_pmuv_avx2, ff_overlay_row_22_pmuv_avx2, ff_overlay_row_20_pmuv_avx2 },
+        }, {
+            { ff_overlay_row_44_alpha_avx2,      ff_overlay_row_22_alpha_avx2,      ff_overlay_row_20_alpha_avx2      },
+            { ff_overlay_row_44_pm_alpha_avx2,   ff_overlay_row_22_pm_alpha_avx2,   ff_overlay_row_20_pm_alpha_avx2   },
+            { ff_overlay_row_44_pmuv_alpha_avx2, ff_overlay_row_22_pmuv_alpha_avx2, ff_overlay_row_20_pmuv_alpha_avx2 },
+        },
+    };
+    static const BlendRowFunc rows_10[3] = {
+        ff_overlay_row_44_10_avx2, ff_overlay_row_22_10_avx2, ff_overlay_row_20_10_avx2,
+    };
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(pix_format);
+    const int yuv = !(desc->flags & AV_PIX_FMT_FLAG_RGB);
+    int i;
+
+    if (!(desc->flags & AV_PIX_FMT_FLAG_PLANAR) && !yuv) {
+        /* the C init only sets a row function if the layouts are compatible */
+        if (s->blend_row[0]) {
+            if (s->main_rgba_map[3] == 0)
+                s->blend_row[0] = alpha_format ? ff_overlay_row_argb_pm_avx2 : ff_overlay_row_argb_avx2;
+            else
+                s->blend_row[0] = alpha_format ? ff_overlay_row_rgba_pm_avx2 : ff_overlay_row_rgba_avx2;
+        }
+    } else if (desc->comp[0].depth == 8) {
+        for (i = 0; i < 3; i++) {
+            int hv   = i ? desc->log2_chroma_w + desc->log2_chroma_h : 0;
+            int mode = alpha_format ? 1 + (yuv && i) : 0;
+
+            /* interleaved chroma stays with the C version */
+            if (desc->comp[i].step == 1)
+                s->blend_row[i] = rows_8[main_has_alpha][mode][hv];
+        }
+        if (main_has_alpha)
+            s->blend_row[3] = ff_overlay_row_alpha_avx2;
+    } else if (!main_has_alpha) {
+        for (i = 0; i < 3; i++) {
+            int hv = i ? desc->log2_chroma_w + desc->log2_chroma_h : 0;
+
+            if (desc->comp[i].shift)
+                s->blend_row[i] = i ? ff_overlay_row_20_p010_avx2 : ff_overlay_row_44_p010_avx2;
+            else
+                s->blend_row[i] = rows_10[hv];
+        }
+    }
+}
 
 av_cold void ff_overlay_init_x86(OverlayContext *s, int format, int pix_format,
                                  int alpha_format, int main_has_alpha)
@@ -62,4 +150,7 @@ av_cold void ff_overlay_init_x86(OverlayContext *s, int format, int pix_format,
         s->blend_row[1] = ff_overlay_row_22_sse4;
         s->blend_row[2] = ff_overlay_row_22_sse4;
     }
+
+    if (ARCH_X86_64 && EXTERNAL_AVX2_FAST(cpu_flags))
+        overlay_init_avx2(s, pix_format, alpha_format, main_has_alpha);
 }
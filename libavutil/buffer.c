@@ -20,12 +20,37 @@
 #include <stdint.h>
 #include <string.h>
 
+#include "config.h"
+
+#if HAVE_LINUX_FRAME_MEM
+#include "compat/linux/frame_mem.h"
+#endif
+
 #include "avassert.h"
 #include "buffer_internal.h"
 #include "common.h"
 #include "mem.h"
 #include "thread.h"
 
+static void buffer_init(AVBuffer *buf, AVBufferRef *ref,
+                        uint8_t *data, size_t size,
+                        void (*free)(void *opaque, uint8_t *data),
+                        void *opaque, int flags)
+{
+    buf->data     = data;
+    buf->size     = size;
+    buf->free     = free ? free : av_buffer_default_free;
+    buf->opaque   = opaque;
+
+    atomic_init(&buf->refcount, 1);
+
+    buf->flags = flags;
+
+    ref->buffer = buf;
+    ref->data   = data;
+    ref->size   = size;
+}
+
 AVBufferRef *av_buffer_create(uint8_t *data, size_t size,
                               void (*free)(void *opaque, uint8_t *data),
                               void *opaque, int flags)
@@ -37,24 +62,13 @@ AVBufferRef *av_buffer_create(uint8_t *data, size_t size,
     if (!buf)
         return NULL;
 
-    buf->data     = data;
-    buf->size     = size;
-    buf->free     = free ? free : av_buffer_default_free;
-    buf->opaque   = opaque;
-
-    atomic_init(&buf->refcount, 1);
-
-    buf->flags = flags;
-
     ref = av_mallocz(sizeof(*ref));
     if (!ref) {
         av_freep(&buf);
         return NULL;
     }
 
-    ref->buffer = buf;
-    ref->data   = data;
-    ref->size   = size;
+    buffer_init(buf, ref, data, size, free, opaque, flags);
 
     return ref;
 }
@@ -104,6 +118,13 @@ AVBufferRef *av_buffer_ref(AVBufferRef *buf)
     return ret;
 }
 
+/* Whether ref is the AVBufferRef embedded in the pool entry owning b. */
+static int is_pool_entry_ref(const AVBuffer *b, const AVBufferRef *ref)
+{
+    return (b->flags_internal & BUFFER_FLAG_NO_FREE) &&
+           ref == &((BufferPoolEntry *)b->opaque)->ref;
+}
+
 static void buffer_replace(AVBufferRef **dst, AVBufferRef **src)
 {
     AVBuffer *b;
@@ -111,14 +132,25 @@ static void buffer_replace(AVBufferRef **dst, AVBufferRef **src)
     b = (*dst)->buffer;
 
     if (src) {
-        **dst = **src;
-        av_freep(src);
+        if (is_pool_entry_ref(b, *dst)) {
+            /* the embedded reference must not outlive its entry */
+            *dst = *src;
+            *src = NULL;
+        } else {
+            **dst = **src;
+            av_freep(src);
+        }
+    } else if (is_pool_entry_ref(b, *dst)) {
+        *dst = NULL;
     } else
         av_freep(dst);
 
     if (atomic_fetch_sub_explicit(&b->refcount, 1, memory_order_acq_rel) == 1) {
+        /* b->free() may recycle the structure b is part of */
+        int free_avbuffer = !(b->flags_internal & BUFFER_FLAG_NO_FREE);
         b->free(b->opaque, b->data);
-        av_freep(&b);
+        if (free_avbuffer)
+            av_free(b);
     }
 }
 
@@ -259,6 +291,8 @@ AVBufferPool *av_buffer_pool_init2(size_t size, void *opaque,
     pool->pool_free = pool_free;
 
     atomic_init(&pool->refcount, 1);
+    for (int i = 0; i < BUFFER_POOL_CACHE_SIZE; i++)
+        atomic_init(&pool->cache[i], 0);
 
     return pool;
 }
@@ -275,18 +309,81 @@ AVBufferPool *av_buffer_pool_init(size_t size, AVBufferRef* (*alloc)(size_t size
     pool->alloc    = alloc ? alloc : av_buffer_alloc;
 
     atomic_init(&pool->refcount, 1);
+    for (int i = 0; i < BUFFER_POOL_CACHE_SIZE; i++)
+        atomic_init(&pool->cache[i], 0);
 
     return pool;
 }
 
+/* Slot of the entry cache to start from. There is no portable thread-local
+ * storage, so hash the stack address to make different threads usually
+ * start from different slots. */
+static unsigned pool_cache_start(void)
+{
+    uintptr_t p = (uintptr_t)&p;
+    return ((uint32_t)(p >> 16) * 0x9E3779B1U) >> (32 - BUFFER_POOL_CACHE_BITS);
+}
+
+static BufferPoolEntry *pool_cache_get(AVBufferPool *pool)
+{
+    unsigned i, start = pool_cache_start();
+
+    for (i = 0; i < BUFFER_POOL_CACHE_SIZE; i++) {
+        atomic_intptr_t *slot = &pool->cache[(start + i) & (BUFFER_POOL_CACHE_SIZE - 1)];
+        intptr_t buf;
+
+        if (!atomic_load_explicit(slot, memory_order_relaxed))
+            continue;
+        buf = (intptr_t)atomic_exchange_explicit(slot, 0, memory_order_acquire);
+        if (buf)
+            return (BufferPoolEntry *)buf;
+    }
+
+    return NULL;
+}
+
+static int pool_cache_put(AVBufferPool *pool, BufferPoolEntry *buf)
+{
+    unsigned i, start = pool_cache_start();
+
+    for (i = 0; i < BUFFER_POOL_CACHE_SIZE; i++) {
+        atomic_intptr_t *slot = &pool->cache[(start + i) & (BUFFER_POOL_CACHE_SIZE - 1)];
+        intptr_t expected = 0;
+
+        if (atomic_load_explicit(slot, memory_order_relaxed))
+            continue;
+        if (atomic_compare_exchange_strong_explicit(slot, &expected, (intptr_t)buf,
+                                                    memory_order_release,
+                                                    memory_order_relaxed))
+            return 1;
+    }
+
+    return 0;
+}
+
+static void buffer_pool_free_entry(BufferPoolEntry *buf)
+{
+    buf->free(buf->opaque, buf->data);
+    av_free(buf);
+}
+
 static void buffer_pool_flush(AVBufferPool *pool)
 {
+    BufferPoolEntry *buf;
+    int i;
+
+    for (i = 0; i < BUFFER_POOL_CACHE_SIZE; i++) {
+        buf = (BufferPoolEntry *)(intptr_t)atomic_exchange_explicit(&pool->cache[i], 0,
+                                                                    memory_order_acquire);
+        if (buf)
+            buffer_pool_free_entry(buf);
+    }
+
     while (pool->pool) {
-        BufferPoolEntry *buf = pool->pool;
+        buf = pool->pool;
         pool->pool = buf->next;
 
-        buf->free(buf->opaque, buf->data);
-        av_freep(&buf);
+        buffer_pool_free_entry(buf);
     }
 }
 
@@ -330,10 +427,12 @@ static void pool_release_buffer(void *opaque, uint8_t *data)
     if(CONFIG_MEMORY_POISONING)
         memset(buf->data, FF_MEMORY_POISON, pool->size);
 
-    ff_mutex_lock(&pool->mutex);
-    buf->next = pool->pool;
-    pool->pool = buf;
-    ff_mutex_unlock(&pool->mutex);
+    if (!pool_cache_put(pool, buf)) {
+        ff_mutex_lock(&pool->mutex);
+        buf->next = pool->pool;
+        pool->pool = buf;
+        ff_mutex_unlock(&pool->mutex);
+    }
 
     if (atomic_fetch_sub_explicit(&pool->refcount, 1, memory_order_acq_rel) == 1)
         buffer_pool_free(pool);
@@ -372,22 +471,31 @@ static AVBufferRef *pool_alloc_buffer(AVBufferPool *pool)
 
 AVBufferRef *av_buffer_pool_get(AVBufferPool *pool)
 {
-    AVBufferRef *ret;
+    AVBufferRef *ret = NULL;
     BufferPoolEntry *buf;
 
-    ff_mutex_lock(&pool->mutex);
-    buf = pool->pool;
-    if (buf) {
-        ret = av_buffer_create(buf->data, pool->size, pool_release_buffer,
-                               buf, 0);
-        if (ret) {
+    buf = pool_cache_get(pool);
+    if (!buf) {
+        ff_mutex_lock(&pool->mutex);
+        buf = pool->pool;
+        if (buf) {
             pool->pool = buf->next;
             buf->next = NULL;
+        } else {
+            ret = pool_alloc_buffer(pool);
         }
-    } else {
-        ret = pool_alloc_buffer(pool);
+        ff_mutex_unlock(&pool->mutex);
+    }
+
+    if (buf) {
+        /* reuse the wrappers embedded in the entry, so that getting a
+         * recycled buffer never allocates */
+        memset(&buf->buffer, 0, sizeof(buf->buffer));
+        buffer_init(&buf->buffer, &buf->ref, buf->data, pool->size,
+                    pool_release_buffer, buf, 0);
+        buf->buffer.flags_internal = BUFFER_FLAG_NO_FREE;
+        ret = &buf->ref;
     }
-    ff_mutex_unlock(&pool->mutex);
 
     if (ret)
         atomic_fetch_add_explicit(&pool->refcount, 1, memory_order_relaxed);
@@ -401,3 +509,117 @@ void *av_buffer_pool_buffer_get_opaque(AVBufferRef *ref)
     av_assert0(buf);
     return buf->opaque;
 }
+
+/* smaller buffers are not worth a mapping of their own just for NUMA binding */
+#define FRAME_MMAP_MIN_SIZE  (256 * 1024)
+#define FRAME_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+static atomic_int frame_flags = ATOMIC_VAR_INIT(0);
+
+static struct {
+    atomic_size_t nb_allocs;
+    atomic_size_t nb_hugetlb;
+    atomic_size_t nb_hugetlb_failed;
+    atomic_size_t nb_hugepages;
+    atomic_size_t nb_numa_bound;
+    atomic_size_t nb_fallback;
+    atomic_size_t bytes_mapped;
+} frame_stats;
+
+#define FRAME_STATS_ADD(field, n) \
+    atomic_fetch_add_explicit(&frame_stats.field, n, memory_order_relaxed)
+
+void av_buffer_frame_set_flags(int flags)
+{
+    atomic_store_explicit(&frame_flags, flags, memory_order_relaxed);
+}
+
+int av_buffer_frame_get_flags(void)
+{
+    return atomic_load_explicit(&frame_flags, memory_order_relaxed);
+}
+
+AVBufferFrameStats *av_buffer_frame_get_stats(void)
+{
+    AVBufferFrameStats *stats = av_mallocz(sizeof(*stats));
+
+    if (!stats)
+        return NULL;
+
+#define GET(field) \
+    stats->field = atomic_load_explicit(&frame_stats.field, memory_order_relaxed)
+    GET(nb_allocs);
+    GET(nb_hugetlb);
+    GET(nb_hugetlb_failed);
+    GET(nb_hugepages);
+    GET(nb_numa_bound);
+    GET(nb_fallback);
+    GET(bytes_mapped);
+#undef GET
+
+    return stats;
+}
+
+#if HAVE_LINUX_FRAME_MEM
+static void frame_unmap(void *opaque, uint8_t *data)
+{
+    size_t len = (uintptr_t)opaque;
+
+    ff_linux_frame_unmap(data, len);
+    atomic_fetch_sub_explicit(&frame_stats.bytes_mapped, len, memory_order_relaxed);
+}
+#endif
+
+static AVBufferRef *frame_pool_alloc(void *opaque, size_t size)
+{
+    av_unused int flags = av_buffer_frame_get_flags();
+    av_unused int node  = (intptr_t)opaque - 1;
+
+    FRAME_STATS_ADD(nb_allocs, 1);
+
+#if HAVE_LINUX_FRAME_MEM
+    if ((flags & (AV_BUFFER_FRAME_FLAG_HUGEPAGES | AV_BUFFER_FRAME_FLAG_HUGETLB) &&
+         size >= FRAME_HUGE_PAGE_SIZE) ||
+        (node >= 0 && size >= FRAME_MMAP_MIN_SIZE)) {
+        const int huge = size >= FRAME_HUGE_PAGE_SIZE;
+        size_t mapped;
+        int result;
+        uint8_t *data = ff_linux_frame_map(size, huge && flags & AV_BUFFER_FRAME_FLAG_HUGETLB,
+                                           huge && flags & AV_BUFFER_FRAME_FLAG_HUGEPAGES ?
+                                           FRAME_HUGE_PAGE_SIZE : 0,
+                                           node, &mapped, &result);
+
+        FRAME_STATS_ADD(nb_hugetlb,        !!(result & FF_LINUX_FRAME_HUGETLB));
+        FRAME_STATS_ADD(nb_hugetlb_failed, !!(result & FF_LINUX_FRAME_HUGETLB_FAILED));
+        FRAME_STATS_ADD(nb_hugepages,      !!(result & FF_LINUX_FRAME_HUGEPAGES));
+        FRAME_STATS_ADD(nb_numa_bound,     !!(result & FF_LINUX_FRAME_NUMA_BOUND));
+
+        if (data) {
+            /* fresh anonymous mappings are already zeroed */
+            AVBufferRef *ret = av_buffer_create(data, size, frame_unmap,
+                                                (void *)(uintptr_t)mapped, 0);
+            if (ret) {
+                FRAME_STATS_ADD(bytes_mapped, mapped);
+                return ret;
+            }
+            ff_linux_frame_unmap(data, mapped);
+        }
+    }
+#endif
+
+    FRAME_STATS_ADD(nb_fallback, 1);
+    return av_buffer_allocz(size);
+}
+
+AVBufferPool *av_buffer_pool_init_frame(size_t size)
+{
+    int node = -1;
+
+#if HAVE_LINUX_FRAME_MEM
+    if (av_buffer_frame_get_flags() & AV_BUFFER_FRAME_FLAG_NUMA)
+        node = ff_linux_numa_node();
+#endif
+
+    return av_buffer_pool_init2(size, (void *)(intptr_t)(node + 1),
+                                frame_pool_alloc, NULL);
+}
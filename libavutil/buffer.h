@@ -286,6 +286,80 @@ AVBufferPool *av_buffer_pool_init2(size_t size, void *opaque,
                                    AVBufferRef* (*alloc)(void *opaque, size_t size),
                                    void (*pool_free)(void *opaque));
 
+/**
+ * @defgroup lavu_buffer_frame Frame buffer allocation
+ * Large, long-lived buffers such as video frame planes can be backed by huge
+ * pages and kept on one NUMA node, to reduce TLB misses and cross-node
+ * traffic. This is controlled globally by the AV_BUFFER_FRAME_FLAG_* flags,
+ * which are all disabled by default, and applies to pools created with
+ * av_buffer_pool_init_frame(). Buffers smaller than a few hundred KiB, and
+ * all buffers on systems without the required support, are allocated with
+ * av_malloc() as usual.
+ * @{
+ */
+
+/**
+ * Back large buffers with transparent huge pages (madvise(MADV_HUGEPAGE)).
+ */
+#define AV_BUFFER_FRAME_FLAG_HUGEPAGES (1 << 0)
+/**
+ * Try explicit huge pages (MAP_HUGETLB) first. These must have been reserved
+ * by the administrator.
+ */
+#define AV_BUFFER_FRAME_FLAG_HUGETLB   (1 << 1)
+/**
+ * Bind the buffers of each pool to the NUMA node of the thread that created
+ * the pool, instead of the node of whichever thread first touches them.
+ */
+#define AV_BUFFER_FRAME_FLAG_NUMA      (1 << 2)
+
+/**
+ * Set the AV_BUFFER_FRAME_FLAG_* flags used for buffers allocated from now on.
+ */
+void av_buffer_frame_set_flags(int flags);
+
+/**
+ * @return the current AV_BUFFER_FRAME_FLAG_* flags
+ */
+int av_buffer_frame_get_flags(void);
+
+/**
+ * Usage statistics of the frame buffer allocator, accumulated over the whole
+ * process. sizeof(AVBufferFrameStats) is not part of the ABI, new fields may
+ * be added to the end with a minor version bump.
+ */
+typedef struct AVBufferFrameStats {
+    uint64_t nb_allocs;         ///< buffers allocated for frame pools
+    uint64_t nb_hugetlb;        ///< of which backed by explicit huge pages
+    uint64_t nb_hugetlb_failed; ///< explicit huge page mappings that failed
+    uint64_t nb_hugepages;      ///< of which mapped for transparent huge pages
+    uint64_t nb_numa_bound;     ///< of which bound to a NUMA node
+    uint64_t nb_fallback;       ///< of which allocated with av_malloc()
+    uint64_t bytes_mapped;      ///< bytes currently mapped by the allocator
+} AVBufferFrameStats;
+
+/**
+ * Get the statistics of the frame buffer allocator.
+ *
+ * @return a snapshot of the statistics, to be freed with av_free(), or NULL
+ *         on allocation failure
+ */
+AVBufferFrameStats *av_buffer_frame_get_stats(void);
+
+/**
+ * Allocate and initialize a buffer pool of frame-sized buffers, using the
+ * frame buffer allocator. The buffers are zero-initialized when they are
+ * first allocated.
+ *
+ * @param size size of each buffer in this pool
+ * @return newly created buffer pool on success, NULL on error.
+ */
+AVBufferPool *av_buffer_pool_init_frame(size_t size);
+
+/**
+ * @}
+ */
+
 /**
  * Mark the pool as being available for freeing. It will actually be freed only
  * once all the allocated buffers associated with the pool are released. Thus it
@@ -30,6 +30,11 @@
  * The buffer was av_realloc()ed, so it is reallocatable.
  */
 #define BUFFER_FLAG_REALLOCATABLE (1 << 0)
+/**
+ * The AVBuffer structure is part of a larger structure
+ * and should not be freed.
+ */
+#define BUFFER_FLAG_NO_FREE       (1 << 1)
 
 struct AVBuffer {
     uint8_t *data; /**< data described by this buffer */
@@ -73,12 +78,29 @@ typedef struct BufferPoolEntry {
 
     AVBufferPool *pool;
     struct BufferPoolEntry *next;
+
+    /*
+     * Used when the entry is handed out again, so that recycling a buffer
+     * does not need any allocation.
+     */
+    AVBuffer buffer;
+    AVBufferRef ref;
 } BufferPoolEntry;
 
+#define BUFFER_POOL_CACHE_BITS 4
+#define BUFFER_POOL_CACHE_SIZE (1 << BUFFER_POOL_CACHE_BITS)
+
 struct AVBufferPool {
     AVMutex mutex;
     BufferPoolEntry *pool;
 
+    /*
+     * Lock-free cache of released entries, tried before the list above.
+     * Each slot is either 0 or owns one entry, and entries only ever move
+     * in and out of a slot with a single atomic operation.
+     */
+    atomic_intptr_t cache[BUFFER_POOL_CACHE_SIZE];
+
     /*
      * This is used to track when the pool is to be freed.
      * The pointer to the pool itself held by the caller is considered to
@@ -18,6 +18,7 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include <stdint.h>
 #include <string.h>
 
 #include "avstring.h"
@@ -27,9 +28,26 @@
 #include "time_internal.h"
 #include "bprint.h"
 
+/* below this many entries a linear scan is faster than hashing the key */
+#define DICT_INDEX_MIN 8
+
+typedef struct DictEntryInfo {
+    uint32_t hash;      ///< case-insensitive hash of the key
+    size_t value_size;  ///< allocated size of the value
+} DictEntryInfo;
+
 struct AVDictionary {
     int count;
     AVDictionaryEntry *elems;
+    DictEntryInfo *info;
+    int nb_alloc;       ///< allocated size of elems and info
+
+    /**
+     * Open-addressing hash table over elems, storing element index + 1
+     * and 0 for free slots. Only present for larger dictionaries.
+     */
+    int *index;
+    int index_size;     ///< power of 2, 0 without an index
 };
 
 int av_dict_count(const AVDictionary *m)
@@ -37,10 +55,37 @@ int av_dict_count(const AVDictionary *m)
     return m ? m->count : 0;
 }
 
+static uint32_t dict_hash(const char *key)
+{
+    uint32_t hash = 2166136261U;
+
+    while (*key)
+        hash = (hash ^ av_toupper(*key++)) * 16777619U;
+
+    return hash;
+}
+
+static int dict_match(const char *s, const char *key, int flags)
+{
+    unsigned int j;
+
+    if (flags & AV_DICT_MATCH_CASE)
+        for (j = 0; s[j] == key[j] && key[j]; j++)
+            ;
+    else
+        for (j = 0; av_toupper(s[j]) == av_toupper(key[j]) && key[j]; j++)
+            ;
+    if (key[j])
+        return 0;
+    if (s[j] && !(flags & AV_DICT_IGNORE_SUFFIX))
+        return 0;
+    return 1;
+}
+
 AVDictionaryEntry *av_dict_get(const AVDictionary *m, const char *key,
                                const AVDictionaryEntry *prev, int flags)
 {
-    unsigned int i, j;
+    unsigned int i;
 
     if (!m)
         return NULL;
@@ -50,41 +95,179 @@ AVDictionaryEntry *av_dict_get(const AVDictionary *m, const char *key,
     else
         i = 0;
 
+    if (m->index_size && !(flags & AV_DICT_IGNORE_SUFFIX)) {
+        const uint32_t hash = dict_hash(key);
+        const unsigned mask = m->index_size - 1;
+        unsigned slot, best = m->count;
+
+        /* the first match after prev in insertion order wins */
+        for (slot = hash & mask; m->index[slot]; slot = (slot + 1) & mask) {
+            unsigned idx = m->index[slot] - 1;
+            if (idx < i || idx >= best || m->info[idx].hash != hash)
+                continue;
+            if (dict_match(m->elems[idx].key, key, flags))
+                best = idx;
+        }
+        return best < m->count ? &m->elems[best] : NULL;
+    }
+
     for (; i < m->count; i++) {
-        const char *s = m->elems[i].key;
-        if (flags & AV_DICT_MATCH_CASE)
-            for (j = 0; s[j] == key[j] && key[j]; j++)
-                ;
-        else
-            for (j = 0; av_toupper(s[j]) == av_toupper(key[j]) && key[j]; j++)
-                ;
-        if (key[j])
-            continue;
-        if (s[j] && !(flags & AV_DICT_IGNORE_SUFFIX))
-            continue;
-        return &m->elems[i];
+        if (dict_match(m->elems[i].key, key, flags))
+            return &m->elems[i];
     }
     return NULL;
 }
 
+static void dict_index_insert(AVDictionary *m, int idx)
+{
+    const unsigned mask = m->index_size - 1;
+    unsigned slot = m->info[idx].hash & mask;
+
+    while (m->index[slot])
+        slot = (slot + 1) & mask;
+    m->index[slot] = idx + 1;
+}
+
+static unsigned dict_index_find(const AVDictionary *m, int idx)
+{
+    const unsigned mask = m->index_size - 1;
+    unsigned slot = m->info[idx].hash & mask;
+
+    while (m->index[slot] != idx + 1)
+        slot = (slot + 1) & mask;
+    return slot;
+}
+
+static void dict_index_remove(AVDictionary *m, int idx)
+{
+    const unsigned mask = m->index_size - 1;
+    unsigned hole = dict_index_find(m, idx), slot = hole;
+
+    /* backward shift deletion, so lookups never need tombstones */
+    for (;;) {
+        unsigned home;
+
+        slot = (slot + 1) & mask;
+        if (!m->index[slot])
+            break;
+        home = m->info[m->index[slot] - 1].hash & mask;
+        if (hole <= slot ? (hole < home && home <= slot)
+                         : (hole < home || home <= slot))
+            continue;
+        m->index[hole] = m->index[slot];
+        hole = slot;
+    }
+    m->index[hole] = 0;
+}
+
+/* Account for the element just added at the end in the index, building or
+ * growing it as needed. Lookups fall back to a linear scan without one. */
+static void dict_index_add(AVDictionary *m)
+{
+    int i, size = 16;
+    int *index;
+
+    if (!m->index_size && m->count < DICT_INDEX_MIN)
+        return;
+
+    if (m->index_size && m->count * 4 <= m->index_size * 3) {
+        dict_index_insert(m, m->count - 1);
+        return;
+    }
+
+    while (size < 2 * m->count)
+        size <<= 1;
+    index = av_calloc(size, sizeof(*index));
+    av_freep(&m->index);
+    m->index_size = 0;
+    if (!index)
+        return;
+
+    m->index      = index;
+    m->index_size = size;
+    for (i = 0; i < m->count; i++)
+        dict_index_insert(m, i);
+}
+
+/* Remove an element by moving the last one into its place. */
+static void dict_remove(AVDictionary *m, int idx)
+{
+    const int last = --m->count;
+
+    if (m->index_size) {
+        dict_index_remove(m, idx);
+        if (idx != last)
+            m->index[dict_index_find(m, last)] = idx + 1;
+    }
+    m->elems[idx] = m->elems[last];
+    m->info[idx]  = m->info[last];
+}
+
+static int dict_reserve(AVDictionary *m, int count)
+{
+    void *tmp;
+    int nb_alloc;
+
+    if (count <= m->nb_alloc)
+        return 0;
+
+    nb_alloc = FFMAX3(count, 2 * m->nb_alloc, 4);
+    tmp = av_realloc_array(m->elems, nb_alloc, sizeof(*m->elems));
+    if (!tmp)
+        return AVERROR(ENOMEM);
+    m->elems = tmp;
+    tmp = av_realloc_array(m->info, nb_alloc, sizeof(*m->info));
+    if (!tmp)
+        return AVERROR(ENOMEM);
+    m->info     = tmp;
+    m->nb_alloc = nb_alloc;
+
+    return 0;
+}
+
+static void dict_free_storage(AVDictionary *m)
+{
+    av_freep(&m->elems);
+    av_freep(&m->info);
+    av_freep(&m->index);
+}
+
 int av_dict_set(AVDictionary **pm, const char *key, const char *value,
                 int flags)
 {
     AVDictionary *m = *pm;
     AVDictionaryEntry *tag = NULL;
     char *oldval = NULL, *copy_key = NULL, *copy_value = NULL;
+    int reuse_key = 0, reuse_value = 0;
+    size_t value_size = 0;
 
     if (!(flags & AV_DICT_MULTIKEY)) {
         tag = av_dict_get(m, key, NULL, flags);
     }
+    /* an overwritten entry keeps its strings where possible, so that
+     * updating a key does not allocate */
+    if (tag && !(flags & (AV_DICT_DONT_OVERWRITE | AV_DICT_APPEND)) && value) {
+        if (!(flags & AV_DICT_DONT_STRDUP_KEY))
+            reuse_key = !strcmp(tag->key, key);
+        if (!(flags & AV_DICT_DONT_STRDUP_VAL))
+            reuse_value = strlen(value) < m->info[tag - m->elems].value_size;
+    }
     if (flags & AV_DICT_DONT_STRDUP_KEY)
         copy_key = (void *)key;
+    else if (reuse_key)
+        copy_key = tag->key;
     else
         copy_key = av_strdup(key);
-    if (flags & AV_DICT_DONT_STRDUP_VAL)
+    if (flags & AV_DICT_DONT_STRDUP_VAL) {
         copy_value = (void *)value;
-    else if (copy_key)
+        value_size = value ? strlen(value) + 1 : 0;
+    } else if (reuse_value) {
+        copy_value = tag->value;
+        value_size = m->info[tag - m->elems].value_size;
+    } else if (copy_key) {
         copy_value = av_strdup(value);
+        value_size = value ? strlen(value) + 1 : 0;
+    }
     if (!m)
         m = *pm = av_mallocz(sizeof(*m));
     if (!m || (key && !copy_key) || (value && !copy_value))
@@ -98,16 +281,16 @@ int av_dict_set(AVDictionary **pm, const char *key, const char *value,
         }
         if (flags & AV_DICT_APPEND)
             oldval = tag->value;
+        else if (reuse_value)
+            memmove(tag->value, value, strlen(value) + 1);
         else
             av_free(tag->value);
-        av_free(tag->key);
-        *tag = m->elems[--m->count];
+        if (!reuse_key)
+            av_free(tag->key);
+        dict_remove(m, tag - m->elems);
     } else if (copy_value) {
-        AVDictionaryEntry *tmp = av_realloc_array(m->elems,
-                                                  m->count + 1, sizeof(*m->elems));
-        if (!tmp)
+        if (dict_reserve(m, m->count + 1) < 0)
             goto err_out;
-        m->elems = tmp;
     }
     if (copy_value) {
         m->elems[m->count].key = copy_key;
@@ -122,13 +305,17 @@ int av_dict_set(AVDictionary **pm, const char *key, const char *value,
             av_strlcat(newval, copy_value, len);
             m->elems[m->count].value = newval;
             av_freep(&copy_value);
+            value_size = len;
         }
+        m->info[m->count].hash       = dict_hash(copy_key);
+        m->info[m->count].value_size = value_size;
         m->count++;
+        dict_index_add(m);
     } else {
         av_freep(&copy_key);
     }
     if (!m->count) {
-        av_freep(&m->elems);
+        dict_free_storage(m);
         av_freep(pm);
     }
 
@@ -136,11 +323,13 @@ int av_dict_set(AVDictionary **pm, const char *key, const char *value,
 
 err_out:
     if (m && !m->count) {
-        av_freep(&m->elems);
+        dict_free_storage(m);
         av_freep(pm);
     }
-    av_free(copy_key);
-    av_free(copy_value);
+    if (!reuse_key)
+        av_free(copy_key);
+    if (!reuse_value)
+        av_free(copy_value);
     return AVERROR(ENOMEM);
 }
 
@@ -209,7 +398,7 @@ void av_dict_free(AVDictionary **pm)
             av_freep(&m->elems[m->count].key);
             av_freep(&m->elems[m->count].value);
         }
-        av_freep(&m->elems);
+        dict_free_storage(m);
     }
     av_freep(pm);
 }
@@ -218,6 +407,10 @@ int av_dict_copy(AVDictionary **dst, const AVDictionary *src, int flags)
 {
     AVDictionaryEntry *t = NULL;
 
+    /* size the destination once instead of growing it entry by entry */
+    if (src && *dst)
+        dict_reserve(*dst, (*dst)->count + src->count);
+
     while ((t = av_dict_get(src, "", t, AV_DICT_IGNORE_SUFFIX))) {
         int ret = av_dict_set(dst, t->key, t->value, flags);
         if (ret < 0)
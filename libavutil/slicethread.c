@@ -48,8 +48,30 @@ struct AVSliceThread {
     void            *priv;
     void            (*worker_func)(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads);
     void            (*main_func)(void *priv);
+
+    /* shared pool state, protected by SharedPool.mutex */
+    int             shared;
+    int             priority;
+    int             queued;
+    int             nb_joined;
+    int             nb_left;
+    AVSliceThread   *next;
 };
 
+typedef struct SharedPool {
+    pthread_t       *threads;
+    int             nb_threads;
+    int             refcount;
+    int             finished;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t  cond;
+    AVSliceThread   *queue[AVPRIV_SLICETHREAD_PRIORITY_NB];
+} SharedPool;
+
+static AVMutex pool_lock = AV_MUTEX_INITIALIZER;
+static SharedPool pool;
+
 static int run_jobs(AVSliceThread *ctx)
 {
     unsigned nb_jobs    = ctx->nb_jobs;
@@ -91,6 +113,168 @@ static void *attribute_align_arg thread_worker(void *v)
     }
 }
 
+static void shared_enqueue(AVSliceThread *ctx)
+{
+    AVSliceThread **p = &pool.queue[ctx->priority];
+
+    while (*p)
+        p = &(*p)->next;
+    *p          = ctx;
+    ctx->next   = NULL;
+    ctx->queued = 1;
+}
+
+static void shared_dequeue(AVSliceThread *ctx)
+{
+    AVSliceThread **p = &pool.queue[ctx->priority];
+
+    while (*p != ctx)
+        p = &(*p)->next;
+    *p          = ctx->next;
+    ctx->queued = 0;
+}
+
+/* find an execution with jobs left and claim a thread number in it */
+static AVSliceThread *shared_join(int *threadnr)
+{
+    int i;
+
+    for (i = AVPRIV_SLICETHREAD_PRIORITY_NB - 1; i >= 0; i--) {
+        AVSliceThread *ctx = pool.queue[i];
+
+        while (ctx) {
+            AVSliceThread *next = ctx->next;
+
+            if (atomic_load_explicit(&ctx->current_job, memory_order_relaxed) >= ctx->nb_jobs) {
+                shared_dequeue(ctx);
+            } else {
+                *threadnr = ctx->nb_joined++;
+                if (ctx->nb_joined == ctx->nb_active_threads)
+                    shared_dequeue(ctx);
+                return ctx;
+            }
+            ctx = next;
+        }
+    }
+    return NULL;
+}
+
+static void shared_run_jobs(AVSliceThread *ctx, unsigned jobnr, int threadnr)
+{
+    unsigned nb_jobs = ctx->nb_jobs;
+
+    while (jobnr < nb_jobs) {
+        ctx->worker_func(ctx->priv, jobnr, threadnr, nb_jobs, ctx->nb_active_threads);
+        jobnr = atomic_fetch_add_explicit(&ctx->current_job, 1, memory_order_acq_rel);
+    }
+}
+
+static void *attribute_align_arg shared_worker(void *v)
+{
+    pthread_mutex_lock(&pool.mutex);
+    while (!pool.finished) {
+        AVSliceThread *ctx;
+        int threadnr;
+
+        if (!(ctx = shared_join(&threadnr))) {
+            pthread_cond_wait(&pool.cond, &pool.mutex);
+            continue;
+        }
+        pthread_mutex_unlock(&pool.mutex);
+
+        shared_run_jobs(ctx, atomic_fetch_add_explicit(&ctx->current_job, 1, memory_order_acq_rel),
+                        threadnr);
+
+        pthread_mutex_lock(&pool.mutex);
+        if (++ctx->nb_left == ctx->nb_joined && !ctx->queued)
+            pthread_cond_signal(&ctx->done_cond);
+    }
+    pthread_mutex_unlock(&pool.mutex);
+    return NULL;
+}
+
+static int shared_pool_ref(void)
+{
+    int nb_workers, i;
+
+    ff_mutex_lock(&pool_lock);
+    if (pool.refcount++) {
+        ff_mutex_unlock(&pool_lock);
+        return pool.nb_threads;
+    }
+
+    pthread_mutex_init(&pool.mutex, NULL);
+    pthread_cond_init(&pool.cond, NULL);
+    pool.finished   = 0;
+    pool.nb_threads = 0;
+
+    nb_workers   = av_cpu_count() - 1;
+    pool.threads = nb_workers > 0 ? av_calloc(nb_workers, sizeof(*pool.threads)) : NULL;
+    for (i = 0; pool.threads && i < nb_workers; i++) {
+        if (pthread_create(&pool.threads[i], NULL, shared_worker, NULL))
+            break;
+        pool.nb_threads++;
+    }
+    ff_mutex_unlock(&pool_lock);
+
+    return pool.nb_threads;
+}
+
+static void shared_pool_unref(void)
+{
+    int i;
+
+    ff_mutex_lock(&pool_lock);
+    if (--pool.refcount) {
+        ff_mutex_unlock(&pool_lock);
+        return;
+    }
+
+    pthread_mutex_lock(&pool.mutex);
+    pool.finished = 1;
+    pthread_cond_broadcast(&pool.cond);
+    pthread_mutex_unlock(&pool.mutex);
+
+    for (i = 0; i < pool.nb_threads; i++)
+        pthread_join(pool.threads[i], NULL);
+    av_freep(&pool.threads);
+    pool.nb_threads = 0;
+
+    pthread_cond_destroy(&pool.cond);
+    pthread_mutex_destroy(&pool.mutex);
+    ff_mutex_unlock(&pool_lock);
+}
+
+static void shared_execute(AVSliceThread *ctx, int nb_jobs)
+{
+    int i;
+
+    ctx->nb_jobs           = nb_jobs;
+    ctx->nb_active_threads = FFMIN(nb_jobs, ctx->nb_threads);
+    atomic_store_explicit(&ctx->current_job, 1, memory_order_relaxed);
+
+    pthread_mutex_lock(&pool.mutex);
+    /* thread number 0 and the first job are reserved for the caller */
+    ctx->nb_joined = 1;
+    ctx->nb_left   = 0;
+    if (ctx->nb_active_threads > 1) {
+        shared_enqueue(ctx);
+        for (i = 1; i < ctx->nb_active_threads; i++)
+            pthread_cond_signal(&pool.cond);
+    }
+    pthread_mutex_unlock(&pool.mutex);
+
+    shared_run_jobs(ctx, 0, 0);
+
+    pthread_mutex_lock(&pool.mutex);
+    if (ctx->queued)
+        shared_dequeue(ctx);
+    ctx->nb_left++;
+    while (ctx->nb_left < ctx->nb_joined)
+        pthread_cond_wait(&ctx->done_cond, &pool.mutex);
+    pthread_mutex_unlock(&pool.mutex);
+}
+
 int avpriv_slicethread_create(AVSliceThread **pctx, void *priv,
                               void (*worker_func)(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads),
                               void (*main_func)(void *priv),
@@ -161,11 +345,47 @@ int avpriv_slicethread_create(AVSliceThread **pctx, void *priv,
     return nb_threads;
 }
 
+int avpriv_slicethread_create_shared(AVSliceThread **pctx, void *priv,
+                                     void (*worker_func)(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads),
+                                     int nb_threads, int priority)
+{
+    AVSliceThread *ctx;
+    int max_threads;
+
+    av_assert0(nb_threads >= 0);
+    av_assert0(priority >= 0 && priority < AVPRIV_SLICETHREAD_PRIORITY_NB);
+
+    *pctx = ctx = av_mallocz(sizeof(*ctx));
+    if (!ctx)
+        return AVERROR(ENOMEM);
+
+    max_threads = shared_pool_ref() + 1;
+    if (!nb_threads)
+        nb_threads = max_threads;
+
+    ctx->priv        = priv;
+    ctx->worker_func = worker_func;
+    ctx->nb_threads  = nb_threads;
+    ctx->shared      = 1;
+    ctx->priority    = priority;
+
+    atomic_init(&ctx->first_job, 0);
+    atomic_init(&ctx->current_job, 0);
+    pthread_cond_init(&ctx->done_cond, NULL);
+
+    return nb_threads;
+}
+
 void avpriv_slicethread_execute(AVSliceThread *ctx, int nb_jobs, int execute_main)
 {
     int nb_workers, i, is_last = 0;
 
     av_assert0(nb_jobs > 0);
+    if (ctx->shared) {
+        shared_execute(ctx, nb_jobs);
+        return;
+    }
+
     ctx->nb_jobs           = nb_jobs;
     ctx->nb_active_threads = FFMIN(nb_jobs, ctx->nb_threads);
     atomic_store_explicit(&ctx->first_job, 0, memory_order_relaxed);
@@ -205,6 +425,13 @@ void avpriv_slicethread_free(AVSliceThread **pctx)
         return;
 
     ctx = *pctx;
+    if (ctx->shared) {
+        pthread_cond_destroy(&ctx->done_cond);
+        av_freep(pctx);
+        shared_pool_unref();
+        return;
+    }
+
     nb_workers = ctx->nb_threads;
     if (!ctx->main_func)
         nb_workers--;
@@ -242,6 +469,14 @@ int avpriv_slicethread_create(AVSliceThread **pctx, void *priv,
     return AVERROR(EINVAL);
 }
 
+int avpriv_slicethread_create_shared(AVSliceThread **pctx, void *priv,
+                                     void (*worker_func)(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads),
+                                     int nb_threads, int priority)
+{
+    *pctx = NULL;
+    return AVERROR(EINVAL);
+}
+
 void avpriv_slicethread_execute(AVSliceThread *ctx, int nb_jobs, int execute_main)
 {
     av_assert0(0);
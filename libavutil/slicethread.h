@@ -21,6 +21,16 @@
 
 typedef struct AVSliceThread AVSliceThread;
 
+/**
+ * Priority classes of contexts sharing the process-wide worker pool.
+ */
+enum {
+    AVPRIV_SLICETHREAD_PRIORITY_LOW,
+    AVPRIV_SLICETHREAD_PRIORITY_NORMAL,
+    AVPRIV_SLICETHREAD_PRIORITY_HIGH,
+    AVPRIV_SLICETHREAD_PRIORITY_NB,
+};
+
 /**
  * Create slice threading context.
  * @param pctx slice threading context returned here
@@ -35,6 +45,28 @@ int avpriv_slicethread_create(AVSliceThread **pctx, void *priv,
                               void (*main_func)(void *priv),
                               int nb_threads);
 
+/**
+ * Create slice threading context running its jobs on the worker pool shared
+ * by the whole process instead of on threads of its own.
+ * The pool is started with the first shared context and has one worker less
+ * than there are CPUs, as the thread calling avpriv_slicethread_execute()
+ * always runs jobs too. Idle workers serve pending executions of a higher
+ * priority first.
+ * Jobs are started in ascending order but may not all run at the same time,
+ * so a job must only wait for jobs with a lower number. The first job is
+ * always run by the calling thread as thread number 0.
+ * @param pctx slice threading context returned here
+ * @param priv private pointer to be passed to callback function
+ * @param worker_func callback function to be executed
+ * @param nb_threads maximum number of jobs run at once, 0 for automatic, must be >= 0;
+ *                   a nonzero value is kept even if the pool has fewer workers
+ * @param priority one of AVPRIV_SLICETHREAD_PRIORITY_*
+ * @return return number of threads or negative AVERROR on failure
+ */
+int avpriv_slicethread_create_shared(AVSliceThread **pctx, void *priv,
+                                     void (*worker_func)(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads),
+                                     int nb_threads, int priority);
+
 /**
  * Execute slice threading.
  * @param ctx slice threading context
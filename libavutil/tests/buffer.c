@@ -0,0 +1,118 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libavutil/buffer.h"
+#include "libavutil/mem.h"
+
+#define NB_BUFFERS 40
+
+static int nb_allocs;
+
+static AVBufferRef *counting_alloc(size_t size)
+{
+    nb_allocs++;
+    return av_buffer_alloc(size);
+}
+
+int main(void)
+{
+    AVBufferPool *pool = av_buffer_pool_init(64, counting_alloc);
+    AVBufferRef *bufs[NB_BUFFERS], *ref, *ref2;
+    uint8_t *data;
+    int i, reused = 0;
+
+    /* more buffers than the lock-free cache holds */
+    for (i = 0; i < NB_BUFFERS; i++) {
+        bufs[i] = av_buffer_pool_get(pool);
+        memset(bufs[i]->data, i, 64);
+    }
+    printf("allocations after first pass: %d\n", nb_allocs);
+    for (i = 0; i < NB_BUFFERS; i++)
+        av_buffer_unref(&bufs[i]);
+
+    for (i = 0; i < NB_BUFFERS; i++)
+        bufs[i] = av_buffer_pool_get(pool);
+    printf("allocations after second pass: %d\n", nb_allocs);
+    for (i = 0; i < NB_BUFFERS; i++) {
+        printf("%d size %d writable %d\n", i, (int)bufs[i]->size,
+               av_buffer_is_writable(bufs[i]));
+        av_buffer_unref(&bufs[i]);
+    }
+
+    /* a recycled buffer is handed out with the same wrapper */
+    ref  = av_buffer_pool_get(pool);
+    data = ref->data;
+    av_buffer_unref(&ref);
+    ref2 = av_buffer_pool_get(pool);
+    reused = ref2->data == data;
+    printf("same data after release: %d\n", reused);
+
+    /* the reference from the pool may be released before other ones */
+    ref = av_buffer_ref(ref2);
+    av_buffer_unref(&ref2);
+    printf("refcount after releasing the pool reference: %d\n",
+           av_buffer_get_ref_count(ref));
+    ref2 = av_buffer_pool_get(pool);
+    printf("distinct buffer while still referenced: %d\n", ref2->data != ref->data);
+    av_buffer_unref(&ref);
+
+    /* replacing the pool reference through av_buffer_make_writable() */
+    ref = av_buffer_ref(ref2);
+    memset(ref2->data, 0xAA, ref2->size);
+    if (av_buffer_make_writable(&ref2) < 0)
+        return 1;
+    printf("writable copy: %d, data %02X, original refcount %d\n",
+           av_buffer_is_writable(ref2), ref2->data[63],
+           av_buffer_get_ref_count(ref));
+    av_buffer_unref(&ref);
+    av_buffer_unref(&ref2);
+
+    /* buffers may outlive the pool */
+    ref = av_buffer_pool_get(pool);
+    av_buffer_pool_uninit(&pool);
+    memset(ref->data, 0, ref->size);
+    av_buffer_unref(&ref);
+
+    printf("total allocations: %d\n", nb_allocs);
+
+    /* frame pools fall back to zeroed av_malloc() buffers by default */
+    {
+        AVBufferFrameStats *stats;
+        int nonzero = 0;
+
+        pool = av_buffer_pool_init_frame(4 << 20);
+        ref  = av_buffer_pool_get(pool);
+        for (i = 0; i < ref->size; i++)
+            nonzero |= ref->data[i];
+        av_buffer_unref(&ref);
+        av_buffer_pool_uninit(&pool);
+
+        stats = av_buffer_frame_get_stats();
+        if (!stats)
+            return 1;
+        printf("frame allocs %d, fallback %d, mapped %d, zeroed %d\n",
+               (int)stats->nb_allocs, (int)stats->nb_fallback,
+               (int)stats->bytes_mapped, !nonzero);
+        av_free(stats);
+    }
+
+    return 0;
+}
@@ -132,5 +132,45 @@ int main(void)
     printf("%s\n", e->value);
     av_dict_free(&dict);
 
+    printf("\nTesting av_dict_set() and av_dict_get() with many entries\n");
+    for (int i = 0; i < 40; i++) {
+        char key[16], val[16];
+        snprintf(key, sizeof(key), "key%d", i);
+        snprintf(val, sizeof(val), "val%d", i);
+        av_dict_set(&dict, key, val, 0);
+    }
+    av_dict_set(&dict, "KEY5", "upper", 0);
+    av_dict_set(&dict, "Key7", "case", AV_DICT_MATCH_CASE);
+    av_dict_set(&dict, "key7", "lower", AV_DICT_MATCH_CASE);
+    av_dict_set(&dict, "key9", "first", AV_DICT_MULTIKEY);
+    av_dict_set(&dict, "key9", "second", AV_DICT_MULTIKEY);
+    av_dict_set(&dict, "key11", "no", AV_DICT_DONT_OVERWRITE);
+    av_dict_set(&dict, "key12", "+more", AV_DICT_APPEND);
+    av_dict_set(&dict, "key13", "a much longer value than before", 0);
+    av_dict_set(&dict, "key14", "v", 0);
+    for (int i = 20; i < 30; i++) {
+        char key[16];
+        snprintf(key, sizeof(key), "KEY%d", i);
+        av_dict_set(&dict, key, NULL, 0);
+    }
+    av_dict_set(&dict, "key39", NULL, 0);
+    av_dict_set(&dict, "key0", NULL, 0);
+    print_dict(dict);
+    printf("count %d\n", av_dict_count(dict));
+    e = NULL;
+    while ((e = av_dict_get(dict, "KEY9", e, 0)))
+        printf("KEY9: %s %s\n", e->key, e->value);
+    e = NULL;
+    while ((e = av_dict_get(dict, "Key7", e, AV_DICT_MATCH_CASE)))
+        printf("Key7: %s %s\n", e->key, e->value);
+    e = NULL;
+    while ((e = av_dict_get(dict, "key3", e, AV_DICT_IGNORE_SUFFIX)))
+        printf("key3*: %s %s\n", e->key, e->value);
+    printf("key25 %s, key31 %s, key5 %s\n",
+           av_dict_get(dict, "key25", NULL, 0) ? "found" : "missing",
+           av_dict_get(dict, "KEY31", NULL, 0)->value,
+           av_dict_get(dict, "key5", NULL, AV_DICT_MATCH_CASE) ? "found" : "missing");
+    av_dict_free(&dict);
+
     return 0;
 }
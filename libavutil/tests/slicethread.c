@@ -0,0 +1,117 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * This test program runs several contexts on the shared slice thread pool
+ * at once and checks that every job runs exactly once, with a valid thread
+ * number, even when jobs wait for the previous job. Explicit thread counts
+ * above the pool size must be kept as they are.
+ */
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "libavutil/cpu.h"
+#include "libavutil/slicethread.h"
+#include "libavutil/thread.h"
+
+#define NB_CONTEXTS 4
+#define MAX_JOBS    64
+#define NB_RUNS     200
+
+typedef struct TestContext {
+    AVSliceThread *thread;
+    int nb_threads;
+    atomic_int done[MAX_JOBS];
+    atomic_int errors;
+} TestContext;
+
+static void worker_func(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads)
+{
+    TestContext *c = priv;
+
+    if (threadnr < 0 || threadnr >= nb_threads || nb_threads > c->nb_threads)
+        atomic_fetch_add(&c->errors, 1);
+
+    /* jobs may only rely on jobs with a lower number having started */
+    if (jobnr)
+        while (!atomic_load(&c->done[jobnr - 1]))
+            ;
+    if (atomic_fetch_add(&c->done[jobnr], 1))
+        atomic_fetch_add(&c->errors, 1);
+}
+
+static void *thread_main(void *arg)
+{
+    TestContext *c = arg;
+    int i, j;
+
+    for (i = 0; i < NB_RUNS; i++) {
+        int nb_jobs = 1 + i % MAX_JOBS;
+
+        for (j = 0; j < MAX_JOBS; j++)
+            atomic_store(&c->done[j], 0);
+        avpriv_slicethread_execute(c->thread, nb_jobs, 0);
+        for (j = 0; j < MAX_JOBS; j++)
+            if (atomic_load(&c->done[j]) != (j < nb_jobs))
+                atomic_fetch_add(&c->errors, 1);
+    }
+    return NULL;
+}
+
+int main(void)
+{
+    static TestContext ctx[NB_CONTEXTS];
+    pthread_t threads[NB_CONTEXTS];
+    int i, ret, errors = 0;
+
+    av_cpu_force_count(4);
+
+    for (i = 0; i < NB_CONTEXTS; i++) {
+        ret = avpriv_slicethread_create_shared(&ctx[i].thread, &ctx[i], worker_func,
+                                               3 * i, i % AVPRIV_SLICETHREAD_PRIORITY_NB);
+        if (ret < 0) {
+            fprintf(stderr, "avpriv_slicethread_create_shared failed\n");
+            return 1;
+        }
+        if (ret != (i ? 3 * i : 4)) {
+            fprintf(stderr, "context %d: got %d threads\n", i, ret);
+            return 2;
+        }
+        ctx[i].nb_threads = ret;
+    }
+
+    for (i = 0; i < NB_CONTEXTS; i++) {
+        if ((ret = pthread_create(&threads[i], NULL, thread_main, &ctx[i]))) {
+            fprintf(stderr, "pthread_create failed: %s.\n", strerror(ret));
+            return 1;
+        }
+    }
+    for (i = 0; i < NB_CONTEXTS; i++) {
+        pthread_join(threads[i], NULL);
+        errors += atomic_load(&ctx[i].errors);
+        avpriv_slicethread_free(&ctx[i].thread);
+    }
+
+    if (errors) {
+        fprintf(stderr, "%d errors\n", errors);
+        return 3;
+    }
+    return 0;
+}
@@ -0,0 +1,96 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libavutil/bprint.h"
+#include "libavutil/time.h"
+#include "libavutil/trace.h"
+
+static void print_stats(void)
+{
+    int i, j;
+
+    for (i = 0; i < AV_TRACE_STAGE_NB; i++) {
+        AVTraceStats stats;
+        uint64_t sum = 0;
+
+        av_trace_get_stats(i, &stats);
+        for (j = 0; j < AV_TRACE_HISTOGRAM_SIZE; j++)
+            sum += stats.histogram[j];
+        printf("%s: spans %d, histogram %s, max %s\n", av_trace_stage_name(i),
+               (int)stats.nb_spans, sum == stats.nb_spans ? "ok" : "mismatch",
+               stats.max >= 3000 * !!stats.nb_spans ? "ok" : "too small");
+    }
+}
+
+static int count(const char *str, const char *needle)
+{
+    int n = 0;
+
+    while ((str = strstr(str, needle))) {
+        str += strlen(needle);
+        n++;
+    }
+    return n;
+}
+
+int main(void)
+{
+    AVBPrint bp;
+    int i;
+
+    printf("disabled: begin %d\n", (int)av_trace_begin());
+    av_trace_end(av_trace_begin(), AV_TRACE_STAGE_DECODE, "dec", 0);
+
+    if (av_trace_enable(4) < 0)
+        return 1;
+
+    /* spans started 3 ms in the past, so that their duration is known */
+    for (i = 0; i < 3; i++)
+        av_trace_end(av_gettime_relative() - 3000, AV_TRACE_STAGE_DECODE, "dec", i);
+    for (i = 0; i < 2; i++)
+        av_trace_end(av_gettime_relative() - 3000, AV_TRACE_STAGE_FILTER,
+                     "Parsed_\"scale\"_0", -1);
+    av_trace_end(av_gettime_relative() - 3000, AV_TRACE_STAGE_MUX, NULL, 1);
+    av_trace_end(av_gettime_relative() - 3000, AV_TRACE_STAGE_NB, "invalid", 0);
+
+    av_trace_disable();
+    av_trace_end(av_trace_begin(), AV_TRACE_STAGE_MUX, NULL, 1);
+    print_stats();
+
+    av_bprint_init(&bp, 0, AV_BPRINT_SIZE_UNLIMITED);
+    if (av_trace_dump_json(&bp) < 0)
+        return 1;
+    printf("json: events %d, streams %d, escaped name %d\n",
+           count(bp.str, "\"ph\":\"X\""), count(bp.str, "\"args\":{\"stream\""),
+           count(bp.str, "\"name\":\"Parsed_\\\"scale\\\"_0\""));
+    av_bprint_finalize(&bp, NULL);
+
+    av_bprint_init(&bp, 0, AV_BPRINT_SIZE_UNLIMITED);
+    if (av_trace_dump_stats(&bp) < 0)
+        return 1;
+    printf("stats: lines %d\n", count(bp.str, "\n"));
+    av_bprint_finalize(&bp, NULL);
+
+    av_trace_free();
+    print_stats();
+
+    return 0;
+}
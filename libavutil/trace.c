@@ -0,0 +1,273 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <limits.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "avstring.h"
+#include "common.h"
+#include "error.h"
+#include "mem.h"
+#include "thread.h"
+#include "time.h"
+#include "trace.h"
+
+#define DEFAULT_MAX_EVENTS (1 << 20)
+
+typedef struct TraceEvent {
+    int64_t start;
+    int64_t duration;
+    uint64_t thread_id;
+    int stream_index;
+    enum AVTraceStage stage;
+    char name[32];
+} TraceEvent;
+
+typedef struct TraceStageStats {
+    atomic_uint_least64_t nb_spans;
+    atomic_uint_least64_t total;
+    atomic_uint_least64_t max;
+    atomic_uint_least64_t histogram[AV_TRACE_HISTOGRAM_SIZE];
+} TraceStageStats;
+
+static AVMutex trace_mutex = AV_MUTEX_INITIALIZER;
+static atomic_int trace_enabled = ATOMIC_VAR_INIT(0);
+static TraceEvent *trace_events;
+static int trace_max_events;
+static atomic_int trace_nb_events = ATOMIC_VAR_INIT(0);
+static int64_t trace_epoch;
+static TraceStageStats trace_stats[AV_TRACE_STAGE_NB];
+
+static const char *const stage_names[AV_TRACE_STAGE_NB] = {
+    [AV_TRACE_STAGE_DEMUX]  = "demux",
+    [AV_TRACE_STAGE_DECODE] = "decode",
+    [AV_TRACE_STAGE_FILTER] = "filter",
+    [AV_TRACE_STAGE_ENCODE] = "encode",
+    [AV_TRACE_STAGE_MUX]    = "mux",
+    [AV_TRACE_STAGE_OTHER]  = "other",
+};
+
+static uint64_t trace_thread_id(void)
+{
+#if !HAVE_THREADS
+    return 0;
+#elif HAVE_W32THREADS
+    return GetCurrentThreadId();
+#elif HAVE_PTHREADS
+    return (uintptr_t)pthread_self();
+#else
+    /* os2threads.h has no pthread_self() */
+    return 0;
+#endif
+}
+
+int av_trace_enable(int max_events)
+{
+    int ret = 0;
+
+    ff_mutex_lock(&trace_mutex);
+    if (!trace_events) {
+        trace_max_events = max_events > 0 ? max_events : DEFAULT_MAX_EVENTS;
+        trace_events = av_malloc_array(trace_max_events, sizeof(*trace_events));
+        if (!trace_events)
+            ret = AVERROR(ENOMEM);
+        trace_epoch = av_gettime_relative();
+    }
+    if (trace_events)
+        atomic_store_explicit(&trace_enabled, 1, memory_order_release);
+    ff_mutex_unlock(&trace_mutex);
+
+    return ret;
+}
+
+void av_trace_disable(void)
+{
+    atomic_store_explicit(&trace_enabled, 0, memory_order_release);
+}
+
+void av_trace_free(void)
+{
+    int i, j;
+
+    ff_mutex_lock(&trace_mutex);
+    atomic_store(&trace_enabled, 0);
+    av_freep(&trace_events);
+    trace_max_events = 0;
+    atomic_store(&trace_nb_events, 0);
+    for (i = 0; i < AV_TRACE_STAGE_NB; i++) {
+        TraceStageStats *s = &trace_stats[i];
+        atomic_store(&s->nb_spans, 0);
+        atomic_store(&s->total, 0);
+        atomic_store(&s->max, 0);
+        for (j = 0; j < AV_TRACE_HISTOGRAM_SIZE; j++)
+            atomic_store(&s->histogram[j], 0);
+    }
+    ff_mutex_unlock(&trace_mutex);
+}
+
+int64_t av_trace_begin(void)
+{
+    if (!atomic_load_explicit(&trace_enabled, memory_order_acquire))
+        return 0;
+    return av_gettime_relative();
+}
+
+void av_trace_end(int64_t begin, enum AVTraceStage stage,
+                  const char *name, int stream_index)
+{
+    TraceStageStats *s;
+    int64_t duration;
+    uint_least64_t max;
+    int idx, bucket;
+
+    if (!begin || (unsigned)stage >= AV_TRACE_STAGE_NB)
+        return;
+
+    duration = FFMAX(av_gettime_relative() - begin, 0);
+    bucket   = duration ? av_log2(FFMIN(duration, INT_MAX)) + 1 : 0;
+
+    s = &trace_stats[stage];
+    atomic_fetch_add_explicit(&s->nb_spans, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&s->total, duration, memory_order_relaxed);
+    atomic_fetch_add_explicit(&s->histogram[FFMIN(bucket, AV_TRACE_HISTOGRAM_SIZE - 1)],
+                              1, memory_order_relaxed);
+    max = atomic_load_explicit(&s->max, memory_order_relaxed);
+    while (duration > max &&
+           !atomic_compare_exchange_weak_explicit(&s->max, &max, duration,
+                                                  memory_order_relaxed,
+                                                  memory_order_relaxed))
+        ;
+
+    idx = atomic_fetch_add_explicit(&trace_nb_events, 1, memory_order_relaxed);
+    if (idx < trace_max_events) {
+        TraceEvent *ev = &trace_events[idx];
+        ev->start        = begin - trace_epoch;
+        ev->duration     = duration;
+        ev->thread_id    = trace_thread_id();
+        ev->stream_index = stream_index;
+        ev->stage        = stage;
+        av_strlcpy(ev->name, name ? name : stage_names[stage], sizeof(ev->name));
+    } else {
+        /* keep the counter from wrapping around */
+        atomic_store_explicit(&trace_nb_events, trace_max_events,
+                              memory_order_relaxed);
+    }
+}
+
+const char *av_trace_stage_name(enum AVTraceStage stage)
+{
+    if ((unsigned)stage >= AV_TRACE_STAGE_NB)
+        return NULL;
+    return stage_names[stage];
+}
+
+int av_trace_get_stats(enum AVTraceStage stage, AVTraceStats *stats)
+{
+    const TraceStageStats *s;
+    int i;
+
+    if ((unsigned)stage >= AV_TRACE_STAGE_NB)
+        return AVERROR(EINVAL);
+
+    s = &trace_stats[stage];
+    stats->nb_spans = atomic_load(&s->nb_spans);
+    stats->total    = atomic_load(&s->total);
+    stats->max      = atomic_load(&s->max);
+    for (i = 0; i < AV_TRACE_HISTOGRAM_SIZE; i++)
+        stats->histogram[i] = atomic_load(&s->histogram[i]);
+
+    return 0;
+}
+
+static void json_escape(AVBPrint *bp, const char *str)
+{
+    for (; *str; str++) {
+        if (*str == '"' || *str == '\\')
+            av_bprintf(bp, "\\%c", *str);
+        else if ((unsigned char)*str < 0x20)
+            av_bprintf(bp, "\\u%04x", *str);
+        else
+            av_bprint_chars(bp, *str, 1);
+    }
+}
+
+int av_trace_dump_json(AVBPrint *bp)
+{
+    int i, nb_events;
+
+    ff_mutex_lock(&trace_mutex);
+    nb_events = FFMIN(atomic_load(&trace_nb_events), trace_max_events);
+
+    av_bprintf(bp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    for (i = 0; i < nb_events; i++) {
+        const TraceEvent *ev = &trace_events[i];
+
+        av_bprintf(bp, "%s\n{\"name\":\"", i ? "," : "");
+        json_escape(bp, ev->name);
+        av_bprintf(bp, "\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%"PRId64
+                   ",\"dur\":%"PRId64",\"pid\":0,\"tid\":%"PRIu64,
+                   stage_names[ev->stage], ev->start, ev->duration,
+                   ev->thread_id);
+        if (ev->stream_index >= 0)
+            av_bprintf(bp, ",\"args\":{\"stream\":%d}", ev->stream_index);
+        av_bprintf(bp, "}");
+    }
+    av_bprintf(bp, "\n]}\n");
+    ff_mutex_unlock(&trace_mutex);
+
+    return av_bprint_is_complete(bp) ? 0 : AVERROR(ENOMEM);
+}
+
+/* upper bound of the bucket holding the given percentile of spans */
+static uint64_t stats_percentile(const AVTraceStats *stats, int percent)
+{
+    uint64_t target = (stats->nb_spans * percent + 99) / 100, sum = 0;
+    int i;
+
+    for (i = 0; i < AV_TRACE_HISTOGRAM_SIZE - 1; i++) {
+        sum += stats->histogram[i];
+        if (sum >= target)
+            return FFMIN(1ULL << i, stats->max);
+    }
+    return stats->max;
+}
+
+int av_trace_dump_stats(AVBPrint *bp)
+{
+    int i;
+
+    av_bprintf(bp, "%-8s %10s %12s %10s %10s %10s %10s %10s\n",
+               "stage", "spans", "total[ms]", "avg[us]", "p50[us]",
+               "p90[us]", "p99[us]", "max[us]");
+    for (i = 0; i < AV_TRACE_STAGE_NB; i++) {
+        AVTraceStats stats;
+
+        av_trace_get_stats(i, &stats);
+        if (!stats.nb_spans)
+            continue;
+        av_bprintf(bp, "%-8s %10"PRIu64" %12.3f %10.1f %10"PRIu64" %10"PRIu64
+                   " %10"PRIu64" %10"PRIu64"\n", stage_names[i], stats.nb_spans,
+                   stats.total / 1000.0, (double)stats.total / stats.nb_spans,
+                   stats_percentile(&stats, 50), stats_percentile(&stats, 90),
+                   stats_percentile(&stats, 99), stats.max);
+    }
+
+    return av_bprint_is_complete(bp) ? 0 : AVERROR(ENOMEM);
+}
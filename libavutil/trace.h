@@ -0,0 +1,163 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * @ingroup lavu_trace
+ * Runtime span tracing of processing stages.
+ */
+
+#ifndef AVUTIL_TRACE_H
+#define AVUTIL_TRACE_H
+
+#include <stdint.h>
+
+#include "bprint.h"
+
+/**
+ * @defgroup lavu_trace Tracing
+ * @ingroup lavu_misc
+ * Low overhead, runtime enabled recording of timed spans.
+ *
+ * Unlike the START_TIMER/STOP_TIMER macros from timer.h, tracing is
+ * compiled in unconditionally and costs a single atomic load per span
+ * while disabled. Recorded spans can be exported in the Chrome trace
+ * event JSON format, which is also understood by Perfetto, and are
+ * aggregated into per-stage duration histograms.
+ *
+ * A span is recorded by passing the value returned by av_trace_begin()
+ * to av_trace_end():
+ * @code
+ * int64_t t = av_trace_begin();
+ * ret = avcodec_receive_frame(avctx, frame);
+ * av_trace_end(t, AV_TRACE_STAGE_DECODE, "h264", stream_index);
+ * @endcode
+ *
+ * @{
+ */
+
+enum AVTraceStage {
+    AV_TRACE_STAGE_DEMUX,
+    AV_TRACE_STAGE_DECODE,
+    AV_TRACE_STAGE_FILTER,
+    AV_TRACE_STAGE_ENCODE,
+    AV_TRACE_STAGE_MUX,
+    AV_TRACE_STAGE_OTHER,
+    AV_TRACE_STAGE_NB,          ///< Not part of ABI
+};
+
+/**
+ * Number of histogram buckets in AVTraceStats.
+ */
+#define AV_TRACE_HISTOGRAM_SIZE 32
+
+/**
+ * Aggregated statistics of all spans recorded for one stage.
+ * All durations are in microseconds.
+ */
+typedef struct AVTraceStats {
+    uint64_t nb_spans;
+    uint64_t total;
+    uint64_t max;
+    /**
+     * histogram[0] counts spans shorter than 1 microsecond, histogram[i]
+     * spans lasting from 2^(i-1) up to 2^i microseconds. The last bucket
+     * also counts all longer spans.
+     */
+    uint64_t histogram[AV_TRACE_HISTOGRAM_SIZE];
+} AVTraceStats;
+
+/**
+ * Enable recording of spans.
+ *
+ * Statistics are always aggregated, individual spans are kept for
+ * av_trace_dump_json() until max_events of them have been recorded.
+ *
+ * @param max_events maximum number of individual spans to keep, 0 for
+ *                   a default; ignored if tracing was enabled before
+ * @return 0 on success, a negative AVERROR code on failure
+ */
+int av_trace_enable(int max_events);
+
+/**
+ * Stop recording spans. Recorded data is kept until av_trace_free().
+ */
+void av_trace_disable(void);
+
+/**
+ * Disable tracing and free all recorded data.
+ *
+ * Must not be called while other threads may record spans.
+ */
+void av_trace_free(void);
+
+/**
+ * Start a span.
+ *
+ * @return a timestamp to pass to av_trace_end(), 0 if tracing is disabled
+ */
+int64_t av_trace_begin(void);
+
+/**
+ * Finish a span and record it.
+ *
+ * This function is thread-safe.
+ *
+ * @param begin        value returned by av_trace_begin(), nothing is
+ *                     recorded if it is 0
+ * @param stage        processing stage the span is accounted to
+ * @param name         name of the span, e.g. a codec or filter instance
+ *                     name; it is copied and may be truncated
+ * @param stream_index index of the stream the span belongs to, or -1
+ */
+void av_trace_end(int64_t begin, enum AVTraceStage stage,
+                  const char *name, int stream_index);
+
+/**
+ * @return the name of a stage, or NULL for an invalid stage
+ */
+const char *av_trace_stage_name(enum AVTraceStage stage);
+
+/**
+ * Get the aggregated statistics of a stage.
+ *
+ * @return 0 on success, AVERROR(EINVAL) for an invalid stage
+ */
+int av_trace_get_stats(enum AVTraceStage stage, AVTraceStats *stats);
+
+/**
+ * Write all kept spans as a Chrome trace event JSON document.
+ *
+ * Must not be called while other threads may record spans.
+ *
+ * @return 0 on success, AVERROR(ENOMEM) if the output was truncated
+ */
+int av_trace_dump_json(AVBPrint *bp);
+
+/**
+ * Write a human readable table of the per-stage statistics.
+ *
+ * @return 0 on success, AVERROR(ENOMEM) if the output was truncated
+ */
+int av_trace_dump_stats(AVBPrint *bp);
+
+/**
+ * @}
+ */
+
+#endif /* AVUTIL_TRACE_H */
@@ -112,6 +112,7 @@ av_cold int swri_dither_init(SwrContext *s, enum AVSampleFormat out_fmt, enum AV
     s->dither.ns_scale   =   scale;
     s->dither.ns_scale_1 = scale ? 1/scale : 0;
     memset(s->dither.ns_errors, 0, sizeof(s->dither.ns_errors));
+    memset(s->dither.ns_errors_simd, 0, sizeof(s->dither.ns_errors_simd));
     for (i=0; filters[i].coefs; i++) {
         const filter_t *f = &filters[i];
         if (llabs(s->out_sample_rate - f->rate)*20 <= f->rate && f->name == s->dither.method) {
@@ -146,3 +147,44 @@ av_cold int swri_dither_init(SwrContext *s, enum AVSampleFormat out_fmt, enum AV
 #define TEMPLATE_DITHER_DBL
 #include "dither_template.c"
 #undef TEMPLATE_DITHER_DBL
+
+#define NS_SIMD_BLOCK 256
+
+void swri_noise_shaping_float_simd(SwrContext *s, AudioData *dsts, const AudioData *srcs, const AudioData *noises, int count){
+    DECLARE_ALIGNED(16, float, buf)  [NS_SIMD_BLOCK][4];
+    DECLARE_ALIGNED(16, float, noise)[NS_SIMD_BLOCK][4];
+    const float scale[2] = { s->dither.ns_scale, s->dither.ns_scale_1 };
+    int pos = s->dither.ns_pos;
+    int ch, c, i, k;
+
+    /* channels are shaped in groups of 4, a missing channel of the last
+     * group is replaced by a copy of the previous one and not written back */
+    for (ch=0; ch<srcs->ch_count; ch+=4) {
+        int nb_ch = FFMIN(srcs->ch_count - ch, 4);
+        float (*errors)[4] = s->dither.ns_errors_simd[ch/4];
+
+        pos = s->dither.ns_pos;
+        for (i=0; i<count; i+=NS_SIMD_BLOCK) {
+            int n = FFMIN(count - i, NS_SIMD_BLOCK);
+
+            for (c=0; c<4; c++) {
+                int ich = ch + FFMIN(c, nb_ch - 1);
+                const float *src = (const float *)srcs->ch[ich] + i;
+                const float *nse = (const float *)noises->ch[ich] + s->dither.noise_pos + i;
+                for (k=0; k<n; k++) {
+                    buf  [k][c] = src[k];
+                    noise[k][c] = nse[k];
+                }
+            }
+            pos = s->dither.noise_shaping_simd(buf[0], noise[0], errors[0], s->dither.ns_coeffs,
+                                               s->dither.ns_taps, pos, n, scale);
+            for (c=0; c<nb_ch; c++) {
+                float *dst = (float *)dsts->ch[ch + c] + i;
+                for (k=0; k<n; k++)
+                    dst[k] = buf[k][c];
+            }
+        }
+    }
+
+    s->dither.ns_pos = pos;
+}
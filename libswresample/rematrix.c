@@ -551,9 +551,15 @@ int swri_rematrix(SwrContext *s, AudioData *out, AudioData *in, int len, int mus
             if(len != len1)
                 s->mix_2_1_f   (out->ch[out_i]+off, in->ch[in_i1]+off, in->ch[in_i2]+off, s->native_matrix, in->ch_count*out_i + in_i1, in->ch_count*out_i + in_i2, len-len1);
             break;}
-        default:
+        default: {
+            int len_n = s->mix_n_1_simd ? len&~15 : 0;
+            const void *coeffp = s->int_sample_fmt == AV_SAMPLE_FMT_FLTP ? (const void*)s->matrix_flt[out_i] :
+                                 s->int_sample_fmt == AV_SAMPLE_FMT_DBLP ? (const void*)s->matrix    [out_i] :
+                                                                           (const void*)s->matrix32  [out_i];
+            if(len_n)
+                s->mix_n_1_simd(out->ch[out_i], (const uint8_t **)in->ch, coeffp, &s->matrix_ch[out_i][1], s->matrix_ch[out_i][0], len_n);
             if(s->int_sample_fmt == AV_SAMPLE_FMT_FLTP){
-                for(i=0; i<len; i++){
+                for(i=len_n; i<len; i++){
                     float v=0;
                     for(j=0; j<s->matrix_ch[out_i][0]; j++){
                         in_i= s->matrix_ch[out_i][1+j];
@@ -562,7 +568,7 @@ int swri_rematrix(SwrContext *s, AudioData *out, AudioData *in, int len, int mus
                     ((float*)out->ch[out_i])[i]= v;
                 }
             }else if(s->int_sample_fmt == AV_SAMPLE_FMT_DBLP){
-                for(i=0; i<len; i++){
+                for(i=len_n; i<len; i++){
                     double v=0;
                     for(j=0; j<s->matrix_ch[out_i][0]; j++){
                         in_i= s->matrix_ch[out_i][1+j];
@@ -571,7 +577,7 @@ int swri_rematrix(SwrContext *s, AudioData *out, AudioData *in, int len, int mus
                     ((double*)out->ch[out_i])[i]= v;
                 }
             }else{
-                for(i=0; i<len; i++){
+                for(i=len_n; i<len; i++){
                     int v=0;
                     for(j=0; j<s->matrix_ch[out_i][0]; j++){
                         in_i= s->matrix_ch[out_i][1+j];
@@ -580,6 +586,7 @@ int swri_rematrix(SwrContext *s, AudioData *out, AudioData *in, int len, int mus
                     ((int16_t*)out->ch[out_i])[i]= (v + 16384)>>15;
                 }
             }
+            break;}
         }
     }
     return 0;
@@ -27,8 +27,40 @@
  */
 
 #include "libavutil/avassert.h"
+#include "libavutil/thread.h"
 #include "resample.h"
 
+/**
+ * Total size in bytes of the filter banks kept cached while no context
+ * uses them, so that contexts created one after another share them too.
+ */
+#define FILTER_BANK_CACHE_SIZE (4 << 20)
+
+/**
+ * Filter bank shared by all the contexts built with the same parameters.
+ * The filter bank is never written to after it was built.
+ */
+typedef struct SharedFilterBank {
+    struct SharedFilterBank *next;
+    int refcount;
+    size_t size;
+
+    /* parameters the filter bank was built from */
+    enum AVSampleFormat format;
+    double factor;
+    int filter_length;
+    int filter_alloc;
+    int phase_count;
+    enum SwrFilterType filter_type;
+    double kaiser_beta;
+
+    uint8_t *filter_bank;
+} SharedFilterBank;
+
+static AVMutex filter_bank_lock = AV_MUTEX_INITIALIZER;
+/* most recently used first */
+static SharedFilterBank *filter_banks;
+
 static inline double eval_poly(const double *coeff, int size, double x) {
     double sum = coeff[size-1];
     int i;
@@ -276,17 +308,143 @@ fail:
     return ret;
 }
 
+/* Minimum number of filter taps to compute per channel and call for the
+ * channels to be resampled in parallel. */
+#define THREAD_MIN_TAPS (1 << 14)
+
+/**
+ * Fill the extra filter of phase phase_count with the filter of phase 0
+ * delayed by one sample, for the linear interpolation of the last phase.
+ */
+static void build_last_phase(ResampleContext *c, uint8_t *filter_bank, int phase_count)
+{
+    /* taken from where it was before the padding was raised for the SIMD filters */
+    int wrapped = FFALIGN(c->filter_length, 8) - 1;
+
+    memcpy(filter_bank + (c->filter_alloc*phase_count+1)*c->felem_size, filter_bank, (c->filter_alloc-1)*c->felem_size);
+    memcpy(filter_bank + (c->filter_alloc*phase_count  )*c->felem_size, filter_bank + wrapped*c->felem_size, c->felem_size);
+}
+
+/* must be called with filter_bank_lock held */
+static void filter_bank_move_to_front(SharedFilterBank *fb)
+{
+    SharedFilterBank **p;
+
+    for (p = &filter_banks; *p != fb; p = &(*p)->next)
+        ;
+    *p = fb->next;
+    fb->next = filter_banks;
+    filter_banks = fb;
+}
+
+/**
+ * Free the least recently used unreferenced filter banks beyond
+ * FILTER_BANK_CACHE_SIZE, must be called with filter_bank_lock held.
+ */
+static void filter_bank_prune(void)
+{
+    SharedFilterBank **p = &filter_banks;
+    size_t cached = 0;
+
+    while (*p) {
+        SharedFilterBank *fb = *p;
+
+        if (!fb->refcount && (cached += fb->size) > FILTER_BANK_CACHE_SIZE) {
+            *p = fb->next;
+            av_free(fb->filter_bank);
+            av_free(fb);
+        } else {
+            p = &fb->next;
+        }
+    }
+}
+
+/**
+ * Get a reference to the filter bank for the current parameters of c and
+ * phase_count filters, building it if it is not cached.
+ */
+static SharedFilterBank *filter_bank_ref(ResampleContext *c, int phase_count)
+{
+    SharedFilterBank *fb;
+
+    ff_mutex_lock(&filter_bank_lock);
+    for (fb = filter_banks; fb; fb = fb->next) {
+        if (fb->format        == c->format        && fb->factor        == c->factor        &&
+            fb->filter_length == c->filter_length && fb->filter_alloc  == c->filter_alloc  &&
+            fb->phase_count   == phase_count      && fb->filter_type   == c->filter_type   &&
+            fb->kaiser_beta   == c->kaiser_beta) {
+            fb->refcount++;
+            filter_bank_move_to_front(fb);
+            goto end;
+        }
+    }
+
+    /* built with the lock held so that contexts initialized concurrently
+     * with the same parameters build the filter bank only once */
+    fb = av_mallocz(sizeof(*fb));
+    if (!fb)
+        goto end;
+    fb->size        = (size_t)c->filter_alloc * (phase_count+1) * c->felem_size;
+    fb->filter_bank = av_calloc(c->filter_alloc, (phase_count+1)*c->felem_size);
+    if (!fb->filter_bank ||
+        build_filter(c, fb->filter_bank, c->factor, c->filter_length, c->filter_alloc,
+                     phase_count, 1 << c->filter_shift, c->filter_type, c->kaiser_beta) < 0) {
+        av_freep(&fb->filter_bank);
+        av_freep(&fb);
+        goto end;
+    }
+    build_last_phase(c, fb->filter_bank, phase_count);
+
+    fb->refcount      = 1;
+    fb->format        = c->format;
+    fb->factor        = c->factor;
+    fb->filter_length = c->filter_length;
+    fb->filter_alloc  = c->filter_alloc;
+    fb->phase_count   = phase_count;
+    fb->filter_type   = c->filter_type;
+    fb->kaiser_beta   = c->kaiser_beta;
+    fb->next          = filter_banks;
+    filter_banks      = fb;
+end:
+    ff_mutex_unlock(&filter_bank_lock);
+    return fb;
+}
+
+static void filter_bank_unref(SharedFilterBank **pfb)
+{
+    SharedFilterBank *fb = *pfb;
+
+    if (!fb)
+        return;
+    *pfb = NULL;
+
+    ff_mutex_lock(&filter_bank_lock);
+    if (!--fb->refcount) {
+        filter_bank_move_to_front(fb);
+        filter_bank_prune();
+    }
+    ff_mutex_unlock(&filter_bank_lock);
+}
+
+static void resample_worker(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads)
+{
+    ResampleContext *c = priv;
+
+    c->job_func(c, c->job_dst->ch[jobnr], c->job_src->ch[jobnr], c->job_size, 0);
+}
+
 static void resample_free(ResampleContext **cc){
     ResampleContext *c = *cc;
     if(!c)
         return;
-    av_freep(&c->filter_bank);
+    avpriv_slicethread_free(&c->slicethread);
+    filter_bank_unref(&c->shared_filter_bank);
     av_freep(cc);
 }
 
 static ResampleContext *resample_init(ResampleContext *c, int out_rate, int in_rate, int filter_size, int phase_shift, int linear,
                                     double cutoff0, enum AVSampleFormat format, enum SwrFilterType filter_type, double kaiser_beta,
-                                    double precision, int cheby, int exact_rational)
+                                    double precision, int cheby, int exact_rational, int threads)
 {
     double cutoff = cutoff0? cutoff0 : 0.97;
     double factor= FFMIN(out_rate * cutoff / in_rate, 1.0);
@@ -316,6 +474,7 @@ static ResampleContext *resample_init(ResampleContext *c, int out_rate, int in_r
             return NULL;
 
         c->format= format;
+        c->threads = 1;
 
         c->felem_size= av_get_bytes_per_sample(c->format);
 
@@ -344,17 +503,23 @@ static ResampleContext *resample_init(ResampleContext *c, int out_rate, int in_r
         c->linear        = linear;
         c->factor        = factor;
         c->filter_length = filter_length;
-        c->filter_alloc  = FFALIGN(c->filter_length, 8);
-        c->filter_bank   = av_calloc(c->filter_alloc, (phase_count+1)*c->felem_size);
+        c->filter_alloc  = FFALIGN(c->filter_length, 16);
         c->filter_type   = filter_type;
         c->kaiser_beta   = kaiser_beta;
         c->phase_count_compensation = phase_count_compensation;
-        if (!c->filter_bank)
-            goto error;
-        if (build_filter(c, (void*)c->filter_bank, factor, c->filter_length, c->filter_alloc, phase_count, 1<<c->filter_shift, filter_type, kaiser_beta))
+        c->shared_filter_bank = filter_bank_ref(c, phase_count);
+        if (!c->shared_filter_bank)
             goto error;
-        memcpy(c->filter_bank + (c->filter_alloc*phase_count+1)*c->felem_size, c->filter_bank, (c->filter_alloc-1)*c->felem_size);
-        memcpy(c->filter_bank + (c->filter_alloc*phase_count  )*c->felem_size, c->filter_bank + (c->filter_alloc - 1)*c->felem_size, c->felem_size);
+        c->filter_bank   = c->shared_filter_bank->filter_bank;
+    }
+
+    if (c->threads != threads) {
+        avpriv_slicethread_free(&c->slicethread);
+        c->threads = threads;
+        if (threads != 1 &&
+            avpriv_slicethread_create_shared(&c->slicethread, c, resample_worker, threads,
+                                             AVPRIV_SLICETHREAD_PRIORITY_NORMAL) <= 1)
+            avpriv_slicethread_free(&c->slicethread);
     }
 
     c->compensation_distance= 0;
@@ -375,40 +540,29 @@ static ResampleContext *resample_init(ResampleContext *c, int out_rate, int in_r
 
     return c;
 error:
-    av_freep(&c->filter_bank);
-    av_free(c);
+    resample_free(&c);
     return NULL;
 }
 
 static int rebuild_filter_bank_with_compensation(ResampleContext *c)
 {
-    uint8_t *new_filter_bank;
+    SharedFilterBank *new_filter_bank;
     int new_src_incr, new_dst_incr;
     int phase_count = c->phase_count_compensation;
-    int ret;
 
     if (phase_count == c->phase_count)
         return 0;
 
     av_assert0(!c->frac && !c->dst_incr_mod);
 
-    new_filter_bank = av_calloc(c->filter_alloc, (phase_count + 1) * c->felem_size);
+    new_filter_bank = filter_bank_ref(c, phase_count);
     if (!new_filter_bank)
         return AVERROR(ENOMEM);
 
-    ret = build_filter(c, new_filter_bank, c->factor, c->filter_length, c->filter_alloc,
-                       phase_count, 1 << c->filter_shift, c->filter_type, c->kaiser_beta);
-    if (ret < 0) {
-        av_freep(&new_filter_bank);
-        return ret;
-    }
-    memcpy(new_filter_bank + (c->filter_alloc*phase_count+1)*c->felem_size, new_filter_bank, (c->filter_alloc-1)*c->felem_size);
-    memcpy(new_filter_bank + (c->filter_alloc*phase_count  )*c->felem_size, new_filter_bank + (c->filter_alloc - 1)*c->felem_size, c->felem_size);
-
     if (!av_reduce(&new_src_incr, &new_dst_incr, c->src_incr,
                    c->dst_incr * (int64_t)(phase_count/c->phase_count), INT32_MAX/2))
     {
-        av_freep(&new_filter_bank);
+        filter_bank_unref(&new_filter_bank);
         return AVERROR(EINVAL);
     }
 
@@ -423,8 +577,9 @@ static int rebuild_filter_bank_with_compensation(ResampleContext *c)
     c->dst_incr_mod   = c->dst_incr % c->src_incr;
     c->index         *= phase_count / c->phase_count;
     c->phase_count    = phase_count;
-    av_freep(&c->filter_bank);
-    c->filter_bank = new_filter_bank;
+    filter_bank_unref(&c->shared_filter_bank);
+    c->shared_filter_bank = new_filter_bank;
+    c->filter_bank        = new_filter_bank->filter_bank;
     return 0;
 }
 
@@ -494,8 +649,26 @@ static int multiple_resample(ResampleContext *c, AudioData *dst, int dst_size, A
              * when frac and dst_incr_mod are zero */
             resample_func = (c->linear && (c->frac || c->dst_incr_mod)) ?
                             c->dsp.resample_linear : c->dsp.resample_common;
-            for (i = 0; i < dst->ch_count; i++)
-                *consumed = resample_func(c, dst->ch[i], src->ch[i], dst_size, i+1 == dst->ch_count);
+            if (c->slicethread && dst->ch_count > 1 && !need_emms &&
+                dst_size * (int64_t)c->filter_length >= THREAD_MIN_TAPS) {
+                /* all channels start from the same state, so advance it
+                 * once here instead of from one of the concurrent jobs */
+                int64_t frac  = c->frac + dst_size * (int64_t)c->dst_incr_mod;
+                int64_t index = c->index + dst_size * (int64_t)c->dst_incr_div + frac / c->src_incr;
+
+                c->job_dst  = dst;
+                c->job_src  = src;
+                c->job_size = dst_size;
+                c->job_func = resample_func;
+                avpriv_slicethread_execute(c->slicethread, dst->ch_count, 0);
+
+                *consumed = index / c->phase_count;
+                c->index  = index % c->phase_count;
+                c->frac   = frac % c->src_incr;
+            } else {
+                for (i = 0; i < dst->ch_count; i++)
+                    *consumed = resample_func(c, dst->ch[i], src->ch[i], dst_size, i+1 == dst->ch_count);
+            }
         }
     }
 
@@ -24,6 +24,7 @@
 
 #include "libavutil/log.h"
 #include "libavutil/samplefmt.h"
+#include "libavutil/slicethread.h"
 
 #include "swresample_internal.h"
 
@@ -49,6 +50,16 @@ typedef struct ResampleContext {
     int felem_size;
     int filter_shift;
     int phase_count_compensation;      /* desired phase_count when compensation is enabled */
+    struct SharedFilterBank *shared_filter_bank; /* reference to the cached filter_bank */
+    int threads;                       /* requested number of threads, 0 for automatic */
+    AVSliceThread *slicethread;        /* resamples the channels in parallel, NULL if single threaded */
+
+    /* arguments of the channel jobs run on slicethread */
+    AudioData *job_dst;
+    AudioData *job_src;
+    int job_size;
+    int (*job_func)(struct ResampleContext *c, void *dst,
+                    const void *src, int n, int update_ctx);
 
     struct {
         void (*resample_one)(void *dst, const void *src,
@@ -42,6 +42,20 @@ typedef void (mix_2_1_func_type)(void *out, const void *in1, const void *in2, vo
 
 typedef void (mix_any_func_type)(uint8_t **out, const uint8_t **in1, void *coeffp, integer len);
 
+/**
+ * Mix the n input channels listed in ch into out: out = sum in[ch[j]] * coeffp[ch[j]].
+ */
+typedef void (mix_n_1_func_type)(void *out, const uint8_t **in, const void *coeffp, const uint8_t *ch, integer n, integer len);
+
+/**
+ * Noise shape 4 interleaved channels in place, see swri_noise_shaping_float().
+ *
+ * @param errors 2*NS_TAPS rows of 4 error values
+ * @param scale  ns_scale and ns_scale_1
+ * @return the new position in the error rows
+ */
+typedef int (noise_shaping_func_type)(float *buf, const float *noise, float *errors, const float *coeffs, int taps, int pos, int count, const float *scale);
+
 typedef struct AudioData{
     uint8_t *ch[SWR_CH_MAX];    ///< samples buffer per channel
     uint8_t *data;              ///< samples buffer
@@ -63,13 +77,15 @@ struct DitherContext {
     int ns_pos;                                     ///< Noise shaping dither position
     float ns_coeffs[NS_TAPS];                       ///< Noise shaping filter coefficients
     float ns_errors[SWR_CH_MAX][2*NS_TAPS];
+    DECLARE_ALIGNED(16, float, ns_errors_simd)[SWR_CH_MAX/4][2*NS_TAPS][4]; ///< ns_errors of groups of 4 channels, used by noise_shaping_simd
+    noise_shaping_func_type *noise_shaping_simd;
     AudioData noise;                                ///< noise used for dithering
     AudioData temp;                                 ///< temporary storage when writing into the input buffer isn't possible
     int output_sample_bits;                         ///< the number of used output bits, needed to scale dither correctly
 };
 
 typedef struct ResampleContext * (* resample_init_func)(struct ResampleContext *c, int out_rate, int in_rate, int filter_size, int phase_shift, int linear,
-                                    double cutoff, enum AVSampleFormat format, enum SwrFilterType filter_type, double kaiser_beta, double precision, int cheby, int exact_rational);
+                                    double cutoff, enum AVSampleFormat format, enum SwrFilterType filter_type, double kaiser_beta, double precision, int cheby, int exact_rational, int threads);
 typedef void    (* resample_free_func)(struct ResampleContext **c);
 typedef int     (* multiple_resample_func)(struct ResampleContext *c, AudioData *dst, int dst_size, AudioData *src, int src_size, int *consumed);
 typedef int     (* resample_flush_func)(struct SwrContext *c);
@@ -133,6 +149,7 @@ struct SwrContext {
     double kaiser_beta;                                /**< swr beta value for Kaiser window (only applicable if filter_type == AV_FILTER_TYPE_KAISER) */
     double precision;                               /**< soxr resampling precision (in bits) */
     int cheby;                                      /**< soxr: if 1 then passband rolloff will be none (Chebyshev) & irrational ratio approximation precision will be higher */
+    int threads;                                    /**< number of threads used to resample the channels in parallel, 0 for automatic */
 
     float min_compensation;                         ///< swr minimum below which no compensation will happen
     float min_hard_compensation;                    ///< swr minimum below which no silence inject / sample drop will happen
@@ -183,6 +200,7 @@ struct SwrContext {
     mix_2_1_func_type *mix_2_1_simd;
 
     mix_any_func_type *mix_any_f;
+    mix_n_1_func_type *mix_n_1_simd;
 
     /* TODO: callbacks for ASM optimizations */
 };
@@ -194,6 +212,7 @@ void swri_noise_shaping_int16 (SwrContext *s, AudioData *dsts, const AudioData *
 void swri_noise_shaping_int32 (SwrContext *s, AudioData *dsts, const AudioData *srcs, const AudioData *noises, int count);
 void swri_noise_shaping_float (SwrContext *s, AudioData *dsts, const AudioData *srcs, const AudioData *noises, int count);
 void swri_noise_shaping_double(SwrContext *s, AudioData *dsts, const AudioData *srcs, const AudioData *noises, int count);
+void swri_noise_shaping_float_simd(SwrContext *s, AudioData *dsts, const AudioData *srcs, const AudioData *noises, int count);
 
 av_warn_unused_result
 int swri_rematrix_init(SwrContext *s);
@@ -0,0 +1,99 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "libswresample/resample.c"
+
+static ResampleContext *init(int out_rate, int in_rate, double cutoff)
+{
+    return resample_init(NULL, out_rate, in_rate, 32, 10, 0, cutoff,
+                         AV_SAMPLE_FMT_DBLP, SWR_FILTER_TYPE_KAISER, 9,
+                         20, 0, 0, 1);
+}
+
+static int is_cached(const SharedFilterBank *bank)
+{
+    const SharedFilterBank *fb;
+
+    for (fb = filter_banks; fb; fb = fb->next)
+        if (fb == bank)
+            return 1;
+    return 0;
+}
+
+static size_t cached_size(void)
+{
+    const SharedFilterBank *fb;
+    size_t size = 0;
+
+    for (fb = filter_banks; fb; fb = fb->next)
+        if (!fb->refcount)
+            size += fb->size;
+    return size;
+}
+
+int main(void)
+{
+    ResampleContext *c, *c2;
+    SharedFilterBank *first;
+    size_t built = 0;
+    int i;
+
+    c = init(48000, 44100, 0);
+    if (!c)
+        return 1;
+    first = c->shared_filter_bank;
+
+    c2 = init(48000, 44100, 0);
+    if (!c2)
+        return 1;
+    printf("concurrent contexts share: %s\n",
+           c2->shared_filter_bank == first ? "yes" : "no");
+    resample_free(&c2);
+
+    c2 = init(8000, 44100, 0);
+    if (!c2)
+        return 1;
+    printf("other parameters share: %s\n",
+           c2->shared_filter_bank == first ? "yes" : "no");
+    resample_free(&c2);
+
+    resample_free(&c);
+    printf("released filter bank cached: %s\n", is_cached(first) ? "yes" : "no");
+
+    c = init(48000, 44100, 0);
+    if (!c)
+        return 1;
+    printf("sequential contexts share: %s\n",
+           c->shared_filter_bank == first ? "yes" : "no");
+    resample_free(&c);
+
+    /* release more filter banks than the cache holds */
+    for (i = 0; built <= 2 * FILTER_BANK_CACHE_SIZE; i++) {
+        c = init(48000, 44100, 0.5 + i * 0.01);
+        if (!c)
+            return 1;
+        built += c->shared_filter_bank->size;
+        resample_free(&c);
+    }
+    printf("least recently used filter bank cached: %s\n",
+           is_cached(first) ? "yes" : "no");
+    printf("cache size within limit: %s\n",
+           cached_size() <= FILTER_BANK_CACHE_SIZE ? "yes" : "no");
+
+    return 0;
+}
@@ -202,6 +202,43 @@ cglobal %2_to_%1_%3, 3, 3, 6, dst, src, len
 %endif
 %endmacro
 
+; int16 <-> int32/float with 256-bit registers, the int16 side is half the
+; width of the other one, 16 samples are converted per iteration
+;to, from, a/u, log2_outsize, log_intsize, conversion macro, const
+%macro CONV_16 7
+cglobal %2_to_%1_%3, 3, 3, 6, dst, src, len
+    mov srcq    , [srcq]
+    mov dstq    , [dstq]
+%ifidn %3, a
+    test dstq, mmsize-1
+        jne %2_to_%1_u_int %+ SUFFIX
+    test srcq, mmsize-1
+        jne %2_to_%1_u_int %+ SUFFIX
+%else
+%2_to_%1_u_int %+ SUFFIX:
+%endif
+    lea     srcq , [srcq  + (1<<%5)*lenq]
+    lea     dstq , [dstq  + (1<<%4)*lenq]
+    neg     lenq
+    %7 m0,m1,m2,m3,m4,m5
+.next:
+%if %4 > %5
+    pmovsxwd  m0, [           srcq +(1<<%5)*lenq]
+    pmovsxwd  m1, [mmsize/2 + srcq +(1<<%5)*lenq]
+    %6
+    mov%3 [           dstq+(1<<%4)*lenq], m0
+    mov%3 [  mmsize + dstq+(1<<%4)*lenq], m1
+%else
+    mov%3     m0, [           srcq +(1<<%5)*lenq]
+    mov%3     m1, [  mmsize + srcq +(1<<%5)*lenq]
+    %6
+    mov%3 [           dstq+(1<<%4)*lenq], m0
+%endif
+    add lenq, mmsize/2
+        jl .next
+    REP_RET
+%endmacro
+
 %macro PACK_6CH 8
 cglobal pack_6ch_%2_to_%1_%3, 2, 8, %6, dst, src, src1, src2, src3, src4, src5, len
 %if ARCH_X86_64
@@ -608,6 +645,36 @@ pack_8ch_%2_to_%1_u_int %+ SUFFIX:
 %macro NOP_N 0-6
 %endmacro
 
+; packssdw works within 128-bit lanes, vpermq puts the words back in order
+%macro INT16_TO_INT32_16 0
+    pslld     m0, 16
+    pslld     m1, 16
+%endmacro
+
+%macro INT32_TO_INT16_16 0
+    psrad     m0, 16
+    psrad     m1, 16
+    packssdw  m0, m1
+    vpermq    m0, m0, q3120
+%endmacro
+
+%macro INT16_TO_FLOAT_16 0
+    INT16_TO_INT32_16
+    cvtdq2ps  m0, m0
+    cvtdq2ps  m1, m1
+    mulps m0, m0, m5
+    mulps m1, m1, m5
+%endmacro
+
+%macro FLOAT_TO_INT16_16 0
+    mulps m0, m5
+    mulps m1, m5
+    cvtps2dq  m0, m0
+    cvtps2dq  m1, m1
+    packssdw  m0, m1
+    vpermq    m0, m0, q3120
+%endmacro
+
 INIT_MMX mmx
 CONV int32, int16, u, 2, 1, INT16_TO_INT32_N, NOP_N
 CONV int32, int16, a, 2, 1, INT16_TO_INT32_N, NOP_N
@@ -736,4 +803,13 @@ CONV float, int32, a, 2, 2, INT32_TO_FLOAT_N, INT32_TO_FLOAT_INIT
 INIT_YMM avx2
 CONV int32, float, u, 2, 2, FLOAT_TO_INT32_N, FLOAT_TO_INT32_INIT
 CONV int32, float, a, 2, 2, FLOAT_TO_INT32_N, FLOAT_TO_INT32_INIT
+
+CONV_16 int32, int16, u, 2, 1, INT16_TO_INT32_16, NOP_N
+CONV_16 int32, int16, a, 2, 1, INT16_TO_INT32_16, NOP_N
+CONV_16 int16, int32, u, 1, 2, INT32_TO_INT16_16, NOP_N
+CONV_16 int16, int32, a, 1, 2, INT32_TO_INT16_16, NOP_N
+CONV_16 float, int16, u, 2, 1, INT16_TO_FLOAT_16, INT16_TO_FLOAT_INIT
+CONV_16 float, int16, a, 2, 1, INT16_TO_FLOAT_16, INT16_TO_FLOAT_INIT
+CONV_16 int16, float, u, 1, 2, FLOAT_TO_INT16_16, FLOAT_TO_INT16_INIT
+CONV_16 int16, float, a, 1, 2, FLOAT_TO_INT16_16, FLOAT_TO_INT16_INIT
 %endif
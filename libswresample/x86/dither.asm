@@ -0,0 +1,117 @@
+;******************************************************************************
+;* SIMD noise shaping dither
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;******************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION .text
+
+;------------------------------------------------------------------------------
+; int ff_noise_shaping_float(float *buf, const float *noise, float *errors,
+;                            const float *coeffs, int taps, int pos, int count,
+;                            const float *scale)
+;------------------------------------------------------------------------------
+; buf, noise and errors hold 4 interleaved channels, one channel per lane.
+; Every lane computes the same operations in the same order as
+; swri_noise_shaping_float(), the filter sums in single precision and the
+; rest in double precision, so the result is bitexact.
+%macro NOISE_SHAPING_FLOAT 0
+cglobal noise_shaping_float, 8, 11, 8, buf, noise, errors, coeffs, taps, pos, count, scale, j, e, groups
+    movsxdifnidn tapsq, tapsd
+    movsxdifnidn  posq, posd
+    vbroadcastss   xm6, [scaleq]
+    vcvtps2pd       m6, xm6
+    vbroadcastss   xm7, [scaleq + 4]
+    lea        groupsq, [tapsq - 2]
+    test        countd, countd
+        jle .end
+
+.next:
+    ; d = src * S_1
+    mulps          xm0, xm7, [bufq]
+    vcvtps2pd       m0, xm0
+    mov             eq, posq
+    shl             eq, 4
+    add             eq, errorsq
+    xor             jq, jq
+.next_group:
+    cmp             jq, groupsq
+        jge .tail
+    vbroadcastss   xm1, [coeffsq + 4*jq]
+    mulps          xm1, [eq]
+    vbroadcastss   xm2, [coeffsq + 4*jq + 4]
+    mulps          xm2, [eq + 16]
+    addps          xm1, xm2
+    vbroadcastss   xm2, [coeffsq + 4*jq + 8]
+    mulps          xm2, [eq + 32]
+    addps          xm1, xm2
+    vbroadcastss   xm2, [coeffsq + 4*jq + 12]
+    mulps          xm2, [eq + 48]
+    addps          xm1, xm2
+    vcvtps2pd       m1, xm1
+    subpd           m0, m1
+    add             eq, 64
+    add             jq, 4
+    jmp .next_group
+.tail:
+    cmp             jq, tapsq
+        jge .filtered
+    vbroadcastss   xm1, [coeffsq + 4*jq]
+    mulps          xm1, [eq]
+    vcvtps2pd       m1, xm1
+    subpd           m0, m1
+.filtered:
+    ; pos = pos ? pos - 1 : taps - 1
+    test          posq, posq
+        jnz .dec_pos
+    mov           posq, tapsq
+.dec_pos:
+    dec           posq
+
+    ; d1 = rint(d + noise), the error is d1 - d
+    vcvtps2pd       m1, [noiseq]
+    addpd           m1, m0
+    vroundpd        m1, m1, 4
+    subpd           m2, m1, m0
+    vcvtpd2ps      xm2, m2
+    mov             eq, posq
+    shl             eq, 4
+    add             eq, errorsq
+    mova          [eq], xm2
+    mov             jq, tapsq
+    shl             jq, 4
+    mova     [eq + jq], xm2
+
+    mulpd           m1, m6
+    vcvtpd2ps      xm1, m1
+    mova         [bufq], xm1
+    add           bufq, 16
+    add         noiseq, 16
+    dec         countd
+        jg .next
+
+.end:
+    mov            eax, posd
+    RET
+%endmacro
+
+%if ARCH_X86_64 && HAVE_AVX_EXTERNAL
+INIT_YMM avx
+NOISE_SHAPING_FLOAT
+%endif
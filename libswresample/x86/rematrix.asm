@@ -24,6 +24,7 @@
 SECTION_RODATA 32
 dw1: times 8  dd 1
 w1 : times 16 dw 1
+pd_16384: times 8 dd 16384
 
 SECTION .text
 
@@ -241,10 +242,106 @@ MIX1_INT16 a
 MIX2_INT16 u
 MIX2_INT16 a
 
+; void ff_mix_n_1_<type>(void *out, const uint8_t **in, const void *coeffp,
+;                        const uint8_t *ch, integer n, integer len)
+; out = sum in[ch[j]] * coeffp[ch[j]], accumulated from zero in the order of
+; ch, like the C code, so the result is bitexact
+; %1 float/double, %2 s/d, %3 log2 of the sample size, %4 number of registers
+%macro MIX_N_FLT 4
+%assign coef %4
+%assign tmp  %4+1
+cglobal mix_n_1_%1, 6, 10, %4+2, out, in, coeffp, ch, n, len, j, c, src, off
+    shl        lenq, %3
+    xor        offq, offq
+.next:
+%assign i 0
+%rep %4
+    xorp%2       m %+ i, m %+ i
+%assign i i+1
+%endrep
+    xor          jq, jq
+.next_ch:
+    movzx        cd, byte [chq + jq]
+    mov        srcq, [inq + gprsize*cq]
+%ifidn %2, s
+    vbroadcastss m %+ coef, [coeffpq + 4*cq]
+%else
+    vbroadcastsd m %+ coef, [coeffpq + 8*cq]
+%endif
+%assign i 0
+%rep %4
+    mulp%2       m %+ tmp, m %+ coef, [srcq + offq + i*mmsize]
+    addp%2       m %+ i, m %+ tmp
+%assign i i+1
+%endrep
+    inc          jq
+    cmp          jq, nq
+        jl .next_ch
+%assign i 0
+%rep %4
+    movu  [outq + offq + i*mmsize], m %+ i
+%assign i i+1
+%endrep
+    add        offq, %4*mmsize
+    cmp        offq, lenq
+        jl .next
+    RET
+%endmacro
+
+; the sum is computed in 32 bits and the result truncated to 16 bits, like
+; the C code
+%macro MIX_N_INT16 0
+cglobal mix_n_1_int16, 6, 10, 6, out, in, coeffp, ch, n, len, j, c, src, off
+    shl        lenq, 1
+    xor        offq, offq
+.next:
+    pxor         m0, m0
+    pxor         m1, m1
+    xor          jq, jq
+.next_ch:
+    movzx        cd, byte [chq + jq]
+    mov        srcq, [inq + gprsize*cq]
+    vpbroadcastd m4, [coeffpq + 4*cq]
+    pmovsxwd     m2, [srcq + offq]
+    pmovsxwd     m3, [srcq + offq + mmsize/2]
+    pmulld       m2, m4
+    pmulld       m3, m4
+    paddd        m0, m2
+    paddd        m1, m3
+    inc          jq
+    cmp          jq, nq
+        jl .next_ch
+    mova         m4, [pd_16384]
+    paddd        m0, m4
+    paddd        m1, m4
+    psrad        m0, 15
+    psrad        m1, 15
+    pslld        m0, 16
+    pslld        m1, 16
+    psrad        m0, 16
+    psrad        m1, 16
+    packssdw     m0, m1
+    vpermq       m0, m0, q3120
+    movu [outq + offq], m0
+    add        offq, mmsize
+    cmp        offq, lenq
+        jl .next
+    RET
+%endmacro
+
 %if HAVE_AVX_EXTERNAL
 INIT_YMM avx
 MIX2_FLT u
 MIX2_FLT a
 MIX1_FLT u
 MIX1_FLT a
+%if ARCH_X86_64
+MIX_N_FLT float,  s, 2, 2
+MIX_N_FLT double, d, 3, 4
+%endif
+%endif
+
+%if ARCH_X86_64 && HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+MIX_N_INT16
 %endif
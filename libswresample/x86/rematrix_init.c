@@ -31,6 +31,12 @@ D(float, avx)
 D(int16, mmx)
 D(int16, sse2)
 
+mix_n_1_func_type ff_mix_n_1_float_avx;
+mix_n_1_func_type ff_mix_n_1_double_avx;
+mix_n_1_func_type ff_mix_n_1_int16_avx2;
+
+noise_shaping_func_type ff_noise_shaping_float_avx;
+
 av_cold int swri_rematrix_init_x86(struct SwrContext *s){
 #if HAVE_X86ASM
     int mm_flags = av_get_cpu_flags();
@@ -41,6 +47,8 @@ av_cold int swri_rematrix_init_x86(struct SwrContext *s){
 
     s->mix_1_1_simd = NULL;
     s->mix_2_1_simd = NULL;
+    s->mix_n_1_simd = NULL;
+    s->dither.noise_shaping_simd = NULL;
 
     if (s->midbuf.fmt == AV_SAMPLE_FMT_S16P){
         if(EXTERNAL_MMX(mm_flags)) {
@@ -51,6 +59,8 @@ av_cold int swri_rematrix_init_x86(struct SwrContext *s){
             s->mix_1_1_simd = ff_mix_1_1_a_int16_sse2;
             s->mix_2_1_simd = ff_mix_2_1_a_int16_sse2;
         }
+        if(ARCH_X86_64 && EXTERNAL_AVX2_FAST(mm_flags))
+            s->mix_n_1_simd = ff_mix_n_1_int16_avx2;
         s->native_simd_matrix = av_mallocz_array(num,  2 * sizeof(int16_t));
         s->native_simd_one    = av_mallocz(2 * sizeof(int16_t));
         if (!s->native_simd_matrix || !s->native_simd_one)
@@ -78,12 +88,19 @@ av_cold int swri_rematrix_init_x86(struct SwrContext *s){
             s->mix_1_1_simd = ff_mix_1_1_a_float_avx;
             s->mix_2_1_simd = ff_mix_2_1_a_float_avx;
         }
+        if(ARCH_X86_64 && EXTERNAL_AVX_FAST(mm_flags)) {
+            s->mix_n_1_simd = ff_mix_n_1_float_avx;
+            s->dither.noise_shaping_simd = ff_noise_shaping_float_avx;
+        }
         s->native_simd_matrix = av_mallocz_array(num, sizeof(float));
         s->native_simd_one = av_mallocz(sizeof(float));
         if (!s->native_simd_matrix || !s->native_simd_one)
             return AVERROR(ENOMEM);
         memcpy(s->native_simd_matrix, s->native_matrix, num * sizeof(float));
         memcpy(s->native_simd_one, s->native_one, sizeof(float));
+    } else if(s->midbuf.fmt == AV_SAMPLE_FMT_DBLP){
+        if(ARCH_X86_64 && EXTERNAL_AVX_FAST(mm_flags))
+            s->mix_n_1_simd = ff_mix_n_1_double_avx;
     }
 #endif
 
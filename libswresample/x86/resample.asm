@@ -52,8 +52,38 @@ pf_1:      dd 1.0
 pdbl_1:    dq 1.0
 pd_0x4000: dd 0x4000
 
+; minus the byte offset of the sample in each dword of a zmm block, compared
+; with the count of bytes left to build the load mask of the last block
+pd_tail_s: dd   0,  -4,  -8, -12, -16, -20, -24, -28
+           dd -32, -36, -40, -44, -48, -52, -56, -60
+pd_tail_d: dd   0,   0,  -8,  -8, -16, -16, -24, -24
+           dd -32, -32, -40, -40, -48, -48, -56, -56
+
 SECTION .text
 
+; With zmm, the last block of a filter_length that is not a multiple of the
+; vector width is loaded with a mask, so that no source sample past
+; filter_length is read; the filter taps past it are zero.
+%macro LOAD_TAIL 1 ; float op suffix [s or d]
+%if mmsize == 64
+    jmp .inner_loop
+.inner_tail:
+    vpbroadcastd                  m1, min_filter_count_x4d
+    vpcmpd                        k1, m1, [pd_tail_%1], 1 ; lt
+    vmovups                 m1{k1}{z}, [srcq+min_filter_count_x4q*1]
+    jmp .inner_madd
+%endif
+%endmacro
+
+%macro LOAD_SRC 0
+%if mmsize == 64
+    cmp         min_filter_count_x4q, -mmsize
+    jg .inner_tail
+%endif
+    movu                          m1, [srcq+min_filter_count_x4q*1]
+.inner_madd:
+%endmacro
+
 ; FIXME remove unneeded variables (index_incr, phase_mask)
 %macro RESAMPLE_FNS 3-5 ; format [float or int16], bps, log2_bps, float op suffix [s or d], 1.0 constant
 ; int resample_common_$format(ResampleContext *ctx, $format *dst,
@@ -166,14 +196,15 @@ cglobal resample_common_%1, 1, 7, 2, ctx, phase_count, dst, frac, \
     mov         min_filter_count_x4q, min_filter_length_x4q
 %endif
 %ifidn %1, int16
-    movd                          m0, [pd_0x4000]
+    movd                         xm0, [pd_0x4000]
 %else ; float/double
     xorps                         m0, m0, m0
+    LOAD_TAIL                     %4
 %endif
 
     align 16
 .inner_loop:
-    movu                          m1, [srcq+min_filter_count_x4q*1]
+    LOAD_SRC
 %ifidn %1, int16
 %if cpuflag(xop)
     vpmadcswd                     m0, m1, [filterq+min_filter_count_x4q*1], m0
@@ -193,16 +224,24 @@ cglobal resample_common_%1, 1, 7, 2, ctx, phase_count, dst, frac, \
     js .inner_loop
 
 %ifidn %1, int16
-    HADDD                         m0, m1
-    psrad                         m0, 15
+%if mmsize == 32
+    vextracti128                 xm1, m0, 0x1
+    paddd                        xm0, xm1
+%endif
+    HADDD                        xm0, xm1
+    psrad                        xm0, 15
     add                        fracd, dst_incr_modd
-    packssdw                      m0, m0
+    packssdw                     xm0, xm0
     add                       indexd, dst_incr_divd
-    movd                      [dstq], m0
+    movd                      [dstq], xm0
 %else ; float/double
     ; horizontal sum & store
-%if mmsize == 32
-    vextractf128                 xm1, m0, 0x1
+%if mmsize == 64
+    vextractf64x4                ym1, m0, 0x1
+    addp%4                       ym0, ym1
+%endif
+%if mmsize >= 32
+    vextractf128                 xm1, ym0, 0x1
     addp%4                       xm0, xm1
 %endif
     movhlps                      xm1, xm0
@@ -312,7 +351,7 @@ cglobal resample_linear_%1, 0, 15, 5, ctx, phase_mask, src, phase_count, index,
     mov                   ctx_stackq, ctxq
     mov           min_filter_len_x4d, [ctxq+ResampleContext.filter_length]
 %ifidn %1, int16
-    movd                          m4, [pd_0x4000]
+    movd                         xm4, [pd_0x4000]
 %else ; float/double
     cvtsi2s%4                    xm0, src_incrd
     movs%4                       xm4, [%5]
@@ -365,7 +404,7 @@ cglobal resample_linear_%1, 1, 7, 5, ctx, min_filter_length_x4, filter2, \
     PUSH                              dword [ctxq+ResampleContext.phase_count]  ; unneeded replacement of phase_mask
     PUSH                              r3d
 %ifidn %1, int16
-    movd                          m4, [pd_0x4000]
+    movd                         xm4, [pd_0x4000]
 %else ; float/double
     cvtsi2s%4                    xm0, r3d
     movs%4                       xm4, [%5]
@@ -419,11 +458,12 @@ cglobal resample_linear_%1, 1, 7, 5, ctx, min_filter_length_x4, filter2, \
 %else ; float/double
     xorps                         m0, m0, m0
     xorps                         m2, m2, m2
+    LOAD_TAIL                     %4
 %endif
 
     align 16
 .inner_loop:
-    movu                          m1, [srcq+min_filter_count_x4q*1]
+    LOAD_SRC
 %ifidn %1, int16
 %if cpuflag(xop)
     vpmadcswd                     m2, m1, [filter2q+min_filter_count_x4q*1], m2
@@ -449,36 +489,42 @@ cglobal resample_linear_%1, 1, 7, 5, ctx, min_filter_length_x4, filter2, \
     js .inner_loop
 
 %ifidn %1, int16
-%if mmsize == 16
+%if mmsize == 32
+    vextracti128                 xm3, m2, 0x1
+    vextracti128                 xm1, m0, 0x1
+    paddd                        xm2, xm3
+    paddd                        xm0, xm1
+%endif
+%if mmsize >= 16
 %if cpuflag(xop)
-    vphadddq                      m2, m2
-    vphadddq                      m0, m0
+    vphadddq                     xm2, xm2
+    vphadddq                     xm0, xm0
 %endif
-    pshufd                        m3, m2, q0032
-    pshufd                        m1, m0, q0032
-    paddd                         m2, m3
-    paddd                         m0, m1
+    pshufd                       xm3, xm2, q0032
+    pshufd                       xm1, xm0, q0032
+    paddd                        xm2, xm3
+    paddd                        xm0, xm1
 %endif
 %if notcpuflag(xop)
-    PSHUFLW                       m3, m2, q0032
-    PSHUFLW                       m1, m0, q0032
-    paddd                         m2, m3
-    paddd                         m0, m1
+    PSHUFLW                      xm3, xm2, q0032
+    PSHUFLW                      xm1, xm0, q0032
+    paddd                        xm2, xm3
+    paddd                        xm0, xm1
 %endif
-    psubd                         m2, m0
+    psubd                        xm2, xm0
     ; This is probably a really bad idea on atom and other machines with a
     ; long transfer latency between GPRs and XMMs (atom). However, it does
     ; make the clip a lot simpler...
-    movd                         eax, m2
+    movd                         eax, xm2
     add                       indexd, dst_incr_divd
     imul                              fracd
     idiv                              src_incrd
-    movd                          m1, eax
+    movd                         xm1, eax
     add                        fracd, dst_incr_modd
-    paddd                         m0, m1
-    psrad                         m0, 15
-    packssdw                      m0, m0
-    movd                      [dstq], m0
+    paddd                        xm0, xm1
+    psrad                        xm0, 15
+    packssdw                     xm0, xm0
+    movd                      [dstq], xm0
 
     ; note that for imul/idiv, I need to move filter to edx/eax for each:
     ; - 32bit: eax=r0[filter1], edx=r2[filter2]
@@ -486,9 +532,15 @@ cglobal resample_linear_%1, 1, 7, 5, ctx, min_filter_length_x4, filter2, \
     ; - unix64: eax=r6[filter1], edx=r2[todo]
 %else ; float/double
     ; val += (v2 - val) * (FELEML) frac / c->src_incr;
-%if mmsize == 32
-    vextractf128                 xm1, m0, 0x1
-    vextractf128                 xm3, m2, 0x1
+%if mmsize == 64
+    vextractf64x4                ym1, m0, 0x1
+    vextractf64x4                ym3, m2, 0x1
+    addp%4                       ym0, ym1
+    addp%4                       ym2, ym3
+%endif
+%if mmsize >= 32
+    vextractf128                 xm1, ym0, 0x1
+    vextractf128                 xm3, ym2, 0x1
     addp%4                       xm0, xm1
     addp%4                       xm2, xm3
 %endif
@@ -593,6 +645,10 @@ RESAMPLE_FNS float, 4, 2, s, pf_1
 INIT_XMM fma4
 RESAMPLE_FNS float, 4, 2, s, pf_1
 %endif
+%if HAVE_AVX512_EXTERNAL
+INIT_ZMM avx512
+RESAMPLE_FNS float, 4, 2, s, pf_1
+%endif
 
 %if ARCH_X86_32
 INIT_MMX mmxext
@@ -605,6 +661,10 @@ RESAMPLE_FNS int16, 2, 1
 INIT_XMM xop
 RESAMPLE_FNS int16, 2, 1
 %endif
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+RESAMPLE_FNS int16, 2, 1
+%endif
 
 INIT_XMM sse2
 RESAMPLE_FNS double, 8, 3, d, pdbl_1
@@ -617,3 +677,7 @@ RESAMPLE_FNS double, 8, 3, d, pdbl_1
 INIT_YMM fma3
 RESAMPLE_FNS double, 8, 3, d, pdbl_1
 %endif
+%if HAVE_AVX512_EXTERNAL
+INIT_ZMM avx512
+RESAMPLE_FNS double, 8, 3, d, pdbl_1
+%endif
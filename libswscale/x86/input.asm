@@ -94,6 +94,10 @@ shuf_rgb_12x4:   db 0, 0x80, 1, 0x80,  2, 0x80,  3, 0x80, \
 shuf_rgb_3x56:   db 2, 0x80, 3, 0x80,  4, 0x80,  5, 0x80, \
                     8, 0x80, 9, 0x80, 10, 0x80, 11, 0x80
 
+shuf_rgb48_rgb64: db 0, 1, 2, 3, 4, 5, 0x80, 0x80, 6, 7, 8, 9, 10, 11, 0x80, 0x80
+pack_rgb64_perm:  db 0, 4, 1, 5, 2, 6, 3, 7
+ps_65535:         dd 65535.0
+
 SECTION .text
 
 ;-----------------------------------------------------------------------------
@@ -524,6 +528,281 @@ INIT_XMM avx
 RGB32_FUNCS 8, 12
 %endif
 
+;-----------------------------------------------------------------------------
+; 16-bit RGB to Y/UV.
+;
+; void <fmt>ToY_<opt>(uint8_t *dst, const uint8_t *src, const uint8_t *unused1,
+;                     const uint8_t *unused2, int w, int32_t *rgb2yuv);
+; void <fmt>ToUV_<opt>(uint8_t *dstU, uint8_t *dstV, const uint8_t *unused0,
+;                      const uint8_t *src1, const uint8_t *src2, int w,
+;                      int32_t *rgb2yuv);
+; void planar_<fmt>_to_y_<opt>(uint8_t *dst, const uint8_t *src[4], int w,
+;                              int32_t *rgb2yuv);
+; void planar_<fmt>_to_uv_<opt>(uint8_t *dstU, uint8_t *dstV,
+;                               const uint8_t *src[4], int w, int32_t *rgb2yuv);
+;
+; Unlike the 8-bit functions above, these use the coefficients in rgb2yuv
+; and match the C functions exactly: the samples are widened to dwords and
+; multiplied with pmulld, and the low 16 bits of the shifted sums are stored.
+; 8 pixels are converted per iteration, so up to 7 pixels past w are read
+; and written.
+;-----------------------------------------------------------------------------
+
+%if HAVE_AVX2_EXTERNAL && ARCH_X86_64
+
+%define RY_IDX 0
+%define GY_IDX 1
+%define BY_IDX 2
+%define RU_IDX 3
+%define GU_IDX 4
+%define BU_IDX 5
+%define RV_IDX 6
+%define GV_IDX 7
+%define BV_IDX 8
+
+; %1 = y or uv, %2/%3 = R or B, the coefficients to apply to m0/m3
+%macro LOAD_RGB16_COEFFS 3
+%ifidn %1, y
+    vpbroadcastd   m8, [tableq+4*%2Y_IDX]
+    vpbroadcastd   m9, [tableq+4*GY_IDX]
+    vpbroadcastd  m10, [tableq+4*%3Y_IDX]
+%else ; uv
+    vpbroadcastd   m8, [tableq+4*%2U_IDX]
+    vpbroadcastd   m9, [tableq+4*GU_IDX]
+    vpbroadcastd  m10, [tableq+4*%3U_IDX]
+    vpbroadcastd  m11, [tableq+4*%2V_IDX]
+    vpbroadcastd  m12, [tableq+4*GV_IDX]
+    vpbroadcastd  m13, [tableq+4*%3V_IDX]
+%endif ; y/uv
+%endmacro
+
+; %1 = rounding constant, %2 = gpr to use as temporary
+%macro LOAD_RGB16_CONSTS 2
+    mov           %2d, %1
+    movd         xm14, %2d
+    vpbroadcastd  m14, xm14
+    pcmpeqd        m5, m5
+    psrld          m5, 16                 ; (dword) { 0xffff } x8
+%endmacro
+
+; %1 = 48 or 64
+; out: m0/m1/m3 = (dword) { C0, G, C2 }[0,1,4,5 | 2,3,6,7]
+%macro LOAD_RGB16 1
+%if %1 == 64
+    movu           m0, [srcq+wq*8]        ; (word) { C0, G, C2, A }[0,1 | 2,3]
+    movu           m2, [srcq+wq*8+mmsize] ; (word) { C0, G, C2, A }[4,5 | 6,7]
+%else ; %1 == 48
+    movu          xm0, [srcq+ 0]
+    vinserti128    m0, m0, [srcq+12], 1
+    movu          xm2, [srcq+24]
+    vinserti128    m2, m2, [srcq+36], 1
+    add          srcq, 48
+    pshufb         m0, m6                 ; (word) { C0, G, C2, 0 }[0,1 | 2,3]
+    pshufb         m2, m6                 ; (word) { C0, G, C2, 0 }[4,5 | 6,7]
+%endif ; %1 == 48/64
+    psrld          m1, m0, 16             ; (dword) { G, A }[0,1 | 2,3]
+    psrld          m3, m2, 16             ; (dword) { G, A }[4,5 | 6,7]
+    pand           m0, m5                 ; (dword) { C0, C2 }[0,1 | 2,3]
+    pand           m2, m5                 ; (dword) { C0, C2 }[4,5 | 6,7]
+    shufps         m1, m1, m3, q2020      ; (dword) G[0,1,4,5 | 2,3,6,7]
+    shufps         m3, m0, m2, q3131      ; (dword) C2[0,1,4,5 | 2,3,6,7]
+    shufps         m0, m0, m2, q2020      ; (dword) C0[0,1,4,5 | 2,3,6,7]
+%endmacro
+
+; %1 = depth (9-16) or f32
+; out: m0/m1/m3 = (dword) { R, G, B }[0-7]
+%macro LOAD_PLANAR_RGB 1
+%ifidn %1, f32
+    mulps          m0, m6, [rq+wq*4]
+    mulps          m1, m6, [gq+wq*4]
+    mulps          m3, m6, [bq+wq*4]
+    maxps          m0, m15                ; also turns NaN into 0
+    maxps          m1, m15
+    maxps          m3, m15
+    minps          m0, m6
+    minps          m1, m6
+    minps          m3, m6
+    cvtps2dq       m0, m0
+    cvtps2dq       m1, m1
+    cvtps2dq       m3, m3
+%else ; %1 == 9-16
+    pmovzxwd       m0, [rq+wq*2]
+    pmovzxwd       m1, [gq+wq*2]
+    pmovzxwd       m3, [bq+wq*2]
+%endif ; %1 == f32/9-16
+%endmacro
+
+; %1 = shift
+; in: m0/m1/m3 = C0, G, C2; out: m0 = (dword) Y
+%macro RGB16_TO_Y 1
+    pmulld         m0, m8
+    pmulld         m1, m9
+    pmulld         m3, m10
+    paddd          m0, m1
+    paddd          m3, m14
+    paddd          m0, m3
+    psrld          m0, %1
+    pand           m0, m5
+%endmacro
+
+; %1 = shift
+; in: m0/m1/m3 = C0, G, C2; out: m2/m0 = (dword) U/V
+%macro RGB16_TO_UV 1
+    pmulld         m2, m0, m8
+    pmulld         m4, m1, m9
+    paddd          m2, m4
+    pmulld         m4, m3, m10
+    paddd          m2, m4
+    pmulld         m0, m11
+    pmulld         m1, m12
+    pmulld         m3, m13
+    paddd          m0, m1
+    paddd          m2, m14
+    paddd          m3, m14
+    paddd          m0, m3
+    psrld          m2, %1
+    psrld          m0, %1
+    pand           m2, m5
+    pand           m0, m5
+%endmacro
+
+; %1 = format name, %2 = 48 or 64, %3/%4 = order of R and B in a pixel
+%macro RGB16_FUNCS 4
+cglobal %1 %+ LEToY, 6, 6, 15, dst, src, u1, u2, w, table
+    LOAD_RGB16_COEFFS y, %3, %4
+    LOAD_RGB16_CONSTS 0x2001 << 14, u1
+%if %2 == 48
+    vbroadcasti128 m6, [shuf_rgb48_rgb64]
+%endif
+    pmovzxbd       m7, [pack_rgb64_perm]
+    movsxd         wq, wd
+    lea          dstq, [dstq+wq*2]
+%if %2 == 64
+    lea          srcq, [srcq+wq*8]
+%endif
+    neg            wq
+.loop:
+    LOAD_RGB16     %2
+    RGB16_TO_Y     15
+    packusdw       m0, m0
+    vpermd         m0, m7, m0
+    movu [dstq+wq*2], xm0
+    add            wq, 8
+    jl .loop
+    RET
+
+cglobal %1 %+ LEToUV, 7, 7, 15, dstU, dstV, u0, src, u2, w, table
+    LOAD_RGB16_COEFFS uv, %3, %4
+    LOAD_RGB16_CONSTS 0x10001 << 14, u0
+%if %2 == 48
+    vbroadcasti128 m6, [shuf_rgb48_rgb64]
+%endif
+    pmovzxbd       m7, [pack_rgb64_perm]
+    movsxd         wq, wd
+    lea         dstUq, [dstUq+wq*2]
+    lea         dstVq, [dstVq+wq*2]
+%if %2 == 64
+    lea          srcq, [srcq+wq*8]
+%endif
+    neg            wq
+.loop:
+    LOAD_RGB16     %2
+    RGB16_TO_UV    15
+    packusdw       m2, m0
+    vpermd         m2, m7, m2
+    movu [dstUq+wq*2], xm2
+    vextracti128 [dstVq+wq*2], m2, 1
+    add            wq, 8
+    jl .loop
+    RET
+%endmacro
+
+; %1 = depth (9-16) or f32
+%macro PLANAR_RGB_FUNCS 1
+%ifidn %1, f32
+%define bps 4
+%assign shift 15
+%assign rnd_y  0x2001  << 14
+%assign rnd_uv 0x10001 << 14
+%else ; %1 == 9-16
+%define bps 2
+%if %1 < 16
+%assign shift %1 + 1
+%else
+%assign shift 15
+%endif
+%assign rnd_y  (16  << (%1 + 7)) + (1 << (shift - 1))
+%assign rnd_uv (128 << (%1 + 7)) + (1 << (shift - 1))
+%endif ; %1 == f32/9-16
+
+cglobal planar_rgb%1le_to_y, 4, 7, 16, dst, src, w, table, g, b, r
+    mov            gq, [srcq+0*gprsize]
+    mov            bq, [srcq+1*gprsize]
+    mov            rq, [srcq+2*gprsize]
+    LOAD_RGB16_COEFFS y, R, B
+    LOAD_RGB16_CONSTS rnd_y, src
+%ifidn %1, f32
+    vbroadcastss   m6, [ps_65535]
+    pxor          m15, m15
+%endif
+    movsxd         wq, wd
+    lea          dstq, [dstq+wq*2]
+    lea            gq, [gq+wq*bps]
+    lea            bq, [bq+wq*bps]
+    lea            rq, [rq+wq*bps]
+    neg            wq
+.loop:
+    LOAD_PLANAR_RGB %1
+    RGB16_TO_Y     shift
+    packusdw       m0, m0
+    vpermq         m0, m0, q3120
+    movu [dstq+wq*2], xm0
+    add            wq, 8
+    jl .loop
+    RET
+
+cglobal planar_rgb%1le_to_uv, 5, 8, 16, dstU, dstV, src, w, table, g, b, r
+    mov            gq, [srcq+0*gprsize]
+    mov            bq, [srcq+1*gprsize]
+    mov            rq, [srcq+2*gprsize]
+    LOAD_RGB16_COEFFS uv, R, B
+    LOAD_RGB16_CONSTS rnd_uv, src
+%ifidn %1, f32
+    vbroadcastss   m6, [ps_65535]
+    pxor          m15, m15
+%endif
+    movsxd         wq, wd
+    lea         dstUq, [dstUq+wq*2]
+    lea         dstVq, [dstVq+wq*2]
+    lea            gq, [gq+wq*bps]
+    lea            bq, [bq+wq*bps]
+    lea            rq, [rq+wq*bps]
+    neg            wq
+.loop:
+    LOAD_PLANAR_RGB %1
+    RGB16_TO_UV    shift
+    packusdw       m2, m0
+    vpermq         m2, m2, q3120
+    movu [dstUq+wq*2], xm2
+    vextracti128 [dstVq+wq*2], m2, 1
+    add            wq, 8
+    jl .loop
+    RET
+%endmacro
+
+INIT_YMM avx2
+RGB16_FUNCS rgb48,  48, R, B
+RGB16_FUNCS bgr48,  48, B, R
+RGB16_FUNCS rgba64, 64, R, B
+RGB16_FUNCS bgra64, 64, B, R
+PLANAR_RGB_FUNCS  9
+PLANAR_RGB_FUNCS 10
+PLANAR_RGB_FUNCS 12
+PLANAR_RGB_FUNCS 14
+PLANAR_RGB_FUNCS 16
+PLANAR_RGB_FUNCS f32
+%endif ; HAVE_AVX2_EXTERNAL && ARCH_X86_64
+
 ;-----------------------------------------------------------------------------
 ; YUYV/UYVY/NV12/NV21 packed pixel shuffling.
 ;
@@ -25,19 +25,19 @@
 
 SECTION_RODATA 32
 
-minshort:      times 8 dw 0x8000
-yuv2yuvX_16_start:  times 4 dd 0x4000 - 0x40000000
-yuv2yuvX_10_start:  times 4 dd 0x10000
-yuv2yuvX_9_start:   times 4 dd 0x20000
-yuv2yuvX_10_upper:  times 8 dw 0x3ff
-yuv2yuvX_9_upper:   times 8 dw 0x1ff
-pd_4:          times 4 dd 4
-pd_4min0x40000:times 4 dd 4 - (0x40000)
-pw_16:         times 8 dw 16
-pw_32:         times 8 dw 32
+minshort:      times 16 dw 0x8000
+yuv2yuvX_16_start:  times 8 dd 0x4000 - 0x40000000
+yuv2yuvX_10_start:  times 8 dd 0x10000
+yuv2yuvX_9_start:   times 8 dd 0x20000
+yuv2yuvX_10_upper:  times 16 dw 0x3ff
+yuv2yuvX_9_upper:   times 16 dw 0x1ff
+pd_4:          times 8 dd 4
+pd_4min0x40000:times 8 dd 4 - (0x40000)
+pw_16:         times 16 dw 16
+pw_32:         times 16 dw 32
 pd_255:        times 8 dd 255
-pw_512:        times 8 dw 512
-pw_1024:       times 8 dw 1024
+pw_512:        times 16 dw 512
+pw_1024:       times 16 dw 1024
 
 yuv2nv12_shuffle_mask: times 2 db 0,  4,  8, 12, \
                                  -1, -1, -1, -1, \
@@ -65,6 +65,10 @@ SECTION .text
 ; data. The input is 15 bits in int16_t if $output_size is [8,10] and 19 bits in
 ; int32_t if $output_size is 16. $filter is 12 bits. $filterSize is a multiple
 ; of 2. $offset is either 0 or 3. $dither holds 8 values.
+;
+; The AVX2 versions handle 16 pixels per iteration, but only store the lower
+; half of the last one if it holds no more than 8 pixels, so they write no
+; further past $dstW than the SSE versions do.
 ;-----------------------------------------------------------------------------
 %macro yuv2planeX_mainloop 2
 .pixelloop_%2:
@@ -98,26 +102,39 @@ SECTION .text
     ; input pixels
     mov             r6, [srcq+gprsize*cntr_reg-2*gprsize]
 %if %1 == 16
-    mova            m3, [r6+r5*4]
-    mova            m5, [r6+r5*4+mmsize]
+    movsrc          m3, [r6+r5*4]
+    movsrc          m5, [r6+r5*4+mmsize]
 %else ; %1 == 8/9/10
-    mova            m3, [r6+r5*2]
+    movsrc          m3, [r6+r5*2]
 %endif ; %1 == 8/9/10/16
     mov             r6, [srcq+gprsize*cntr_reg-gprsize]
 %if %1 == 16
-    mova            m4, [r6+r5*4]
-    mova            m6, [r6+r5*4+mmsize]
+    movsrc          m4, [r6+r5*4]
+    movsrc          m6, [r6+r5*4+mmsize]
 %else ; %1 == 8/9/10
-    mova            m4, [r6+r5*2]
+    movsrc          m4, [r6+r5*2]
 %endif ; %1 == 8/9/10/16
 
     ; coefficients
+%if mmsize == 32
+%if %1 == 16
+    vpbroadcastw    m7, [filterq+2*cntr_reg-4] ; coeff[0]
+    vpbroadcastw    m0, [filterq+2*cntr_reg-2] ; coeff[1]
+    pmovsxwd        m7, xm7              ; word -> dword
+    pmovsxwd        m0, xm0              ; word -> dword
+%else ; %1 == 9/10
+    vpbroadcastd    m0, [filterq+2*cntr_reg-4] ; coeff[0], coeff[1]
+%endif ; %1 == 9/10/16
+%else ; mmsize == 8/16
     movd            m0, [filterq+2*cntr_reg-4] ; coeff[0], coeff[1]
 %if %1 == 16
     pshuflw         m7,  m0,  0          ; coeff[0]
     pshuflw         m0,  m0,  0x55       ; coeff[1]
     pmovsxwd        m7,  m7              ; word -> dword
     pmovsxwd        m0,  m0              ; word -> dword
+%endif ; %1 == 16
+%endif ; mmsize == 8/16
+%if %1 == 16
 
     pmulld          m3,  m7
     pmulld          m5,  m7
@@ -131,7 +148,9 @@ SECTION .text
 %else ; %1 == 10/9/8
     punpcklwd       m5,  m3,  m4
     punpckhwd       m3,  m4
+%if mmsize != 32
     SPLATD          m0
+%endif ; mmsize != 32
 
     pmaddwd         m5,  m0
     pmaddwd         m3,  m0
@@ -158,6 +177,9 @@ SECTION .text
 %else ; %1 == 9/10/16
 %if %1 == 16
     packssdw        m2,  m1
+%if mmsize == 32
+    vpermq          m2,  m2,  q3120
+%endif ; mmsize == 32
     paddw           m2, [minshort]
 %else ; %1 == 9/10
 %if cpuflag(sse4)
@@ -168,6 +190,10 @@ SECTION .text
 %endif ; mmxext/sse2/sse4/avx
     pminsw          m2, [yuv2yuvX_%1_upper]
 %endif ; %1 == 9/10/16
+%if mmsize == 32
+    cmp             wd,  mmsize/4
+    jle .last_%2
+%endif ; mmsize == 32
     mov%2   [dstq+r5*2],  m2
 %endif ; %1 == 8/9/10/16
 
@@ -247,8 +273,19 @@ cglobal yuv2planeX_%1, %3, 8, %2, filter, fltsize, src, dst, w, dither, offset
 
     xor             r5,  r5
 
+%if mmsize == 32
+%define movsrc movu
+%else ; mmsize == 8/16
+%define movsrc mova
+%endif ; mmsize == 8/16/32
+
 %if mmsize == 8 || %1 == 8
     yuv2planeX_mainloop %1, a
+%elif mmsize == 32
+    yuv2planeX_mainloop %1, u
+    RET
+.last_u:
+    movu    [dstq+r5*2], xm2
 %else ; mmsize == 16
     test          dstq, 15
     jnz .unaligned
@@ -256,7 +293,7 @@ cglobal yuv2planeX_%1, %3, 8, %2, filter, fltsize, src, dst, w, dither, offset
     REP_RET
 .unaligned:
     yuv2planeX_mainloop %1, u
-%endif ; mmsize == 8/16
+%endif ; mmsize == 8/16/32
 
 %if %1 == 8
 %if ARCH_X86_32
@@ -295,6 +332,13 @@ yuv2planeX_fn  9,  7, 5
 yuv2planeX_fn 10,  7, 5
 %endif
 
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+yuv2planeX_fn  9,  7, 5
+yuv2planeX_fn 10,  7, 5
+yuv2planeX_fn 16,  8, 5
+%endif
+
 ; %1=outout-bpc, %2=alignment (u/a)
 %macro yuv2plane1_mainloop 2
 .loop_%2:
@@ -305,6 +349,14 @@ yuv2planeX_fn 10,  7, 5
     psraw           m1, 7
     packuswb        m0, m1
     mov%2    [dstq+wq], m0
+%elif %1 == 16 && mmsize == 32
+    paddd           m0, m4, [srcq+wq*4+mmsize*0]
+    paddd           m1, m4, [srcq+wq*4+mmsize*1]
+    psrad           m0, 3
+    psrad           m1, 3
+    packusdw        m0, m1
+    vpermq          m0, m0, q3120
+    mov%2    [dstq+wq*2], m0
 %elif %1 == 16
     paddd           m0, m4, [srcq+wq*4+mmsize*0]
     paddd           m1, m4, [srcq+wq*4+mmsize*1]
@@ -325,6 +377,12 @@ yuv2planeX_fn 10,  7, 5
 %endif ; mmx/sse2/sse4/avx
     mov%2    [dstq+wq*2+mmsize*0], m0
     mov%2    [dstq+wq*2+mmsize*1], m2
+%elif mmsize == 32 ; %1 == 9/10
+    paddsw          m0, m2, [srcq+wq*2]
+    psraw           m0, 15 - %1
+    pmaxsw          m0, m4
+    pminsw          m0, m3
+    mov%2    [dstq+wq*2], m0
 %else ; %1 == 9/10
     paddsw          m0, m2, [srcq+wq*2+mmsize*0]
     paddsw          m1, m2, [srcq+wq*2+mmsize*1]
@@ -337,15 +395,20 @@ yuv2planeX_fn 10,  7, 5
     mov%2    [dstq+wq*2+mmsize*0], m0
     mov%2    [dstq+wq*2+mmsize*1], m1
 %endif
-    add             wq, mmsize
+    add             wq, pxstep
     jl .loop_%2
 %endmacro
 
 %macro yuv2plane1_fn 3
 cglobal yuv2plane1_%1, %3, %3, %2, src, dst, w, dither, offset
+%if mmsize == 32 ; one register of 16 pixels per iteration, like SSE
+%assign pxstep 16
+%else ; mmsize == 8/16
+%assign pxstep mmsize
+%endif ; mmsize == 8/16/32
     movsxdifnidn    wq, wd
-    add             wq, mmsize - 1
-    and             wq, ~(mmsize - 1)
+    add             wq, pxstep - 1
+    and             wq, ~(pxstep - 1)
 %if %1 == 8
     add           dstq, wq
 %else ; %1 != 8
@@ -398,6 +461,8 @@ cglobal yuv2plane1_%1, %3, %3, %2, src, dst, w, dither, offset
     ; actual pixel scaling
 %if mmsize == 8
     yuv2plane1_mainloop %1, a
+%elif mmsize == 32
+    yuv2plane1_mainloop %1, u
 %else ; mmsize == 16
     test          dstq, 15
     jnz .unaligned
@@ -405,7 +470,7 @@ cglobal yuv2plane1_%1, %3, %3, %2, src, dst, w, dither, offset
     REP_RET
 .unaligned:
     yuv2plane1_mainloop %1, u
-%endif ; mmsize == 8/16
+%endif ; mmsize == 8/16/32
     REP_RET
 %endmacro
 
@@ -436,6 +501,13 @@ yuv2plane1_fn 10, 5, 3
 yuv2plane1_fn 16, 5, 3
 %endif
 
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+yuv2plane1_fn  9, 5, 3
+yuv2plane1_fn 10, 5, 3
+yuv2plane1_fn 16, 5, 3
+%endif
+
 %undef movsx
 
 ;-----------------------------------------------------------------------------
@@ -421,3 +421,264 @@ INIT_XMM ssse3
 SCALE_FUNCS2 6, 6, 8
 INIT_XMM sse4
 SCALE_FUNCS2 6, 6, 8
+
+%if HAVE_AVX2_EXTERNAL && ARCH_X86_64
+;-----------------------------------------------------------------------------
+; AVX2 version of the above. Four output pixels are produced per iteration,
+; as in the SSE versions, so the filter and filterPos padding done in
+; initFilter() still covers everything that is read, but the source pixels
+; of two (4 taps: four) output pixels are filtered in one ymm register.
+;-----------------------------------------------------------------------------
+
+; SCALE_FUNC_AVX2 source_width, intermediate_nbits, filtersize, filtersuffix
+%macro SCALE_FUNC_AVX2 4
+%ifnidn %3, X
+cglobal hscale%1to%2_%4, 6, 9, 9, pos0, dst, w, src, filter, fltpos, pos1, pos2, pos3
+%else
+cglobal hscale%1to%2_%4, 7, 14, 9, pos0, dst, w, src, filter, fltpos, fltsize, \
+                                   pos1, pos2, pos3, srccur, fltcur, srcend, fltsize3
+%endif
+    movsxd        wq, wd
+%if %1 == 16
+    vpbroadcastd  m6, [minshort]
+    mova         xm7, [unicoeff]
+%endif ; %1 == 16
+%if %2 == 19
+    mova         xm8, [max_19bit_int]
+%endif ; %2 == 19
+
+%if %1 == 8
+%define srcmul 1
+%else ; %1 == 9-16
+%define srcmul 2
+%endif ; %1 == 8/9-16
+
+%ifnidn %3, X
+
+    ; setup loop
+%if %3 == 8
+    shl           wq, 1                         ; this allows *16 (i.e. now *8) in lea instructions for the 8-tap filter
+%define wshr 1
+%else ; %3 == 4
+%define wshr 0
+%endif ; %3 == 8
+    lea      filterq, [filterq+wq*8]
+%if %2 == 15
+    lea         dstq, [dstq+wq*(2>>wshr)]
+%else ; %2 == 19
+    lea         dstq, [dstq+wq*(4>>wshr)]
+%endif ; %2 == 15/19
+    lea      fltposq, [fltposq+wq*(4>>wshr)]
+    neg           wq
+
+.loop:
+    movsxd     pos0q, dword [fltposq+wq*(4>>wshr)+ 0] ; filterPos[0]
+    movsxd     pos1q, dword [fltposq+wq*(4>>wshr)+ 4] ; filterPos[1]
+    movsxd     pos2q, dword [fltposq+wq*(4>>wshr)+ 8] ; filterPos[2]
+    movsxd     pos3q, dword [fltposq+wq*(4>>wshr)+12] ; filterPos[3]
+%if %3 == 4 ; filterSize == 4 scaling
+    ; load 4x4 source pixels into m0
+%if %1 == 8
+    movd         xm0, [srcq+pos0q]              ; src[filterPos[0] + {0,1,2,3}]
+    pinsrd       xm0, [srcq+pos1q], 1           ; src[filterPos[1] + {0,1,2,3}]
+    pinsrd       xm0, [srcq+pos2q], 2           ; src[filterPos[2] + {0,1,2,3}]
+    pinsrd       xm0, [srcq+pos3q], 3           ; src[filterPos[3] + {0,1,2,3}]
+    pmovzxbw      m0, xm0                       ; byte -> word
+%else ; %1 > 8
+    movq         xm0, [srcq+pos0q*2]            ; src[filterPos[0] + {0,1,2,3}]
+    movhps       xm0, [srcq+pos1q*2]            ; src[filterPos[1] + {0,1,2,3}]
+    movq         xm1, [srcq+pos2q*2]            ; src[filterPos[2] + {0,1,2,3}]
+    movhps       xm1, [srcq+pos3q*2]            ; src[filterPos[3] + {0,1,2,3}]
+    vinserti128   m0, m0, xm1, 1
+%endif ; %1 == 8/9-16
+
+    ; multiply with filter coefficients
+%if %1 == 16 ; pmaddwd needs signed adds, so this moves unsigned -> signed, we'll
+             ; add back 0x8000 * sum(coeffs) after the horizontal add
+    psubw         m0, m6
+%endif ; %1 == 16
+    pmaddwd       m0, [filterq+wq*8]            ; *= filter[{0,1,..,14,15}]
+
+    ; add up horizontally (4 srcpix * 4 coefficients -> 1 dstpix)
+    vextracti128 xm1, m0, 1
+    phaddd       xm0, xm1                       ; filter[{ 0, 1, 2, 3}]*src[filterPos[0]+{0,1,2,3}],
+                                                ; filter[{ 4, 5, 6, 7}]*src[filterPos[1]+{0,1,2,3}],
+                                                ; filter[{ 8, 9,10,11}]*src[filterPos[2]+{0,1,2,3}],
+                                                ; filter[{12,13,14,15}]*src[filterPos[3]+{0,1,2,3}]
+%else ; %3 == 8, i.e. filterSize == 8 scaling
+    ; load 4x8 source pixels into m0 and m1
+%if %1 == 8
+    movq         xm0, [srcq+pos0q]              ; src[filterPos[0] + {0,1,2,3,4,5,6,7}]
+    movhps       xm0, [srcq+pos1q]              ; src[filterPos[1] + {0,1,2,3,4,5,6,7}]
+    movq         xm1, [srcq+pos2q]              ; src[filterPos[2] + {0,1,2,3,4,5,6,7}]
+    movhps       xm1, [srcq+pos3q]              ; src[filterPos[3] + {0,1,2,3,4,5,6,7}]
+    pmovzxbw      m0, xm0                       ; byte -> word
+    pmovzxbw      m1, xm1                       ; byte -> word
+%else ; %1 > 8
+    movu         xm0, [srcq+pos0q*2]            ; src[filterPos[0] + {0,1,2,3,4,5,6,7}]
+    vinserti128   m0, m0, [srcq+pos1q*2], 1     ; src[filterPos[1] + {0,1,2,3,4,5,6,7}]
+    movu         xm1, [srcq+pos2q*2]            ; src[filterPos[2] + {0,1,2,3,4,5,6,7}]
+    vinserti128   m1, m1, [srcq+pos3q*2], 1     ; src[filterPos[3] + {0,1,2,3,4,5,6,7}]
+%endif ; %1 == 8/9-16
+
+    ; multiply
+%if %1 == 16 ; pmaddwd needs signed adds, so this moves unsigned -> signed, we'll
+             ; add back 0x8000 * sum(coeffs) after the horizontal add
+    psubw         m0, m6
+    psubw         m1, m6
+%endif ; %1 == 16
+    pmaddwd       m0, [filterq+wq*8+mmsize*0]   ; *= filter[{0,1,..,14,15}]
+    pmaddwd       m1, [filterq+wq*8+mmsize*1]   ; *= filter[{16,17,..,30,31}]
+
+    ; add up horizontally (8 srcpix * 8 coefficients -> 1 dstpix)
+    phaddd        m0, m1                        ; dstpix {0,0,2,2 | 1,1,3,3}
+    vextracti128 xm1, m0, 1
+    phaddd       xm0, xm1                       ; dstpix {0,2,1,3}
+    pshufd       xm0, xm0, q3120
+%endif ; %3 == 4/8
+
+%else ; %3 == X, i.e. any filterSize scaling
+
+%ifidn %4, X4
+%define dlt 4
+%else ; %4 == X8
+%define dlt 0
+%endif ; %4 ==/!= X4
+    movsxd  fltsizeq, fltsized                  ; filterSize
+    lea      srcendq, [srcq+(fltsizeq-dlt)*srcmul] ; &src[filterSize&~4]
+    add     fltsizeq, fltsizeq                  ; filterSize * sizeof(*filter)
+    lea    fltsize3q, [fltsizeq*3]
+    lea      fltposq, [fltposq+wq*4]
+%if %2 == 15
+    lea         dstq, [dstq+wq*2]
+%else ; %2 == 19
+    lea         dstq, [dstq+wq*4]
+%endif ; %2 == 15/19
+    neg           wq
+
+.loop:
+    movsxd     pos0q, dword [fltposq+wq*4+ 0]   ; filterPos[0]
+    movsxd     pos1q, dword [fltposq+wq*4+ 4]   ; filterPos[1]
+    movsxd     pos2q, dword [fltposq+wq*4+ 8]   ; filterPos[2]
+    movsxd     pos3q, dword [fltposq+wq*4+12]   ; filterPos[3]
+    pxor          m4, m4
+    pxor          m5, m5
+    mov      srccurq, srcq
+    mov      fltcurq, filterq
+
+.innerloop:
+    ; load 4x8 source pixels into m0 and m1 -> m4/m5
+%if %1 == 8
+    movq         xm0, [srccurq+pos0q]
+    movhps       xm0, [srccurq+pos1q]
+    movq         xm1, [srccurq+pos2q]
+    movhps       xm1, [srccurq+pos3q]
+    pmovzxbw      m0, xm0
+    pmovzxbw      m1, xm1
+%else ; %1 > 8
+    movu         xm0, [srccurq+pos0q*2]
+    vinserti128   m0, m0, [srccurq+pos1q*2], 1
+    movu         xm1, [srccurq+pos2q*2]
+    vinserti128   m1, m1, [srccurq+pos3q*2], 1
+%endif ; %1 == 8/9-16
+    movu         xm2, [fltcurq]
+    vinserti128   m2, m2, [fltcurq+fltsizeq], 1
+    movu         xm3, [fltcurq+fltsizeq*2]
+    vinserti128   m3, m3, [fltcurq+fltsize3q], 1
+
+    ; multiply
+%if %1 == 16 ; pmaddwd needs signed adds, so this moves unsigned -> signed, we'll
+             ; add back 0x8000 * sum(coeffs) after the horizontal add
+    psubw         m0, m6
+    psubw         m1, m6
+%endif ; %1 == 16
+    pmaddwd       m0, m2
+    pmaddwd       m1, m3
+    paddd         m4, m0
+    paddd         m5, m1
+    add      fltcurq, 16
+    add      srccurq, srcmul*8
+    cmp      srccurq, srcendq                   ; while (src += 8) < &src[filterSize]
+    jl .innerloop
+
+    phaddd        m4, m5                        ; dstpix {0,0,2,2 | 1,1,3,3}
+    vextracti128 xm5, m4, 1
+    phaddd       xm0, xm4, xm5                  ; dstpix {0,2,1,3}
+    pshufd       xm0, xm0, q3120
+
+%ifidn %4, X4
+    ; last 4 srcpx of each dstpx
+%if %1 == 8
+    movd         xm1, [srccurq+pos0q]
+    pinsrd       xm1, [srccurq+pos1q], 1
+    pinsrd       xm1, [srccurq+pos2q], 2
+    pinsrd       xm1, [srccurq+pos3q], 3
+    pmovzxbw      m1, xm1
+%else ; %1 > 8
+    movq         xm1, [srccurq+pos0q*2]
+    movhps       xm1, [srccurq+pos1q*2]
+    movq         xm2, [srccurq+pos2q*2]
+    movhps       xm2, [srccurq+pos3q*2]
+    vinserti128   m1, m1, xm2, 1
+%endif ; %1 == 8/9-16
+    movq         xm2, [fltcurq]
+    movhps       xm2, [fltcurq+fltsizeq]
+    movq         xm3, [fltcurq+fltsizeq*2]
+    movhps       xm3, [fltcurq+fltsize3q]
+    vinserti128   m2, m2, xm3, 1
+%if %1 == 16 ; pmaddwd needs signed adds, so this moves unsigned -> signed, we'll
+             ; add back 0x8000 * sum(coeffs) after the horizontal add
+    psubw         m1, m6
+%endif ; %1 == 16
+    pmaddwd       m1, m2
+    vextracti128 xm2, m1, 1
+    phaddd       xm1, xm2
+    paddd        xm0, xm1
+%endif ; %4 == X4
+
+    lea      filterq, [filterq+fltsizeq*4]
+%endif ; %3 ==/!= X
+
+%if %1 == 16 ; add 0x8000 * sum(coeffs), i.e. back from signed -> unsigned
+    paddd        xm0, xm7
+%endif ; %1 == 16
+
+    ; clip, store
+    psrad        xm0, 14 + %1 - %2
+%ifidn %3, X
+%define wshr 0
+%endif ; %3 == X
+%if %2 == 15
+    packssdw     xm0, xm0
+    movq [dstq+wq*(2>>wshr)], xm0
+%else ; %2 == 19
+    pminsd       xm0, xm8
+    movu [dstq+wq*(4>>wshr)], xm0
+%endif ; %2 == 15/19
+    add           wq, 4<<wshr
+    jl .loop
+    RET
+%endmacro
+
+; SCALE_FUNCS_AVX2 source_width, intermediate_nbits
+%macro SCALE_FUNCS_AVX2 2
+SCALE_FUNC_AVX2 %1, %2, 4, 4
+SCALE_FUNC_AVX2 %1, %2, 8, 8
+SCALE_FUNC_AVX2 %1, %2, X, X4
+SCALE_FUNC_AVX2 %1, %2, X, X8
+%endmacro
+
+INIT_YMM avx2
+SCALE_FUNCS_AVX2  8, 15
+SCALE_FUNCS_AVX2  9, 15
+SCALE_FUNCS_AVX2 10, 15
+SCALE_FUNCS_AVX2 12, 15
+SCALE_FUNCS_AVX2 14, 15
+SCALE_FUNCS_AVX2 16, 15
+SCALE_FUNCS_AVX2  8, 19
+SCALE_FUNCS_AVX2  9, 19
+SCALE_FUNCS_AVX2 10, 19
+SCALE_FUNCS_AVX2 12, 19
+SCALE_FUNCS_AVX2 14, 19
+SCALE_FUNCS_AVX2 16, 19
+%endif
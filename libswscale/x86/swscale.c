@@ -275,6 +275,9 @@ SCALE_FUNCS_MMX(mmx);
 SCALE_FUNCS_SSE(sse2);
 SCALE_FUNCS_SSE(ssse3);
 SCALE_FUNCS_SSE(sse4);
+#if ARCH_X86_64
+SCALE_FUNCS_SSE(avx2);
+#endif
 
 #define VSCALEX_FUNC(size, opt) \
 void ff_yuv2planeX_ ## size ## _ ## opt(const int16_t *filter, int filterSize, \
@@ -292,6 +295,11 @@ VSCALEX_FUNCS(sse2);
 VSCALEX_FUNCS(sse4);
 VSCALEX_FUNC(16, sse4);
 VSCALEX_FUNCS(avx);
+#if ARCH_X86_64
+VSCALEX_FUNC(9,  avx2);
+VSCALEX_FUNC(10, avx2);
+VSCALEX_FUNC(16, avx2);
+#endif
 
 #define VSCALE_FUNC(size, opt) \
 void ff_yuv2plane1_ ## size ## _ ## opt(const int16_t *src, uint8_t *dst, int dstW, \
@@ -308,6 +316,11 @@ VSCALE_FUNCS(mmx, mmxext);
 VSCALE_FUNCS(sse2, sse2);
 VSCALE_FUNC(16, sse4);
 VSCALE_FUNCS(avx, avx);
+#if ARCH_X86_64
+VSCALE_FUNC(9,  avx2);
+VSCALE_FUNC(10, avx2);
+VSCALE_FUNC(16, avx2);
+#endif
 
 #define INPUT_Y_FUNC(fmt, opt) \
 void ff_ ## fmt ## ToY_  ## opt(uint8_t *dst, const uint8_t *src, \
@@ -342,6 +355,28 @@ INPUT_FUNCS(ssse3);
 INPUT_FUNCS(avx);
 
 #if ARCH_X86_64
+INPUT_FUNC(rgb48LE,  avx2);
+INPUT_FUNC(bgr48LE,  avx2);
+INPUT_FUNC(rgba64LE, avx2);
+INPUT_FUNC(bgra64LE, avx2);
+
+#define INPUT_PLANAR_RGB_Y_FN_DECL(fmt, opt) \
+void ff_planar_##fmt##_to_y_##opt(uint8_t *dst, \
+                                  const uint8_t *src[4], int w, int32_t *rgb2yuv)
+#define INPUT_PLANAR_RGB_UV_FN_DECL(fmt, opt) \
+void ff_planar_##fmt##_to_uv_##opt(uint8_t *dstU, uint8_t *dstV, \
+                                   const uint8_t *src[4], int w, int32_t *rgb2yuv)
+#define INPUT_PLANAR_RGB_FN_DECL(fmt, opt) \
+    INPUT_PLANAR_RGB_Y_FN_DECL(fmt, opt); \
+    INPUT_PLANAR_RGB_UV_FN_DECL(fmt, opt)
+
+INPUT_PLANAR_RGB_FN_DECL(rgb9le,   avx2);
+INPUT_PLANAR_RGB_FN_DECL(rgb10le,  avx2);
+INPUT_PLANAR_RGB_FN_DECL(rgb12le,  avx2);
+INPUT_PLANAR_RGB_FN_DECL(rgb14le,  avx2);
+INPUT_PLANAR_RGB_FN_DECL(rgb16le,  avx2);
+INPUT_PLANAR_RGB_FN_DECL(rgbf32le, avx2);
+
 #define YUV2NV_DECL(fmt, opt) \
 void ff_yuv2 ## fmt ## cX_ ## opt(enum AVPixelFormat format, const uint8_t *dither, \
                                   const int16_t *filter, int filterSize, \
@@ -568,7 +603,54 @@ switch(c->dstBpc){ \
     }
 
 #if ARCH_X86_64
+#define ASSIGN_PLANAR_RGB_FUNC(x, X, opt) \
+        case AV_PIX_FMT_ ## X: \
+            c->readLumPlanar = ff_planar_ ## x ## _to_y_ ## opt; \
+            c->readChrPlanar = ff_planar_ ## x ## _to_uv_ ## opt; \
+            break
     if (EXTERNAL_AVX2_FAST(cpu_flags)) {
+        ASSIGN_SSE_SCALE_FUNC(c->hyScale, c->hLumFilterSize, avx2, avx2);
+        ASSIGN_SSE_SCALE_FUNC(c->hcScale, c->hChrFilterSize, avx2, avx2);
+        switch (c->dstBpc) {
+        case 16:
+            if (!isBE(c->dstFormat)) {
+                c->yuv2planeX = ff_yuv2planeX_16_avx2;
+                c->yuv2plane1 = ff_yuv2plane1_16_avx2;
+            }
+            break;
+        case 10:
+            if (!isBE(c->dstFormat) && c->dstFormat != AV_PIX_FMT_P010LE) {
+                c->yuv2planeX = ff_yuv2planeX_10_avx2;
+                c->yuv2plane1 = ff_yuv2plane1_10_avx2;
+            }
+            break;
+        case 9:
+            if (!isBE(c->dstFormat)) {
+                c->yuv2planeX = ff_yuv2planeX_9_avx2;
+                c->yuv2plane1 = ff_yuv2plane1_9_avx2;
+            }
+            break;
+        }
+
+        switch (c->srcFormat) {
+        case_rgb(rgb48LE,  RGB48LE,  avx2);
+        case_rgb(bgr48LE,  BGR48LE,  avx2);
+        case_rgb(rgba64LE, RGBA64LE, avx2);
+        case_rgb(bgra64LE, BGRA64LE, avx2);
+        ASSIGN_PLANAR_RGB_FUNC(rgb9le,   GBRP9LE,    avx2);
+        ASSIGN_PLANAR_RGB_FUNC(rgb10le,  GBRP10LE,   avx2);
+        ASSIGN_PLANAR_RGB_FUNC(rgb10le,  GBRAP10LE,  avx2);
+        ASSIGN_PLANAR_RGB_FUNC(rgb12le,  GBRP12LE,   avx2);
+        ASSIGN_PLANAR_RGB_FUNC(rgb12le,  GBRAP12LE,  avx2);
+        ASSIGN_PLANAR_RGB_FUNC(rgb14le,  GBRP14LE,   avx2);
+        ASSIGN_PLANAR_RGB_FUNC(rgb16le,  GBRP16LE,   avx2);
+        ASSIGN_PLANAR_RGB_FUNC(rgb16le,  GBRAP16LE,  avx2);
+        ASSIGN_PLANAR_RGB_FUNC(rgbf32le, GBRPF32LE,  avx2);
+        ASSIGN_PLANAR_RGB_FUNC(rgbf32le, GBRAPF32LE, avx2);
+        default:
+            break;
+        }
+
         switch (c->dstFormat) {
         case AV_PIX_FMT_NV12:
         case AV_PIX_FMT_NV24:
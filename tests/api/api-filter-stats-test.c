@@ -0,0 +1,234 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/**
+ * Filter statistics API test
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libavfilter/avfilter.h"
+#include "libavfilter/buffersink.h"
+#include "libavfilter/buffersrc.h"
+#include "libavutil/channel_layout.h"
+#include "libavutil/frame.h"
+#include "libavutil/imgutils.h"
+
+#define NB_FRAMES  10
+#define WIDTH      64
+#define HEIGHT     48
+#define NB_SAMPLES 100
+
+static int create_graph(AVFilterGraph **graph, int collect_stats,
+                        const char *src_name, const char *src_args,
+                        const char *filt_name, const char *filt_args,
+                        const char *sink_name, AVFilterContext **src,
+                        AVFilterContext **filt, AVFilterContext **sink)
+{
+    int ret;
+
+    *graph = avfilter_graph_alloc();
+    if (!*graph)
+        return AVERROR(ENOMEM);
+    (*graph)->nb_threads    = 1;
+    (*graph)->collect_stats = collect_stats;
+
+    if ((ret = avfilter_graph_create_filter(src, avfilter_get_by_name(src_name),
+                                            "src", src_args, NULL, *graph)) < 0 ||
+        (ret = avfilter_graph_create_filter(filt, avfilter_get_by_name(filt_name),
+                                            "filt", filt_args, NULL, *graph)) < 0 ||
+        (ret = avfilter_graph_create_filter(sink, avfilter_get_by_name(sink_name),
+                                            "sink", NULL, NULL, *graph)) < 0 ||
+        (ret = avfilter_link(*src, 0, *filt, 0)) < 0 ||
+        (ret = avfilter_link(*filt, 0, *sink, 0)) < 0)
+        return ret;
+
+    return avfilter_graph_config(*graph, NULL);
+}
+
+static int drain(AVFilterContext *sink, AVFrame *frame, int *nb_frames)
+{
+    int ret;
+
+    while ((ret = av_buffersink_get_frame(sink, frame)) >= 0) {
+        (*nb_frames)++;
+        av_frame_unref(frame);
+    }
+    return ret == AVERROR(EAGAIN) || ret == AVERROR_EOF ? 0 : ret;
+}
+
+static void print_stats(const char *name, const AVFilterContext *filter)
+{
+    AVFilterStats stats;
+
+    if (avfilter_get_stats(filter, &stats) < 0)
+        return;
+    printf("%s: frame_count_in=%"PRId64" frame_count_out=%"PRId64" activated=%d\n",
+           name, stats.frame_count_in, stats.frame_count_out,
+           stats.nb_activations > 0);
+}
+
+static void print_link_stats(const char *name, const AVFilterLink *link)
+{
+    AVFilterLinkStats stats;
+
+    if (avfilter_link_get_stats(link, &stats) < 0)
+        return;
+    printf("%s: frame_count_in=%"PRId64" frame_count_out=%"PRId64
+           " queued_frames=%"PRId64" max_queued_frames=%"PRId64
+           " max_queued_samples=%"PRId64"\n",
+           name, stats.frame_count_in, stats.frame_count_out,
+           stats.queued_frames, stats.max_queued_frames,
+           stats.max_queued_samples);
+}
+
+static int test_video(AVFrame *frame)
+{
+    AVFilterGraph *graph = NULL;
+    AVFilterContext *src, *filt, *sink;
+    AVFilterStats stats;
+    int64_t frame_size;
+    int i, nb_out = 0, ret;
+
+    ret = create_graph(&graph, 1, "buffer",
+                       "video_size=64x48:pix_fmt=yuv420p:time_base=1/25",
+                       "hflip", NULL, "buffersink", &src, &filt, &sink);
+    if (ret < 0)
+        goto end;
+
+    for (i = 0; i < NB_FRAMES; i++) {
+        frame->format = AV_PIX_FMT_YUV420P;
+        frame->width  = WIDTH;
+        frame->height = HEIGHT;
+        frame->pts    = i;
+        if ((ret = av_frame_get_buffer(frame, 0)) < 0)
+            goto end;
+        memset(frame->data[0], i, frame->linesize[0] * HEIGHT);
+        memset(frame->data[1], 128, frame->linesize[1] * HEIGHT / 2);
+        memset(frame->data[2], 128, frame->linesize[2] * HEIGHT / 2);
+        if ((ret = av_buffersrc_add_frame(src, frame)) < 0 ||
+            (ret = drain(sink, frame, &nb_out)) < 0)
+            goto end;
+    }
+    if ((ret = av_buffersrc_add_frame(src, NULL)) < 0 ||
+        (ret = drain(sink, frame, &nb_out)) < 0)
+        goto end;
+
+    printf("video: %d frames out\n", nb_out);
+    print_stats("video src", src);
+    print_stats("video filt", filt);
+    print_link_stats("video filt input", filt->inputs[0]);
+    print_link_stats("video filt output", filt->outputs[0]);
+
+    /* hflip gets a new buffer for every frame, the source none; the buffer
+     * sizes depend on the alignment, so only check the lower bound */
+    frame_size = av_image_get_buffer_size(AV_PIX_FMT_YUV420P, WIDTH, HEIGHT, 1);
+    if ((ret = avfilter_get_stats(filt, &stats)) < 0)
+        goto end;
+    printf("video filt: bytes_requested %s\n",
+           stats.bytes_requested >= NB_FRAMES * frame_size ? "ok" : "too small");
+    if ((ret = avfilter_get_stats(src, &stats)) < 0)
+        goto end;
+    printf("video src: bytes_requested=%"PRId64"\n", stats.bytes_requested);
+
+end:
+    avfilter_graph_free(&graph);
+    return ret;
+}
+
+static int test_audio(AVFrame *frame)
+{
+    AVFilterGraph *graph = NULL;
+    AVFilterContext *src, *filt, *sink;
+    int i, nb_out = 0, ret;
+
+    ret = create_graph(&graph, 1, "abuffer",
+                       "sample_rate=8000:sample_fmt=s16:channel_layout=mono",
+                       "asetnsamples", "n=256:p=0", "abuffersink",
+                       &src, &filt, &sink);
+    if (ret < 0)
+        goto end;
+
+    /* queue all the frames before pulling, so they pile up in the links */
+    for (i = 0; i < NB_FRAMES; i++) {
+        frame->format         = AV_SAMPLE_FMT_S16;
+        frame->channel_layout = AV_CH_LAYOUT_MONO;
+        frame->sample_rate    = 8000;
+        frame->nb_samples     = NB_SAMPLES;
+        frame->pts            = i * NB_SAMPLES;
+        if ((ret = av_frame_get_buffer(frame, 0)) < 0)
+            goto end;
+        av_samples_set_silence(frame->extended_data, 0, NB_SAMPLES, 1,
+                               AV_SAMPLE_FMT_S16);
+        if ((ret = av_buffersrc_add_frame(src, frame)) < 0)
+            goto end;
+    }
+    if ((ret = av_buffersrc_add_frame(src, NULL)) < 0 ||
+        (ret = drain(sink, frame, &nb_out)) < 0)
+        goto end;
+
+    printf("audio: %d frames out\n", nb_out);
+    print_stats("audio filt", filt);
+    print_link_stats("audio filt input", filt->inputs[0]);
+    print_link_stats("audio filt output", filt->outputs[0]);
+
+end:
+    avfilter_graph_free(&graph);
+    return ret;
+}
+
+static int test_disabled(void)
+{
+    AVFilterGraph *graph = NULL;
+    AVFilterContext *src, *filt, *sink;
+    AVFilterStats stats;
+    AVFilterLinkStats link_stats;
+    int ret;
+
+    ret = create_graph(&graph, 0, "buffer",
+                       "video_size=64x48:pix_fmt=yuv420p:time_base=1/25",
+                       "hflip", NULL, "buffersink", &src, &filt, &sink);
+    if (ret >= 0) {
+        printf("disabled: filter %s, link %s\n",
+               avfilter_get_stats(filt, &stats) == AVERROR(ENOSYS) ? "ENOSYS" : "failed",
+               avfilter_link_get_stats(filt->inputs[0], &link_stats) == AVERROR(ENOSYS) ? "ENOSYS" : "failed");
+    }
+
+    avfilter_graph_free(&graph);
+    return ret;
+}
+
+int main(void)
+{
+    AVFrame *frame = av_frame_alloc();
+    int ret;
+
+    if (!frame)
+        return 1;
+
+    if ((ret = test_video(frame)) < 0 ||
+        (ret = test_audio(frame)) < 0 ||
+        (ret = test_disabled()) < 0)
+        fprintf(stderr, "Error: %s\n", av_err2str(ret));
+
+    av_frame_free(&frame);
+    return ret < 0;
+}
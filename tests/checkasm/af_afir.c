@@ -21,7 +21,7 @@
 #include <float.h>
 #include <stdint.h>
 
-#include "libavfilter/af_afir.h"
+#include "libavfilter/af_afirdsp.h"
 #include "libavutil/internal.h"
 #include "libavutil/mem_internal.h"
 #include "checkasm.h"
@@ -0,0 +1,119 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <float.h>
+#include <string.h>
+
+#include "libavfilter/af_arnndndsp.h"
+#include "libavutil/internal.h"
+#include "libavutil/mem_internal.h"
+#include "checkasm.h"
+
+#define LEN    96
+#define ROWS   24
+#define STRIDE (LEN * 3)
+
+static void randomize_buffer(float *buf, int len)
+{
+    for (int i = 0; i < len; i++)
+        buf[i] = (int)(rnd() % 2001 - 1000) / 1000.f;
+}
+
+static int check_rows(const float *ref, const float *new, const float *w,
+                      const float *src, int rows)
+{
+    for (int i = 0; i < rows; i++) {
+        double t = 1.0;
+
+        for (int k = 0; k < LEN; k++)
+            t += fabs(w[i * STRIDE + k] * src[k]);
+        if (!float_near_abs_eps(ref[i], new[i], t * 2 * FLT_EPSILON)) {
+            fprintf(stderr, "%d: %- .12f - %- .12f = % .12g\n",
+                    i, ref[i], new[i], ref[i] - new[i]);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void check_dot_rows(const float *w, const float *src)
+{
+    LOCAL_ALIGNED_32(float, dst0, [ROWS]);
+    LOCAL_ALIGNED_32(float, dst1, [ROWS]);
+
+    declare_func(void, float *dst, const float *w, ptrdiff_t w_stride,
+                 const float *src, ptrdiff_t len, ptrdiff_t rows);
+
+    for (int rows = ROWS - 3; rows <= ROWS; rows += 3) {
+        memset(dst0, 0, ROWS * sizeof(float));
+        memset(dst1, 0, ROWS * sizeof(float));
+        call_ref(dst0, w, STRIDE, src, LEN, rows);
+        call_new(dst1, w, STRIDE, src, LEN, rows);
+        if (!check_rows(dst0, dst1, w, src, rows))
+            fail();
+    }
+    bench_new(dst1, w, STRIDE, src, LEN, ROWS);
+}
+
+static void check_dot_rows4(const AudioRNNDSPContext *dsp, const float *w, const float *src)
+{
+    LOCAL_ALIGNED_32(float, dst0, [ARNNDN_BATCH * ROWS]);
+    LOCAL_ALIGNED_32(float, dst1, [ARNNDN_BATCH * ROWS]);
+    LOCAL_ALIGNED_32(float, dst2, [ROWS]);
+
+    declare_func(void, float *dst, ptrdiff_t dst_stride,
+                 const float *w, ptrdiff_t w_stride,
+                 const float *src, ptrdiff_t src_stride,
+                 ptrdiff_t len, ptrdiff_t rows);
+
+    for (int rows = ROWS - 3; rows <= ROWS; rows += 3) {
+        memset(dst0, 0, ARNNDN_BATCH * ROWS * sizeof(float));
+        memset(dst1, 0, ARNNDN_BATCH * ROWS * sizeof(float));
+        call_ref(dst0, ROWS, w, STRIDE, src, LEN, LEN, rows);
+        call_new(dst1, ROWS, w, STRIDE, src, LEN, LEN, rows);
+        for (int b = 0; b < ARNNDN_BATCH; b++) {
+            if (!check_rows(dst0 + b * ROWS, dst1 + b * ROWS, w, src + b * LEN, rows))
+                fail();
+            /* batching must not change the output of a channel */
+            dsp->dot_rows(dst2, w, STRIDE, src + b * LEN, LEN, rows);
+            if (memcmp(dst1 + b * ROWS, dst2, rows * sizeof(float)))
+                fail();
+        }
+    }
+    bench_new(dst1, ROWS, w, STRIDE, src, LEN, LEN, ROWS);
+}
+
+void checkasm_check_arnndn(void)
+{
+    LOCAL_ALIGNED_32(float, w,   [ROWS * STRIDE]);
+    LOCAL_ALIGNED_32(float, src, [ARNNDN_BATCH * LEN]);
+    AudioRNNDSPContext dsp = { 0 };
+
+    ff_arnndn_init(&dsp);
+
+    randomize_buffer(w, ROWS * STRIDE);
+    randomize_buffer(src, ARNNDN_BATCH * LEN);
+
+    if (check_func(dsp.dot_rows, "dot_rows"))
+        check_dot_rows(w, src);
+    report("dot_rows");
+
+    if (check_func(dsp.dot_rows4, "dot_rows4"))
+        check_dot_rows4(&dsp, w, src);
+    report("dot_rows4");
+}
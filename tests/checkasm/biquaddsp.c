@@ -0,0 +1,110 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "libavfilter/biquaddsp.h"
+#include "libavutil/internal.h"
+#include "libavutil/mem_internal.h"
+#include "checkasm.h"
+
+#define LEN          256
+#define MAX_SECTIONS 3
+
+static const char *const form_names[BIQUAD_NB_FORMS] = { "di", "dii", "tdii", "latt" };
+
+/* stable sections with random poles and zeros, each lane being different */
+#define SET_SECTIONS(name, type, lanes)                                                  \
+static void set_sections_## name(type *coeffs, enum BiquadForm form)              \
+{                                                                                  \
+    for (int s = 0; s < MAX_SECTIONS; s++) {                                       \
+        for (int l = 0; l < lanes; l++) {                                          \
+            double r     = 0.5 + (rnd() % 1024) / 2560.0;                          \
+            double theta = (rnd() % 1024) * M_PI / 1024.0;                         \
+            double b[3];                                                           \
+                                                                                   \
+            for (int i = 0; i < 3; i++)                                            \
+                b[i] = (int)(rnd() % 2048 - 1024) / 1024.0;                        \
+            ff_biquaddsp_set_section_## name(coeffs, s, l, form, b[0], b[1], b[2], \
+                                             -2. * r * cos(theta), r * r);         \
+        }                                                                          \
+    }                                                                              \
+}
+
+#define CHECK_FILTER(name, type, lanes)                                                  \
+static void check_filter_## name(BiquadDSPContext *dsp, enum BiquadForm form)      \
+{                                                                                  \
+    LOCAL_ALIGNED_32(type, buf0,   [LEN * lanes]);                                 \
+    LOCAL_ALIGNED_32(type, buf1,   [LEN * lanes]);                                 \
+    LOCAL_ALIGNED_32(type, state0, [MAX_SECTIONS * BIQUAD_NB_STATES * lanes]);     \
+    LOCAL_ALIGNED_32(type, state1, [MAX_SECTIONS * BIQUAD_NB_STATES * lanes]);     \
+    LOCAL_ALIGNED_32(type, coeffs, [MAX_SECTIONS * BIQUAD_NB_COEFFS * lanes]);     \
+    const int state_size = MAX_SECTIONS * BIQUAD_NB_STATES * lanes * sizeof(type); \
+                                                                                   \
+    declare_func(void, type *buf, ptrdiff_t len, const type *coeffs,               \
+                 type *state, int nb_sections);                                    \
+                                                                                   \
+    if (!check_func(dsp->filter_## name[form], "biquad_%s_" #name, form_names[form])) \
+        return;                                                                    \
+                                                                                   \
+    set_sections_## name(coeffs, form);                                            \
+    for (int i = 0; i < MAX_SECTIONS * BIQUAD_NB_STATES * lanes; i++)              \
+        state0[i] = (int)(rnd() % 2048 - 1024) / 1024.0;                           \
+    memcpy(state1, state0, state_size);                                            \
+                                                                                   \
+    for (int nb_sections = 0; nb_sections <= MAX_SECTIONS; nb_sections++) {        \
+        int len = LEN - (rnd() & 7);                                               \
+                                                                                   \
+        for (int i = 0; i < LEN * lanes; i++)                                      \
+            buf0[i] = (int)(rnd() % 65536 - 32768) / 32768.0;                      \
+        memcpy(buf1, buf0, LEN * lanes * sizeof(type));                            \
+                                                                                   \
+        call_ref(buf0, len, coeffs, state0, nb_sections);                          \
+        call_new(buf1, len, coeffs, state1, nb_sections);                          \
+        if (memcmp(buf0, buf1, LEN * lanes * sizeof(type)) ||                      \
+            memcmp(state0, state1, state_size))                                    \
+            fail();                                                                \
+                                                                                   \
+        call_ref(buf0, 0, coeffs, state0, nb_sections);                            \
+        call_new(buf1, 0, coeffs, state1, nb_sections);                            \
+        if (memcmp(state0, state1, state_size))                                    \
+            fail();                                                                \
+    }                                                                              \
+    bench_new(buf1, LEN, coeffs, state1, MAX_SECTIONS);                            \
+}
+
+SET_SECTIONS(flt, float,  BIQUAD_LANES_FLT)
+SET_SECTIONS(dbl, double, BIQUAD_LANES_DBL)
+CHECK_FILTER(flt, float,  BIQUAD_LANES_FLT)
+CHECK_FILTER(dbl, double, BIQUAD_LANES_DBL)
+
+void checkasm_check_biquaddsp(void)
+{
+    BiquadDSPContext dsp;
+
+    ff_biquaddsp_init(&dsp);
+
+    for (int form = 0; form < BIQUAD_NB_FORMS; form++)
+        check_filter_flt(&dsp, form);
+    report("filter_flt");
+
+    for (int form = 0; form < BIQUAD_NB_FORMS; form++)
+        check_filter_dbl(&dsp, form);
+    report("filter_dbl");
+}
@@ -92,6 +92,9 @@ static const struct {
     #if CONFIG_DCA_DECODER
         { "synth_filter", checkasm_check_synth_filter },
     #endif
+    #if CONFIG_DNXHD_ENCODER
+        { "dnxhdenc", checkasm_check_dnxhdenc },
+    #endif
     #if CONFIG_EXR_DECODER
         { "exrdsp", checkasm_check_exrdsp },
     #endif
@@ -140,12 +143,18 @@ static const struct {
     #if CONFIG_LLVIDENCDSP
         { "llviddspenc", checkasm_check_llviddspenc },
     #endif
+    #if CONFIG_ME_CMP
+        { "motion", checkasm_check_motion },
+    #endif
     #if CONFIG_OPUS_DECODER
         { "opusdsp", checkasm_check_opusdsp },
     #endif
     #if CONFIG_PIXBLOCKDSP
         { "pixblockdsp", checkasm_check_pixblockdsp },
     #endif
+    #if CONFIG_PRORES_DECODER
+        { "proresdsp", checkasm_check_proresdsp },
+    #endif
     #if CONFIG_UTVIDEO_DECODER
         { "utvideodsp", checkasm_check_utvideodsp },
     #endif
@@ -169,6 +178,16 @@ static const struct {
     #if CONFIG_AFIR_FILTER
         { "af_afir", checkasm_check_afir },
     #endif
+    #if CONFIG_ARNNDN_FILTER
+        { "af_arnndn", checkasm_check_arnndn },
+    #endif
+    #if CONFIG_ACROSSOVER_FILTER || CONFIG_BIQUAD_FILTER
+        { "biquaddsp", checkasm_check_biquaddsp },
+    #endif
+        { "drawutils", checkasm_check_drawutils },
+    #if CONFIG_EBUR128_FILTER || CONFIG_LOUDNORM_FILTER
+        { "ebur128dsp", checkasm_check_ebur128dsp },
+    #endif
     #if CONFIG_BLEND_FILTER
         { "vf_blend", checkasm_check_blend },
     #endif
@@ -187,10 +206,17 @@ static const struct {
     #if CONFIG_NLMEANS_FILTER
         { "vf_nlmeans", checkasm_check_nlmeans },
     #endif
+    #if CONFIG_OVERLAY_FILTER
+        { "vf_overlay", checkasm_check_vf_overlay },
+    #endif
     #if CONFIG_THRESHOLD_FILTER
         { "vf_threshold", checkasm_check_vf_threshold },
     #endif
 #endif
+#if CONFIG_SWRESAMPLE
+    { "sw_audio", checkasm_check_sw_audio },
+    { "sw_resample", checkasm_check_sw_resample },
+#endif
 #if CONFIG_SWSCALE
     { "sw_rgb", checkasm_check_sw_rgb },
     { "sw_scale", checkasm_check_sw_scale },
@@ -0,0 +1,76 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <string.h>
+
+#include "libavutil/common.h"
+#include "libavutil/mem_internal.h"
+
+#include "libavcodec/dnxhdenc.h"
+#include "libavcodec/mathops.h"
+
+#include "checkasm.h"
+
+static void check_quantize_10bit(DNXHDEncContext *ctx)
+{
+    LOCAL_ALIGNED_32(int16_t, block0, [64]);
+    LOCAL_ALIGNED_32(int16_t, block1, [64]);
+    LOCAL_ALIGNED_32(int16_t, scan_pos, [64]);
+    LOCAL_ALIGNED_32(int, qmat, [64]);
+    int i, j, last0, last1, max0, max1;
+
+    declare_func(int, int16_t *block, const int *qmat, int bias, int shift,
+                 const int16_t *scan_pos, int *max);
+
+    for (i = 0; i < 64; i++)
+        scan_pos[ff_zigzag_direct[i]] = i;
+
+    for (j = 0; j < 2; j++) {
+        /* the two quantizers used by the 10-bit DNxHD/DNxHR profiles */
+        const int shift = j ? 16 : 18;
+        const int bias  = j ? rnd() & 0xFFFF : 0;
+
+        if (!check_func(ctx->quantize_10bit, "dnxhd_10bit_quantize_%d", shift))
+            continue;
+
+        for (i = 0; i < 64; i++) {
+            block0[i] = rnd() % 3 ? 0 : (int16_t)rnd() >> (rnd() % 8);
+            qmat[i]   = 1 + rnd() % 16384;
+        }
+        memcpy(block1, block0, 64 * sizeof(*block0));
+
+        last0 = call_ref(block0, qmat, bias, shift, scan_pos, &max0);
+        last1 = call_new(block1, qmat, bias, shift, scan_pos, &max1);
+        if (last0 != last1 || max0 != max1 ||
+            memcmp(block0, block1, 64 * sizeof(*block0)))
+            fail();
+
+        bench_new(block1, qmat, bias, shift, scan_pos, &max1);
+    }
+}
+
+void checkasm_check_dnxhdenc(void)
+{
+    static DNXHDEncContext ctx;
+
+    ctx.cid_table = ff_dnxhd_get_cid_table(1256);
+    ff_dnxhdenc_init(&ctx);
+
+    check_quantize_10bit(&ctx);
+    report("quantize_10bit");
+}
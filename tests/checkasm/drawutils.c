@@ -0,0 +1,141 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+#include "checkasm.h"
+#include "libavfilter/drawutils.h"
+#include "libavutil/mem_internal.h"
+#include "libavutil/pixdesc.h"
+
+#define WIDTH 256
+
+#define randomize_buffers(buf, size)      \
+    do {                                  \
+        int j;                            \
+        for (j = 0; j < size; j++)        \
+            buf[j] = rnd() & 0xFF;        \
+    } while (0)
+
+static void check_blend_row(enum AVPixelFormat format, int plane,
+                            const char *report_name)
+{
+    LOCAL_ALIGNED_32(uint8_t, dst_ref, [WIDTH * 8]);
+    LOCAL_ALIGNED_32(uint8_t, dst_new, [WIDTH * 8]);
+    LOCAL_ALIGNED_32(uint8_t, dst_org, [WIDTH * 8]);
+    LOCAL_ALIGNED_32(uint32_t, tau,  [8]);
+    LOCAL_ALIGNED_32(uint32_t, asrc, [8]);
+    FFDrawContext draw;
+    int bytes, nb_comp, len, i, ref, new;
+
+    declare_func(int, uint8_t *dst, const uint32_t *tau,
+                 const uint32_t *asrc, int len);
+
+    if (ff_draw_init(&draw, format, 0) < 0)
+        return;
+    bytes   = draw.desc->comp[0].depth > 8 ? 2 : 1;
+    nb_comp = draw.pixelstep[plane] / bytes;
+
+    if (check_func(draw.blend_row[plane], "draw_blend_row_%s", report_name)) {
+        /* alpha ranges as set up by ff_blend_rectangle() */
+        for (i = 0; i < 8; i++) {
+            unsigned one   = bytes == 1 ? 0x1010101 : 0x10001;
+            unsigned alpha = (bytes == 1 ? 0x10203 : 0x101) * (rnd() & 0xFF) + 2;
+            unsigned src   = rnd() & (bytes == 1 ? 0xFF : 0xFFFF);
+
+            if (i >= nb_comp) {
+                tau[i]  = tau[i % nb_comp];
+                asrc[i] = asrc[i % nb_comp];
+            } else {
+                tau[i]  = one - alpha;
+                asrc[i] = src * alpha;
+            }
+        }
+        for (len = nb_comp; len <= WIDTH * nb_comp; len += 7 * nb_comp) {
+            randomize_buffers(dst_org, WIDTH * 8);
+            memcpy(dst_ref, dst_org, WIDTH * 8);
+            memcpy(dst_new, dst_org, WIDTH * 8);
+            ref = call_ref(dst_ref, tau, asrc, len);
+            new = call_new(dst_new, tau, asrc, len);
+            /* the remaining components are left to the caller */
+            if (new < 0 || new > ref || new % nb_comp ||
+                memcmp(dst_ref, dst_new, new * bytes) ||
+                memcmp(dst_new + new * bytes, dst_org + new * bytes,
+                       WIDTH * 8 - new * bytes))
+                fail();
+        }
+        bench_new(dst_new, tau, asrc, WIDTH * nb_comp);
+    }
+}
+
+static void check_blend_mask_row(enum AVPixelFormat format, int plane,
+                                 const char *report_name)
+{
+    LOCAL_ALIGNED_32(uint8_t, dst_ref, [WIDTH * 4]);
+    LOCAL_ALIGNED_32(uint8_t, dst_new, [WIDTH * 4]);
+    LOCAL_ALIGNED_32(uint8_t, dst_org, [WIDTH * 4]);
+    LOCAL_ALIGNED_32(uint8_t, mask,    [WIDTH]);
+    LOCAL_ALIGNED_32(uint32_t, alpha, [8]);
+    LOCAL_ALIGNED_32(uint32_t, src,   [8]);
+    FFDrawContext draw;
+    int nb_comp, w, i, ref, new;
+
+    declare_func(int, uint8_t *dst, const uint8_t *mask,
+                 const uint32_t *alpha, const uint32_t *src, int w);
+
+    if (ff_draw_init(&draw, format, 0) < 0)
+        return;
+    nb_comp = draw.pixelstep[plane];
+
+    if (check_func(draw.blend_mask_row[plane], "draw_blend_mask_row_%s", report_name)) {
+        /* alpha range as set up by ff_blend_mask() */
+        for (i = 0; i < 8; i++) {
+            alpha[i] = i < nb_comp ? (0x10307 * (rnd() & 0xFF) + 3) >> 8 : alpha[i % nb_comp];
+            src[i]   = i < nb_comp ? rnd() & 0xFF : src[i % nb_comp];
+        }
+        for (w = 1; w <= WIDTH; w += 7) {
+            randomize_buffers(dst_org, WIDTH * 4);
+            randomize_buffers(mask, WIDTH);
+            memcpy(dst_ref, dst_org, WIDTH * 4);
+            memcpy(dst_new, dst_org, WIDTH * 4);
+            ref = call_ref(dst_ref, mask, alpha, src, w);
+            new = call_new(dst_new, mask, alpha, src, w);
+            if (new < 0 || new > ref ||
+                memcmp(dst_ref, dst_new, new * nb_comp) ||
+                memcmp(dst_new + new * nb_comp, dst_org + new * nb_comp,
+                       WIDTH * 4 - new * nb_comp))
+                fail();
+        }
+        bench_new(dst_new, mask, alpha, src, WIDTH);
+    }
+}
+
+void checkasm_check_drawutils(void)
+{
+    check_blend_row(AV_PIX_FMT_YUV420P,   0, "8_1");
+    check_blend_row(AV_PIX_FMT_NV12,      1, "8_2");
+    check_blend_row(AV_PIX_FMT_RGBA,      0, "8_4");
+    report("blend_row8");
+
+    check_blend_row(AV_PIX_FMT_P010LE,    0, "16_1");
+    check_blend_row(AV_PIX_FMT_P010LE,    1, "16_2");
+    report("blend_row16");
+
+    check_blend_mask_row(AV_PIX_FMT_YUV420P, 0, "8_1");
+    check_blend_mask_row(AV_PIX_FMT_RGBA,    0, "8_4");
+    report("blend_mask_row8");
+}
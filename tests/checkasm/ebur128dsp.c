@@ -0,0 +1,116 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "libavfilter/ebur128dsp.h"
+#include "libavutil/internal.h"
+#include "libavutil/mem_internal.h"
+#include "checkasm.h"
+
+#define LEN      480
+#define STRIDE   (2 * EBUR128_LANES)
+#define BUF_SIZE (LEN * STRIDE)
+
+static void randomize_buffer(double *buf, int len)
+{
+    for (int i = 0; i < len; i++)
+        buf[i] = (int)(rnd() % 65536 - 32768) / 32768.0;
+}
+
+/* All implementations must be bit-exact, so that the measurements do not
+ * depend on the CPU. */
+static void check_filter(const double *src)
+{
+    LOCAL_ALIGNED_32(double, dst0,   [BUF_SIZE]);
+    LOCAL_ALIGNED_32(double, dst1,   [BUF_SIZE]);
+    LOCAL_ALIGNED_32(double, state0, [EBUR128_NB_STATES * STRIDE]);
+    LOCAL_ALIGNED_32(double, state1, [EBUR128_NB_STATES * STRIDE]);
+    LOCAL_ALIGNED_32(double, coeffs, [EBUR128_NB_COEFFS * EBUR128_LANES]);
+    double k[EBUR128_NB_COEFFS];
+
+    declare_func(void, double *dst, const double *src, ptrdiff_t len, ptrdiff_t stride,
+                 const double *coeffs, double *state);
+
+    ff_ebur128dsp_filter_coeffs(k, 44100);
+    ff_ebur128dsp_set_coeffs(coeffs, k);
+    randomize_buffer(state0, EBUR128_NB_STATES * STRIDE);
+    memcpy(state1, state0, EBUR128_NB_STATES * STRIDE * sizeof(*state0));
+
+    for (int stride = EBUR128_LANES; stride <= STRIDE; stride += EBUR128_LANES) {
+        int len = BUF_SIZE / stride - (rnd() & 7);
+
+        call_ref(dst0, src, len, stride, coeffs, state0);
+        call_new(dst1, src, len, stride, coeffs, state1);
+        if (memcmp(dst0, dst1, len * stride * sizeof(*dst0)) ||
+            memcmp(state0, state1, EBUR128_NB_STATES * stride * sizeof(*state0)))
+            fail();
+    }
+    bench_new(dst1, src, LEN, STRIDE, coeffs, state1);
+}
+
+static void check_sum_peak(const double *src, int peak)
+{
+    LOCAL_ALIGNED_32(double, dst0, [STRIDE]);
+    LOCAL_ALIGNED_32(double, dst1, [STRIDE]);
+
+    declare_func(void, double *dst, const double *src, ptrdiff_t len, ptrdiff_t stride);
+
+    for (int stride = EBUR128_LANES; stride <= STRIDE; stride += EBUR128_LANES) {
+        int len = BUF_SIZE / stride - (rnd() & 7);
+
+        randomize_buffer(dst0, STRIDE);
+        if (peak) {
+            for (int i = 0; i < STRIDE; i++)
+                dst0[i] = fabs(dst0[i]);
+        }
+        memcpy(dst1, dst0, STRIDE * sizeof(*dst0));
+        call_ref(dst0, src, len, stride);
+        call_new(dst1, src, len, stride);
+        if (memcmp(dst0, dst1, stride * sizeof(*dst0)))
+            fail();
+
+        call_ref(dst0, src, 0, stride);
+        call_new(dst1, src, 0, stride);
+        if (memcmp(dst0, dst1, stride * sizeof(*dst0)))
+            fail();
+    }
+    bench_new(dst1, src, LEN, STRIDE);
+}
+
+void checkasm_check_ebur128dsp(void)
+{
+    LOCAL_ALIGNED_32(double, src, [BUF_SIZE]);
+    EBUR128DSPContext dsp;
+
+    ff_ebur128dsp_init(&dsp);
+    randomize_buffer(src, BUF_SIZE);
+
+    if (check_func(dsp.filter, "ebur128_filter"))
+        check_filter(src);
+    report("filter");
+
+    if (check_func(dsp.sum, "ebur128_sum"))
+        check_sum_peak(src, 0);
+    report("sum");
+
+    if (check_func(dsp.peak, "ebur128_peak"))
+        check_sum_peak(src, 1);
+    report("peak");
+}
@@ -102,6 +102,61 @@ static void check_sub_left_pred(LLVidEncDSPContext *c)
     }
 }
 
+static void check_sub_paeth_pred(LLVidEncDSPContext *c)
+{
+    int i, bpp;
+    LOCAL_ALIGNED_32(uint8_t, dst0, [MAX_STRIDE]);
+    LOCAL_ALIGNED_32(uint8_t, dst1, [MAX_STRIDE]);
+    LOCAL_ALIGNED_32(uint8_t, src,  [MAX_STRIDE + 16]);
+    LOCAL_ALIGNED_32(uint8_t, top,  [MAX_STRIDE + 16]);
+
+    declare_func(void, uint8_t *dst, const uint8_t *src,
+                 const uint8_t *top, intptr_t w, int bpp);
+
+    randomize_buffers(src, MAX_STRIDE + 16);
+    randomize_buffers(top, MAX_STRIDE + 16);
+
+    for (bpp = 1; bpp <= 8; bpp++) {
+        if (check_func(c->sub_paeth_pred, "sub_paeth_pred_bpp%d", bpp)) {
+            for (i = 16; i <= MAX_STRIDE; i += 16) {
+                memset(dst0, 0, MAX_STRIDE);
+                memset(dst1, 0, MAX_STRIDE);
+                call_ref(dst0, src + 8 + 1, top + 8 + 1, i, bpp);
+                call_new(dst1, src + 8 + 1, top + 8 + 1, i, bpp);
+                if (memcmp(dst0, dst1, MAX_STRIDE))
+                    fail();
+            }
+            bench_new(dst1, src + 8 + 1, top + 8 + 1, MAX_STRIDE, bpp);
+        }
+    }
+}
+
+static void check_sum_abs_s8(LLVidEncDSPContext *c)
+{
+    int i, res0, res1;
+    LOCAL_ALIGNED_32(uint8_t, src, [MAX_STRIDE + 4]);
+
+    declare_func(int, const uint8_t *src, intptr_t w);
+
+    /* the rows start at src + 1 and are read up to src[MAX_STRIDE] */
+    randomize_buffers(src, MAX_STRIDE + 4);
+
+    if (check_func(c->sum_abs_s8, "sum_abs_s8")) {
+        for (i = 32; i <= MAX_STRIDE; i += 32) {
+            res0 = call_ref(src + 1, i);
+            res1 = call_new(src + 1, i);
+            if (res0 != res1)
+                fail();
+        }
+        memset(src, 0x80, MAX_STRIDE + 1);
+        res0 = call_ref(src, MAX_STRIDE);
+        res1 = call_new(src, MAX_STRIDE);
+        if (res0 != res1)
+            fail();
+        bench_new(src, MAX_STRIDE);
+    }
+}
+
 void checkasm_check_llviddspenc(void)
 {
     LLVidEncDSPContext c;
@@ -112,4 +167,10 @@ void checkasm_check_llviddspenc(void)
 
     check_sub_left_pred(&c);
     report("sub_left_predict");
+
+    check_sub_paeth_pred(&c);
+    report("sub_paeth_pred");
+
+    check_sum_abs_s8(&c);
+    report("sum_abs_s8");
 }
@@ -0,0 +1,95 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "libavutil/common.h"
+#include "libavutil/intreadwrite.h"
+#include "libavutil/mem_internal.h"
+
+#include "libavcodec/me_cmp.h"
+
+#include "checkasm.h"
+
+#define WIDTH    64
+#define HEIGHT   48
+#define BUF_SIZE (WIDTH * HEIGHT)
+
+#define randomize_buffers(buf, size)      \
+    do {                                  \
+        int j;                            \
+        for (j = 0; j < size; j += 4)     \
+            AV_WN32A(buf + j, rnd());     \
+    } while (0)
+
+static const struct { uint8_t size, w, h; } blocks[] = {
+    { 0, 16, 16 }, { 0, 16, 8 }, { 1, 8, 8 },
+};
+
+static void check_sad_x4(MECmpContext *c)
+{
+    LOCAL_ALIGNED_16(uint8_t, cur, [BUF_SIZE]);
+    LOCAL_ALIGNED_16(uint8_t, ref, [BUF_SIZE]);
+    uint8_t *pix1 = cur + WIDTH * 8 + 16;
+    uint8_t *pix2[4];
+    int scores0[4], scores1[4];
+    int i, k;
+
+    declare_func_emms(AV_CPU_FLAG_MMX, void, uint8_t *pix1, uint8_t *const pix2[4],
+                      ptrdiff_t stride, int h, int scores[4]);
+
+    for (i = 0; i < FF_ARRAY_ELEMS(blocks); i++) {
+        const int w = blocks[i].w, h = blocks[i].h;
+
+        if (!check_func(c->sad_x4[blocks[i].size], "sad%d_x4_h%d", w, h))
+            continue;
+
+        randomize_buffers(cur, BUF_SIZE);
+        randomize_buffers(ref, BUF_SIZE);
+        /* unaligned horizontal neighbours as in a full search */
+        pix2[0] = ref + WIDTH * (rnd() % (HEIGHT - h)) + rnd() % (WIDTH - w - 3);
+        for (k = 1; k < 4; k++)
+            pix2[k] = pix2[0] + k;
+
+        call_ref(pix1, pix2, WIDTH, h, scores0);
+        call_new(pix1, pix2, WIDTH, h, scores1);
+        if (memcmp(scores0, scores1, sizeof(scores0)))
+            fail();
+
+        /* maximal differences must not overflow the accumulators */
+        memset(cur, 0xFF, BUF_SIZE);
+        memset(ref, 0x00, BUF_SIZE);
+        call_ref(pix1, pix2, WIDTH, h, scores0);
+        call_new(pix1, pix2, WIDTH, h, scores1);
+        if (memcmp(scores0, scores1, sizeof(scores0)))
+            fail();
+
+        bench_new(pix1, pix2, WIDTH, h, scores1);
+    }
+}
+
+void checkasm_check_motion(void)
+{
+    AVCodecContext avctx = { 0 };
+    MECmpContext c;
+
+    ff_me_cmp_init(&c, &avctx);
+
+    check_sad_x4(&c);
+    report("sad_x4");
+}
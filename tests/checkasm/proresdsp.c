@@ -0,0 +1,97 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <string.h>
+
+#include "libavutil/common.h"
+#include "libavutil/mem_internal.h"
+
+#include "libavcodec/avcodec.h"
+#include "libavcodec/proresdsp.h"
+
+#include "checkasm.h"
+
+#define STRIDE 32
+
+static void randomize_block(int16_t *block, int16_t *qmat, int bits, int qmax,
+                            int sparse)
+{
+    int i;
+
+    for (i = 0; i < 64; i++) {
+        if (sparse && i && rnd() % 4)
+            block[i] = 0;
+        else
+            block[i] = (int)(rnd() % (1 << bits)) - (1 << (bits - 1));
+        qmat[i] = 1 + rnd() % qmax;
+    }
+}
+
+static void check_idct_put(int bits)
+{
+    ProresDSPContext h;
+    AVCodecContext avctx = { .bits_per_raw_sample = bits };
+    LOCAL_ALIGNED_16(int16_t, block,  [64]);
+    LOCAL_ALIGNED_16(int16_t, qmat,   [64]);
+    LOCAL_ALIGNED_16(int16_t, block0, [64]);
+    LOCAL_ALIGNED_16(int16_t, block1, [64]);
+    LOCAL_ALIGNED_16(int16_t, qmat1,  [64]);
+    LOCAL_ALIGNED_16(uint16_t, dst0, [8 * STRIDE]);
+    LOCAL_ALIGNED_16(uint16_t, dst1, [8 * STRIDE]);
+    int i, j;
+
+    declare_func(void, uint16_t *out, ptrdiff_t linesize, int16_t *block,
+                 const int16_t *qmat);
+
+    if (ff_proresdsp_init(&h, &avctx) < 0)
+        return;
+
+    if (check_func(h.idct_put, "prores_idct_put_%d", bits)) {
+        for (j = 0; j < 3; j++) {
+            /* the 12-bit version must also match the C wraparound for
+             * out of range input */
+            if (bits == 12)
+                randomize_block(block, qmat, j ? 12 : 16, 32, j == 2);
+            else
+                randomize_block(block, qmat, 8, 16, j == 2);
+            /* the reference is always the C version, which expects the
+             * coefficients in natural order */
+            memcpy(block0, block, 64 * sizeof(*block));
+            for (i = 0; i < 64; i++) {
+                block1[h.idct_permutation[i]] = block[i];
+                qmat1 [h.idct_permutation[i]] = qmat[i];
+            }
+            memset(dst0, 0, 8 * STRIDE * sizeof(*dst0));
+            memset(dst1, 0, 8 * STRIDE * sizeof(*dst1));
+
+            call_ref(dst0, STRIDE * sizeof(*dst0), block0, qmat);
+            call_new(dst1, STRIDE * sizeof(*dst1), block1, qmat1);
+            if (memcmp(dst0, dst1, 8 * STRIDE * sizeof(*dst0)))
+                fail();
+        }
+        memcpy(block1, block, 64 * sizeof(*block));
+        bench_new(dst1, STRIDE * sizeof(*dst1), block1, qmat1);
+    }
+}
+
+void checkasm_check_proresdsp(void)
+{
+    check_idct_put(10);
+    check_idct_put(12);
+    report("idct_put");
+}
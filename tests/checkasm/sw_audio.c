@@ -0,0 +1,269 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "libavutil/channel_layout.h"
+#include "libavutil/common.h"
+#include "libavutil/mem.h"
+#include "libavutil/mem_internal.h"
+#include "libavutil/opt.h"
+
+#include "libswresample/audioconvert.h"
+#include "libswresample/swresample_internal.h"
+
+#include "checkasm.h"
+
+#define LEN    256
+#define NB_IN  8
+
+/* The SIMD sample format conversions, rematrixing and noise shaping have no
+ * C counterpart with the same prototype, the expected output is computed
+ * with the C conversion functions or the reference code below. */
+
+static void randomize_samples(uint8_t *buf, enum AVSampleFormat fmt, int len)
+{
+    int i;
+
+    for (i = 0; i < len; i++) {
+        int v = (int)(rnd() % 0x10001) - 0x8000;
+        switch (av_get_packed_sample_fmt(fmt)) {
+        case AV_SAMPLE_FMT_S16: ((int16_t *)buf)[i] = v;                   break;
+        case AV_SAMPLE_FMT_S32: ((int32_t *)buf)[i] = v * 0x10000 + (rnd() & 0xffff); break;
+        case AV_SAMPLE_FMT_FLT: ((float   *)buf)[i] = v / 32768.0f;        break;
+        case AV_SAMPLE_FMT_DBL: ((double  *)buf)[i] = v / 32768.0;         break;
+        }
+    }
+}
+
+static void check_convert(void)
+{
+    static const enum AVSampleFormat pairs[][2] = {
+        { AV_SAMPLE_FMT_S32P, AV_SAMPLE_FMT_S16P },
+        { AV_SAMPLE_FMT_S16P, AV_SAMPLE_FMT_S32P },
+        { AV_SAMPLE_FMT_FLTP, AV_SAMPLE_FMT_S16P },
+        { AV_SAMPLE_FMT_S16P, AV_SAMPLE_FMT_FLTP },
+        { AV_SAMPLE_FMT_FLTP, AV_SAMPLE_FMT_S32P },
+        { AV_SAMPLE_FMT_S32P, AV_SAMPLE_FMT_FLTP },
+    };
+    LOCAL_ALIGNED_32(uint8_t, src,  [LEN * 4]);
+    LOCAL_ALIGNED_32(uint8_t, dst0, [LEN * 4]);
+    LOCAL_ALIGNED_32(uint8_t, dst1, [LEN * 4]);
+    int i;
+
+    declare_func(void, uint8_t **dst, const uint8_t **src, int len);
+
+    for (i = 0; i < FF_ARRAY_ELEMS(pairs); i++) {
+        enum AVSampleFormat out_fmt = pairs[i][0], in_fmt = pairs[i][1];
+        AudioConvert *ac = swri_audio_convert_alloc(out_fmt, in_fmt, 1, NULL, 0);
+        int is = av_get_bytes_per_sample(in_fmt), os = av_get_bytes_per_sample(out_fmt);
+        const uint8_t *srcp[1] = { src };
+        uint8_t *dstp[1] = { dst1 };
+
+        if (!ac)
+            fail();
+        else if (ac->simd_f &&
+                 check_func(ac->simd_f, "audio_convert_%s_to_%s",
+                            av_get_sample_fmt_name(in_fmt), av_get_sample_fmt_name(out_fmt))) {
+            randomize_samples(src, in_fmt, LEN);
+            ac->conv_f(dst0, src, is, os, dst0 + LEN * os);
+            memset(dst1, 0, LEN * os);
+            call_new(dstp, srcp, LEN);
+            if (memcmp(dst0, dst1, LEN * os))
+                fail();
+            bench_new(dstp, srcp, LEN);
+        }
+        swri_audio_convert_free(&ac);
+    }
+    report("audio_convert");
+}
+
+static SwrContext *alloc_swr(enum AVSampleFormat in_fmt, enum AVSampleFormat out_fmt,
+                             enum AVSampleFormat int_fmt, int dither)
+{
+    SwrContext *s = swr_alloc_set_opts(NULL, AV_CH_LAYOUT_STEREO, out_fmt, 48000,
+                                       AV_CH_LAYOUT_7POINT1, in_fmt, 48000, 0, NULL);
+    if (!s)
+        return NULL;
+    av_opt_set_sample_fmt(s, "internal_sample_fmt", int_fmt, 0);
+    if (dither)
+        av_opt_set_int(s, "dither_method", SWR_DITHER_NS_SHIBATA, 0);
+    if (swr_init(s) < 0)
+        swr_free(&s);
+    return s;
+}
+
+static void check_mix_n_1(enum AVSampleFormat fmt, const char *name)
+{
+    static const uint8_t ch[] = { 6, 0, 3, 5, 7, 1, 2 };
+    LOCAL_ALIGNED_32(uint8_t, in_buf, [NB_IN * LEN * sizeof(double)]);
+    LOCAL_ALIGNED_32(uint8_t, dst0, [LEN * sizeof(double)]);
+    LOCAL_ALIGNED_32(uint8_t, dst1, [LEN * sizeof(double)]);
+    LOCAL_ALIGNED_32(uint8_t, coeffs, [SWR_CH_MAX * sizeof(double)]);
+    const uint8_t *in[NB_IN];
+    int bps = av_get_bytes_per_sample(fmt);
+    SwrContext *s = alloc_swr(av_get_packed_sample_fmt(fmt), av_get_packed_sample_fmt(fmt), fmt, 0);
+    int i, j, n;
+
+    declare_func(void, void *out, const uint8_t **in, const void *coeffp,
+                 const uint8_t *ch, integer n, integer len);
+
+    if (!s) {
+        fail();
+        return;
+    }
+
+    if (s->mix_n_1_simd && check_func(s->mix_n_1_simd, "mix_n_1_%s", name)) {
+        for (i = 0; i < NB_IN; i++)
+            in[i] = in_buf + i * LEN * bps;
+        randomize_samples(in_buf, fmt, NB_IN * LEN);
+        for (i = 0; i < SWR_CH_MAX; i++) {
+            int v = (int)(rnd() % 0x10001) - 0x8000;
+            switch (fmt) {
+            case AV_SAMPLE_FMT_S16P: ((int32_t *)coeffs)[i] = v / 8;            break;
+            case AV_SAMPLE_FMT_FLTP: ((float   *)coeffs)[i] = v / 32768.0f;     break;
+            case AV_SAMPLE_FMT_DBLP: ((double  *)coeffs)[i] = v / 32768.0;      break;
+            }
+        }
+
+        for (n = 3; n <= FF_ARRAY_ELEMS(ch); n += 4) {
+            for (i = 0; i < LEN; i++) {
+                if (fmt == AV_SAMPLE_FMT_FLTP) {
+                    float v = 0;
+                    for (j = 0; j < n; j++)
+                        v += ((const float *)in[ch[j]])[i] * ((float *)coeffs)[ch[j]];
+                    ((float *)dst0)[i] = v;
+                } else if (fmt == AV_SAMPLE_FMT_DBLP) {
+                    double v = 0;
+                    for (j = 0; j < n; j++)
+                        v += ((const double *)in[ch[j]])[i] * ((double *)coeffs)[ch[j]];
+                    ((double *)dst0)[i] = v;
+                } else {
+                    int v = 0;
+                    for (j = 0; j < n; j++)
+                        v += ((const int16_t *)in[ch[j]])[i] * ((int32_t *)coeffs)[ch[j]];
+                    ((int16_t *)dst0)[i] = (v + 16384) >> 15;
+                }
+            }
+            memset(dst1, 0, LEN * bps);
+            call_new(dst1, in, coeffs, ch, n, LEN);
+            if (memcmp(dst0, dst1, LEN * bps))
+                fail();
+            bench_new(dst1, in, coeffs, ch, n, LEN);
+        }
+    }
+    swr_free(&s);
+}
+
+static int noise_shaping_ref(float *buf, const float *noise, float *errors,
+                             const float *coeffs, int taps, int pos, int count,
+                             const float *scale)
+{
+    float S = scale[0], S_1 = scale[1];
+    int c, i, j, p = pos;
+
+    for (c = 0; c < 4; c++) {
+        p = pos;
+        for (i = 0; i < count; i++) {
+            double d1, d = buf[4 * i + c] * S_1;
+            for (j = 0; j < taps - 2; j += 4) {
+                d -= coeffs[j    ] * errors[4 * (p + j    ) + c]
+                    +coeffs[j + 1] * errors[4 * (p + j + 1) + c]
+                    +coeffs[j + 2] * errors[4 * (p + j + 2) + c]
+                    +coeffs[j + 3] * errors[4 * (p + j + 3) + c];
+            }
+            if (j < taps)
+                d -= coeffs[j] * errors[4 * (p + j) + c];
+            p = p ? p - 1 : taps - 1;
+            d1 = rint(d + noise[4 * i + c]);
+            errors[4 * (p + taps) + c] = errors[4 * p + c] = d1 - d;
+            d1 *= S;
+            buf[4 * i + c] = d1;
+        }
+    }
+    return p;
+}
+
+static void check_noise_shaping(void)
+{
+    static const int taps_list[] = { 8, 9, 20 };
+    LOCAL_ALIGNED_32(float, buf0,    [LEN * 4]);
+    LOCAL_ALIGNED_32(float, buf1,    [LEN * 4]);
+    LOCAL_ALIGNED_32(float, noise,   [LEN * 4]);
+    LOCAL_ALIGNED_32(float, errors0, [2 * NS_TAPS * 4]);
+    LOCAL_ALIGNED_32(float, errors1, [2 * NS_TAPS * 4]);
+    float coeffs[NS_TAPS + 1];
+    const float scale[2] = { 1.0f / 32768, 32768 };
+    SwrContext *s = alloc_swr(AV_SAMPLE_FMT_FLT, AV_SAMPLE_FMT_S16, AV_SAMPLE_FMT_FLTP, 1);
+    int i, t;
+
+    declare_func(int, float *buf, const float *noise, float *errors,
+                 const float *coeffs, int taps, int pos, int count,
+                 const float *scale);
+
+    if (!s) {
+        fail();
+        return;
+    }
+
+    if (s->dither.noise_shaping_simd &&
+        check_func(s->dither.noise_shaping_simd, "noise_shaping_float")) {
+        for (t = 0; t < FF_ARRAY_ELEMS(taps_list); t++) {
+            int taps = taps_list[t];
+            int pos = rnd() % taps, pos0, pos1;
+
+            for (i = 0; i < FF_ARRAY_ELEMS(coeffs); i++)
+                coeffs[i] = i < taps ? ((int)(rnd() % 2001) - 1000) / 500.0f : 0;
+            for (i = 0; i < taps; i++) {
+                int c;
+                for (c = 0; c < 4; c++)
+                    errors0[4 * (i + taps) + c] = errors0[4 * i + c] =
+                        ((int)(rnd() % 1001) - 500) / 1000.0f;
+            }
+            for (i = 0; i < LEN * 4; i++) {
+                buf0[i]  = ((int)(rnd() % 0x10001) - 0x8000) / 32768.0f;
+                noise[i] = ((int)(rnd() % 2001) - 1000) / 1000.0f;
+            }
+            memcpy(buf1, buf0, LEN * 4 * sizeof(*buf0));
+            memcpy(errors1, errors0, 2 * NS_TAPS * 4 * sizeof(*errors0));
+
+            pos0 = noise_shaping_ref(buf0, noise, errors0, coeffs, taps, pos, LEN, scale);
+            pos1 = call_new(buf1, noise, errors1, coeffs, taps, pos, LEN, scale);
+            if (pos0 != pos1 ||
+                memcmp(buf0, buf1, LEN * 4 * sizeof(*buf0)) ||
+                memcmp(errors0, errors1, 2 * taps * 4 * sizeof(*errors0)))
+                fail();
+            bench_new(buf1, noise, errors1, coeffs, taps, pos, LEN, scale);
+        }
+    }
+    swr_free(&s);
+    report("noise_shaping");
+}
+
+void checkasm_check_sw_audio(void)
+{
+    check_convert();
+
+    check_mix_n_1(AV_SAMPLE_FMT_S16P, "int16");
+    check_mix_n_1(AV_SAMPLE_FMT_FLTP, "float");
+    check_mix_n_1(AV_SAMPLE_FMT_DBLP, "double");
+    report("mix_n_1");
+
+    check_noise_shaping();
+}
@@ -0,0 +1,166 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "libavutil/common.h"
+#include "libavutil/mathematics.h"
+#include "libavutil/mem.h"
+#include "libavutil/mem_internal.h"
+
+#include "libswresample/resample.h"
+
+#include "checkasm.h"
+
+#define PHASE_COUNT      32
+#define MAX_FILTER_ALLOC 32
+#define DST_LEN          256
+#define SRC_LEN          (DST_LEN * 2 + MAX_FILTER_ALLOC)
+
+static void randomize_samples(uint8_t *buf, enum AVSampleFormat fmt, int len, int range)
+{
+    int i;
+
+    for (i = 0; i < len; i++) {
+        int v = (int)(rnd() % (2 * range + 1)) - range;
+        switch (fmt) {
+        case AV_SAMPLE_FMT_S16P: ((int16_t *)buf)[i] = v;                  break;
+        case AV_SAMPLE_FMT_FLTP: ((float   *)buf)[i] = v / (float) range;  break;
+        case AV_SAMPLE_FMT_DBLP: ((double  *)buf)[i] = v / (double)range;  break;
+        }
+    }
+}
+
+/* The SIMD functions read whole vectors of taps, so every filter of the bank
+ * is zero padded up to filter_alloc like resample_init() does. */
+static void build_filter_bank(uint8_t *bank, enum AVSampleFormat fmt,
+                              int filter_length, int filter_alloc)
+{
+    int bps = av_get_bytes_per_sample(fmt);
+    int i;
+
+    memset(bank, 0, (PHASE_COUNT + 1) * MAX_FILTER_ALLOC * sizeof(double));
+    for (i = 0; i <= PHASE_COUNT; i++)
+        randomize_samples(bank + i * filter_alloc * bps, fmt, filter_length,
+                          fmt == AV_SAMPLE_FMT_S16P ? 0x7ff : 0x8000);
+}
+
+static void init_context(ResampleContext *c, enum AVSampleFormat fmt, uint8_t *bank,
+                         int filter_length, int in_rate, int out_rate)
+{
+    memset(c, 0, sizeof(*c));
+    c->format        = fmt;
+    c->felem_size    = av_get_bytes_per_sample(fmt);
+    c->filter_bank   = bank;
+    c->filter_length = filter_length;
+    c->filter_alloc  = FFALIGN(filter_length, 16);
+    c->phase_count   = PHASE_COUNT;
+    av_reduce(&c->src_incr, &c->dst_incr, out_rate, in_rate * (int64_t)PHASE_COUNT, INT32_MAX / 2);
+    while (c->dst_incr < (1 << 20) && c->src_incr < (1 << 20)) {
+        c->dst_incr *= 2;
+        c->src_incr *= 2;
+    }
+    c->dst_incr_div  = c->dst_incr / c->src_incr;
+    c->dst_incr_mod  = c->dst_incr % c->src_incr;
+    swri_resample_dsp_init(c);
+}
+
+static void check_resample(enum AVSampleFormat fmt, const char *name, int linear)
+{
+    static const int filter_lengths[] = { 8, 22, 32 };
+    static const int rates[][2] = { { 44100, 48000 }, { 48000, 44100 }, { 48000, 32000 } };
+    LOCAL_ALIGNED_32(uint8_t, src,  [SRC_LEN * sizeof(double)]);
+    LOCAL_ALIGNED_32(uint8_t, dst0, [DST_LEN * sizeof(double)]);
+    LOCAL_ALIGNED_32(uint8_t, dst1, [DST_LEN * sizeof(double)]);
+    LOCAL_ALIGNED_32(uint8_t, bank, [(PHASE_COUNT + 1) * MAX_FILTER_ALLOC * sizeof(double)]);
+    ResampleContext c0, c1;
+    int bps = av_get_bytes_per_sample(fmt);
+    int i, j;
+
+    declare_func_emms(AV_CPU_FLAG_MMX, int, ResampleContext *c, void *dst,
+                      const void *src, int n, int update_ctx);
+
+    for (i = 0; i < FF_ARRAY_ELEMS(filter_lengths); i++) {
+        int filter_length = filter_lengths[i];
+
+        init_context(&c0, fmt, bank, filter_length, rates[0][0], rates[0][1]);
+        if (!check_func(linear ? c0.dsp.resample_linear : c0.dsp.resample_common,
+                        "resample_%s_%s_%d", linear ? "linear" : "common", name, filter_length))
+            continue;
+
+        build_filter_bank(bank, fmt, filter_length, c0.filter_alloc);
+        randomize_samples(src, fmt, SRC_LEN, fmt == AV_SAMPLE_FMT_S16P ? 0x1fff : 0x8000);
+
+        for (j = 0; j < FF_ARRAY_ELEMS(rates); j++) {
+            int index, frac, ret0, ret1;
+
+            init_context(&c0, fmt, bank, filter_length, rates[j][0], rates[j][1]);
+            index = rnd() % PHASE_COUNT;
+            frac  = rnd() % c0.src_incr;
+            c0.index = index;
+            c0.frac  = frac;
+            c1 = c0;
+
+            memset(dst0, 0, DST_LEN * bps);
+            memset(dst1, 0, DST_LEN * bps);
+            ret0 = call_ref(&c0, dst0, src, DST_LEN, 1);
+            ret1 = call_new(&c1, dst1, src, DST_LEN, 1);
+            if (ret0 != ret1 || c0.index != c1.index || c0.frac != c1.frac)
+                fail();
+            switch (fmt) {
+            case AV_SAMPLE_FMT_S16P:
+                if (memcmp(dst0, dst1, DST_LEN * bps))
+                    fail();
+                break;
+            case AV_SAMPLE_FMT_FLTP:
+                if (!float_near_abs_eps_array((float *)dst0, (float *)dst1, 1e-5, DST_LEN))
+                    fail();
+                break;
+            case AV_SAMPLE_FMT_DBLP:
+                if (!double_near_abs_eps_array((double *)dst0, (double *)dst1, 1e-12, DST_LEN))
+                    fail();
+                break;
+            }
+
+            c1.index = index;
+            c1.frac  = frac;
+            bench_new(&c1, dst1, src, DST_LEN, 0);
+        }
+    }
+}
+
+void checkasm_check_sw_resample(void)
+{
+    static const struct {
+        enum AVSampleFormat fmt;
+        const char *name;
+    } formats[] = {
+        { AV_SAMPLE_FMT_S16P, "int16"  },
+        { AV_SAMPLE_FMT_FLTP, "float"  },
+        { AV_SAMPLE_FMT_DBLP, "double" },
+    };
+    int i;
+
+    for (i = 0; i < FF_ARRAY_ELEMS(formats); i++)
+        check_resample(formats[i].fmt, formats[i].name, 0);
+    report("resample_common");
+
+    for (i = 0; i < FF_ARRAY_ELEMS(formats); i++)
+        check_resample(formats[i].fmt, formats[i].name, 1);
+    report("resample_linear");
+}
@@ -20,9 +20,11 @@
 #include <string.h>
 
 #include "libavutil/common.h"
+#include "libavutil/intfloat.h"
 #include "libavutil/intreadwrite.h"
 #include "libavutil/mem.h"
 #include "libavutil/mem_internal.h"
+#include "libavutil/pixdesc.h"
 
 #include "libswscale/swscale.h"
 #include "libswscale/swscale_internal.h"
@@ -137,23 +139,42 @@ static void check_yuv2yuvX(void)
 #undef SRC_PIXELS
 #define SRC_PIXELS 128
 
+static const enum AVPixelFormat hscale_formats[17] = {
+    [8]  = AV_PIX_FMT_YUV420P,
+    [9]  = AV_PIX_FMT_YUV420P9LE,
+    [10] = AV_PIX_FMT_YUV420P10LE,
+    [12] = AV_PIX_FMT_YUV420P12LE,
+    [14] = AV_PIX_FMT_YUV420P14LE,
+    [16] = AV_PIX_FMT_YUV420P16LE,
+};
+
 static void check_hscale(void)
 {
 #define MAX_FILTER_WIDTH 40
 #define FILTER_SIZES 5
     static const int filter_sizes[FILTER_SIZES] = { 4, 8, 16, 32, 40 };
 
-#define HSCALE_PAIRS 2
+#define HSCALE_PAIRS 12
     static const int hscale_pairs[HSCALE_PAIRS][2] = {
-        { 8, 14 },
-        { 8, 18 },
+        {  8, 14 },
+        {  8, 18 },
+        {  9, 14 },
+        {  9, 18 },
+        { 10, 14 },
+        { 10, 18 },
+        { 12, 14 },
+        { 12, 18 },
+        { 14, 14 },
+        { 14, 18 },
+        { 16, 14 },
+        { 16, 18 },
     };
 
     int i, j, fsi, hpi, width;
     struct SwsContext *ctx;
 
-    // padded
-    LOCAL_ALIGNED_32(uint8_t, src, [FFALIGN(SRC_PIXELS + MAX_FILTER_WIDTH - 1, 4)]);
+    // padded, holds either 8 or 16 bit samples
+    LOCAL_ALIGNED_32(uint16_t, src, [FFALIGN(SRC_PIXELS + MAX_FILTER_WIDTH - 1, 4)]);
     LOCAL_ALIGNED_32(uint32_t, dst0, [SRC_PIXELS]);
     LOCAL_ALIGNED_32(uint32_t, dst1, [SRC_PIXELS]);
 
@@ -171,13 +192,22 @@ static void check_hscale(void)
     if (sws_init_context(ctx, NULL, NULL) < 0)
         fail();
 
-    randomize_buffers(src, SRC_PIXELS + MAX_FILTER_WIDTH - 1);
-
     for (hpi = 0; hpi < HSCALE_PAIRS; hpi++) {
+        const int src_bpc = hscale_pairs[hpi][0];
+
+        randomize_buffers((uint8_t *)src, sizeof(src[0]) * FFALIGN(SRC_PIXELS + MAX_FILTER_WIDTH - 1, 4));
+        if (src_bpc > 8) {
+            for (i = 0; i < SRC_PIXELS + MAX_FILTER_WIDTH - 1; i++)
+                src[i] &= (1 << src_bpc) - 1;
+        }
+
         for (fsi = 0; fsi < FILTER_SIZES; fsi++) {
             width = filter_sizes[fsi];
 
-            ctx->srcBpc = hscale_pairs[hpi][0];
+            // the C functions for more than 8 bits take the depth from
+            // the source format
+            ctx->srcFormat = hscale_formats[src_bpc];
+            ctx->srcBpc = src_bpc;
             ctx->dstBpc = hscale_pairs[hpi][1];
             ctx->hLumFilterSize = ctx->hChrFilterSize = width;
 
@@ -197,10 +227,17 @@ static void check_hscale(void)
                 // The coefficients sum to the 1.0 point for the hscale
                 // functions (1 << 14).
 
+                //
+                // The 16 bit SIMD functions bias the input to signed and
+                // correct for it assuming an exact 1.0 sum, so they get the
+                // largest tap that brings the sum back to (1 << 14) instead.
+
                 for (j = 0; j < width; j++) {
                     filter[i * width + j] = -((1 << 14) / (width - 1));
                 }
-                filter[i * width + (rnd() % width)] = ((1 << 15) - 1);
+                filter[i * width + (rnd() % width)] = src_bpc > 8 ?
+                    (1 << 14) + (width - 1) * ((1 << 14) / (width - 1)) :
+                    ((1 << 15) - 1);
             }
 
             for (i = 0; i < MAX_FILTER_WIDTH; i++) {
@@ -216,21 +253,296 @@ static void check_hscale(void)
                 memset(dst0, 0, SRC_PIXELS * sizeof(dst0[0]));
                 memset(dst1, 0, SRC_PIXELS * sizeof(dst1[0]));
 
-                call_ref(NULL, dst0, SRC_PIXELS, src, filter, filterPos, width);
-                call_new(NULL, dst1, SRC_PIXELS, src, filter, filterPos, width);
+                call_ref(ctx, dst0, SRC_PIXELS, (uint8_t *)src, filter, filterPos, width);
+                call_new(ctx, dst1, SRC_PIXELS, (uint8_t *)src, filter, filterPos, width);
                 if (memcmp(dst0, dst1, SRC_PIXELS * sizeof(dst0[0])))
                     fail();
-                bench_new(NULL, dst0, SRC_PIXELS, src, filter, filterPos, width);
+                bench_new(ctx, dst0, SRC_PIXELS, (uint8_t *)src, filter, filterPos, width);
             }
         }
     }
     sws_freeContext(ctx);
 }
 
+static const enum AVPixelFormat vscale_formats[] = {
+    AV_PIX_FMT_YUV420P9LE,
+    AV_PIX_FMT_YUV420P10LE,
+    AV_PIX_FMT_YUV420P16LE,
+};
+
+#define VSCALE_WIDTH 128
+
+static void randomize_vscale_input(uint8_t *buf, int bpc)
+{
+    int i;
+
+    // 19 bit samples in int32_t for 16 bit output, 15 bit in int16_t
+    // otherwise; both with some headroom for filter overshoot
+    if (bpc == 16) {
+        for (i = 0; i < VSCALE_WIDTH + 16; i++)
+            AV_WN32A(buf + 4 * i, (int32_t)rnd() >> 11);
+    } else {
+        for (i = 0; i < VSCALE_WIDTH + 16; i++)
+            AV_WN16A(buf + 2 * i, rnd());
+    }
+}
+
+static void check_yuv2plane1(void)
+{
+    struct SwsContext *ctx;
+    int fmi, w;
+
+    LOCAL_ALIGNED_32(uint8_t, src, [(VSCALE_WIDTH + 16) * 4]);
+    LOCAL_ALIGNED_32(uint8_t, dst0, [(VSCALE_WIDTH + 16) * 2]);
+    LOCAL_ALIGNED_32(uint8_t, dst1, [(VSCALE_WIDTH + 16) * 2]);
+    LOCAL_ALIGNED_8(uint8_t, dither, [8]);
+
+    declare_func(void, const int16_t *src, uint8_t *dst, int dstW,
+                 const uint8_t *dither, int offset);
+
+    memset(dither, 0, 8);
+    ctx = sws_alloc_context();
+    if (sws_init_context(ctx, NULL, NULL) < 0)
+        fail();
+
+    for (fmi = 0; fmi < FF_ARRAY_ELEMS(vscale_formats); fmi++) {
+        const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(vscale_formats[fmi]);
+        const int bpc = desc->comp[0].depth;
+
+        ctx->dstFormat = vscale_formats[fmi];
+        ctx->dstBpc    = bpc;
+        ff_sws_init_scale(ctx);
+
+        if (!check_func(ctx->yuv2plane1, "yuv2plane1_%d", bpc))
+            continue;
+
+        for (w = 1; w <= VSCALE_WIDTH; w += w < 40 ? 1 : 29) {
+            randomize_vscale_input(src, bpc);
+            memset(dst0, 0, (VSCALE_WIDTH + 16) * 2);
+            memset(dst1, 0, (VSCALE_WIDTH + 16) * 2);
+
+            call_ref((const int16_t *)src, dst0, w, dither, 0);
+            call_new((const int16_t *)src, dst1, w, dither, 0);
+            if (memcmp(dst0, dst1, w * 2))
+                fail();
+        }
+        bench_new((const int16_t *)src, dst1, VSCALE_WIDTH, dither, 0);
+    }
+    sws_freeContext(ctx);
+}
+
+static void check_yuv2planeX(void)
+{
+#define VSCALE_MAX_FILTER 16
+    static const int filter_sizes[] = { 2, 4, 8, 16 };
+    struct SwsContext *ctx;
+    const int16_t *src[VSCALE_MAX_FILTER];
+    int fmi, fsi, i, w;
+
+    LOCAL_ALIGNED_32(uint8_t, src_pixels, [VSCALE_MAX_FILTER * (VSCALE_WIDTH + 16) * 4]);
+    LOCAL_ALIGNED_32(int16_t, filter, [VSCALE_MAX_FILTER]);
+    LOCAL_ALIGNED_32(uint8_t, dst0, [(VSCALE_WIDTH + 16) * 2]);
+    LOCAL_ALIGNED_32(uint8_t, dst1, [(VSCALE_WIDTH + 16) * 2]);
+    LOCAL_ALIGNED_8(uint8_t, dither, [8]);
+
+    declare_func(void, const int16_t *filter, int filterSize,
+                 const int16_t **src, uint8_t *dest, int dstW,
+                 const uint8_t *dither, int offset);
+
+    memset(dither, 0, 8);
+    ctx = sws_alloc_context();
+    if (sws_init_context(ctx, NULL, NULL) < 0)
+        fail();
+
+    for (fmi = 0; fmi < FF_ARRAY_ELEMS(vscale_formats); fmi++) {
+        const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(vscale_formats[fmi]);
+        const int bpc = desc->comp[0].depth;
+
+        ctx->dstFormat = vscale_formats[fmi];
+        ctx->dstBpc    = bpc;
+        ff_sws_init_scale(ctx);
+
+        for (fsi = 0; fsi < FF_ARRAY_ELEMS(filter_sizes); fsi++) {
+            const int size = filter_sizes[fsi];
+
+            if (!check_func(ctx->yuv2planeX, "yuv2planeX_%d_%d", bpc, size))
+                continue;
+
+            for (w = 1; w <= VSCALE_WIDTH; w += w < 40 ? 1 : 29) {
+                int sum = 0;
+
+                // filters sum to 1.0 (1 << 12) like the vertical scaler
+                // builds them, with a few negative taps
+                for (i = 0; i < size; i++) {
+                    src[i] = (const int16_t *)(src_pixels + i * (VSCALE_WIDTH + 16) * 4);
+                    randomize_vscale_input(src_pixels + i * (VSCALE_WIDTH + 16) * 4, bpc);
+                    if (i < size - 1) {
+                        filter[i] = rnd() % (2 * (1 << 12) / size) - (1 << 12) / (4 * size);
+                        sum      += filter[i];
+                    }
+                }
+                filter[size - 1] = (1 << 12) - sum;
+                memset(dst0, 0, (VSCALE_WIDTH + 16) * 2);
+                memset(dst1, 0, (VSCALE_WIDTH + 16) * 2);
+
+                call_ref(filter, size, src, dst0, w, dither, 0);
+                call_new(filter, size, src, dst1, w, dither, 0);
+                if (memcmp(dst0, dst1, w * 2))
+                    fail();
+            }
+            bench_new(filter, size, src, dst1, VSCALE_WIDTH, dither, 0);
+        }
+    }
+    sws_freeContext(ctx);
+}
+
+static const enum AVPixelFormat input_formats[] = {
+    AV_PIX_FMT_RGB48LE,
+    AV_PIX_FMT_BGR48LE,
+    AV_PIX_FMT_RGBA64LE,
+    AV_PIX_FMT_BGRA64LE,
+    AV_PIX_FMT_GBRP9LE,
+    AV_PIX_FMT_GBRP10LE,
+    AV_PIX_FMT_GBRP12LE,
+    AV_PIX_FMT_GBRP14LE,
+    AV_PIX_FMT_GBRP16LE,
+    AV_PIX_FMT_GBRPF32LE,
+};
+
+#define INPUT_WIDTH 128
+#define INPUT_SIZE  ((INPUT_WIDTH + 16) * 8)
+
+static void randomize_input_plane(uint8_t *buf, const AVPixFmtDescriptor *desc)
+{
+    int i;
+
+    if (desc->flags & AV_PIX_FMT_FLAG_FLOAT) {
+        // include some values outside of [0,1] to exercise clipping
+        for (i = 0; i < INPUT_SIZE / 4; i++)
+            AV_WN32A(buf + 4 * i, av_float2int((int)(rnd() % 6000 - 1000) / 4000.0f));
+    } else {
+        for (i = 0; i < INPUT_SIZE / 2; i++)
+            AV_WN16A(buf + 2 * i, rnd() & ((1 << desc->comp[0].depth) - 1));
+    }
+}
+
+static void check_input(void)
+{
+    struct SwsContext *ctx;
+    int fmi, i, w;
+
+    LOCAL_ALIGNED_32(uint8_t, src_pixels, [3 * INPUT_SIZE]);
+    LOCAL_ALIGNED_32(uint8_t, dst0, [2 * INPUT_SIZE]);
+    LOCAL_ALIGNED_32(uint8_t, dst1, [2 * INPUT_SIZE]);
+
+    for (fmi = 0; fmi < FF_ARRAY_ELEMS(input_formats); fmi++) {
+        const enum AVPixelFormat fmt = input_formats[fmi];
+        const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(fmt);
+        const char *name = av_get_pix_fmt_name(fmt);
+        const uint8_t *src[4];
+
+        // scale so that no unscaled special converter is picked, and read
+        // full resolution chroma so that the packed readers are not halved
+        ctx = sws_getContext(INPUT_WIDTH, 2, fmt, INPUT_WIDTH / 2, 2,
+                             AV_PIX_FMT_YUV444P16LE,
+                             SWS_BILINEAR | SWS_FULL_CHR_H_INP, NULL, NULL, NULL);
+        if (!ctx) {
+            fail();
+            continue;
+        }
+
+        for (i = 0; i < 3; i++) {
+            src[i] = src_pixels + i * INPUT_SIZE;
+            randomize_input_plane(src_pixels + i * INPUT_SIZE, desc);
+        }
+        src[3] = NULL;
+
+        if (desc->flags & AV_PIX_FMT_FLAG_PLANAR) {
+            {
+                declare_func(void, uint8_t *dst, const uint8_t *src[4],
+                             int w, int32_t *rgb2yuv);
+
+                if (check_func(ctx->readLumPlanar, "planar_%s_to_y", name)) {
+                    for (w = 1; w <= INPUT_WIDTH; w += w < 40 ? 1 : 29) {
+                        memset(dst0, 0, INPUT_SIZE);
+                        memset(dst1, 0, INPUT_SIZE);
+                        call_ref(dst0, src, w, ctx->input_rgb2yuv_table);
+                        call_new(dst1, src, w, ctx->input_rgb2yuv_table);
+                        if (memcmp(dst0, dst1, w * 2))
+                            fail();
+                    }
+                    bench_new(dst1, src, INPUT_WIDTH, ctx->input_rgb2yuv_table);
+                }
+            }
+            {
+                declare_func(void, uint8_t *dstU, uint8_t *dstV,
+                             const uint8_t *src[4], int w, int32_t *rgb2yuv);
+
+                if (check_func(ctx->readChrPlanar, "planar_%s_to_uv", name)) {
+                    for (w = 1; w <= INPUT_WIDTH; w += w < 40 ? 1 : 29) {
+                        memset(dst0, 0, 2 * INPUT_SIZE);
+                        memset(dst1, 0, 2 * INPUT_SIZE);
+                        call_ref(dst0, dst0 + INPUT_SIZE, src, w, ctx->input_rgb2yuv_table);
+                        call_new(dst1, dst1 + INPUT_SIZE, src, w, ctx->input_rgb2yuv_table);
+                        if (memcmp(dst0, dst1, w * 2) ||
+                            memcmp(dst0 + INPUT_SIZE, dst1 + INPUT_SIZE, w * 2))
+                            fail();
+                    }
+                    bench_new(dst1, dst1 + INPUT_SIZE, src, INPUT_WIDTH, ctx->input_rgb2yuv_table);
+                }
+            }
+        } else {
+            uint32_t *table = (uint32_t *)ctx->input_rgb2yuv_table;
+            {
+                declare_func(void, uint8_t *dst, const uint8_t *src,
+                             const uint8_t *src2, const uint8_t *src3,
+                             int w, uint32_t *pal);
+
+                if (check_func(ctx->lumToYV12, "%sToY", name)) {
+                    for (w = 1; w <= INPUT_WIDTH; w += w < 40 ? 1 : 29) {
+                        memset(dst0, 0, INPUT_SIZE);
+                        memset(dst1, 0, INPUT_SIZE);
+                        call_ref(dst0, src[0], NULL, NULL, w, table);
+                        call_new(dst1, src[0], NULL, NULL, w, table);
+                        if (memcmp(dst0, dst1, w * 2))
+                            fail();
+                    }
+                    bench_new(dst1, src[0], NULL, NULL, INPUT_WIDTH, table);
+                }
+            }
+            {
+                declare_func(void, uint8_t *dstU, uint8_t *dstV,
+                             const uint8_t *src1, const uint8_t *src2,
+                             const uint8_t *src3, int w, uint32_t *pal);
+
+                if (check_func(ctx->chrToYV12, "%sToUV", name)) {
+                    for (w = 1; w <= INPUT_WIDTH; w += w < 40 ? 1 : 29) {
+                        memset(dst0, 0, 2 * INPUT_SIZE);
+                        memset(dst1, 0, 2 * INPUT_SIZE);
+                        call_ref(dst0, dst0 + INPUT_SIZE, NULL, src[0], src[0], w, table);
+                        call_new(dst1, dst1 + INPUT_SIZE, NULL, src[0], src[0], w, table);
+                        if (memcmp(dst0, dst1, w * 2) ||
+                            memcmp(dst0 + INPUT_SIZE, dst1 + INPUT_SIZE, w * 2))
+                            fail();
+                    }
+                    bench_new(dst1, dst1 + INPUT_SIZE, NULL, src[0], src[0], INPUT_WIDTH, table);
+                }
+            }
+        }
+        sws_freeContext(ctx);
+    }
+}
+
 void checkasm_check_sw_scale(void)
 {
     check_hscale();
     report("hscale");
     check_yuv2yuvX();
     report("yuv2yuvX");
+    check_yuv2plane1();
+    report("yuv2plane1");
+    check_yuv2planeX();
+    report("yuv2planeX");
+    check_input();
+    report("input");
 }
@@ -0,0 +1,155 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+#include "checkasm.h"
+#include "libavfilter/drawutils.h"
+#include "libavfilter/vf_overlay.h"
+#include "libavutil/imgutils.h"
+#include "libavutil/intreadwrite.h"
+#include "libavutil/mem_internal.h"
+#include "libavutil/pixdesc.h"
+
+#define WIDTH    128
+#define LINESIZE (WIDTH * 2 * 2 + 64)
+
+static const struct {
+    enum AVPixelFormat main;
+    enum AVPixelFormat overlay;
+    int format;
+} formats[] = {
+    { AV_PIX_FMT_YUV420P,   AV_PIX_FMT_YUVA420P,   OVERLAY_FORMAT_YUV420    },
+    { AV_PIX_FMT_YUVA420P,  AV_PIX_FMT_YUVA420P,   OVERLAY_FORMAT_YUV420    },
+    { AV_PIX_FMT_NV12,      AV_PIX_FMT_YUVA420P,   OVERLAY_FORMAT_YUV420    },
+    { AV_PIX_FMT_YUV422P,   AV_PIX_FMT_YUVA422P,   OVERLAY_FORMAT_YUV422    },
+    { AV_PIX_FMT_YUVA422P,  AV_PIX_FMT_YUVA422P,   OVERLAY_FORMAT_YUV422    },
+    { AV_PIX_FMT_YUV444P,   AV_PIX_FMT_YUVA444P,   OVERLAY_FORMAT_YUV444    },
+    { AV_PIX_FMT_YUVA444P,  AV_PIX_FMT_YUVA444P,   OVERLAY_FORMAT_YUV444    },
+    { AV_PIX_FMT_GBRP,      AV_PIX_FMT_GBRAP,      OVERLAY_FORMAT_GBRP      },
+    { AV_PIX_FMT_GBRAP,     AV_PIX_FMT_GBRAP,      OVERLAY_FORMAT_GBRP      },
+    { AV_PIX_FMT_RGBA,      AV_PIX_FMT_RGBA,       OVERLAY_FORMAT_RGB       },
+    { AV_PIX_FMT_ARGB,      AV_PIX_FMT_ARGB,       OVERLAY_FORMAT_RGB       },
+    { AV_PIX_FMT_YUV420P10, AV_PIX_FMT_YUVA420P10, OVERLAY_FORMAT_YUV420P10 },
+    { AV_PIX_FMT_P010,      AV_PIX_FMT_YUVA420P10, OVERLAY_FORMAT_YUV420P10 },
+    { AV_PIX_FMT_YUV422P10, AV_PIX_FMT_YUVA422P10, OVERLAY_FORMAT_YUV422P10 },
+};
+
+static int rnd_sample(int depth)
+{
+    int max = (1 << depth) - 1;
+
+    /* transparent and opaque alpha take separate paths */
+    switch (rnd() & 7) {
+    case 0:  return 0;
+    case 1:  return max;
+    default: return rnd() & max;
+    }
+}
+
+static void randomize_plane(uint8_t *buf, int depth, int shift)
+{
+    int i;
+
+    if (depth == 8) {
+        for (i = 0; i < LINESIZE * 2; i++)
+            buf[i] = rnd_sample(8);
+    } else {
+        for (i = 0; i < LINESIZE; i++)
+            AV_WN16A(buf + 2 * i, rnd_sample(depth) << shift);
+    }
+}
+
+static void check_blend_row(int idx, int alpha_format)
+{
+    LOCAL_ALIGNED_32(uint8_t, d_ref, [LINESIZE * 2]);
+    LOCAL_ALIGNED_32(uint8_t, d_new, [LINESIZE * 2]);
+    LOCAL_ALIGNED_32(uint8_t, d_org, [LINESIZE * 2]);
+    LOCAL_ALIGNED_32(uint8_t, da,    [LINESIZE * 2]);
+    LOCAL_ALIGNED_32(uint8_t, src,   [LINESIZE * 2]);
+    LOCAL_ALIGNED_32(uint8_t, a,     [LINESIZE * 2]);
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(formats[idx].main);
+    const int packed = !(desc->flags & AV_PIX_FMT_FLAG_PLANAR);
+    const int main_has_alpha = !!(desc->flags & AV_PIX_FMT_FLAG_ALPHA);
+    const int depth = desc->comp[0].depth;
+    OverlayContext s;
+    int i, w;
+
+    declare_func(int, uint8_t *d, uint8_t *da, uint8_t *s, uint8_t *a, int w,
+                 ptrdiff_t alinesize, ptrdiff_t dalinesize);
+
+    memset(&s, 0, sizeof(s));
+    av_image_fill_max_pixsteps(s.main_pix_step, NULL, desc);
+    av_image_fill_max_pixsteps(s.overlay_pix_step, NULL,
+                               av_pix_fmt_desc_get(formats[idx].overlay));
+    ff_fill_rgba_map(s.main_rgba_map, formats[idx].main);
+    ff_fill_rgba_map(s.overlay_rgba_map, formats[idx].overlay);
+    ff_overlay_init(&s, formats[idx].format, formats[idx].main,
+                    alpha_format, main_has_alpha);
+
+    for (i = 0; i < 4; i++) {
+        /* the alpha plane and packed pixels are blended in place */
+        const int in_place = i == 3 || packed;
+        const int step = packed ? 4 : desc->comp[i].step;
+        const int shift = packed ? 0 : desc->comp[i].shift;
+
+        if (!check_func(s.blend_row[i], "overlay_row_%s_%d%s",
+                        av_get_pix_fmt_name(formats[idx].main), i,
+                        alpha_format ? "_pm" : ""))
+            continue;
+
+        for (w = 1; w <= WIDTH; w += w < 40 ? 1 : 29) {
+            int n_ref, n_new;
+
+            randomize_plane(d_org, depth, shift);
+            randomize_plane(da,    depth, 0);
+            randomize_plane(src,   depth, 0);
+            randomize_plane(a,     depth, 0);
+            memcpy(d_ref, d_org, LINESIZE * 2);
+            memcpy(d_new, d_org, LINESIZE * 2);
+
+            if (in_place) {
+                n_ref = call_ref(d_ref, d_ref, src, src, w, 0, 0);
+                n_new = call_new(d_new, d_new, src, src, w, 0, 0);
+            } else {
+                n_ref = call_ref(d_ref, da, src, a, w, LINESIZE, LINESIZE);
+                n_new = call_new(d_new, da, src, a, w, LINESIZE, LINESIZE);
+            }
+            /* the caller blends the pixels left by the SIMD version */
+            if (n_new < 0 || n_new > n_ref ||
+                memcmp(d_ref, d_new, n_new * step) ||
+                memcmp(d_new + n_new * step, d_org + n_new * step,
+                       LINESIZE * 2 - n_new * step))
+                fail();
+        }
+        if (in_place)
+            bench_new(d_new, d_new, src, src, WIDTH, 0, 0);
+        else
+            bench_new(d_new, da, src, a, WIDTH, LINESIZE, LINESIZE);
+    }
+}
+
+void checkasm_check_vf_overlay(void)
+{
+    int i;
+
+    for (i = 0; i < FF_ARRAY_ELEMS(formats); i++) {
+        check_blend_row(i, 0);
+        check_blend_row(i, 1);
+    }
+    report("blend_row");
+}
@@ -26,6 +26,10 @@ fate-api-threadmessage: $(APITESTSDIR)/api-threadmessage-test$(EXESUF)
 fate-api-threadmessage: CMD = run $(APITESTSDIR)/api-threadmessage-test$(EXESUF) 3 10 30 50 2 20 40
 fate-api-threadmessage: CMP = null
 
+FATE_API_LIBAVFILTER-$(call ALLYES, HFLIP_FILTER ASETNSAMPLES_FILTER) += fate-api-filter-stats
+fate-api-filter-stats: $(APITESTSDIR)/api-filter-stats-test$(EXESUF)
+fate-api-filter-stats: CMD = run $(APITESTSDIR)/api-filter-stats-test$(EXESUF)
+
 FATE_API_SAMPLES-$(CONFIG_AVFORMAT) += $(FATE_API_SAMPLES_LIBAVFORMAT-yes)
 
 ifdef SAMPLES
@@ -34,6 +38,7 @@ endif
 
 FATE_API-$(CONFIG_AVCODEC) += $(FATE_API_LIBAVCODEC-yes)
 FATE_API-$(CONFIG_AVFORMAT) += $(FATE_API_LIBAVFORMAT-yes)
+FATE_API-$(CONFIG_AVFILTER) += $(FATE_API_LIBAVFILTER-yes)
 FATE_API = $(FATE_API-yes)
 
 FATE-yes += $(FATE_API) $(FATE_API_SAMPLES)
@@ -52,6 +52,18 @@ fate-filter-afade-log: CMD = framecrc -i $(SRC) -af afade=t=in:ss=1:d=2.5:curve=
 
 FATE_AFILTER-$(call FILTERDEMDECENCMUX, AFADE, WAV, PCM_S16LE, PCM_S16LE, WAV) += $(FATE_FILTER_AFADE)
 
+# Small partitions, so the impulse response is split into several segments
+# which are convolved by separate jobs.
+FATE_FILTER_AFIR += fate-filter-afir-minp-threads1
+FATE_FILTER_AFIR += fate-filter-afir-minp-threads4
+FATE_AFILTER-$(call FILTERDEMDECENCMUX, AFIR, WAV, PCM_S16LE, PCM_S16LE, WAV) += $(FATE_FILTER_AFIR)
+$(FATE_FILTER_AFIR): tests/data/asynth-44100-2.wav tests/data/asynth-44100-2-2.wav
+$(FATE_FILTER_AFIR): SRC  = $(TARGET_PATH)/tests/data/asynth-44100-2.wav
+$(FATE_FILTER_AFIR): SRC1 = $(TARGET_PATH)/tests/data/asynth-44100-2-2.wav
+$(FATE_FILTER_AFIR): CMD = md5 -auto_conversion_filters -filter_complex_threads $(@:fate-filter-afir-minp-threads%=%) -i $(SRC) -t 0.05 -i $(SRC1) -filter_complex afir=minp=16:maxp=256 -f s16le
+$(FATE_FILTER_AFIR): CMP = oneline
+$(FATE_FILTER_AFIR): REF = cee04fb1ec5ca9b90fbd8b357fe40704
+
 FATE_AFILTER_SAMPLES-$(call FILTERDEMDECENCMUX, ACROSSFADE, WAV, PCM_S16LE, PCM_S16LE, WAV) += fate-filter-acrossfade
 fate-filter-acrossfade: tests/data/asynth-44100-2.wav
 fate-filter-acrossfade: SRC = $(TARGET_PATH)/tests/data/asynth-44100-2.wav
@@ -78,6 +90,16 @@ fate-filter-apad: tests/data/asynth-44100-2.wav
 fate-filter-apad: SRC = $(TARGET_PATH)/tests/data/asynth-44100-2.wav
 fate-filter-apad: CMD = framecrc -i $(SRC) -af apad=pad_len=10
 
+# Small model with made-up weights, four channels are evaluated in one batch.
+FATE_AFILTER-$(call FILTERDEMDECENCMUX, ARNNDN ARESAMPLE, WAV, PCM_S16LE, PCM_S16LE, WAV) += fate-filter-arnndn
+fate-filter-arnndn: tests/data/asynth-48000-4.wav
+fate-filter-arnndn: tests/data/filtergraphs/arnndn
+fate-filter-arnndn: REF = tests/data/asynth-48000-4.wav
+fate-filter-arnndn: CMD = ffmpeg -i $(TARGET_PATH)/tests/data/asynth-48000-4.wav -af aresample,arnndn=m=$(TARGET_PATH)/tests/data/filtergraphs/arnndn,aresample -f wav -c:a pcm_s16le -
+fate-filter-arnndn: CMP = stddev
+fate-filter-arnndn: CMP_TARGET = 8058.18
+fate-filter-arnndn: FUZZ = 0.1
+
 FATE_AFILTER-$(call FILTERDEMDECENCMUX, ANEQUALIZER, WAV, PCM_S16LE, PCM_S16LE, WAV) += fate-filter-anequalizer
 fate-filter-anequalizer: tests/data/asynth-44100-2.wav
 fate-filter-anequalizer: tests/data/filtergraphs/anequalizer
@@ -99,6 +121,15 @@ fate-filter-asetrate: tests/data/asynth-44100-2.wav
 fate-filter-asetrate: SRC = $(TARGET_PATH)/tests/data/asynth-44100-2.wav
 fate-filter-asetrate: CMD = framecrc -i $(SRC) -frames:a 20 -af asetrate=20000
 
+# Seeded noise gives clear correlation peaks, the stereo fragments are
+# down-mixed and blended by several jobs.
+FATE_FILTER_ATEMPO += fate-filter-atempo-threads1
+FATE_FILTER_ATEMPO += fate-filter-atempo-threads4
+FATE_AFILTER-$(call ALLYES, LAVFI_INDEV ANOISESRC_FILTER AMERGE_FILTER ATEMPO_FILTER ARESAMPLE_FILTER PCM_S16LE_ENCODER PCM_S16LE_MUXER) += $(FATE_FILTER_ATEMPO)
+$(FATE_FILTER_ATEMPO): CMD = md5 -filter_complex_threads $(@:fate-filter-atempo-threads%=%) -f lavfi -i "anoisesrc=d=2:r=44100:seed=42" -f lavfi -i "anoisesrc=d=2:r=44100:c=pink:seed=43" -filter_complex "[0][1]amerge,atempo=0.8,aresample" -f s16le
+$(FATE_FILTER_ATEMPO): CMP = oneline
+$(FATE_FILTER_ATEMPO): REF = 7024857b64d88b50bede5912bab65f67
+
 FATE_AFILTER-$(call FILTERDEMDECENCMUX, CHORUS, WAV, PCM_S16LE, PCM_S16LE, WAV) += fate-filter-chorus
 fate-filter-chorus: tests/data/asynth-22050-1.wav
 fate-filter-chorus: SRC = $(TARGET_PATH)/tests/data/asynth-22050-1.wav
@@ -128,6 +159,41 @@ fate-filter-firequalizer: CMP = oneoff
 fate-filter-firequalizer: CMP_UNIT = s16
 fate-filter-firequalizer: SIZE_TOLERANCE = 1058400 - 1097208
 
+FATE_AFILTER-$(call FILTERDEMDECENCMUX, HEADPHONE, WAV, PCM_S16LE, PCM_S16LE, WAV) += fate-filter-headphone
+fate-filter-headphone: tests/data/asynth-44100-2.wav tests/data/asynth-44100-2-2.wav
+fate-filter-headphone: SRC  = $(TARGET_PATH)/tests/data/asynth-44100-2.wav
+fate-filter-headphone: SRC1 = $(TARGET_PATH)/tests/data/asynth-44100-2-2.wav
+fate-filter-headphone: CMD = md5 -auto_conversion_filters -i $(SRC) -t 0.02 -i $(SRC1) -t 0.02 -i $(SRC1) -filter_complex "headphone=map=FL\|FR" -f s16le
+fate-filter-headphone: CMP = oneline
+fate-filter-headphone: REF = 9cf5adafc2bdb97dea6e0399627318bb
+
+FATE_AFILTER-$(call FILTERDEMDECENCMUX, HIGHPASS ASETNSAMPLES ARESAMPLE, WAV, PCM_S16LE, PCM_S16LE, WAV) += fate-filter-highpass-di
+fate-filter-highpass-di: tests/data/asynth-44100-2.wav
+fate-filter-highpass-di: SRC = $(TARGET_PATH)/tests/data/asynth-44100-2.wav
+fate-filter-highpass-di: CMD = framecrc -i $(SRC) -frames:a 20 -af aresample,asetnsamples=n=1001:p=0,highpass=f=200:a=di,aresample
+
+FATE_AFILTER-$(call FILTERDEMDECENCMUX, HIGHPASS ASETNSAMPLES ARESAMPLE, WAV, PCM_S16LE, PCM_S16LE, WAV) += fate-filter-highpass-tdii
+fate-filter-highpass-tdii: tests/data/asynth-44100-2.wav
+fate-filter-highpass-tdii: SRC = $(TARGET_PATH)/tests/data/asynth-44100-2.wav
+fate-filter-highpass-tdii: CMD = framecrc -i $(SRC) -frames:a 20 -af aresample,asetnsamples=n=1001:p=0,highpass=f=200:a=tdii,aresample
+
+FATE_AFILTER-$(call FILTERDEMDECENCMUX, LOUDNORM ARESAMPLE, WAV, PCM_S16LE, PCM_S16LE, WAV) += fate-filter-loudnorm-lookahead
+fate-filter-loudnorm-lookahead: tests/data/asynth-44100-2.wav
+fate-filter-loudnorm-lookahead: SRC = $(TARGET_PATH)/tests/data/asynth-44100-2.wav
+fate-filter-loudnorm-lookahead: CMD = md5 -i $(SRC) -af aresample,loudnorm=lookahead=0.3,aresample=44100 -f s16le
+fate-filter-loudnorm-lookahead: CMP = oneline
+fate-filter-loudnorm-lookahead: REF = 93710ef93e9a6ebd52f60ba17cedc9be
+
+FATE_AFILTER-$(call FILTERDEMDECENCMUX, LOWPASS ASETNSAMPLES ARESAMPLE, WAV, PCM_S16LE, PCM_S16LE, WAV) += fate-filter-lowpass-di
+fate-filter-lowpass-di: tests/data/asynth-44100-2.wav
+fate-filter-lowpass-di: SRC = $(TARGET_PATH)/tests/data/asynth-44100-2.wav
+fate-filter-lowpass-di: CMD = framecrc -i $(SRC) -frames:a 20 -af aresample,asetnsamples=n=1001:p=0,lowpass=f=1000:a=di,aresample
+
+FATE_AFILTER-$(call FILTERDEMDECENCMUX, LOWPASS ASETNSAMPLES ARESAMPLE, WAV, PCM_S16LE, PCM_S16LE, WAV) += fate-filter-lowpass-tdii
+fate-filter-lowpass-tdii: tests/data/asynth-44100-2.wav
+fate-filter-lowpass-tdii: SRC = $(TARGET_PATH)/tests/data/asynth-44100-2.wav
+fate-filter-lowpass-tdii: CMD = framecrc -i $(SRC) -frames:a 20 -af aresample,asetnsamples=n=1001:p=0,lowpass=f=1000:a=tdii,aresample
+
 FATE_AFILTER-$(call FILTERDEMDECENCMUX, PAN, WAV, PCM_S16LE, PCM_S16LE, WAV) += fate-filter-pan-mono1
 fate-filter-pan-mono1: tests/data/asynth-44100-2.wav
 fate-filter-pan-mono1: SRC = $(TARGET_PATH)/tests/data/asynth-44100-2.wav
@@ -245,6 +311,34 @@ $(FATE_AMIX): SRC1 = $(TARGET_PATH)/tests/data/asynth-44100-2-2.wav
 $(FATE_AMIX): CMP  = oneoff
 $(FATE_AMIX): CMP_UNIT = f32
 
+# Batching the audio frames of the filter graph may change the framing of
+# the output, but not the samples. Filters depending on the framing, like
+# volume with per-frame evaluation, and the filters before them are not
+# batched.
+FATE_AFILTER_BATCH += fate-filter-audio-batch-off
+fate-filter-audio-batch-off: AUDIO_BATCH = 0
+fate-filter-audio-batch-off: AFILTERS = aresample,dcshift=0.1,aresample
+
+FATE_AFILTER_BATCH += fate-filter-audio-batch-on
+fate-filter-audio-batch-on: AUDIO_BATCH = 4096
+fate-filter-audio-batch-on: AFILTERS = aresample,dcshift=0.1,aresample
+fate-filter-audio-batch-on fate-filter-audio-batch-off: REF = 0989f957c9ed541682d69270acd59433
+
+FATE_AFILTER_BATCH += fate-filter-audio-batch-frame-off
+fate-filter-audio-batch-frame-off: AUDIO_BATCH = 0
+fate-filter-audio-batch-frame-off: AFILTERS = aresample,volume=eval=frame:volume=n/200,aresample,dcshift=0.1,aresample
+
+FATE_AFILTER_BATCH += fate-filter-audio-batch-frame-on
+fate-filter-audio-batch-frame-on: AUDIO_BATCH = 4096
+fate-filter-audio-batch-frame-on: AFILTERS = aresample,volume=eval=frame:volume=n/200,aresample,dcshift=0.1,aresample
+fate-filter-audio-batch-frame-on fate-filter-audio-batch-frame-off: REF = c83eea1f45e9197054deaa8649d4c0bb
+
+FATE_AFILTER-$(call FILTERDEMDECENCMUX, DCSHIFT VOLUME ARESAMPLE, WAV, PCM_S16LE, PCM_S16LE, WAV) += $(FATE_AFILTER_BATCH)
+$(FATE_AFILTER_BATCH): tests/data/asynth-44100-2.wav
+$(FATE_AFILTER_BATCH): SRC = $(TARGET_PATH)/tests/data/asynth-44100-2.wav
+$(FATE_AFILTER_BATCH): CMD = md5 -filter_audio_batch $(AUDIO_BATCH) -i $(SRC) -af $(AFILTERS) -f s16le
+$(FATE_AFILTER_BATCH): CMP = oneline
+
 FATE_AFILTER_SAMPLES-$(CONFIG_ARESAMPLE_FILTER) += fate-filter-aresample
 fate-filter-aresample: SRC = $(TARGET_SAMPLES)/nellymoser/nellymoser-discont.flv
 fate-filter-aresample: CMD = pcm -analyzeduration 10000000 -i $(SRC) -af aresample=min_comp=0.001:min_hard_comp=0.1:first_pts=0
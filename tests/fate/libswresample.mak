@@ -1086,6 +1086,23 @@ FATE_SWR_RESAMPLE-$(call FILTERDEMDECENCMUX, ARESAMPLE, WAV, PCM_S16LE, PCM_S16L
 fate-swr-resample: $(FATE_SWR_RESAMPLE-yes)
 FATE_SWR += $(FATE_SWR_RESAMPLE-yes)
 
+# the output with several threads must match the single thread one, only
+# the integer formats are tested as the float kernels depend on the CPU
+define SWR_THREADS
+FATE_SWR_THREADS += fate-swr-threads-$(1)-$(2)
+fate-swr-threads-$(1)-$(2): tests/data/asynth-44100-6.wav
+fate-swr-threads-$(1)-$(2): CMD = md5 -filter_threads $(2) -i $(TARGET_PATH)/tests/data/asynth-44100-6.wav -af aresample=96000:internal_sample_fmt=$(1):threads=$(2) -f s16le
+fate-swr-threads-$(1)-$(2): CMP = oneline
+fate-swr-threads-$(1)-$(2): REF = $(3)
+endef
+
+$(foreach N,1 4,$(eval $(call SWR_THREADS,s16p,$(N),4182f40e16ddae1a35b9a24af9e1b8d8)))
+$(foreach N,1 4,$(eval $(call SWR_THREADS,s32p,$(N),d992f7017202928164301873957d9824)))
+
+FATE_SWR_THREADS-$(call FILTERDEMDECENCMUX, ARESAMPLE, WAV, PCM_S16LE, PCM_S16LE, PCM_S16LE) += $(FATE_SWR_THREADS)
+fate-swr-threads: $(FATE_SWR_THREADS-yes)
+FATE_SWR += $(FATE_SWR_THREADS-yes)
+
 FATE_SWR_AUDIOCONVERT-$(call FILTERDEMDECENCMUX, AFORMAT AEVAL, WAV, PCM_S16LE, PCM_S16LE, WAV) += fate-swr-audioconvert
 fate-swr-audioconvert: tests/data/asynth-44100-1.wav
 fate-swr-audioconvert: REF = tests/data/asynth-44100-1.wav
@@ -1095,4 +1112,10 @@ fate-swr-audioconvert: FUZZ = 0
 
 FATE_SWR += $(FATE_SWR_AUDIOCONVERT-yes)
 FATE_FFMPEG += $(FATE_SWR)
-fate-swr: $(FATE_SWR)
+
+FATE_LIBSWRESAMPLE += fate-swr-filter-bank-cache
+fate-swr-filter-bank-cache: libswresample/tests/resample$(EXESUF)
+fate-swr-filter-bank-cache: CMD = run libswresample/tests/resample$(EXESUF)
+
+FATE-$(CONFIG_SWRESAMPLE) += $(FATE_LIBSWRESAMPLE)
+fate-swr: $(FATE_SWR) $(FATE_LIBSWRESAMPLE)
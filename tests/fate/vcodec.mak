@@ -490,3 +490,39 @@ fate-vsynth2: $(FATE_VSYNTH2)
 fate-vsynth_lena: $(FATE_VSYNTH_LENA)
 fate-vsynth3: $(FATE_VSYNTH3)
 fate-vcodec:  fate-vsynth1 fate-vsynth_lena fate-vsynth2 fate-vsynth3
+
+# The motion estimation wavefront used with one slice and slice threads must
+# produce the same bitstream as a single thread.
+FATE_MPEG4_ME_THREADS-$(call ALLYES, RAWVIDEO_DEMUXER MPEG4_ENCODER FRAMECRC_MUXER) += fate-mpeg4-me-threads1 fate-mpeg4-me-threads4
+fate-mpeg4-me-threads%: CMD = framecrc -f rawvideo -s 352x288 -pix_fmt yuv420p -i $(TARGET_PATH)/tests/data/vsynth1.yuv -frames:v 10 -c:v mpeg4 -slices 1 -bf 2 -mepre 2 -last_pred 2 -threads $(@:fate-mpeg4-me-threads%=%) -thread_type slice
+fate-mpeg4-me-threads4: REF = $(SRC_PATH)/tests/ref/fate/mpeg4-me-threads1
+
+$(FATE_MPEG4_ME_THREADS-yes): tests/data/vsynth1.yuv
+FATE_AVCONV += $(FATE_MPEG4_ME_THREADS-yes)
+fate-mpeg4-me-threads: $(FATE_MPEG4_ME_THREADS-yes)
+
+FATE_MPEG1_ME_THREADS-$(call ALLYES, RAWVIDEO_DEMUXER MPEG1VIDEO_ENCODER FRAMECRC_MUXER) += fate-mpeg1-me-threads1 fate-mpeg1-me-threads4
+fate-mpeg1-me-threads%: CMD = framecrc -f rawvideo -s 352x288 -pix_fmt yuv420p -i $(TARGET_PATH)/tests/data/vsynth1.yuv -frames:v 10 -c:v mpeg1video -slices 1 -bf 2 -mepre 2 -last_pred 2 -threads $(@:fate-mpeg1-me-threads%=%) -thread_type slice
+fate-mpeg1-me-threads4: REF = $(SRC_PATH)/tests/ref/fate/mpeg1-me-threads1
+
+$(FATE_MPEG1_ME_THREADS-yes): tests/data/vsynth1.yuv
+FATE_AVCONV += $(FATE_MPEG1_ME_THREADS-yes)
+fate-mpeg1-me-threads: $(FATE_MPEG1_ME_THREADS-yes)
+
+FATE_MPEG2_ME_THREADS-$(call ALLYES, RAWVIDEO_DEMUXER MPEG2VIDEO_ENCODER FRAMECRC_MUXER) += fate-mpeg2-me-threads1 fate-mpeg2-me-threads4
+fate-mpeg2-me-threads%: CMD = framecrc -f rawvideo -s 352x288 -pix_fmt yuv420p -i $(TARGET_PATH)/tests/data/vsynth1.yuv -frames:v 10 -c:v mpeg2video -slices 1 -bf 2 -mepre 2 -last_pred 2 -threads $(@:fate-mpeg2-me-threads%=%) -thread_type slice
+fate-mpeg2-me-threads4: REF = $(SRC_PATH)/tests/ref/fate/mpeg2-me-threads1
+
+$(FATE_MPEG2_ME_THREADS-yes): tests/data/vsynth1.yuv
+FATE_AVCONV += $(FATE_MPEG2_ME_THREADS-yes)
+fate-mpeg2-me-threads: $(FATE_MPEG2_ME_THREADS-yes)
+
+# The chunked deflate stream must not depend on the thread count and must
+# decode to the same images as the default single deflate stream.
+FATE_PNG_CHUNKED_DEFLATE-$(call ENCDEC, PNG, AVI) += fate-png-chunked-deflate-threads1 fate-png-chunked-deflate-threads4
+fate-png-chunked-deflate-threads%: CMD = enc_dec "rawvideo -s 352x288 -pix_fmt yuv420p" $(TARGET_PATH)/tests/data/vsynth1.yuv avi "-c png -chunked_deflate 1 -threads $(@:fate-png-chunked-deflate-threads%=%) -thread_type slice" rawvideo "-s 352x288 -pix_fmt yuv420p"
+fate-png-chunked-deflate-threads%: CMP_UNIT = 1
+
+$(FATE_PNG_CHUNKED_DEFLATE-yes): tests/data/vsynth1.yuv
+FATE_AVCONV += $(FATE_PNG_CHUNKED_DEFLATE-yes)
+fate-png-chunked-deflate: $(FATE_PNG_CHUNKED_DEFLATE-yes)